@@ -1,68 +1,4 @@
-#include <stdlib.h>
-#include <stdio.h>
-#include <string.h>
-#include <stdbool.h>
-
-#if !defined(null)
-#define null 0
-#endif 
-
-#if !defined(offsetof)
-#define offsetof(s,m) ((size_t)&(((s*)0)->m))
-#endif
-
-#if !defined(assert)
-#define assert(condition) { if (!(condition)) { perror("Assert failed"); exit(1); } }
-#endif 
-
-#if !defined(max)
-#define max(a,b) ((a) > (b) ? (a) : (b))
-#endif 
-
-#if !defined(min)
-#define max(a,b) ((a) < (b) ? (a) : (b))
-#endif 
-
-#if !defined(align_down)
-#define align_down(num, align) ((num) & ~((align) - 1))
-#endif
-
-#if !defined(align_up)
-#define align_up(num, align) (align_down((num) + (align) - 1, (align)))
-#endif 
-
-#if !defined(align_down_ptr)
-#define align_down_ptr(ptr, align) ((void *)align_down((uintptr_t)(ptr), (align)))
-#endif 
-
-#if !defined(align_up_ptr)
-#define align_up_ptr(ptr, align) ((void *)align_up((uintptr_t)(ptr), (align)))
-#endif 
-
-typedef struct ___alloc_hdr___ {
-  size_t size;
-} ___alloc_hdr___;
-
-#define ___alive_tag___ 0x1000000000000000
-#define ___tag___(v, t) ((v) = ((v) | (t)))
-#define ___untag___(v, t) ((v) = ((v) & (~0 & ~(t))))
-
-#define ___get_obj_ptr___(hdr_ptr) (void*)((char*)(hdr_ptr) + sizeof(___alloc_hdr___))
-#define ___get_hdr_ptr___(obj_ptr) (___alloc_hdr___*)((char*)(obj_ptr) - sizeof(___alloc_hdr___))
-
-typedef struct ___alloc_map_value___ ___alloc_map_value___;
-struct ___alloc_map_value___ {
-  uintptr_t key;
-  uintptr_t value;
-  ___alloc_map_value___ *next;
-};
-
-typedef struct ___alloc_map___ {
-  ___alloc_map_value___ **values;
-  size_t total_count;
-  size_t used_capacity;
-  size_t capacity;
-} ___alloc_map___;
+#include "common.h"
 
 uint64_t ___hash_ptr___(uint64_t ptr) {
   ptr *= 0xff51afd7ed558ccd;
@@ -327,13 +263,6 @@ void ___mark_heap___(void) {
   }
 }
 
-typedef struct ___list_hdr___ {
-  bool is_managed;
-  size_t length;
-  size_t capacity;
-  char* buffer;
-} ___list_hdr___;
-
 ___list_hdr___* ___list_initialize___(size_t initial_capacity, size_t element_size, bool managed) {  
   ___list_hdr___* hdr = 0;
   if (managed) {   
@@ -363,7 +292,7 @@ void ___list_grow___(___list_hdr___* hdr, size_t new_length, size_t element_size
 
 bool ___check_list_fits___(___list_hdr___* hdr, size_t increase) {
   if (hdr) {
-    if (hdr->length + increase < hdr->capacity) {
+    if (hdr->length + increase <= hdr->capacity) {
       return true;
     }
   }
@@ -378,6 +307,81 @@ void ___list_fit___(___list_hdr___* hdr, size_t increase, size_t element_size) {
   }
 }
 
+void ___list_reserve___(___list_hdr___* hdr, size_t capacity, size_t element_size) {
+  if (hdr && hdr->capacity < capacity) {
+    if (hdr->is_managed) {
+      hdr->buffer = (char*)___managed_realloc___(hdr->buffer, capacity * element_size);
+    } else {
+      hdr->buffer = (char*)___realloc___(hdr->buffer, capacity * element_size);
+    }
+    hdr->capacity = capacity;
+  }
+}
+
+void ___index_out_of_bounds___(size_t index, size_t bound) {
+  fprintf(stderr, "Index out of bounds: %zu (bound: %zu)\n", index, bound);
+  exit(1);
+}
+
+void ___list_add_range___(___list_hdr___* hdr, const void* elements, size_t count, size_t element_size) {
+  if (hdr && elements && count > 0) {
+    // elementy mogą pochodzić z tej samej listy, a bufor może zostać przeniesiony
+    const char* old_buffer = hdr->buffer;
+    bool from_own_buffer = ((const char*)elements >= old_buffer 
+      && (const char*)elements < old_buffer + (hdr->capacity * element_size));
+    size_t offset = from_own_buffer ? (size_t)((const char*)elements - old_buffer) : 0;
+    ___list_fit___(hdr, count, element_size);
+    if (from_own_buffer) {
+      elements = hdr->buffer + offset;
+    }
+    memmove(hdr->buffer + (hdr->length * element_size), elements, count * element_size);
+    hdr->length += count;
+  }
+}
+
+void ___list_insert_at___(___list_hdr___* hdr, size_t index, const void* element, size_t element_size) {
+  if (hdr && index <= hdr->length) {
+    ___list_fit___(hdr, 1, element_size);
+    memmove(
+      hdr->buffer + ((index + 1) * element_size),
+      hdr->buffer + (index * element_size),
+      (hdr->length - index) * element_size);
+    memcpy(hdr->buffer + (index * element_size), element, element_size);
+    hdr->length++;
+  }
+}
+
+void ___list_remove_at_ordered___(___list_hdr___* hdr, size_t element_size, size_t index) {
+  if (hdr && hdr->length > index) {
+    memmove(
+      hdr->buffer + (index * element_size),
+      hdr->buffer + ((index + 1) * element_size),
+      (hdr->length - index - 1) * element_size);
+    memset(hdr->buffer + ((hdr->length - 1) * element_size), 0, element_size);
+    hdr->length--;
+  }
+}
+
+void ___list_clear___(___list_hdr___* hdr, size_t element_size) {
+  if (hdr) {
+    // zerujemy, żeby gc nie trzymał przy życiu obiektów wskazywanych przez usunięte elementy
+    memset(hdr->buffer, 0, hdr->length * element_size);
+    hdr->length = 0;
+  }
+}
+
+void ___list_copy_from___(___list_hdr___* hdr, ___list_hdr___* source, size_t element_size) {
+  if (hdr && source && hdr != source) {
+    ___list_reserve___(hdr, source->length, element_size);
+    memcpy(hdr->buffer, source->buffer, source->length * element_size);
+    if (hdr->length > source->length) {
+      memset(hdr->buffer + (source->length * element_size), 0, 
+        (hdr->length - source->length) * element_size);
+    }
+    hdr->length = source->length;
+  }
+}
+
 void ___list_remove_at___(___list_hdr___* hdr, size_t element_size, size_t index) {
   if (hdr && hdr->length > index) {
     memcpy(
@@ -401,17 +405,6 @@ void ___list_free_internal__(___list_hdr___* hdr) {
   }
 }
 
-#define ___list_free___(hdr) \
-  ((hdr) ? (___list_free_internal__(hdr), (hdr) = null) : 0)
-
-#define ___list_add___(hdr, new_element, element_type) \
-  (___list_fit___((hdr), 1, sizeof(new_element)), \
-  ((element_type*)(hdr)->buffer)[hdr->length++] = (new_element))
-
-#define ___get_list_capacity___(hdr) ((hdr) ? (hdr->capacity) : 0)
-
-#define ___get_list_length___(hdr) ((hdr) ? (hdr->length) : 0)
-
 void ___sweep___(void) {
   ___list_hdr___ *garbage = ___list_initialize___(2, sizeof(uintptr_t), false);
   for (size_t i = 0; i < ___gc_allocs___->capacity; i++) {
@@ -478,7 +471,3 @@ void *allocate(size_t num_bytes) {
 void *reallocate(void *ptr, size_t num_bytes) {
   return ___realloc___(ptr, num_bytes);
 }
-
-#define ulong unsigned long
-#define uint unsigned int
-
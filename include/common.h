@@ -0,0 +1,155 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#if !defined(null)
+#define null 0
+#endif 
+
+#if !defined(offsetof)
+#define offsetof(s,m) ((size_t)&(((s*)0)->m))
+#endif
+
+#if !defined(assert)
+#define assert(condition) { if (!(condition)) { perror("Assert failed"); exit(1); } }
+#endif 
+
+#if !defined(max)
+#define max(a,b) ((a) > (b) ? (a) : (b))
+#endif 
+
+#if !defined(min)
+#define min(a,b) ((a) < (b) ? (a) : (b))
+#endif 
+
+#if !defined(___likely___)
+#if defined(__GNUC__) || defined(__clang__)
+#define ___likely___(condition) __builtin_expect(!!(condition), 1)
+#else
+#define ___likely___(condition) (condition)
+#endif
+#endif
+
+#if !defined(align_down)
+#define align_down(num, align) ((num) & ~((align) - 1))
+#endif
+
+#if !defined(align_up)
+#define align_up(num, align) (align_down((num) + (align) - 1, (align)))
+#endif 
+
+#if !defined(align_down_ptr)
+#define align_down_ptr(ptr, align) ((void *)align_down((uintptr_t)(ptr), (align)))
+#endif 
+
+#if !defined(align_up_ptr)
+#define align_up_ptr(ptr, align) ((void *)align_up((uintptr_t)(ptr), (align)))
+#endif 
+
+typedef struct ___alloc_hdr___ {
+  size_t size;
+} ___alloc_hdr___;
+
+#define ___alive_tag___ 0x1000000000000000
+#define ___tag___(v, t) ((v) = ((v) | (t)))
+#define ___untag___(v, t) ((v) = ((v) & (~0 & ~(t))))
+
+#define ___get_obj_ptr___(hdr_ptr) (void*)((char*)(hdr_ptr) + sizeof(___alloc_hdr___))
+#define ___get_hdr_ptr___(obj_ptr) (___alloc_hdr___*)((char*)(obj_ptr) - sizeof(___alloc_hdr___))
+
+typedef struct ___alloc_map_value___ ___alloc_map_value___;
+struct ___alloc_map_value___ {
+  uintptr_t key;
+  uintptr_t value;
+  ___alloc_map_value___ *next;
+};
+
+typedef struct ___alloc_map___ {
+  ___alloc_map_value___ **values;
+  size_t total_count;
+  size_t used_capacity;
+  size_t capacity;
+} ___alloc_map___;
+
+extern ___alloc_map___ *___allocs___;
+extern ___alloc_map___ *___gc_allocs___;
+extern uintptr_t ___stack_begin___;
+
+typedef struct ___list_hdr___ {
+  bool is_managed;
+  size_t length;
+  size_t capacity;
+  char* buffer;
+} ___list_hdr___;
+
+uint64_t ___hash_ptr___(uint64_t ptr);
+uintptr_t ___alloc_map_get___(___alloc_map___ *map, uintptr_t key);
+void ___alloc_map_delete___(___alloc_map___ *map, uintptr_t key);
+void ___alloc_map_grow___(___alloc_map___ *map, size_t new_capacity);
+void ___alloc_map_put___(___alloc_map___ *map, uintptr_t key, uintptr_t value);
+void ___alloc_map_free___(___alloc_map___ *map);
+void *___calloc_wrapper___(size_t num_bytes, bool gc);
+void* ___alloc___(size_t num_bytes);
+void *___realloc_wrapper___(void *ptr, size_t num_bytes, bool gc);
+void* ___realloc___(void* ptr, size_t num_bytes);
+void ___free___(void* ptr);
+void* ___managed_alloc___(size_t num_bytes);
+void* ___managed_realloc___(void* ptr, size_t num_bytes);
+void ___managed_free___(void* ptr);
+void ___gc_init___();
+void ___scan_for_pointers___(uintptr_t memory_block_begin, size_t byte_count);
+void ___mark_stack___(void);
+void ___mark_heap___(void);
+___list_hdr___* ___list_initialize___(size_t initial_capacity, size_t element_size, bool managed);
+void ___list_grow___(___list_hdr___* hdr, size_t new_length, size_t element_size);
+bool ___check_list_fits___(___list_hdr___* hdr, size_t increase);
+void ___list_fit___(___list_hdr___* hdr, size_t increase, size_t element_size);
+void ___list_reserve___(___list_hdr___* hdr, size_t capacity, size_t element_size);
+void ___index_out_of_bounds___(size_t index, size_t bound);
+void ___list_add_range___(___list_hdr___* hdr, const void* elements, size_t count, size_t element_size);
+void ___list_insert_at___(___list_hdr___* hdr, size_t index, const void* element, size_t element_size);
+void ___list_remove_at_ordered___(___list_hdr___* hdr, size_t element_size, size_t index);
+void ___list_clear___(___list_hdr___* hdr, size_t element_size);
+void ___list_copy_from___(___list_hdr___* hdr, ___list_hdr___* source, size_t element_size);
+void ___list_remove_at___(___list_hdr___* hdr, size_t element_size, size_t index);
+void ___list_free_internal__(___list_hdr___* hdr);
+void ___sweep___(void);
+size_t query_gc_total_memory(void);
+size_t query_gc_total_count(void);
+void gc(void);
+void ___clean_memory___(void);
+void *allocate(size_t num_bytes);
+void *reallocate(void *ptr, size_t num_bytes);
+
+static inline size_t ___checked_index___(size_t index, size_t bound) {
+  if (___likely___(index < bound)) {
+    return index;
+  }
+  ___index_out_of_bounds___(index, bound);
+  return 0;
+}
+
+static inline void* ___list_checked_element___(___list_hdr___* hdr, size_t index, size_t element_size) {
+  if (___likely___(hdr && index < hdr->length)) {
+    return hdr->buffer + index * element_size;
+  }
+  ___index_out_of_bounds___(index, hdr ? hdr->length : 0);
+  return 0;
+}
+
+#define ___list_free___(hdr) \
+  ((hdr) ? (___list_free_internal__(hdr), (hdr) = null) : 0)
+
+#define ___list_add___(hdr, new_element, element_type) \
+  (___list_fit___((hdr), 1, sizeof(new_element)), \
+  ((element_type*)(hdr)->buffer)[hdr->length++] = (new_element))
+
+#define ___get_list_capacity___(hdr) ((hdr) ? (hdr->capacity) : 0)
+
+#define ___get_list_length___(hdr) ((hdr) ? (hdr->length) : 0)
+
+#define ulong unsigned long
+#define uint unsigned int
@@ -0,0 +1,9 @@
+#!/bin/sh
+# kompilacja dla Linuksa i macOS; kompilator uruchamiamy z katalogu głównego repozytorium
+
+cd "$(dirname "$0")"
+mkdir -p output
+
+disable_warnings="-Wno-switch -Wno-unused-value -Wno-unused-variable -Wno-unused-parameter -Wno-unused-but-set-variable -Wno-sign-compare -Wno-format-security -Wno-unused-function -Wno-pointer-sign -Wno-discarded-qualifiers -Wno-incompatible-pointer-types-discards-qualifiers -Wno-unknown-warning-option"
+
+${CC:-cc} -std=c99 -Wall $disable_warnings -O2 -o wilfrid source/main.c -lm -lpthread
@@ -117,6 +117,7 @@ typedef struct index_expr
 {
     expr *array_expr;
     expr *index_expr;
+    bool is_in_bounds; // ustawiane przez analizę zakresów
 } index_expr;
 
 typedef struct field_expr
@@ -143,12 +144,14 @@ typedef struct new_expr
 {
     typespec *type;
     type *resolved_type;
+    bool on_stack; // ustawiane przez analizę ucieczki
 } new_expr;
 
 typedef struct auto_expr
 {
     typespec *type;
     type *resolved_type;
+    bool on_stack; // ustawiane przez analizę ucieczki
 } auto_expr;
 
 typedef struct size_of_type_expr
@@ -180,6 +183,11 @@ typedef enum stub_expr_kind
     STUB_EXPR_LIST_NEW,
     STUB_EXPR_LIST_AUTO,
     STUB_EXPR_LIST_INDEX,
+    STUB_EXPR_LIST_RESERVE,
+    STUB_EXPR_LIST_ADD_RANGE,
+    STUB_EXPR_LIST_INSERT_AT,
+    STUB_EXPR_LIST_CLEAR,
+    STUB_EXPR_LIST_COPY_FROM,
     STUB_EXPR_CAST,
     STUB_EXPR_POINTER_ARITHMETIC_BINARY,
     STUB_EXPR_POINTER_ARITHMETIC_INC,
@@ -324,6 +332,7 @@ typedef struct switch_stmt
 typedef struct delete_stmt
 {
     expr *expr;
+    bool target_on_stack; // ustawiane przez analizę ucieczki
 } delete_stmt;
 
 typedef struct inc_stmt
@@ -380,6 +389,7 @@ typedef struct variable_decl
 {
     typespec *type; 
     expr *expr;
+    char *folded_value; // wartość obliczona w czasie kompilacji
 } variable_decl;
 
 typedef struct const_decl
@@ -407,6 +417,9 @@ typedef struct function_decl
     function_param *method_receiver;
     stmt_block stmts;
     bool is_extern;
+    bool is_inline;
+    bool is_noinline;
+    bool is_const; // może być wywołana w czasie kompilacji
 } function_decl;
 
 typedef struct enum_value enum_value;
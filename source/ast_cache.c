@@ -0,0 +1,1194 @@
+// pamięć podręczna sparsowanych deklaracji - dla każdego pliku źródłowego zapisujemy
+// drzewo składniowe razem ze skrótem jego zawartości; niezmieniony plik nie jest
+// ponownie leksowany ani parsowany, a zmiana pliku unieważnia tylko jego wpis
+// zapisywane jest drzewo sprzed rozwiązywania nazw - resolve modyfikuje je w miejscu
+
+#define AST_CACHE_MAGIC 0x54534157 // "WAST"
+#define AST_CACHE_VERSION 1
+
+// węzły mogą być współdzielone w drzewie, dlatego zapisujemy je jako referencje
+#define AST_CACHE_NULL 0
+#define AST_CACHE_NEW_NODE 1
+#define AST_CACHE_FIRST_NODE_ID 2
+
+#ifdef __EMSCRIPTEN__
+bool ast_cache_enabled = false;
+#else
+bool ast_cache_enabled = true;
+#endif
+const char *ast_cache_dir = "output/cache";
+
+typedef struct ast_cache_writer
+{
+    char *buffer;
+    hashmap nodes; // wskaźnik węzła -> numer + 1
+    size_t nodes_count;
+    bool failed;
+} ast_cache_writer;
+
+typedef struct ast_cache_reader
+{
+    char *pos;
+    char *end;
+    const char *filename;
+    void **nodes;
+    bool failed;
+} ast_cache_reader;
+
+void ast_cache_put_bytes(ast_cache_writer *w, const void *bytes, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        buf_push(w->buffer, ((const char *)bytes)[i]);
+    }
+}
+
+void ast_cache_put_u8(ast_cache_writer *w, uint8_t value)
+{
+    ast_cache_put_bytes(w, &value, sizeof(value));
+}
+
+void ast_cache_put_u32(ast_cache_writer *w, uint32_t value)
+{
+    ast_cache_put_bytes(w, &value, sizeof(value));
+}
+
+void ast_cache_put_u64(ast_cache_writer *w, uint64_t value)
+{
+    ast_cache_put_bytes(w, &value, sizeof(value));
+}
+
+void ast_cache_put_string(ast_cache_writer *w, const char *str)
+{
+    if (str == null)
+    {
+        ast_cache_put_u32(w, UINT32_MAX);
+        return;
+    }
+    uint32_t length = (uint32_t)strlen(str);
+    ast_cache_put_u32(w, length);
+    ast_cache_put_bytes(w, str, length);
+}
+
+void ast_cache_put_pos(ast_cache_writer *w, source_pos pos)
+{
+    ast_cache_put_u32(w, (uint32_t)pos.line);
+    ast_cache_put_u32(w, (uint32_t)pos.character);
+}
+
+// zwraca true, jeśli węzeł jest zapisywany po raz pierwszy i trzeba zapisać jego treść
+bool ast_cache_put_ref(ast_cache_writer *w, void *node)
+{
+    if (node == null)
+    {
+        ast_cache_put_u32(w, AST_CACHE_NULL);
+        return false;
+    }
+
+    size_t id = (size_t)map_get(&w->nodes, node);
+    if (id)
+    {
+        ast_cache_put_u32(w, (uint32_t)(AST_CACHE_FIRST_NODE_ID + id - 1));
+        return false;
+    }
+
+    w->nodes_count++;
+    map_put(&w->nodes, node, (void *)w->nodes_count);
+    ast_cache_put_u32(w, AST_CACHE_NEW_NODE);
+    return true;
+}
+
+void ast_cache_put_expr(ast_cache_writer *w, expr *e);
+void ast_cache_put_stmt(ast_cache_writer *w, stmt *s);
+void ast_cache_put_decl(ast_cache_writer *w, decl *d);
+
+void ast_cache_put_typespec(ast_cache_writer *w, typespec *t)
+{
+    if (false == ast_cache_put_ref(w, t))
+    {
+        return;
+    }
+
+    ast_cache_put_u32(w, t->kind);
+    ast_cache_put_pos(w, t->pos);
+    switch (t->kind)
+    {
+        case TYPESPEC_NAME:
+        {
+            ast_cache_put_string(w, t->name);
+        }
+        break;
+        case TYPESPEC_ARRAY:
+        {
+            ast_cache_put_typespec(w, t->array.base_type);
+            ast_cache_put_expr(w, t->array.size_expr);
+        }
+        break;
+        case TYPESPEC_LIST:
+        {
+            ast_cache_put_typespec(w, t->list.base_type);
+        }
+        break;
+        case TYPESPEC_POINTER:
+        {
+            ast_cache_put_typespec(w, t->pointer.base_type);
+        }
+        break;
+        case TYPESPEC_FUNCTION:
+        {
+            ast_cache_put_typespec(w, t->function.ret_type);
+            ast_cache_put_u64(w, t->function.param_count);
+            for (size_t i = 0; i < t->function.param_count; i++)
+            {
+                ast_cache_put_typespec(w, t->function.param_types[i]);
+            }
+        }
+        break;
+        case TYPESPEC_NONE:
+        default:
+        {
+            w->failed = true;
+        }
+        break;
+    }
+}
+
+void ast_cache_put_expr(ast_cache_writer *w, expr *e)
+{
+    if (false == ast_cache_put_ref(w, e))
+    {
+        return;
+    }
+
+    ast_cache_put_u32(w, e->kind);
+    ast_cache_put_pos(w, e->pos);
+    switch (e->kind)
+    {
+        case EXPR_INT:
+        {
+            ast_cache_put_u64(w, e->integer_value);
+        }
+        break;
+        case EXPR_FLOAT:
+        {
+            ast_cache_put_bytes(w, &e->float_value, sizeof(e->float_value));
+        }
+        break;
+        case EXPR_CHAR:
+        case EXPR_STRING:
+        {
+            ast_cache_put_string(w, e->string_value);
+        }
+        break;
+        case EXPR_NULL:
+        break;
+        case EXPR_BOOL:
+        {
+            ast_cache_put_u8(w, e->bool_value);
+        }
+        break;
+        case EXPR_NAME:
+        {
+            ast_cache_put_string(w, e->name);
+        }
+        break;
+        case EXPR_UNARY:
+        {
+            ast_cache_put_u32(w, e->unary.operator);
+            ast_cache_put_expr(w, e->unary.operand);
+        }
+        break;
+        case EXPR_BINARY:
+        {
+            ast_cache_put_u32(w, e->binary.operator);
+            ast_cache_put_expr(w, e->binary.left);
+            ast_cache_put_expr(w, e->binary.right);
+        }
+        break;
+        case EXPR_TERNARY:
+        {
+            ast_cache_put_expr(w, e->ternary.condition);
+            ast_cache_put_expr(w, e->ternary.if_true);
+            ast_cache_put_expr(w, e->ternary.if_false);
+        }
+        break;
+        case EXPR_CALL:
+        {
+            ast_cache_put_expr(w, e->call.function_expr);
+            ast_cache_put_expr(w, e->call.method_receiver);
+            ast_cache_put_u64(w, e->call.args_num);
+            for (size_t i = 0; i < e->call.args_num; i++)
+            {
+                ast_cache_put_expr(w, e->call.args[i]);
+            }
+        }
+        break;
+        case EXPR_FIELD:
+        {
+            ast_cache_put_expr(w, e->field.expr);
+            ast_cache_put_string(w, e->field.field_name);
+        }
+        break;
+        case EXPR_INDEX:
+        {
+            ast_cache_put_expr(w, e->index.array_expr);
+            ast_cache_put_expr(w, e->index.index_expr);
+        }
+        break;
+        case EXPR_NEW:
+        {
+            ast_cache_put_typespec(w, e->new_init.type);
+        }
+        break;
+        case EXPR_AUTO:
+        {
+            ast_cache_put_typespec(w, e->auto_init.type);
+        }
+        break;
+        case EXPR_SIZE_OF:
+        {
+            ast_cache_put_expr(w, e->size_of.expr);
+        }
+        break;
+        case EXPR_SIZE_OF_TYPE:
+        {
+            ast_cache_put_typespec(w, e->size_of_type.type);
+        }
+        break;
+        case EXPR_CAST:
+        {
+            ast_cache_put_typespec(w, e->cast.type);
+            ast_cache_put_expr(w, e->cast.expr);
+        }
+        break;
+        case EXPR_COMPOUND_LITERAL:
+        {
+            ast_cache_put_typespec(w, e->compound.type);
+            ast_cache_put_u64(w, e->compound.fields_count);
+            for (size_t i = 0; i < e->compound.fields_count; i++)
+            {
+                compound_literal_field *field = e->compound.fields[i];
+                if (ast_cache_put_ref(w, field))
+                {
+                    ast_cache_put_expr(w, field->expr);
+                    ast_cache_put_u64(w, (uint64_t)field->field_index);
+                    ast_cache_put_string(w, field->field_name);
+                }
+            }
+        }
+        break;
+        default:
+        {
+            // stuby powstają dopiero podczas rozwiązywania nazw
+            w->failed = true;
+        }
+        break;
+    }
+}
+
+void ast_cache_put_stmt_block(ast_cache_writer *w, stmt_block block)
+{
+    ast_cache_put_u64(w, block.stmts_count);
+    for (size_t i = 0; i < block.stmts_count; i++)
+    {
+        ast_cache_put_stmt(w, block.stmts[i]);
+    }
+}
+
+void ast_cache_put_stmt(ast_cache_writer *w, stmt *s)
+{
+    if (false == ast_cache_put_ref(w, s))
+    {
+        return;
+    }
+
+    ast_cache_put_u32(w, s->kind);
+    ast_cache_put_pos(w, s->pos);
+    switch (s->kind)
+    {
+        case STMT_RETURN:
+        {
+            ast_cache_put_expr(w, s->return_stmt.ret_expr);
+        }
+        break;
+        case STMT_BREAK:
+        case STMT_CONTINUE:
+        break;
+        case STMT_DECL:
+        {
+            ast_cache_put_decl(w, s->decl_stmt.decl);
+        }
+        break;
+        case STMT_IF_ELSE:
+        {
+            ast_cache_put_expr(w, s->if_else.cond_expr);
+            ast_cache_put_stmt_block(w, s->if_else.then_block);
+            ast_cache_put_stmt(w, s->if_else.else_stmt);
+        }
+        break;
+        case STMT_WHILE:
+        case STMT_DO_WHILE:
+        {
+            ast_cache_put_expr(w, s->while_stmt.cond_expr);
+            ast_cache_put_stmt_block(w, s->while_stmt.stmts);
+        }
+        break;
+        case STMT_FOR:
+        {
+            ast_cache_put_stmt(w, s->for_stmt.init_stmt);
+            ast_cache_put_expr(w, s->for_stmt.cond_expr);
+            ast_cache_put_stmt(w, s->for_stmt.next_stmt);
+            ast_cache_put_stmt_block(w, s->for_stmt.stmts);
+        }
+        break;
+        case STMT_ASSIGN:
+        {
+            ast_cache_put_expr(w, s->assign.assigned_var_expr);
+            ast_cache_put_u32(w, s->assign.operation);
+            ast_cache_put_expr(w, s->assign.value_expr);
+        }
+        break;
+        case STMT_SWITCH:
+        {
+            ast_cache_put_expr(w, s->switch_stmt.var_expr);
+            ast_cache_put_u64(w, s->switch_stmt.cases_num);
+            for (size_t i = 0; i < s->switch_stmt.cases_num; i++)
+            {
+                switch_case *c = s->switch_stmt.cases[i];
+                if (ast_cache_put_ref(w, c))
+                {
+                    ast_cache_put_u64(w, c->cond_exprs_num);
+                    for (size_t k = 0; k < c->cond_exprs_num; k++)
+                    {
+                        ast_cache_put_expr(w, c->cond_exprs[k]);
+                    }
+                    ast_cache_put_stmt_block(w, c->stmts);
+                    ast_cache_put_u8(w, c->is_default);
+                    ast_cache_put_u8(w, c->fallthrough);
+                }
+            }
+        }
+        break;
+        case STMT_EXPR:
+        {
+            ast_cache_put_expr(w, s->expr);
+        }
+        break;
+        case STMT_BLOCK:
+        {
+            ast_cache_put_stmt_block(w, s->block);
+        }
+        break;
+        case STMT_DELETE:
+        {
+            ast_cache_put_expr(w, s->delete.expr);
+        }
+        break;
+        case STMT_INC:
+        {
+            ast_cache_put_expr(w, s->inc.operand);
+            ast_cache_put_u32(w, s->inc.operator);
+        }
+        break;
+        default:
+        {
+            w->failed = true;
+        }
+        break;
+    }
+}
+
+void ast_cache_put_param(ast_cache_writer *w, function_param *p)
+{
+    ast_cache_put_string(w, p->name);
+    ast_cache_put_typespec(w, p->type);
+    ast_cache_put_pos(w, p->pos);
+}
+
+void ast_cache_put_decl(ast_cache_writer *w, decl *d)
+{
+    if (false == ast_cache_put_ref(w, d))
+    {
+        return;
+    }
+
+    ast_cache_put_u32(w, d->kind);
+    ast_cache_put_pos(w, d->pos);
+    ast_cache_put_string(w, d->name);
+    switch (d->kind)
+    {
+        case DECL_STRUCT:
+        case DECL_UNION:
+        {
+            ast_cache_put_u64(w, d->aggregate.fields_count);
+            for (size_t i = 0; i < d->aggregate.fields_count; i++)
+            {
+                aggregate_field *field = &d->aggregate.fields[i];
+                ast_cache_put_string(w, field->name);
+                ast_cache_put_typespec(w, field->type);
+                ast_cache_put_pos(w, field->pos);
+            }
+        }
+        break;
+        case DECL_VARIABLE:
+        {
+            ast_cache_put_typespec(w, d->variable.type);
+            ast_cache_put_expr(w, d->variable.expr);
+        }
+        break;
+        case DECL_CONST:
+        {
+            ast_cache_put_expr(w, d->const_decl.expr);
+        }
+        break;
+        case DECL_FUNCTION:
+        {
+            ast_cache_put_u64(w, (uint64_t)d->function.params.param_count);
+            for (int i = 0; i < d->function.params.param_count; i++)
+            {
+                ast_cache_put_param(w, &d->function.params.params[i]);
+            }
+            ast_cache_put_typespec(w, d->function.return_type);
+            if (ast_cache_put_ref(w, d->function.method_receiver))
+            {
+                ast_cache_put_param(w, d->function.method_receiver);
+            }
+            ast_cache_put_stmt_block(w, d->function.stmts);
+            ast_cache_put_u8(w, d->function.is_extern);
+            ast_cache_put_u8(w, d->function.is_inline);
+            ast_cache_put_u8(w, d->function.is_noinline);
+            ast_cache_put_u8(w, d->function.is_const);
+        }
+        break;
+        case DECL_ENUM:
+        {
+            ast_cache_put_u64(w, d->enum_decl.values_count);
+            for (size_t i = 0; i < d->enum_decl.values_count; i++)
+            {
+                enum_value *val = d->enum_decl.values[i];
+                if (ast_cache_put_ref(w, val))
+                {
+                    ast_cache_put_string(w, val->name);
+                    ast_cache_put_u8(w, val->value_set);
+                    ast_cache_put_u64(w, (uint64_t)val->value);
+                    ast_cache_put_pos(w, val->pos);
+                    // wartość, od której zależy etykieta, jest zapisana wcześniej
+                    ast_cache_put_ref(w, val->depending_on);
+                }
+            }
+        }
+        break;
+        default:
+        {
+            w->failed = true;
+        }
+        break;
+    }
+}
+
+// zwraca null, jeśli któregoś z węzłów nie da się zapisać
+char *ast_cache_serialize(decl **declarations, size_t declarations_count, uint64_t source_hash)
+{
+    ast_cache_writer w = {0};
+    map_grow(&w.nodes, 256);
+
+    ast_cache_put_u32(&w, AST_CACHE_MAGIC);
+    ast_cache_put_u32(&w, AST_CACHE_VERSION);
+    ast_cache_put_u64(&w, source_hash);
+    ast_cache_put_u64(&w, declarations_count);
+    for (size_t i = 0; i < declarations_count; i++)
+    {
+        ast_cache_put_decl(&w, declarations[i]);
+    }
+
+    map_free(&w.nodes);
+    if (w.failed)
+    {
+        buf_free(w.buffer);
+    }
+    return w.buffer;
+}
+
+void ast_cache_get_bytes(ast_cache_reader *r, void *bytes, size_t size)
+{
+    if (r->failed || (size_t)(r->end - r->pos) < size)
+    {
+        r->failed = true;
+        memset(bytes, 0, size);
+        return;
+    }
+    memcpy(bytes, r->pos, size);
+    r->pos += size;
+}
+
+uint8_t ast_cache_get_u8(ast_cache_reader *r)
+{
+    uint8_t result = 0;
+    ast_cache_get_bytes(r, &result, sizeof(result));
+    return result;
+}
+
+uint32_t ast_cache_get_u32(ast_cache_reader *r)
+{
+    uint32_t result = 0;
+    ast_cache_get_bytes(r, &result, sizeof(result));
+    return result;
+}
+
+uint64_t ast_cache_get_u64(ast_cache_reader *r)
+{
+    uint64_t result = 0;
+    ast_cache_get_bytes(r, &result, sizeof(result));
+    return result;
+}
+
+// liczba elementów tablicy nie może przekraczać liczby pozostałych bajtów
+size_t ast_cache_get_count(ast_cache_reader *r)
+{
+    uint64_t result = ast_cache_get_u64(r);
+    if (result > (uint64_t)(r->end - r->pos))
+    {
+        r->failed = true;
+        result = 0;
+    }
+    return (size_t)result;
+}
+
+const char *ast_cache_get_string(ast_cache_reader *r)
+{
+    uint32_t length = ast_cache_get_u32(r);
+    if (r->failed || length == UINT32_MAX)
+    {
+        return null;
+    }
+    if ((size_t)(r->end - r->pos) < length)
+    {
+        r->failed = true;
+        return null;
+    }
+    const char *result = str_intern_range(r->pos, r->pos + length);
+    r->pos += length;
+    return result;
+}
+
+source_pos ast_cache_get_pos(ast_cache_reader *r)
+{
+    source_pos result = {0};
+    result.filename = r->filename;
+    result.line = ast_cache_get_u32(r);
+    result.character = ast_cache_get_u32(r);
+    return result;
+}
+
+void *ast_cache_push(size_t size)
+{
+    void *result = push_size(arena, size);
+    memset(result, 0, size);
+    return result;
+}
+
+// zwraca wcześniej wczytany węzeł albo null; is_new jest ustawiane,
+// gdy w strumieniu następuje treść nowego węzła
+void *ast_cache_get_ref(ast_cache_reader *r, bool *is_new)
+{
+    *is_new = false;
+    uint32_t tag = ast_cache_get_u32(r);
+    if (r->failed || tag == AST_CACHE_NULL)
+    {
+        return null;
+    }
+    if (tag == AST_CACHE_NEW_NODE)
+    {
+        *is_new = true;
+        return null;
+    }
+
+    size_t id = tag - AST_CACHE_FIRST_NODE_ID;
+    if (id >= buf_len(r->nodes))
+    {
+        r->failed = true;
+        return null;
+    }
+    return r->nodes[id];
+}
+
+void *ast_cache_new_node(ast_cache_reader *r, size_t size)
+{
+    void *result = ast_cache_push(size);
+    buf_push(r->nodes, result);
+    return result;
+}
+
+expr *ast_cache_get_expr(ast_cache_reader *r);
+stmt *ast_cache_get_stmt(ast_cache_reader *r);
+decl *ast_cache_get_decl(ast_cache_reader *r);
+
+typespec *ast_cache_get_typespec(ast_cache_reader *r)
+{
+    bool is_new = false;
+    typespec *t = ast_cache_get_ref(r, &is_new);
+    if (false == is_new)
+    {
+        return t;
+    }
+
+    t = ast_cache_new_node(r, sizeof(typespec));
+    t->kind = ast_cache_get_u32(r);
+    t->pos = ast_cache_get_pos(r);
+    switch (t->kind)
+    {
+        case TYPESPEC_NAME:
+        {
+            t->name = ast_cache_get_string(r);
+        }
+        break;
+        case TYPESPEC_ARRAY:
+        {
+            t->array.base_type = ast_cache_get_typespec(r);
+            t->array.size_expr = ast_cache_get_expr(r);
+        }
+        break;
+        case TYPESPEC_LIST:
+        {
+            t->list.base_type = ast_cache_get_typespec(r);
+        }
+        break;
+        case TYPESPEC_POINTER:
+        {
+            t->pointer.base_type = ast_cache_get_typespec(r);
+        }
+        break;
+        case TYPESPEC_FUNCTION:
+        {
+            t->function.ret_type = ast_cache_get_typespec(r);
+            t->function.param_count = ast_cache_get_count(r);
+            if (t->function.param_count > 0)
+            {
+                t->function.param_types = ast_cache_push(t->function.param_count * sizeof(typespec *));
+                for (size_t i = 0; i < t->function.param_count; i++)
+                {
+                    t->function.param_types[i] = ast_cache_get_typespec(r);
+                }
+            }
+        }
+        break;
+        default:
+        {
+            r->failed = true;
+        }
+        break;
+    }
+    return t;
+}
+
+expr *ast_cache_get_expr(ast_cache_reader *r)
+{
+    bool is_new = false;
+    expr *e = ast_cache_get_ref(r, &is_new);
+    if (false == is_new)
+    {
+        return e;
+    }
+
+    e = ast_cache_new_node(r, sizeof(expr));
+    e->kind = ast_cache_get_u32(r);
+    e->pos = ast_cache_get_pos(r);
+    switch (e->kind)
+    {
+        case EXPR_INT:
+        {
+            e->integer_value = ast_cache_get_u64(r);
+        }
+        break;
+        case EXPR_FLOAT:
+        {
+            ast_cache_get_bytes(r, &e->float_value, sizeof(e->float_value));
+        }
+        break;
+        case EXPR_CHAR:
+        case EXPR_STRING:
+        {
+            e->string_value = ast_cache_get_string(r);
+        }
+        break;
+        case EXPR_NULL:
+        break;
+        case EXPR_BOOL:
+        {
+            e->bool_value = ast_cache_get_u8(r);
+        }
+        break;
+        case EXPR_NAME:
+        {
+            e->name = ast_cache_get_string(r);
+        }
+        break;
+        case EXPR_UNARY:
+        {
+            e->unary.operator = ast_cache_get_u32(r);
+            e->unary.operand = ast_cache_get_expr(r);
+        }
+        break;
+        case EXPR_BINARY:
+        {
+            e->binary.operator = ast_cache_get_u32(r);
+            e->binary.left = ast_cache_get_expr(r);
+            e->binary.right = ast_cache_get_expr(r);
+        }
+        break;
+        case EXPR_TERNARY:
+        {
+            e->ternary.condition = ast_cache_get_expr(r);
+            e->ternary.if_true = ast_cache_get_expr(r);
+            e->ternary.if_false = ast_cache_get_expr(r);
+        }
+        break;
+        case EXPR_CALL:
+        {
+            e->call.function_expr = ast_cache_get_expr(r);
+            e->call.method_receiver = ast_cache_get_expr(r);
+            e->call.args_num = ast_cache_get_count(r);
+            if (e->call.args_num > 0)
+            {
+                e->call.args = ast_cache_push(e->call.args_num * sizeof(expr *));
+                for (size_t i = 0; i < e->call.args_num; i++)
+                {
+                    e->call.args[i] = ast_cache_get_expr(r);
+                }
+            }
+        }
+        break;
+        case EXPR_FIELD:
+        {
+            e->field.expr = ast_cache_get_expr(r);
+            e->field.field_name = ast_cache_get_string(r);
+        }
+        break;
+        case EXPR_INDEX:
+        {
+            e->index.array_expr = ast_cache_get_expr(r);
+            e->index.index_expr = ast_cache_get_expr(r);
+        }
+        break;
+        case EXPR_NEW:
+        {
+            e->new_init.type = ast_cache_get_typespec(r);
+        }
+        break;
+        case EXPR_AUTO:
+        {
+            e->auto_init.type = ast_cache_get_typespec(r);
+        }
+        break;
+        case EXPR_SIZE_OF:
+        {
+            e->size_of.expr = ast_cache_get_expr(r);
+        }
+        break;
+        case EXPR_SIZE_OF_TYPE:
+        {
+            e->size_of_type.type = ast_cache_get_typespec(r);
+        }
+        break;
+        case EXPR_CAST:
+        {
+            e->cast.type = ast_cache_get_typespec(r);
+            e->cast.expr = ast_cache_get_expr(r);
+        }
+        break;
+        case EXPR_COMPOUND_LITERAL:
+        {
+            e->compound.type = ast_cache_get_typespec(r);
+            e->compound.fields_count = ast_cache_get_count(r);
+            if (e->compound.fields_count > 0)
+            {
+                e->compound.fields = ast_cache_push(e->compound.fields_count * sizeof(compound_literal_field *));
+                for (size_t i = 0; i < e->compound.fields_count; i++)
+                {
+                    bool is_new_field = false;
+                    compound_literal_field *field = ast_cache_get_ref(r, &is_new_field);
+                    if (is_new_field)
+                    {
+                        field = ast_cache_new_node(r, sizeof(compound_literal_field));
+                        field->expr = ast_cache_get_expr(r);
+                        field->field_index = (int64_t)ast_cache_get_u64(r);
+                        field->field_name = ast_cache_get_string(r);
+                    }
+                    e->compound.fields[i] = field;
+                }
+            }
+        }
+        break;
+        default:
+        {
+            r->failed = true;
+        }
+        break;
+    }
+    return e;
+}
+
+stmt_block ast_cache_get_stmt_block(ast_cache_reader *r)
+{
+    stmt_block result = {0};
+    result.stmts_count = ast_cache_get_count(r);
+    if (result.stmts_count > 0)
+    {
+        result.stmts = ast_cache_push(result.stmts_count * sizeof(stmt *));
+        for (size_t i = 0; i < result.stmts_count; i++)
+        {
+            result.stmts[i] = ast_cache_get_stmt(r);
+        }
+    }
+    return result;
+}
+
+stmt *ast_cache_get_stmt(ast_cache_reader *r)
+{
+    bool is_new = false;
+    stmt *s = ast_cache_get_ref(r, &is_new);
+    if (false == is_new)
+    {
+        return s;
+    }
+
+    s = ast_cache_new_node(r, sizeof(stmt));
+    s->kind = ast_cache_get_u32(r);
+    s->pos = ast_cache_get_pos(r);
+    switch (s->kind)
+    {
+        case STMT_RETURN:
+        {
+            s->return_stmt.ret_expr = ast_cache_get_expr(r);
+        }
+        break;
+        case STMT_BREAK:
+        case STMT_CONTINUE:
+        break;
+        case STMT_DECL:
+        {
+            s->decl_stmt.decl = ast_cache_get_decl(r);
+        }
+        break;
+        case STMT_IF_ELSE:
+        {
+            s->if_else.cond_expr = ast_cache_get_expr(r);
+            s->if_else.then_block = ast_cache_get_stmt_block(r);
+            s->if_else.else_stmt = ast_cache_get_stmt(r);
+        }
+        break;
+        case STMT_WHILE:
+        case STMT_DO_WHILE:
+        {
+            s->while_stmt.cond_expr = ast_cache_get_expr(r);
+            s->while_stmt.stmts = ast_cache_get_stmt_block(r);
+        }
+        break;
+        case STMT_FOR:
+        {
+            s->for_stmt.init_stmt = ast_cache_get_stmt(r);
+            s->for_stmt.cond_expr = ast_cache_get_expr(r);
+            s->for_stmt.next_stmt = ast_cache_get_stmt(r);
+            s->for_stmt.stmts = ast_cache_get_stmt_block(r);
+        }
+        break;
+        case STMT_ASSIGN:
+        {
+            s->assign.assigned_var_expr = ast_cache_get_expr(r);
+            s->assign.operation = ast_cache_get_u32(r);
+            s->assign.value_expr = ast_cache_get_expr(r);
+        }
+        break;
+        case STMT_SWITCH:
+        {
+            s->switch_stmt.var_expr = ast_cache_get_expr(r);
+            s->switch_stmt.cases_num = ast_cache_get_count(r);
+            if (s->switch_stmt.cases_num > 0)
+            {
+                s->switch_stmt.cases = ast_cache_push(s->switch_stmt.cases_num * sizeof(switch_case *));
+                for (size_t i = 0; i < s->switch_stmt.cases_num; i++)
+                {
+                    bool is_new_case = false;
+                    switch_case *c = ast_cache_get_ref(r, &is_new_case);
+                    if (is_new_case)
+                    {
+                        c = ast_cache_new_node(r, sizeof(switch_case));
+                        c->cond_exprs_num = ast_cache_get_count(r);
+                        if (c->cond_exprs_num > 0)
+                        {
+                            c->cond_exprs = ast_cache_push(c->cond_exprs_num * sizeof(expr *));
+                            for (size_t k = 0; k < c->cond_exprs_num; k++)
+                            {
+                                c->cond_exprs[k] = ast_cache_get_expr(r);
+                            }
+                        }
+                        c->stmts = ast_cache_get_stmt_block(r);
+                        c->is_default = ast_cache_get_u8(r);
+                        c->fallthrough = ast_cache_get_u8(r);
+                    }
+                    s->switch_stmt.cases[i] = c;
+                }
+            }
+        }
+        break;
+        case STMT_EXPR:
+        {
+            s->expr = ast_cache_get_expr(r);
+        }
+        break;
+        case STMT_BLOCK:
+        {
+            s->block = ast_cache_get_stmt_block(r);
+        }
+        break;
+        case STMT_DELETE:
+        {
+            s->delete.expr = ast_cache_get_expr(r);
+        }
+        break;
+        case STMT_INC:
+        {
+            s->inc.operand = ast_cache_get_expr(r);
+            s->inc.operator = ast_cache_get_u32(r);
+        }
+        break;
+        default:
+        {
+            r->failed = true;
+        }
+        break;
+    }
+    return s;
+}
+
+function_param ast_cache_get_param(ast_cache_reader *r)
+{
+    function_param result = {0};
+    result.name = ast_cache_get_string(r);
+    result.type = ast_cache_get_typespec(r);
+    result.pos = ast_cache_get_pos(r);
+    return result;
+}
+
+decl *ast_cache_get_decl(ast_cache_reader *r)
+{
+    bool is_new = false;
+    decl *d = ast_cache_get_ref(r, &is_new);
+    if (false == is_new)
+    {
+        return d;
+    }
+
+    d = ast_cache_new_node(r, sizeof(decl));
+    d->kind = ast_cache_get_u32(r);
+    d->pos = ast_cache_get_pos(r);
+    d->name = ast_cache_get_string(r);
+    switch (d->kind)
+    {
+        case DECL_STRUCT:
+        case DECL_UNION:
+        {
+            d->aggregate.fields_count = ast_cache_get_count(r);
+            if (d->aggregate.fields_count > 0)
+            {
+                d->aggregate.fields = ast_cache_push(d->aggregate.fields_count * sizeof(aggregate_field));
+                for (size_t i = 0; i < d->aggregate.fields_count; i++)
+                {
+                    aggregate_field *field = &d->aggregate.fields[i];
+                    field->name = ast_cache_get_string(r);
+                    field->type = ast_cache_get_typespec(r);
+                    field->pos = ast_cache_get_pos(r);
+                }
+            }
+        }
+        break;
+        case DECL_VARIABLE:
+        {
+            d->variable.type = ast_cache_get_typespec(r);
+            d->variable.expr = ast_cache_get_expr(r);
+        }
+        break;
+        case DECL_CONST:
+        {
+            d->const_decl.expr = ast_cache_get_expr(r);
+        }
+        break;
+        case DECL_FUNCTION:
+        {
+            d->function.params.param_count = (int)ast_cache_get_count(r);
+            if (d->function.params.param_count > 0)
+            {
+                d->function.params.params = ast_cache_push(d->function.params.param_count * sizeof(function_param));
+                for (int i = 0; i < d->function.params.param_count; i++)
+                {
+                    d->function.params.params[i] = ast_cache_get_param(r);
+                }
+            }
+            d->function.return_type = ast_cache_get_typespec(r);
+
+            bool is_new_receiver = false;
+            function_param *receiver = ast_cache_get_ref(r, &is_new_receiver);
+            if (is_new_receiver)
+            {
+                receiver = ast_cache_new_node(r, sizeof(function_param));
+                *receiver = ast_cache_get_param(r);
+            }
+            d->function.method_receiver = receiver;
+
+            d->function.stmts = ast_cache_get_stmt_block(r);
+            d->function.is_extern = ast_cache_get_u8(r);
+            d->function.is_inline = ast_cache_get_u8(r);
+            d->function.is_noinline = ast_cache_get_u8(r);
+            d->function.is_const = ast_cache_get_u8(r);
+        }
+        break;
+        case DECL_ENUM:
+        {
+            d->enum_decl.values_count = ast_cache_get_count(r);
+            if (d->enum_decl.values_count > 0)
+            {
+                d->enum_decl.values = ast_cache_push(d->enum_decl.values_count * sizeof(enum_value *));
+                for (size_t i = 0; i < d->enum_decl.values_count; i++)
+                {
+                    bool is_new_value = false;
+                    enum_value *val = ast_cache_get_ref(r, &is_new_value);
+                    if (is_new_value)
+                    {
+                        val = ast_cache_new_node(r, sizeof(enum_value));
+                        val->name = ast_cache_get_string(r);
+                        val->value_set = ast_cache_get_u8(r);
+                        val->value = (int64_t)ast_cache_get_u64(r);
+                        val->pos = ast_cache_get_pos(r);
+                        bool is_new_dependency = false;
+                        val->depending_on = ast_cache_get_ref(r, &is_new_dependency);
+                        r->failed |= is_new_dependency;
+                    }
+                    d->enum_decl.values[i] = val;
+                }
+            }
+        }
+        break;
+        default:
+        {
+            r->failed = true;
+        }
+        break;
+    }
+    return d;
+}
+
+// zwraca false, jeśli wpis jest nieaktualny albo uszkodzony - wtedy plik trzeba sparsować
+bool ast_cache_deserialize(char *buffer, size_t size, uint64_t source_hash,
+    const char *filename, decl ***declarations)
+{
+    ast_cache_reader r = {
+        .pos = buffer,
+        .end = buffer + size,
+        .filename = filename,
+    };
+
+    if (ast_cache_get_u32(&r) != AST_CACHE_MAGIC
+        || ast_cache_get_u32(&r) != AST_CACHE_VERSION
+        || ast_cache_get_u64(&r) != source_hash)
+    {
+        return false;
+    }
+
+    decl **loaded = null;
+    size_t count = ast_cache_get_count(&r);
+    for (size_t i = 0; i < count && false == r.failed; i++)
+    {
+        buf_push(loaded, ast_cache_get_decl(&r));
+    }
+
+    bool success = (false == r.failed && r.pos == r.end);
+    if (success)
+    {
+        for (size_t i = 0; i < buf_len(loaded); i++)
+        {
+            buf_push(*declarations, loaded[i]);
+        }
+    }
+    buf_free(loaded);
+    buf_free(r.nodes);
+    return success;
+}
+
+char *get_ast_cache_filename(const char *cache_dir, const char *filename)
+{
+    uint64_t path_hash = hash_bytes(filename, strlen(filename));
+    return xprintf("%s/ast_%016llx.bin", cache_dir, (unsigned long long)path_hash);
+}
+
+// parsuje plik albo wczytuje jego deklaracje z pamięci podręcznej, jeśli się nie zmienił
+void parse_source_with_cache(string_ref source, char *filename, const char *cache_dir, decl ***declarations)
+{
+    uint64_t source_hash = hash_bytes(source.str, source.length);
+    char *cache_filename = get_ast_cache_filename(cache_dir, filename);
+
+    if (file_exists(cache_filename))
+    {
+        // lekser przy okazji inicjalizuje słowa kluczowe, z których korzysta reszta kompilatora
+        init_keywords();
+        string_ref cached = read_file(cache_filename);
+        bool loaded = cached.str
+            && ast_cache_deserialize(cached.str, cached.length, source_hash, filename, declarations);
+        free(cached.str);
+        if (loaded)
+        {
+            return;
+        }
+    }
+
+    size_t errors_count = buf_len(errors);
+    size_t first_decl = buf_len(*declarations);
+    lex_and_parse(source.str, filename, declarations);
+
+    // wpis zapisujemy tylko dla poprawnego pliku - błędy parsowania muszą się pojawić znowu
+    if (buf_len(errors) == errors_count && make_directory(cache_dir))
+    {
+        char *serialized = ast_cache_serialize(*declarations + first_decl,
+            buf_len(*declarations) - first_decl, source_hash);
+        if (serialized)
+        {
+            write_file(cache_filename, serialized, buf_len(serialized));
+        }
+        buf_free(serialized);
+    }
+}
+
+// obraz deklaracji z prelude (include/common.wil) trzymany przez cały czas działania procesu
+// nie jest alokowany w arenie, więc przetrwa clear_memory - kolejne kompilacje w tym samym
+// procesie (emscripten, testy) odtwarzają z niego deklaracje i tablicę internowanych nazw
+char *prelude_image;
+
+void parse_prelude_with_image(string_ref source, char *filename, decl ***declarations)
+{
+    uint64_t source_hash = hash_bytes(source.str, source.length);
+    if (prelude_image)
+    {
+        init_keywords();
+        if (ast_cache_deserialize(prelude_image, buf_len(prelude_image), source_hash, filename, declarations))
+        {
+            return;
+        }
+        buf_free(prelude_image);
+    }
+
+    size_t errors_count = buf_len(errors);
+    size_t first_decl = buf_len(*declarations);
+    if (ast_cache_enabled)
+    {
+        parse_source_with_cache(source, filename, ast_cache_dir, declarations);
+    }
+    else
+    {
+        lex_and_parse(source.str, filename, declarations);
+    }
+
+    if (buf_len(errors) == errors_count)
+    {
+        prelude_image = ast_cache_serialize(*declarations + first_decl,
+            buf_len(*declarations) - first_decl, source_hash);
+    }
+}
@@ -536,6 +536,20 @@ void ast_print_decl(decl *d)
                 ast_printf("extern ");
             }
 
+            if (d->function.is_inline)
+            {
+                ast_printf("inline ");
+            }
+            else if (d->function.is_noinline)
+            {
+                ast_printf("noinline ");
+            }
+
+            if (d->function.is_const)
+            {
+                ast_printf("const ");
+            }
+
             if (d->name)
             {
                 ast_printf("%s", d->name);
@@ -716,6 +730,11 @@ char *get_stub_expr_name(stub_expr_kind kind)
         case STUB_EXPR_LIST_NEW: return "stub-expr-list-new";
         case STUB_EXPR_LIST_AUTO: return "stub-expr-list-auto";
         case STUB_EXPR_LIST_INDEX: return "stub-expr-list-index";
+        case STUB_EXPR_LIST_RESERVE: return "stub-expr-list-reserve";
+        case STUB_EXPR_LIST_ADD_RANGE: return "stub-expr-list-add-range";
+        case STUB_EXPR_LIST_INSERT_AT: return "stub-expr-list-insert-at";
+        case STUB_EXPR_LIST_CLEAR: return "stub-expr-list-clear";
+        case STUB_EXPR_LIST_COPY_FROM: return "stub-expr-list-copy-from";
         default: return xprintf("stub-expr unknown:%d", kind);
     }
 }
\ No newline at end of file
@@ -0,0 +1,192 @@
+// budowanie programu wykonywalnego systemowym kompilatorem C
+// pliki obiektowe trafiają do katalogu cache pod nazwami wyznaczonymi przez skrót
+// kodu i opcji kompilacji - niezmieniony program nie jest kompilowany ponownie
+
+#if _WIN32
+#define EXECUTABLE_EXT ".exe"
+#define BUILD_LINK_LIBRARIES ""
+#define popen _popen
+#define pclose _pclose
+#else
+#define EXECUTABLE_EXT ""
+// wywołania funkcji matematycznych zadeklarowanych jako extern nie zawsze są zwijane przez kompilator C
+#define BUILD_LINK_LIBRARIES " -lm"
+#include <sys/wait.h>
+#endif
+
+typedef struct build_options
+{
+    const char *compiler;
+    const char *flags;
+    const char *cache_dir;
+} build_options;
+
+uint64_t hash_combine(uint64_t a, uint64_t b)
+{
+    uint64_t result = hash_uint64(a ^ (b + 0x9e3779b97f4a7c15 + (a << 6) + (a >> 2)));
+    return result;
+}
+
+uint64_t hash_build_input(build_options *options, const char *buf, size_t len)
+{
+    uint64_t result = hash_bytes(buf, len);
+    result = hash_combine(result, hash_bytes(options->compiler, strlen(options->compiler)));
+    result = hash_combine(result, hash_bytes(options->flags, strlen(options->flags)));
+    return result;
+}
+
+uint64_t hash_file(build_options *options, char *path)
+{
+    string_ref file_buf = read_file(path);
+    uint64_t result = hash_build_input(options, file_buf.str ? file_buf.str : "", file_buf.length);
+    free(file_buf.str);
+    return result;
+}
+
+// system i pclose zwracają status procesu, a nie kod, z którym polecenie się zakończyło
+int get_build_command_exit_code(int status)
+{
+#if _WIN32
+    return status;
+#else
+    if (status != -1 && WIFEXITED(status))
+    {
+        return WEXITSTATUS(status);
+    }
+    return -1;
+#endif
+}
+
+bool run_build_command(const char *command)
+{
+    printf("%s\n", command);
+    int status = system(command);
+    if (status != 0)
+    {
+        int exit_code = get_build_command_exit_code(status);
+        error_without_pos(xprintf("Build command failed with exit code %d: %s", exit_code, command));
+        return false;
+    }
+    return true;
+}
+
+// wszystkie polecenia są uruchamiane od razu, a potem czekamy na każde z nich
+bool run_build_commands_in_parallel(char **commands)
+{
+    FILE **processes = null;
+    for (size_t i = 0; i < buf_len(commands); i++)
+    {
+        printf("%s\n", commands[i]);
+        fflush(stdout);
+        buf_push(processes, popen(commands[i], "w"));
+    }
+
+    bool success = true;
+    for (size_t i = 0; i < buf_len(processes); i++)
+    {
+        int status = processes[i] ? pclose(processes[i]) : -1;
+        if (status != 0)
+        {
+            int exit_code = get_build_command_exit_code(status);
+            error_without_pos(xprintf("Build command failed with exit code %d: %s", exit_code, commands[i]));
+            success = false;
+        }
+    }
+    buf_free(processes);
+    return success;
+}
+
+// zwraca ścieżkę pliku obiektowego w cache; jeśli go tam nie ma, dodaje polecenie kompilacji
+char *get_cached_object(build_options *options, const char *name, char *source_path, uint64_t hash, char ***commands)
+{
+    char *object_path = xprintf("%s/%s_%016llx.o", options->cache_dir, name, (unsigned long long)hash);
+    if (false == file_exists(object_path))
+    {
+        char *command = xprintf("%s %s -c \"%s\" -o \"%s\"",
+            options->compiler, options->flags, source_path, object_path);
+        buf_push(*commands, command);
+    }
+    return object_path;
+}
+
+// przy podziale kodu na kilka plików .c wszystkie dołączają ten sam nagłówek,
+// więc jego skrót wchodzi w skład skrótu każdego z nich
+bool build_executable(build_options *options, char **c_source_paths, char *c_header_path,
+    char *native_object_path, char *executable_path)
+{
+    if (false == make_directory(options->cache_dir))
+    {
+        error_without_pos(xprintf("Could not create the build cache directory '%s'", options->cache_dir));
+        return false;
+    }
+
+    // środowisko uruchomieniowe jest kompilowane raz dla danych opcji
+    uint64_t runtime_hash = hash_combine(
+        hash_file(options, "include/common.h"),
+        hash_file(options, "include/common.c"));
+    char **commands = null;
+    char **objects = null;
+    buf_push(objects, get_cached_object(options, "runtime", "include/common.c", runtime_hash, &commands));
+
+    uint64_t header_hash = c_header_path ? hash_file(options, c_header_path) : 0;
+    uint64_t link_hash = runtime_hash;
+    for (size_t i = 0; i < buf_len(c_source_paths); i++)
+    {
+        uint64_t program_hash = hash_combine(hash_file(options, c_source_paths[i]), header_hash);
+        char *name = (buf_len(c_source_paths) == 1) ? "program" : xprintf("program_%zu", i);
+        buf_push(objects, get_cached_object(options, name, c_source_paths[i], program_hash, &commands));
+        link_hash = hash_combine(link_hash, program_hash);
+    }
+
+    bool compiled = run_build_commands_in_parallel(commands);
+    buf_free(commands);
+    if (false == compiled)
+    {
+        buf_free(objects);
+        return false;
+    }
+
+    if (native_object_path)
+    {
+        link_hash = hash_combine(link_hash, hash_file(options, native_object_path));
+    }
+
+    // plik z skrótem zapisany obok programu pozwala pominąć konsolidację
+    char *stamp_path = xprintf("%s.hash", executable_path);
+    char *stamp = xprintf("%016llx", (unsigned long long)link_hash);
+    if (file_exists(executable_path) && file_exists(stamp_path))
+    {
+        string_ref previous_stamp = read_file(stamp_path);
+        bool up_to_date = (previous_stamp.str && 0 == strcmp(previous_stamp.str, stamp));
+        free(previous_stamp.str);
+        if (up_to_date)
+        {
+            printf("'%s' is up to date\n", executable_path);
+            buf_free(objects);
+            return true;
+        }
+    }
+
+    if (native_object_path)
+    {
+        buf_push(objects, native_object_path);
+    }
+
+    char *command = null;
+    buf_printf(command, "%s %s", options->compiler, options->flags);
+    for (size_t i = 0; i < buf_len(objects); i++)
+    {
+        buf_printf(command, " \"%s\"", objects[i]);
+    }
+    buf_printf(command, " -o \"%s\"%s", executable_path, BUILD_LINK_LIBRARIES);
+    bool linked = run_build_command(command);
+    buf_free(command);
+    buf_free(objects);
+    if (false == linked)
+    {
+        return false;
+    }
+
+    write_file(stamp_path, stamp, strlen(stamp));
+    return true;
+}
@@ -1,4 +1,10 @@
 ﻿bool generate_line_hints = true;
+bool generate_bounds_checks = true;
+bool generate_from_ir = true;
+bool print_ir = false;
+bool generate_native_code = false;
+bool generate_separate_runtime = false;
+size_t generate_split_units = 0; // 0 i 1 oznaczają jeden plik .c
 
 int gen_indent;
 
@@ -374,7 +380,14 @@ void gen_simple_stmt(stmt *stmt)
         break;
         case STMT_DELETE:
         {
-            if (stmt->delete.expr->kind == EXPR_STUB)
+            if (stmt->delete.target_on_stack)
+            {
+                // obiekt na stosie zostanie zwolniony razem z ramką funkcji
+                gen_printf("(void)(");
+                gen_expr(stmt->delete.expr);
+                gen_printf(")");
+            }
+            else if (stmt->delete.expr->kind == EXPR_STUB)
             {
                 gen_expr_stub(stmt->delete.expr);
             }
@@ -525,6 +538,83 @@ void gen_stmt(stmt *stmt)
     }
 }
 
+// typy elementów list, dla których generujemy wyspecjalizowane funkcje
+type **gen_list_element_types = null;
+const char **gen_list_element_cdecls = null;
+
+size_t get_list_helpers_index(type *element_type)
+{
+    const char *cdecl = type_to_cdecl(element_type, null);
+    for (size_t i = 0; i < buf_len(gen_list_element_cdecls); i++)
+    {
+        if (0 == strcmp(gen_list_element_cdecls[i], cdecl))
+        {
+            return i;
+        }
+    }
+
+    buf_push(gen_list_element_types, element_type);
+    buf_push(gen_list_element_cdecls, cdecl);
+    return buf_len(gen_list_element_types) - 1;
+}
+
+void gen_list_helpers_forward_decls(void)
+{
+    for (size_t i = 0; i < buf_len(gen_list_element_types); i++)
+    {
+        type *element_type = gen_list_element_types[i];
+        gen_printf_newline("static void ___list_grow_%zu___(___list_hdr___ *hdr, size_t new_length);", i);
+        gen_printf_newline("static inline void ___list_add_%zu___(___list_hdr___ *hdr, %s);",
+            i, type_to_cdecl(element_type, "element"));
+        gen_printf_newline("static inline void ___list_reserve_%zu___(___list_hdr___ *hdr, size_t capacity);", i);
+        gen_printf_newline("static inline void ___list_insert_at_%zu___(___list_hdr___ *hdr, size_t index, %s);",
+            i, type_to_cdecl(element_type, "element"));
+    }
+}
+
+void gen_list_helpers(void)
+{
+    for (size_t i = 0; i < buf_len(gen_list_element_types); i++)
+    {
+        type *element_type = gen_list_element_types[i];
+        const char *size_str = xprintf("sizeof(%s)", gen_list_element_cdecls[i]);
+        const char *ptr_str = type_to_cdecl(get_pointer_type(element_type), null);
+
+        gen_printf("\n");
+        gen_printf_newline("static void ___list_grow_%zu___(___list_hdr___ *hdr, size_t new_length) {", i);
+        gen_printf_newline("  size_t new_capacity = max(1 + 2 * hdr->capacity, new_length);");
+        gen_printf_newline("  if (hdr->is_managed) {");
+        gen_printf_newline("    hdr->buffer = ___managed_realloc___(hdr->buffer, new_capacity * %s);", size_str);
+        gen_printf_newline("  } else {");
+        gen_printf_newline("    hdr->buffer = ___realloc___(hdr->buffer, new_capacity * %s);", size_str);
+        gen_printf_newline("  }");
+        gen_printf_newline("  hdr->capacity = new_capacity;");
+        gen_printf_newline("}");
+
+        gen_printf("\n");
+        gen_printf_newline("static inline void ___list_add_%zu___(___list_hdr___ *hdr, %s) {",
+            i, type_to_cdecl(element_type, "element"));
+        gen_printf_newline("  if (false == ___likely___(hdr->length < hdr->capacity)) {");
+        gen_printf_newline("    ___list_grow_%zu___(hdr, hdr->length + 1);", i);
+        gen_printf_newline("  }");
+        gen_printf_newline("  ((%s)hdr->buffer)[hdr->length++] = element;", ptr_str);
+        gen_printf_newline("}");
+
+        gen_printf("\n");
+        gen_printf_newline("static inline void ___list_reserve_%zu___(___list_hdr___ *hdr, size_t capacity) {", i);
+        gen_printf_newline("  if (hdr->capacity < capacity) {");
+        gen_printf_newline("    ___list_reserve___(hdr, capacity, %s);", size_str);
+        gen_printf_newline("  }");
+        gen_printf_newline("}");
+
+        gen_printf("\n");
+        gen_printf_newline("static inline void ___list_insert_at_%zu___(___list_hdr___ *hdr, size_t index, %s) {",
+            i, type_to_cdecl(element_type, "element"));
+        gen_printf_newline("  ___list_insert_at___(hdr, index, &element, %s);", size_str);
+        gen_printf_newline("}");
+    }
+}
+
 void gen_expr_stub(expr *exp)
 {
     assert(exp->kind == EXPR_STUB);
@@ -576,7 +666,14 @@ void gen_expr_stub(expr *exp)
         break;
         case STUB_EXPR_LIST_REMOVE_AT:
         {
-            fatal("not implemented");
+            assert(orig_exp->call.args_num == 1);
+            assert(receiver->resolved_type->kind == TYPE_LIST);
+            type *base_type = receiver->resolved_type->list.base_type;
+            gen_printf("___list_remove_at_ordered___(");
+            gen_expr(receiver);
+            gen_printf(", sizeof(%s), (size_t)(", type_to_cdecl(base_type, null));
+            gen_expr(orig_exp->call.args[0]);
+            gen_printf("))");
         }
         break;
         case STUB_EXPR_LIST_FREE:
@@ -609,26 +706,100 @@ void gen_expr_stub(expr *exp)
         case STUB_EXPR_LIST_INDEX:
         {
             assert(orig_exp->kind == EXPR_INDEX);
-            gen_expr(orig_exp->index.array_expr);
-            gen_printf("->buffer[");
-            gen_expr(orig_exp->index.index_expr);
-            gen_printf("]");
+            type *list_type = orig_exp->index.array_expr->resolved_type;
+            assert(list_type && list_type->kind == TYPE_LIST);
+            type *ptr_type = get_pointer_type(list_type->list.base_type);
+            if (generate_bounds_checks && false == orig_exp->index.is_in_bounds)
+            {
+                gen_printf("(*(%s)___list_checked_element___(", type_to_cdecl(ptr_type, null));
+                gen_expr(orig_exp->index.array_expr);
+                gen_printf(", (size_t)(");
+                gen_expr(orig_exp->index.index_expr);
+                gen_printf("), sizeof(%s)))", type_to_cdecl(list_type->list.base_type, null));
+            }
+            else
+            {
+                gen_printf("((%s)", type_to_cdecl(ptr_type, null));
+                gen_expr(orig_exp->index.array_expr);
+                gen_printf("->buffer)[");
+                gen_expr(orig_exp->index.index_expr);
+                gen_printf("]");
+            }
         }
         break;
         case STUB_EXPR_LIST_ADD:
         {
             assert(orig_exp->call.args_num == 1);
-            gen_printf("___list_add___(");
+            assert(receiver->resolved_type->kind == TYPE_LIST);
+            size_t helpers_index = get_list_helpers_index(receiver->resolved_type->list.base_type);
+            gen_printf("___list_add_%zu___(", helpers_index);
             gen_expr(receiver);
             gen_printf(", (");
             gen_expr(orig_exp->call.args[0]);
-            gen_printf("), ");
+            gen_printf("))");
+        }
+        break;
+        case STUB_EXPR_LIST_RESERVE:
+        {
+            assert(orig_exp->call.args_num == 1);
+            assert(receiver->resolved_type->kind == TYPE_LIST);
+            size_t helpers_index = get_list_helpers_index(receiver->resolved_type->list.base_type);
+            gen_printf("___list_reserve_%zu___(", helpers_index);
+            gen_expr(receiver);
+            gen_printf(", (size_t)(");
+            gen_expr(orig_exp->call.args[0]);
+            gen_printf("))");
+        }
+        break;
+        case STUB_EXPR_LIST_ADD_RANGE:
+        {
+            assert(orig_exp->call.args_num == 2);
             assert(receiver->resolved_type->kind == TYPE_LIST);
             type *base_type = receiver->resolved_type->list.base_type;
-            char *type_str = type_to_cdecl(base_type, null);
-            gen_printf("%s)", type_str);
+            gen_printf("___list_add_range___(");
+            gen_expr(receiver);
+            gen_printf(", (");
+            gen_expr(orig_exp->call.args[0]);
+            gen_printf("), (size_t)(");
+            gen_expr(orig_exp->call.args[1]);
+            gen_printf("), sizeof(%s))", type_to_cdecl(base_type, null));
         }
-        break;        
+        break;
+        case STUB_EXPR_LIST_INSERT_AT:
+        {
+            assert(orig_exp->call.args_num == 2);
+            assert(receiver->resolved_type->kind == TYPE_LIST);
+            size_t helpers_index = get_list_helpers_index(receiver->resolved_type->list.base_type);
+            gen_printf("___list_insert_at_%zu___(", helpers_index);
+            gen_expr(receiver);
+            gen_printf(", (size_t)(");
+            gen_expr(orig_exp->call.args[0]);
+            gen_printf("), (");
+            gen_expr(orig_exp->call.args[1]);
+            gen_printf("))");
+        }
+        break;
+        case STUB_EXPR_LIST_CLEAR:
+        {
+            assert(receiver->resolved_type->kind == TYPE_LIST);
+            type *base_type = receiver->resolved_type->list.base_type;
+            gen_printf("___list_clear___(");
+            gen_expr(receiver);
+            gen_printf(", sizeof(%s))", type_to_cdecl(base_type, null));
+        }
+        break;
+        case STUB_EXPR_LIST_COPY_FROM:
+        {
+            assert(orig_exp->call.args_num == 1);
+            assert(receiver->resolved_type->kind == TYPE_LIST);
+            type *base_type = receiver->resolved_type->list.base_type;
+            gen_printf("___list_copy_from___(");
+            gen_expr(receiver);
+            gen_printf(", ");
+            gen_expr(orig_exp->call.args[0]);
+            gen_printf(", sizeof(%s))", type_to_cdecl(base_type, null));
+        }
+        break;
         invalid_default_case;
     }
 }
@@ -819,7 +990,17 @@ void gen_expr(expr *e)
             gen_printf(")");
 
             gen_printf("[");
-            gen_expr(e->index.index_expr);
+            if (generate_bounds_checks && t->kind == TYPE_ARRAY && false == e->index.is_in_bounds)
+            {
+                // wskaźniki nie mają znanego rozmiaru, więc sprawdzamy tylko tablice
+                gen_printf("___checked_index___((size_t)(");
+                gen_expr(e->index.index_expr);
+                gen_printf("), %zu)", t->array.size);
+            }
+            else
+            {
+                gen_expr(e->index.index_expr);
+            }
             gen_printf("]");
         }
         break;
@@ -892,7 +1073,13 @@ void gen_expr(expr *e)
         case EXPR_NEW: 
         {
             assert(e->new_init.type->kind != TYPESPEC_LIST);
-            if (e->new_init.type->kind == TYPESPEC_ARRAY)
+            if (e->new_init.on_stack)
+            {
+                // literał złożony ma automatyczny czas życia aż do końca bloku
+                char *type_str = typespec_to_cdecl(e->new_init.type, null);
+                gen_printf("&(%s){0}", type_str);
+            }
+            else if (e->new_init.type->kind == TYPESPEC_ARRAY)
             {
                 assert(e->new_init.type->array.size_expr);
                 char *type_str = typespec_to_cdecl(e->new_init.type, null);
@@ -909,7 +1096,12 @@ void gen_expr(expr *e)
         break;
         case EXPR_AUTO: 
         {
-            if (e->auto_init.type->kind == TYPESPEC_ARRAY)
+            if (e->auto_init.on_stack)
+            {
+                char *type_str = typespec_to_cdecl(e->auto_init.type, null);
+                gen_printf("&(%s){0}", type_str);
+            }
+            else if (e->auto_init.type->kind == TYPESPEC_ARRAY)
             {
                 assert(e->auto_init.type->array.size_expr);
                 char *type_str = typespec_to_cdecl(e->auto_init.type, null);
@@ -943,19 +1135,124 @@ void gen_aggregate_decl(symbol *sym)
     gen_printf_newline("");
 }
 
-void gen_var_decl(decl *decl, symbol *sym)
+void gen_folded_value(type *t, char *val)
+{
+    switch (t->kind)
+    {
+        case TYPE_CHAR:
+        {
+            gen_printf("%u", *(uint8_t *)val);
+        }
+        break;
+        case TYPE_INT:
+        {
+            gen_printf("%d", *(int32_t *)val);
+        }
+        break;
+        case TYPE_UINT:
+        {
+            gen_printf("%uu", *(uint32_t *)val);
+        }
+        break;
+        case TYPE_LONG:
+        case TYPE_ENUM:
+        {
+            int64_t value = *(int64_t *)val;
+            if (value == INT64_MIN)
+            {
+                gen_printf("(-9223372036854775807LL - 1)");
+            }
+            else
+            {
+                gen_printf("%lldLL", (long long)value);
+            }
+        }
+        break;
+        case TYPE_ULONG:
+        {
+            gen_printf("%lluULL", (unsigned long long)*(uint64_t *)val);
+        }
+        break;
+        case TYPE_FLOAT:
+        {
+            float value = *(float *)val;
+            if (isnan(value))
+            {
+                gen_printf("(0.0f / 0.0f)");
+            }
+            else if (isinf(value))
+            {
+                gen_printf(value > 0 ? "(1.0f / 0.0f)" : "(-1.0f / 0.0f)");
+            }
+            else
+            {
+                // zapis szesnastkowy nie traci precyzji
+                gen_printf("%af", value);
+            }
+        }
+        break;
+        case TYPE_BOOL:
+        {
+            gen_printf("%s", *(uint32_t *)val ? "true" : "false");
+        }
+        break;
+        case TYPE_STRUCT:
+        {
+            gen_printf("{ ");
+            for (size_t i = 0; i < t->aggregate.fields_count; i++)
+            {
+                type_aggregate_field *field = t->aggregate.fields[i];
+                if (i != 0)
+                {
+                    gen_printf(", ");
+                }
+                gen_folded_value(field->type, val + field->offset);
+            }
+            gen_printf(" }");
+        }
+        break;
+        case TYPE_ARRAY:
+        {
+            size_t element_size = get_type_size(t->array.base_type);
+            gen_printf("{ ");
+            for (size_t i = 0; i < t->array.size; i++)
+            {
+                if (i != 0)
+                {
+                    gen_printf(", ");
+                }
+                gen_folded_value(t->array.base_type, val + i * element_size);
+            }
+            gen_printf(" }");
+        }
+        break;
+        default:
+        {
+            fatal("value of this type cannot be computed at compile time");
+        }
+        break;
+    }
+}
+
+char *get_var_cdecl(decl *decl, symbol *sym)
 {
     assert(decl->kind == DECL_VARIABLE);
- 
     if (decl->variable.type)
     {
-        gen_printf_newline("%s", typespec_to_cdecl(decl->variable.type, sym->name));
+        return typespec_to_cdecl(decl->variable.type, sym->name);
     }
-    else
+    return type_to_cdecl(sym->type, sym->name);
+}
+
+void gen_var_decl(decl *decl, symbol *sym)
+{
+    gen_printf_newline("%s", get_var_cdecl(decl, sym));
+    if (decl->variable.folded_value)
     {
-        gen_printf_newline("%s", type_to_cdecl(sym->type, sym->name));
+        gen_printf(" = ");
+        gen_folded_value(sym->type, decl->variable.folded_value);
     }
-    if (decl->variable.expr)
+    else if (decl->variable.expr)
     {
         gen_printf(" = ");
         gen_expr(decl->variable.expr);
@@ -1016,6 +1313,307 @@ void gen_func_decl(decl *d, const char *mangled_name)
     buf_free(result);
 }
 
+const char *gen_ir_value_name(ir_instr *instr)
+{
+    // przedrostek wyklucza konflikt z nazwami zmiennych z kodu źródłowego
+    const char *result = xprintf("___v%zu", instr->id);
+    return result;
+}
+
+void gen_ir_value(ir_function *f, ir_instr *instr)
+{
+    instr = ir_resolve(instr);
+    switch (instr->opcode)
+    {
+        case IR_CONST:
+        {
+            if (instr->type->kind == TYPE_POINTER || instr->type->kind == TYPE_NULL)
+            {
+                gen_printf("0");
+            }
+            else
+            {
+                gen_folded_value(instr->type, (char *)&instr->int_value);
+            }
+        }
+        break;
+        case IR_PARAM:
+        {
+            // parametry nie są nigdy nadpisywane w wygenerowanym kodzie
+            gen_printf("%s", f->symbol->decl->function.params.params[instr->param_index].name);
+        }
+        break;
+        default:
+        {
+            gen_printf("%s", gen_ir_value_name(instr));
+        }
+        break;
+    }
+}
+
+void gen_ir_phi_copies(ir_function *f, ir_block *from, ir_block *to)
+{
+    size_t pred_index = 0;
+    while (to->preds[pred_index] != from)
+    {
+        pred_index++;
+    }
+
+    for (size_t i = 0; i < buf_len(to->instrs); i++)
+    {
+        ir_instr *phi = to->instrs[i];
+        if (phi->opcode != IR_PHI)
+        {
+            break;
+        }
+        gen_printf_newline("%s_in = ", gen_ir_value_name(phi));
+        gen_ir_value(f, phi->operands[pred_index]);
+        gen_printf(";");
+    }
+}
+
+void gen_ir_instr(ir_function *f, ir_instr *instr)
+{
+    if (instr->pos.filename)
+    {
+        gen_line_hint(instr->pos);
+    }
+
+    if (instr->type && instr->opcode != IR_PARAM)
+    {
+        gen_printf_newline("%s = ", gen_ir_value_name(instr));
+    }
+
+    switch (instr->opcode)
+    {
+        case IR_PARAM:
+        {
+        }
+        break;
+        case IR_PHI:
+        {
+            gen_printf("%s_in;", gen_ir_value_name(instr));
+        }
+        break;
+        case IR_UNARY:
+        {
+            gen_printf("%s(", get_token_kind_name(instr->operator));
+            gen_ir_value(f, instr->operands[0]);
+            gen_printf(");");
+        }
+        break;
+        case IR_BINARY:
+        {
+            gen_ir_value(f, instr->operands[0]);
+            gen_printf(" %s ", get_token_kind_name(instr->operator));
+            gen_ir_value(f, instr->operands[1]);
+            gen_printf(";");
+        }
+        break;
+        case IR_CAST:
+        {
+            gen_printf("(%s)(", type_to_cdecl(instr->type, null));
+            gen_ir_value(f, instr->operands[0]);
+            gen_printf(");");
+        }
+        break;
+        case IR_LOAD_GLOBAL:
+        {
+            gen_printf("%s;", instr->global->name);
+        }
+        break;
+        case IR_STORE_GLOBAL:
+        {
+            gen_printf_newline("%s = ", instr->global->name);
+            gen_ir_value(f, instr->operands[0]);
+            gen_printf(";");
+        }
+        break;
+        case IR_CALL:
+        {
+            if (instr->type == null)
+            {
+                gen_printf_newline("");
+            }
+            gen_printf("%s(", instr->function->mangled_name);
+            for (size_t i = 0; i < buf_len(instr->operands); i++)
+            {
+                if (i != 0)
+                {
+                    gen_printf(", ");
+                }
+                gen_ir_value(f, instr->operands[i]);
+            }
+            gen_printf(");");
+        }
+        break;
+        case IR_JUMP:
+        {
+            gen_ir_phi_copies(f, instr->block, instr->targets[0]);
+            gen_printf_newline("goto ___b%zu;", instr->targets[0]->id);
+        }
+        break;
+        case IR_BRANCH:
+        {
+            gen_printf_newline("if (");
+            gen_ir_value(f, instr->operands[0]);
+            gen_printf(") {");
+            gen_indent++;
+            gen_ir_phi_copies(f, instr->block, instr->targets[0]);
+            gen_printf_newline("goto ___b%zu;", instr->targets[0]->id);
+            gen_indent--;
+            gen_printf_newline("} else {");
+            gen_indent++;
+            gen_ir_phi_copies(f, instr->block, instr->targets[1]);
+            gen_printf_newline("goto ___b%zu;", instr->targets[1]->id);
+            gen_indent--;
+            gen_printf_newline("}");
+        }
+        break;
+        case IR_RETURN:
+        {
+            if (buf_len(instr->operands) > 0)
+            {
+                gen_printf_newline("return ");
+                gen_ir_value(f, instr->operands[0]);
+                gen_printf(";");
+            }
+            else
+            {
+                gen_printf_newline("return;");
+            }
+        }
+        break;
+        invalid_default_case;
+    }
+}
+
+void gen_ir_function_body(ir_function *f)
+{
+    gen_printf("{");
+    gen_indent++;
+
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        ir_block *block = f->blocks[i];
+        for (size_t k = 0; k < buf_len(block->instrs); k++)
+        {
+            ir_instr *instr = block->instrs[k];
+            if (instr->type == null || instr->opcode == IR_PARAM)
+            {
+                continue;
+            }
+
+            gen_printf_newline("%s;", type_to_cdecl(instr->type, (char *)gen_ir_value_name(instr)));
+            if (instr->opcode == IR_PHI)
+            {
+                gen_printf_newline("%s;", type_to_cdecl(instr->type, xprintf("%s_in", gen_ir_value_name(instr))));
+            }
+        }
+    }
+
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        ir_block *block = f->blocks[i];
+        if (buf_len(block->preds) > 0)
+        {
+            gen_indent--;
+            gen_printf_newline("___b%zu:;", block->id);
+            gen_indent++;
+        }
+
+        for (size_t k = 0; k < buf_len(block->instrs); k++)
+        {
+            gen_ir_instr(f, block->instrs[k]);
+        }
+    }
+
+    gen_indent--;
+    gen_printf_newline("}");
+}
+
+void build_ir_functions(symbol **resolved)
+{
+    map_grow(&ir_functions, 64);
+    for (size_t i = 0; i < buf_len(resolved); i++)
+    {
+        symbol *sym = resolved[i];
+        if (sym->kind != SYMBOL_FUNCTION || sym->decl == null)
+        {
+            continue;
+        }
+
+        ir_function *f = build_ir_function(sym);
+        if (f)
+        {
+            run_ir_passes(f);
+            map_put(&ir_functions, sym, f);
+
+            if (print_ir)
+            {
+                char *ir_str = print_ir_function(f);
+                printf("%s", ir_str);
+                buf_free(ir_str);
+            }
+        }
+    }
+}
+
+void free_ir_functions(void)
+{
+    for (size_t i = 0; i < ir_functions.capacity; i++)
+    {
+        if (ir_functions.keys[i])
+        {
+            free_ir_function(ir_functions.values[i]);
+        }
+    }
+    map_free(&ir_functions);
+}
+
+// zamienia rozszerzenie .c pliku wyjściowego na podane
+char *get_output_filename_with_extension(char *output_filename, const char *extension)
+{
+    char *result = null;
+    size_t len = strlen(output_filename);
+    if (len > 2 && 0 == strcmp(output_filename + len - 2, ".c"))
+    {
+        result = xprintf("%.*s%s", (int)(len - 2), output_filename, extension);
+    }
+    else
+    {
+        result = xprintf("%s%s", output_filename, extension);
+    }
+    return result;
+}
+
+char *get_native_object_filename(char *output_filename)
+{
+    return get_output_filename_with_extension(output_filename, ".o");
+}
+
+// funkcje przetłumaczone na kod maszynowy trafiają do osobnego pliku obiektowego,
+// a w kodzie C zostają po nich tylko deklaracje
+void gen_native_object(symbol **resolved, char *output_filename)
+{
+    x64_object obj = {0};
+    x64_compile_functions(&obj, resolved);
+
+    if (output_filename)
+    {
+        char *elf = write_elf_object(&obj);
+        write_file(get_native_object_filename(output_filename), elf, buf_len(elf));
+        buf_free(elf);
+    }
+
+    free_x64_object(&obj);
+}
+
+void free_native_functions(void)
+{
+    map_free(&native_functions);
+}
+
 void gen_forward_decls(symbol **resolved)
 {
     for (size_t i = 0; i < buf_len(resolved); i++)
@@ -1092,7 +1690,8 @@ void gen_symbol_decl(symbol *sym)
             else
             {            
                 char *decl_str = type_to_cdecl(sym->type, sym->name);
-                gen_printf_newline(decl_str);                
+                // przy podziale na kilka plików stałe trafiają do wspólnego nagłówka
+                gen_printf_newline("%s%s", generate_split_units > 1 ? "static " : "", decl_str);
                 gen_printf(" = ");
                 gen_expr(decl->const_decl.expr);
                 gen_printf(";");
@@ -1101,11 +1700,21 @@ void gen_symbol_decl(symbol *sym)
         break;
         case DECL_FUNCTION:
         {
-            if (decl->function.is_extern == false)
+            if (decl->function.is_extern == false
+                && (native_functions.capacity == 0 || null == map_get(&native_functions, sym)))
             {
                 gen_func_decl(decl, sym->mangled_name);
                 gen_printf(" ");
-                gen_stmt_block(decl->function.stmts);
+
+                ir_function *f = (ir_functions.capacity > 0) ? map_get(&ir_functions, sym) : null;
+                if (f)
+                {
+                    gen_ir_function_body(f);
+                }
+                else
+                {
+                    gen_stmt_block(decl->function.stmts);
+                }
                 gen_printf(";");
             }
         }
@@ -1144,9 +1753,9 @@ void gen_entry_point(symbol **resolved)
     buf_push(buf, s);\n\
   }\n\
   ___gc_init___();\n\
-  ___main___0l___0s___0v(buf);\n\
+  %s(buf);\n\
   buf_free(buf);\n\
-}\n");
+}\n", main_function->mangled_name);
 
     }
     else if (main_function->mangled_name == mangled_main_void_str)
@@ -1154,8 +1763,8 @@ void gen_entry_point(symbol **resolved)
         gen_printf(
 "\nint main(int argc, char **argv) {\n\
   ___gc_init___();\n\
-  ___main___0v();\n\
-}\n");
+  %s();\n\
+}\n", main_function->mangled_name);
     }
     else
     {
@@ -1165,16 +1774,180 @@ void gen_entry_point(symbol **resolved)
 
 void gen_common_includes(void)
 {
-    char *common_include_file = "include/common.c";
-    string_ref file_buf = read_file(common_include_file);
-    gen_printf(file_buf.str);
+    string_ref header_buf = read_file("include/common.h");
+    gen_printf("%s", header_buf.str);
+    free(header_buf.str);
+
+    // przy budowaniu środowisko uruchomieniowe jest kompilowane osobno
+    if (false == generate_separate_runtime)
+    {
+        string_ref file_buf = read_file("include/common.c");
+        char *runtime = strstr(file_buf.str, "#include \"common.h\"");
+        assert(runtime);
+        runtime = strchr(runtime, '\n');
+        gen_printf("%s", runtime ? runtime : "");
+        free(file_buf.str);
+    }
 
     gen_printf(
 "#undef offsetof\n\
 #undef NULL\n\
 #define char unsigned char\n");
+}
 
-    free(file_buf.str);
+char *get_split_header_filename(char *output_filename)
+{
+    return get_output_filename_with_extension(output_filename, ".h");
+}
+
+char *get_split_unit_filename(char *output_filename, size_t unit_index)
+{
+    return get_output_filename_with_extension(output_filename, xprintf("_%zu.c", unit_index));
+}
+
+char *get_split_manifest_filename(char *output_filename)
+{
+    return get_output_filename_with_extension(output_filename, ".manifest");
+}
+
+// podział kodu na kilka plików .c ze wspólnym nagłówkiem, które kompilator C może
+// przetwarzać równolegle - w nagłówku są typy, stałe, prototypy i deklaracje zmiennych
+// globalnych, a funkcje są rozdzielane tak, żeby pliki miały zbliżony rozmiar
+void gen_split_units(symbol **resolved, char *decls_buf, char *output_filename, bool print_to_console)
+{
+    assert(generate_split_units > 1);
+    assert(generate_separate_runtime);
+
+    for (size_t i = 0; i < buf_len(resolved); i++)
+    {
+        symbol *sym = resolved[i];
+        if (sym->decl == null)
+        {
+            continue;
+        }
+
+        switch (sym->decl->kind)
+        {
+            case DECL_STRUCT:
+            case DECL_UNION:
+            case DECL_CONST:
+            {
+                gen_symbol_decl(sym);
+            }
+            break;
+            case DECL_VARIABLE:
+            {
+                gen_printf("\n");
+                gen_line_hint(sym->decl->pos);
+                gen_printf_newline("extern %s;", get_var_cdecl(sym->decl, sym));
+            }
+            break;
+            default:
+            {
+                // funkcje trafiają do plików .c, a enumy nie mają odpowiednika w C
+            }
+            break;
+        }
+    }
+    char *types_buf = gen_buf;
+    gen_buf = null;
+
+    char **units = null;
+    for (size_t i = 0; i < generate_split_units; i++)
+    {
+        buf_push(units, null);
+    }
+
+    // pierwszy plik zawiera punkt wejścia i definicje zmiennych globalnych
+    gen_pos = (source_pos){0};
+    gen_entry_point(resolved);
+    for (size_t i = 0; i < buf_len(resolved); i++)
+    {
+        if (resolved[i]->decl && resolved[i]->decl->kind == DECL_VARIABLE)
+        {
+            gen_symbol_decl(resolved[i]);
+        }
+    }
+    units[0] = gen_buf;
+
+    for (size_t i = 0; i < buf_len(resolved); i++)
+    {
+        symbol *sym = resolved[i];
+        if (sym->decl == null || sym->decl->kind != DECL_FUNCTION)
+        {
+            continue;
+        }
+
+        size_t smallest = 0;
+        for (size_t k = 1; k < generate_split_units; k++)
+        {
+            if (buf_len(units[k]) < buf_len(units[smallest]))
+            {
+                smallest = k;
+            }
+        }
+
+        // każdy plik zaczyna się bez wcześniejszej informacji o pozycji
+        gen_pos = (source_pos){0};
+        gen_buf = units[smallest];
+        gen_symbol_decl(sym);
+        units[smallest] = gen_buf;
+    }
+
+    gen_buf = decls_buf;
+    gen_list_helpers_forward_decls();
+    gen_printf("%s", types_buf ? types_buf : "");
+    gen_list_helpers();
+    gen_printf("\n");
+    buf_free(types_buf);
+
+    char *header_filename = output_filename ? get_split_header_filename(output_filename) : "output.h";
+    char *header_name = strrchr(header_filename, '/');
+    header_name = header_name ? header_name + 1 : header_filename;
+
+    char *manifest = null;
+    buf_printf(manifest, "include/common.c\n");
+    if (output_filename && generate_native_code && generate_from_ir)
+    {
+        buf_printf(manifest, "%s\n", get_native_object_filename(output_filename));
+    }
+
+    if (output_filename)
+    {
+        write_file(header_filename, gen_buf, buf_len(gen_buf));
+    }
+    if (print_to_console)
+    {
+        printf("// %s\n%s\n", header_filename, gen_buf);
+    }
+    buf_free(gen_buf);
+
+    for (size_t i = 0; i < generate_split_units; i++)
+    {
+        gen_buf = null;
+        gen_printf("#include \"%s\"\n%s\n", header_name, units[i] ? units[i] : "");
+        buf_free(units[i]);
+
+        if (output_filename)
+        {
+            char *unit_filename = get_split_unit_filename(output_filename, i);
+            write_file(unit_filename, gen_buf, buf_len(gen_buf));
+            buf_printf(manifest, "%s\n", unit_filename);
+        }
+        if (print_to_console)
+        {
+            printf("// unit %zu\n%s\n", i, gen_buf);
+        }
+        buf_free(gen_buf);
+    }
+    buf_free(units);
+
+    // lista plików potrzebnych do zbudowania programu, po jednym w linii
+    if (output_filename)
+    {
+        write_file(get_split_manifest_filename(output_filename), manifest, buf_len(manifest));
+    }
+    buf_free(manifest);
 }
 
 void c_gen(symbol **resolved_declarations, char *output_filename, bool print_to_console)
@@ -1186,24 +1959,71 @@ void c_gen(symbol **resolved_declarations, char *output_filename, bool print_to_
 
     gen_common_includes();
     gen_forward_decls(resolved_declarations);
-    gen_entry_point(resolved_declarations);
 
-    for (size_t i = 0; i < buf_len(resolved_declarations); i++)
+    // typy elementów list poznajemy dopiero przy generowaniu ciał funkcji,
+    // a deklaracje funkcji dla list muszą się znaleźć przed nimi
+    char *decls_buf = gen_buf;
+    gen_buf = null;
+
+    if (generate_bounds_checks)
     {
-        gen_symbol_decl(resolved_declarations[i]);
+        for (size_t i = 0; i < buf_len(resolved_declarations); i++)
+        {
+            symbol *sym = resolved_declarations[i];
+            if (sym->decl && sym->decl->kind == DECL_FUNCTION)
+            {
+                analyze_index_ranges(sym->decl);
+            }
+        }
     }
 
-    if (output_filename)
+    if (generate_from_ir)
     {
-        write_file(output_filename, gen_buf, buf_len(gen_buf));
+        build_ir_functions(resolved_declarations);
+        if (generate_native_code)
+        {
+            gen_native_object(resolved_declarations, output_filename);
+        }
     }
 
-    if (print_to_console)
+    if (generate_split_units > 1)
+    {
+        gen_split_units(resolved_declarations, decls_buf, output_filename, print_to_console);
+    }
+    else
     {
-        printf("%s\n", gen_buf);
+        gen_entry_point(resolved_declarations);
+
+        for (size_t i = 0; i < buf_len(resolved_declarations); i++)
+        {
+            gen_symbol_decl(resolved_declarations[i]);
+        }
+
+        char *body_buf = gen_buf;
+        gen_buf = decls_buf;
+
+        gen_list_helpers_forward_decls();
+        gen_printf("%s", body_buf);
+        gen_list_helpers();
+        buf_free(body_buf);
+
+        if (output_filename)
+        {
+            write_file(output_filename, gen_buf, buf_len(gen_buf));
+        }
+
+        if (print_to_console)
+        {
+            printf("%s\n", gen_buf);
+        }
+
+        buf_free(gen_buf);
     }
 
-    buf_free(gen_buf);    
+    free_ir_functions();
+    free_native_functions();
+    buf_free(gen_list_element_types);
+    buf_free(gen_list_element_cdecls);
 }
 
 const char *pretty_print_type_list(type **list)
@@ -0,0 +1,742 @@
+﻿// obliczanie wartości w czasie kompilacji - korzysta z interpretera,
+// więc musi być dołączone po treewalk.c
+
+// obliczenie, które przekroczy limit, jest zgłaszane jako błąd kompilacji
+#define MAX_COMPILE_TIME_STEPS 50000000
+
+size_t compile_time_step_limit = MAX_COMPILE_TIME_STEPS;
+bool compile_time_globals_ready;
+
+bool is_foldable_type(type *t)
+{
+    switch (t->kind)
+    {
+        case TYPE_CHAR:
+        case TYPE_INT:
+        case TYPE_LONG:
+        case TYPE_UINT:
+        case TYPE_ULONG:
+        case TYPE_FLOAT:
+        case TYPE_BOOL:
+        case TYPE_ENUM:
+        {
+            return true;
+        }
+        break;
+        case TYPE_ARRAY:
+        {
+            return is_foldable_type(t->array.base_type);
+        }
+        break;
+        case TYPE_STRUCT:
+        {
+            for (size_t i = 0; i < t->aggregate.fields_count; i++)
+            {
+                if (false == is_foldable_type(t->aggregate.fields[i]->type))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        break;
+        default:
+        {
+            // wskaźniki, listy, unie i funkcje zostają obliczane w czasie wykonania
+            return false;
+        }
+        break;
+    }
+    return false;
+}
+
+// zwraca podwyrażenie, którego nie da się obliczyć w czasie kompilacji
+// zmienne lokalne są dozwolone tylko w ciałach funkcji oznaczonych jako const
+expr *find_non_const_expr(expr *e, bool allow_locals)
+{
+    if (e == null)
+    {
+        return null;
+    }
+
+    switch (e->kind)
+    {
+        case EXPR_INT:
+        case EXPR_FLOAT:
+        case EXPR_CHAR:
+        case EXPR_BOOL:
+        case EXPR_NULL:
+        case EXPR_SIZE_OF_TYPE:
+        {
+            return null;
+        }
+        break;
+        case EXPR_NAME:
+        {
+            symbol *sym = map_get(&global_symbols, e->name);
+            if (sym == null)
+            {
+                return allow_locals ? null : e;
+            }
+            if (sym->kind == SYMBOL_CONST || sym->kind == SYMBOL_TYPE)
+            {
+                return null;
+            }
+            return e;
+        }
+        break;
+        case EXPR_UNARY:
+        {
+            if (e->unary.operator == TOKEN_ADDRESS_OF
+                || e->unary.operator == TOKEN_DEREFERENCE)
+            {
+                return e;
+            }
+            return find_non_const_expr(e->unary.operand, allow_locals);
+        }
+        break;
+        case EXPR_BINARY:
+        {
+            expr *result = find_non_const_expr(e->binary.left, allow_locals);
+            if (result == null)
+            {
+                result = find_non_const_expr(e->binary.right, allow_locals);
+            }
+            return result;
+        }
+        break;
+        case EXPR_TERNARY:
+        {
+            expr *result = find_non_const_expr(e->ternary.condition, allow_locals);
+            if (result == null)
+            {
+                result = find_non_const_expr(e->ternary.if_true, allow_locals);
+            }
+            if (result == null)
+            {
+                result = find_non_const_expr(e->ternary.if_false, allow_locals);
+            }
+            return result;
+        }
+        break;
+        case EXPR_CALL:
+        {
+            symbol *function = e->call.resolved_function;
+            if (function == null
+                || e->call.method_receiver
+                || function->decl == null
+                || false == function->decl->function.is_const)
+            {
+                return e;
+            }
+            for (size_t i = 0; i < e->call.args_num; i++)
+            {
+                expr *result = find_non_const_expr(e->call.args[i], allow_locals);
+                if (result)
+                {
+                    return result;
+                }
+            }
+            return null;
+        }
+        break;
+        case EXPR_FIELD:
+        {
+            type *t = e->field.expr->resolved_type;
+            if (t && t->kind == TYPE_POINTER)
+            {
+                return e;
+            }
+            return find_non_const_expr(e->field.expr, allow_locals);
+        }
+        break;
+        case EXPR_INDEX:
+        {
+            if (e->index.array_expr->resolved_type->kind != TYPE_ARRAY)
+            {
+                return e;
+            }
+            expr *result = find_non_const_expr(e->index.array_expr, allow_locals);
+            if (result == null)
+            {
+                result = find_non_const_expr(e->index.index_expr, allow_locals);
+            }
+            return result;
+        }
+        break;
+        case EXPR_SIZE_OF:
+        {
+            return find_non_const_expr(e->size_of.expr, allow_locals);
+        }
+        break;
+        case EXPR_CAST:
+        {
+            if (e->resolved_type->kind == TYPE_POINTER)
+            {
+                return e;
+            }
+            return find_non_const_expr(e->cast.expr, allow_locals);
+        }
+        break;
+        case EXPR_COMPOUND_LITERAL:
+        {
+            for (size_t i = 0; i < e->compound.fields_count; i++)
+            {
+                expr *result = find_non_const_expr(e->compound.fields[i]->expr, allow_locals);
+                if (result)
+                {
+                    return result;
+                }
+            }
+            return null;
+        }
+        break;
+        case EXPR_STUB:
+        {
+            if (e->stub.kind == STUB_EXPR_CAST)
+            {
+                return find_non_const_expr(e->stub.original_expr, allow_locals);
+            }
+            return e;
+        }
+        break;
+        default:
+        {
+            // new, auto, napisy
+            return e;
+        }
+        break;
+    }
+    return e;
+}
+
+void report_non_const_expr(expr *e)
+{
+    const char *message = null;
+    switch (e->kind)
+    {
+        case EXPR_CALL:
+        {
+            message = "Functions marked as const can call only other const functions";
+        }
+        break;
+        case EXPR_NAME:
+        {
+            message = xprintf("Functions marked as const cannot refer to the global '%s'", e->name);
+        }
+        break;
+        case EXPR_STRING:
+        {
+            message = "Functions marked as const cannot use string literals";
+        }
+        break;
+        case EXPR_STUB:
+        {
+            message = "Functions marked as const cannot use lists or pointer arithmetic";
+        }
+        break;
+        default:
+        {
+            message = "Functions marked as const cannot allocate memory or use pointers";
+        }
+        break;
+    }
+    error_in_resolving(message, e->pos);
+}
+
+void check_const_function_expr(expr *e)
+{
+    expr *non_const = find_non_const_expr(e, true);
+    if (non_const)
+    {
+        report_non_const_expr(non_const);
+    }
+}
+
+void check_const_function_stmt_block(stmt_block block);
+
+void check_const_function_stmt(stmt *st)
+{
+    switch (st->kind)
+    {
+        case STMT_RETURN:
+        {
+            check_const_function_expr(st->return_stmt.ret_expr);
+        }
+        break;
+        case STMT_DECL:
+        {
+            if (st->decl_stmt.decl->kind == DECL_VARIABLE)
+            {
+                check_const_function_expr(st->decl_stmt.decl->variable.expr);
+            }
+        }
+        break;
+        case STMT_IF_ELSE:
+        {
+            check_const_function_expr(st->if_else.cond_expr);
+            check_const_function_stmt_block(st->if_else.then_block);
+            if (st->if_else.else_stmt)
+            {
+                check_const_function_stmt(st->if_else.else_stmt);
+            }
+        }
+        break;
+        case STMT_WHILE:
+        case STMT_DO_WHILE:
+        {
+            check_const_function_expr(st->while_stmt.cond_expr);
+            check_const_function_stmt_block(st->while_stmt.stmts);
+        }
+        break;
+        case STMT_FOR:
+        {
+            if (st->for_stmt.init_stmt)
+            {
+                check_const_function_stmt(st->for_stmt.init_stmt);
+            }
+            check_const_function_expr(st->for_stmt.cond_expr);
+            if (st->for_stmt.next_stmt)
+            {
+                check_const_function_stmt(st->for_stmt.next_stmt);
+            }
+            check_const_function_stmt_block(st->for_stmt.stmts);
+        }
+        break;
+        case STMT_ASSIGN:
+        {
+            check_const_function_expr(st->assign.assigned_var_expr);
+            check_const_function_expr(st->assign.value_expr);
+        }
+        break;
+        case STMT_SWITCH:
+        {
+            check_const_function_expr(st->switch_stmt.var_expr);
+            for (size_t i = 0; i < st->switch_stmt.cases_num; i++)
+            {
+                check_const_function_stmt_block(st->switch_stmt.cases[i]->stmts);
+            }
+        }
+        break;
+        case STMT_EXPR:
+        {
+            check_const_function_expr(st->expr);
+        }
+        break;
+        case STMT_BLOCK:
+        {
+            check_const_function_stmt_block(st->block);
+        }
+        break;
+        case STMT_INC:
+        {
+            check_const_function_expr(st->inc.operand);
+        }
+        break;
+        case STMT_DELETE:
+        {
+            error_in_resolving("Functions marked as const cannot allocate memory or use pointers", st->pos);
+        }
+        break;
+        default:
+        {
+            // break, continue
+        }
+        break;
+    }
+}
+
+void check_const_function_stmt_block(stmt_block block)
+{
+    for (size_t i = 0; i < block.stmts_count; i++)
+    {
+        check_const_function_stmt(block.stmts[i]);
+    }
+}
+
+void check_const_function(symbol *function)
+{
+    decl *d = function->decl;
+    if (d->function.method_receiver)
+    {
+        error_in_resolving("Methods cannot be marked as const", d->pos);
+        return;
+    }
+    check_const_function_stmt_block(d->function.stmts);
+}
+
+char *evaluate_at_compile_time(expr *e, symbol **resolved)
+{
+    if (false == compile_time_globals_ready)
+    {
+        // funkcje const nie mają dostępu do zmiennych globalnych - wystarczą stałe
+        for (size_t i = 0; i < buf_len(resolved); i++)
+        {
+            symbol *sym = resolved[i];
+            if (sym->kind == SYMBOL_CONST)
+            {
+                push_global_identifier(sym->decl->pos, sym->name, (byte *)&sym->val, sizeof(sym->val));
+            }
+        }
+        compile_time_globals_ready = true;
+    }
+
+    size_t size = get_type_size(e->resolved_type);
+    char *result = push_size(arena, size);
+
+    // kod z JIT nie liczy kroków, więc wszystko wykonuje interpreter
+    bool jit_was_enabled = jit_enabled;
+    jit_enabled = false;
+
+    jmp_buf recovery;
+    jmp_buf *outer_recovery = runtime_error_recovery;
+    size_t outer_step_limit = vm_step_limit;
+    runtime_error_recovery = &recovery;
+    vm_step_limit = compile_time_step_limit;
+    vm_steps = 0;
+
+    byte *marker = enter_vm_stack_scope();
+    if (0 == setjmp(recovery))
+    {
+        byte *val = eval_expression(e);
+        copy_vm_val(result, val, size);
+        leave_vm_stack_scope(marker);
+    }
+    else
+    {
+        // wyrażenie zostaje obliczone w czasie wykonania, ale kompilacja się nie powiedzie
+        reset_vm_after_error(marker);
+        const char *message = runtime_error_pos.filename
+            ? xprintf("Compile-time evaluation failed in line %zu: %s", runtime_error_pos.line, runtime_error_message)
+            : xprintf("Compile-time evaluation failed: %s", runtime_error_message);
+        error_in_resolving(message, e->pos);
+        result = null;
+    }
+
+    runtime_error_recovery = outer_recovery;
+    vm_step_limit = outer_step_limit;
+    jit_enabled = jit_was_enabled;
+    return result;
+}
+
+bool fold_const_call(expr *e, symbol **resolved)
+{
+    assert(e->kind == EXPR_CALL);
+
+    type *t = e->resolved_type;
+    if (e->call.resolved_function == null
+        || e->call.resolved_function->decl == null
+        || false == e->call.resolved_function->decl->function.is_const
+        || false == (t == type_int || t == type_long || t == type_uint || t == type_ulong || t == type_bool)
+        || find_non_const_expr(e, false))
+    {
+        return false;
+    }
+
+    char *val = evaluate_at_compile_time(e, resolved);
+    if (val == null)
+    {
+        return false;
+    }
+
+    if (t == type_bool)
+    {
+        e->kind = EXPR_BOOL;
+        e->bool_value = (*(uint32_t *)val != 0);
+        return true;
+    }
+
+    uint64_t value = (t->size == 4) ? *(uint32_t *)val : *(uint64_t *)val;
+    int64_t signed_value = (t->size == 4) ? *(int32_t *)val : *(int64_t *)val;
+    if (is_signed_type(t) && signed_value < 0)
+    {
+        if (signed_value == INT64_MIN)
+        {
+            return false;
+        }
+
+        // literały są zawsze nieujemne - minus musi być osobnym operatorem
+        expr *operand = push_int_expr(e->pos, -signed_value);
+        operand->resolved_type = t;
+        e->kind = EXPR_UNARY;
+        e->unary.operator = TOKEN_SUB;
+        e->unary.operand = operand;
+    }
+    else
+    {
+        e->kind = EXPR_INT;
+        e->integer_value = value;
+    }
+    return true;
+}
+
+void fold_const_calls_in_expr(expr *e, symbol **resolved)
+{
+    if (e == null)
+    {
+        return;
+    }
+
+    switch (e->kind)
+    {
+        case EXPR_UNARY:
+        {
+            fold_const_calls_in_expr(e->unary.operand, resolved);
+        }
+        break;
+        case EXPR_BINARY:
+        {
+            fold_const_calls_in_expr(e->binary.left, resolved);
+            fold_const_calls_in_expr(e->binary.right, resolved);
+        }
+        break;
+        case EXPR_TERNARY:
+        {
+            fold_const_calls_in_expr(e->ternary.condition, resolved);
+            fold_const_calls_in_expr(e->ternary.if_true, resolved);
+            fold_const_calls_in_expr(e->ternary.if_false, resolved);
+        }
+        break;
+        case EXPR_CALL:
+        {
+            if (false == fold_const_call(e, resolved))
+            {
+                fold_const_calls_in_expr(e->call.method_receiver, resolved);
+                for (size_t i = 0; i < e->call.args_num; i++)
+                {
+                    fold_const_calls_in_expr(e->call.args[i], resolved);
+                }
+            }
+        }
+        break;
+        case EXPR_FIELD:
+        {
+            fold_const_calls_in_expr(e->field.expr, resolved);
+        }
+        break;
+        case EXPR_INDEX:
+        {
+            fold_const_calls_in_expr(e->index.array_expr, resolved);
+            fold_const_calls_in_expr(e->index.index_expr, resolved);
+        }
+        break;
+        case EXPR_SIZE_OF:
+        {
+            fold_const_calls_in_expr(e->size_of.expr, resolved);
+        }
+        break;
+        case EXPR_CAST:
+        {
+            fold_const_calls_in_expr(e->cast.expr, resolved);
+        }
+        break;
+        case EXPR_COMPOUND_LITERAL:
+        {
+            for (size_t i = 0; i < e->compound.fields_count; i++)
+            {
+                fold_const_calls_in_expr(e->compound.fields[i]->expr, resolved);
+            }
+        }
+        break;
+        case EXPR_STUB:
+        {
+            fold_const_calls_in_expr(e->stub.original_expr, resolved);
+        }
+        break;
+        default:
+        {
+            // nie zawierają podwyrażeń
+        }
+        break;
+    }
+}
+
+void fold_const_calls_in_stmt_block(stmt_block block, symbol **resolved);
+
+void fold_const_calls_in_stmt(stmt *st, symbol **resolved)
+{
+    switch (st->kind)
+    {
+        case STMT_RETURN:
+        {
+            fold_const_calls_in_expr(st->return_stmt.ret_expr, resolved);
+        }
+        break;
+        case STMT_DECL:
+        {
+            if (st->decl_stmt.decl->kind == DECL_VARIABLE)
+            {
+                fold_const_calls_in_expr(st->decl_stmt.decl->variable.expr, resolved);
+            }
+        }
+        break;
+        case STMT_IF_ELSE:
+        {
+            fold_const_calls_in_expr(st->if_else.cond_expr, resolved);
+            fold_const_calls_in_stmt_block(st->if_else.then_block, resolved);
+            if (st->if_else.else_stmt)
+            {
+                fold_const_calls_in_stmt(st->if_else.else_stmt, resolved);
+            }
+        }
+        break;
+        case STMT_WHILE:
+        case STMT_DO_WHILE:
+        {
+            fold_const_calls_in_expr(st->while_stmt.cond_expr, resolved);
+            fold_const_calls_in_stmt_block(st->while_stmt.stmts, resolved);
+        }
+        break;
+        case STMT_FOR:
+        {
+            if (st->for_stmt.init_stmt)
+            {
+                fold_const_calls_in_stmt(st->for_stmt.init_stmt, resolved);
+            }
+            fold_const_calls_in_expr(st->for_stmt.cond_expr, resolved);
+            if (st->for_stmt.next_stmt)
+            {
+                fold_const_calls_in_stmt(st->for_stmt.next_stmt, resolved);
+            }
+            fold_const_calls_in_stmt_block(st->for_stmt.stmts, resolved);
+        }
+        break;
+        case STMT_ASSIGN:
+        {
+            fold_const_calls_in_expr(st->assign.assigned_var_expr, resolved);
+            fold_const_calls_in_expr(st->assign.value_expr, resolved);
+        }
+        break;
+        case STMT_SWITCH:
+        {
+            fold_const_calls_in_expr(st->switch_stmt.var_expr, resolved);
+            for (size_t i = 0; i < st->switch_stmt.cases_num; i++)
+            {
+                fold_const_calls_in_stmt_block(st->switch_stmt.cases[i]->stmts, resolved);
+            }
+        }
+        break;
+        case STMT_EXPR:
+        {
+            fold_const_calls_in_expr(st->expr, resolved);
+        }
+        break;
+        case STMT_BLOCK:
+        {
+            fold_const_calls_in_stmt_block(st->block, resolved);
+        }
+        break;
+        case STMT_DELETE:
+        {
+            fold_const_calls_in_expr(st->delete.expr, resolved);
+        }
+        break;
+        case STMT_INC:
+        {
+            fold_const_calls_in_expr(st->inc.operand, resolved);
+        }
+        break;
+        default:
+        {
+            // break, continue
+        }
+        break;
+    }
+}
+
+void fold_const_calls_in_stmt_block(stmt_block block, symbol **resolved)
+{
+    for (size_t i = 0; i < block.stmts_count; i++)
+    {
+        fold_const_calls_in_stmt(block.stmts[i], resolved);
+    }
+}
+
+void reset_compile_time_globals(void)
+{
+    if (compile_time_globals_ready)
+    {
+        free_memory_arena(vm_global_memory);
+        vm_global_memory = allocate_memory_arena(kilobytes(100));
+        map_free(&global_identifiers);
+        map_grow(&global_identifiers, 32);
+        compile_time_globals_ready = false;
+
+        // skompilowany kod odwołuje się do adresów zwolnionych zmiennych
+        jit_free();
+    }
+}
+
+void evaluate_compile_time_values(symbol **resolved)
+{
+    for (size_t i = 0; i < buf_len(resolved); i++)
+    {
+        symbol *sym = resolved[i];
+        if (sym->kind == SYMBOL_FUNCTION && sym->decl->function.is_const)
+        {
+            check_const_function(sym);
+        }
+    }
+
+    if (buf_len(errors) > 0)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < buf_len(resolved); i++)
+    {
+        symbol *sym = resolved[i];
+        if (sym->kind == SYMBOL_VARIABLE)
+        {
+            expr *init_expr = sym->decl->variable.expr;
+            if (init_expr
+                && is_foldable_type(sym->type)
+                && null == find_non_const_expr(init_expr, false))
+            {
+                sym->decl->variable.folded_value = evaluate_at_compile_time(init_expr, resolved);
+            }
+        }
+        else if (sym->kind == SYMBOL_FUNCTION && false == sym->decl->function.is_extern)
+        {
+            fold_const_calls_in_stmt_block(sym->decl->function.stmts, resolved);
+        }
+    }
+
+    // interpreter zaczyna później z pustą pamięcią globalną
+    reset_compile_time_globals();
+}
+
+void compile_time_evaluation_test(void)
+{
+    printf("\n==== COMPILE TIME EVALUATION TEST ====\n");
+
+    char *test_strs[] = {
+        "const fn spin(n: int): int { let i := 0 while (n > 0) { i += 1 } return i }",
+        "const fn out_of_range(k: int): int { let arr: int[3] return arr[k] }",
+        "const fn in_range(k: int): int { let arr: int[3] arr[2] = 7 return arr[k] }",
+        "fn use() { let a := spin(1) let b := out_of_range(5) let c := in_range(2) }",
+    };
+    size_t str_count = sizeof(test_strs) / sizeof(test_strs[0]);
+    symbol **resolved = test_resolve_decls(test_strs, str_count, false, false);
+
+    // błędy obliczeń są zgłaszane przy wywołaniu, a kompilator działa dalej
+    compile_time_step_limit = 100000;
+    evaluate_compile_time_values(resolved);
+    compile_time_step_limit = MAX_COMPILE_TIME_STEPS;
+
+    assert(buf_len(errors) == 2);
+    assert(strstr(errors[0].text, "exceeded the limit of 100000 steps"));
+    assert(errors[0].pos.line == 1);
+    assert(strstr(errors[1].text, "Index out of bounds: 5 (bound: 3)"));
+    buf_free(errors);
+
+    // nieudane wywołania nie są zastępowane wartością
+    stmt_block body = ((symbol *)map_get(&global_symbols, str_intern("use")))->decl->function.stmts;
+    assert(body.stmts[0]->decl_stmt.decl->variable.expr->kind == EXPR_CALL);
+    assert(body.stmts[1]->decl_stmt.decl->variable.expr->kind == EXPR_CALL);
+    expr *folded = body.stmts[2]->decl_stmt.decl->variable.expr;
+    assert(folded->kind == EXPR_INT && folded->integer_value == 7);
+    assert(runtime_error_recovery == null && vm_step_limit == 0);
+
+    printf("\nAll compile time evaluation tests passed!\n");
+}
@@ -0,0 +1,232 @@
+// zapis kodu x86-64 jako relokowalnego pliku obiektowego ELF64
+// struktury są serializowane ręcznie, żeby nie zależeć od elf.h
+
+#define ELF_SECTION_HEADER_SIZE 64
+#define ELF_SYMBOL_SIZE 24
+#define ELF_RELA_SIZE 24
+#define ELF_HEADER_SIZE 64
+
+#define ELF_SHT_PROGBITS 1
+#define ELF_SHT_SYMTAB 2
+#define ELF_SHT_STRTAB 3
+#define ELF_SHT_RELA 4
+
+#define ELF_SHF_ALLOC 0x2
+#define ELF_SHF_EXECINSTR 0x4
+#define ELF_SHF_INFO_LINK 0x40
+
+#define ELF_STB_LOCAL 0
+#define ELF_STB_GLOBAL 1
+#define ELF_STT_NOTYPE 0
+#define ELF_STT_FUNC 2
+#define ELF_STT_SECTION 3
+
+enum
+{
+    ELF_SECTION_NULL,
+    ELF_SECTION_TEXT,
+    ELF_SECTION_RELA_TEXT,
+    ELF_SECTION_SYMTAB,
+    ELF_SECTION_STRTAB,
+    ELF_SECTION_NOTE_GNU_STACK,
+    ELF_SECTION_SHSTRTAB,
+    ELF_SECTION_COUNT,
+};
+
+void elf_put_u8(char **buffer, uint8_t value)
+{
+    buf_push(*buffer, (char)value);
+}
+
+void elf_put_u16(char **buffer, uint16_t value)
+{
+    elf_put_u8(buffer, (uint8_t)value);
+    elf_put_u8(buffer, (uint8_t)(value >> 8));
+}
+
+void elf_put_u32(char **buffer, uint32_t value)
+{
+    elf_put_u16(buffer, (uint16_t)value);
+    elf_put_u16(buffer, (uint16_t)(value >> 16));
+}
+
+void elf_put_u64(char **buffer, uint64_t value)
+{
+    elf_put_u32(buffer, (uint32_t)value);
+    elf_put_u32(buffer, (uint32_t)(value >> 32));
+}
+
+void elf_put_bytes(char **buffer, const void *bytes, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        elf_put_u8(buffer, ((const uint8_t *)bytes)[i]);
+    }
+}
+
+void elf_align(char **buffer, size_t alignment)
+{
+    while (buf_len(*buffer) % alignment != 0)
+    {
+        elf_put_u8(buffer, 0);
+    }
+}
+
+uint32_t elf_add_string(char **strtab, const char *str)
+{
+    uint32_t result = (uint32_t)buf_len(*strtab);
+    elf_put_bytes(strtab, str, strlen(str) + 1);
+    return result;
+}
+
+void elf_put_symbol(char **buffer, uint32_t name, uint8_t bind, uint8_t type, uint16_t section, uint64_t value, uint64_t size)
+{
+    elf_put_u32(buffer, name);
+    elf_put_u8(buffer, (uint8_t)((bind << 4) | type));
+    elf_put_u8(buffer, 0);
+    elf_put_u16(buffer, section);
+    elf_put_u64(buffer, value);
+    elf_put_u64(buffer, size);
+}
+
+void elf_put_section_header(char **buffer, uint32_t name, uint32_t type, uint64_t flags,
+    uint64_t offset, uint64_t size, uint32_t link, uint32_t info, uint64_t alignment, uint64_t entry_size)
+{
+    elf_put_u32(buffer, name);
+    elf_put_u32(buffer, type);
+    elf_put_u64(buffer, flags);
+    elf_put_u64(buffer, 0); // adres
+    elf_put_u64(buffer, offset);
+    elf_put_u64(buffer, size);
+    elf_put_u32(buffer, link);
+    elf_put_u32(buffer, info);
+    elf_put_u64(buffer, alignment);
+    elf_put_u64(buffer, entry_size);
+}
+
+char *write_elf_object(x64_object *obj)
+{
+    char *strtab = null;
+    char *symtab = null;
+    char *rela = null;
+    elf_put_u8(&strtab, 0);
+
+    // symbole lokalne muszą poprzedzać globalne
+    elf_put_symbol(&symtab, 0, ELF_STB_LOCAL, ELF_STT_NOTYPE, 0, 0, 0);
+    elf_put_symbol(&symtab, 0, ELF_STB_LOCAL, ELF_STT_SECTION, ELF_SECTION_TEXT, 0, 0);
+    uint32_t first_global_symbol = 2;
+
+    hashmap symbol_indices = {0};
+    map_grow(&symbol_indices, 64);
+    uint32_t symbols_count = first_global_symbol;
+
+    for (size_t i = 0; i < buf_len(obj->functions); i++)
+    {
+        x64_function_code f = obj->functions[i];
+        uint32_t name = elf_add_string(&strtab, f.name);
+        elf_put_symbol(&symtab, name, ELF_STB_GLOBAL, ELF_STT_FUNC, ELF_SECTION_TEXT, f.offset, f.size);
+        map_put(&symbol_indices, f.name, (void *)(uintptr_t)symbols_count++);
+    }
+
+    for (size_t i = 0; i < buf_len(obj->relocations); i++)
+    {
+        // nazwy są internowane, więc wystarczy porównanie wskaźników
+        x64_relocation reloc = obj->relocations[i];
+        uint32_t index = (uint32_t)(uintptr_t)map_get(&symbol_indices, reloc.symbol);
+        if (index == 0)
+        {
+            uint32_t name = elf_add_string(&strtab, reloc.symbol);
+            elf_put_symbol(&symtab, name, ELF_STB_GLOBAL, ELF_STT_NOTYPE, 0, 0, 0);
+            index = symbols_count++;
+            map_put(&symbol_indices, reloc.symbol, (void *)(uintptr_t)index);
+        }
+
+        elf_put_u64(&rela, reloc.offset);
+        elf_put_u64(&rela, ((uint64_t)index << 32) | reloc.type);
+        elf_put_u64(&rela, (uint64_t)reloc.addend);
+    }
+    map_free(&symbol_indices);
+
+    char *shstrtab = null;
+    elf_put_u8(&shstrtab, 0);
+    uint32_t text_name = elf_add_string(&shstrtab, ".text");
+    uint32_t rela_name = elf_add_string(&shstrtab, ".rela.text");
+    uint32_t symtab_name = elf_add_string(&shstrtab, ".symtab");
+    uint32_t strtab_name = elf_add_string(&shstrtab, ".strtab");
+    uint32_t note_name = elf_add_string(&shstrtab, ".note.GNU-stack");
+    uint32_t shstrtab_name = elf_add_string(&shstrtab, ".shstrtab");
+
+    char *result = null;
+
+    // nagłówek jest uzupełniany na końcu, gdy znane jest położenie tabeli sekcji
+    for (size_t i = 0; i < ELF_HEADER_SIZE; i++)
+    {
+        elf_put_u8(&result, 0);
+    }
+
+    elf_align(&result, 16);
+    size_t text_offset = buf_len(result);
+    elf_put_bytes(&result, obj->code, buf_len(obj->code));
+
+    elf_align(&result, 8);
+    size_t rela_offset = buf_len(result);
+    elf_put_bytes(&result, rela, buf_len(rela));
+
+    elf_align(&result, 8);
+    size_t symtab_offset = buf_len(result);
+    elf_put_bytes(&result, symtab, buf_len(symtab));
+
+    size_t strtab_offset = buf_len(result);
+    elf_put_bytes(&result, strtab, buf_len(strtab));
+
+    size_t shstrtab_offset = buf_len(result);
+    elf_put_bytes(&result, shstrtab, buf_len(shstrtab));
+
+    elf_align(&result, 8);
+    size_t section_headers_offset = buf_len(result);
+
+    elf_put_section_header(&result, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    elf_put_section_header(&result, text_name, ELF_SHT_PROGBITS, ELF_SHF_ALLOC | ELF_SHF_EXECINSTR,
+        text_offset, buf_len(obj->code), 0, 0, 16, 0);
+    elf_put_section_header(&result, rela_name, ELF_SHT_RELA, ELF_SHF_INFO_LINK,
+        rela_offset, buf_len(rela), ELF_SECTION_SYMTAB, ELF_SECTION_TEXT, 8, ELF_RELA_SIZE);
+    elf_put_section_header(&result, symtab_name, ELF_SHT_SYMTAB, 0,
+        symtab_offset, buf_len(symtab), ELF_SECTION_STRTAB, first_global_symbol, 8, ELF_SYMBOL_SIZE);
+    elf_put_section_header(&result, strtab_name, ELF_SHT_STRTAB, 0,
+        strtab_offset, buf_len(strtab), 0, 0, 1, 0);
+    elf_put_section_header(&result, note_name, ELF_SHT_PROGBITS, 0,
+        shstrtab_offset, 0, 0, 0, 1, 0);
+    elf_put_section_header(&result, shstrtab_name, ELF_SHT_STRTAB, 0,
+        shstrtab_offset, buf_len(shstrtab), 0, 0, 1, 0);
+
+    char *header = null;
+    elf_put_bytes(&header, "\x7F" "ELF", 4);
+    elf_put_u8(&header, 2); // 64-bit
+    elf_put_u8(&header, 1); // little endian
+    elf_put_u8(&header, 1); // wersja
+    elf_put_u8(&header, 0); // System V ABI
+    elf_put_u64(&header, 0);
+    elf_put_u16(&header, 1); // ET_REL
+    elf_put_u16(&header, 62); // EM_X86_64
+    elf_put_u32(&header, 1);
+    elf_put_u64(&header, 0); // punkt wejścia
+    elf_put_u64(&header, 0); // tabela programu
+    elf_put_u64(&header, section_headers_offset);
+    elf_put_u32(&header, 0);
+    elf_put_u16(&header, ELF_HEADER_SIZE);
+    elf_put_u16(&header, 0);
+    elf_put_u16(&header, 0);
+    elf_put_u16(&header, ELF_SECTION_HEADER_SIZE);
+    elf_put_u16(&header, ELF_SECTION_COUNT);
+    elf_put_u16(&header, ELF_SECTION_SHSTRTAB);
+    assert(buf_len(header) == ELF_HEADER_SIZE);
+    memcpy(result, header, ELF_HEADER_SIZE);
+
+    buf_free(header);
+    buf_free(strtab);
+    buf_free(symtab);
+    buf_free(rela);
+    buf_free(shstrtab);
+
+    return result;
+}
@@ -0,0 +1,567 @@
+// analiza ucieczki - obiekty tworzone przez new i auto, których wskaźnik nie opuszcza
+// funkcji, są umieszczane na stosie zamiast na stercie
+
+const size_t MAX_STACK_ALLOCATION_SIZE = 1024;
+
+bool expr_mentions_name(expr *e, const char *name);
+
+bool expr_list_mentions_name(expr **exprs, size_t count, const char *name)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (expr_mentions_name(exprs[i], name))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool expr_mentions_name(expr *e, const char *name)
+{
+    if (e == null)
+    {
+        return false;
+    }
+
+    switch (e->kind)
+    {
+        case EXPR_NAME:
+        {
+            return (e->name == name);
+        }
+        break;
+        case EXPR_UNARY:
+        {
+            return expr_mentions_name(e->unary.operand, name);
+        }
+        break;
+        case EXPR_BINARY:
+        {
+            return expr_mentions_name(e->binary.left, name)
+                || expr_mentions_name(e->binary.right, name);
+        }
+        break;
+        case EXPR_TERNARY:
+        {
+            return expr_mentions_name(e->ternary.condition, name)
+                || expr_mentions_name(e->ternary.if_true, name)
+                || expr_mentions_name(e->ternary.if_false, name);
+        }
+        break;
+        case EXPR_CALL:
+        {
+            return expr_mentions_name(e->call.function_expr, name)
+                || expr_mentions_name(e->call.method_receiver, name)
+                || expr_list_mentions_name(e->call.args, e->call.args_num, name);
+        }
+        break;
+        case EXPR_FIELD:
+        {
+            return expr_mentions_name(e->field.expr, name);
+        }
+        break;
+        case EXPR_INDEX:
+        {
+            return expr_mentions_name(e->index.array_expr, name)
+                || expr_mentions_name(e->index.index_expr, name);
+        }
+        break;
+        case EXPR_SIZE_OF:
+        {
+            return expr_mentions_name(e->size_of.expr, name);
+        }
+        break;
+        case EXPR_CAST:
+        {
+            return expr_mentions_name(e->cast.expr, name);
+        }
+        break;
+        case EXPR_COMPOUND_LITERAL:
+        {
+            for (size_t i = 0; i < e->compound.fields_count; i++)
+            {
+                if (expr_mentions_name(e->compound.fields[i]->expr, name))
+                {
+                    return true;
+                }
+            }
+        }
+        break;
+        case EXPR_STUB:
+        {
+            return expr_mentions_name(e->stub.original_expr, name);
+        }
+        break;
+        default:
+        {
+            // nie zawierają podwyrażeń
+        }
+        break;
+    }
+    return false;
+}
+
+bool is_plain_name(expr *e, const char *name)
+{
+    return (e && e->kind == EXPR_NAME && e->name == name);
+}
+
+bool pointer_escapes_in_expr(expr *e, const char *name);
+
+// porównania, warunki i operatory logiczne nie kopiują wskaźnika
+bool pointer_escapes_in_condition(expr *e, const char *name)
+{
+    if (is_plain_name(skip_implicit_casts(e), name))
+    {
+        return false;
+    }
+    return pointer_escapes_in_expr(e, name);
+}
+
+// zwraca true, jeśli wskaźnik o podanej nazwie może zostać skopiowany gdzieś poza
+// dostęp do pól, dereferencję i porównania - każde inne użycie uznajemy za ucieczkę
+bool pointer_escapes_in_expr(expr *e, const char *name)
+{
+    if (e == null)
+    {
+        return false;
+    }
+
+    switch (e->kind)
+    {
+        case EXPR_NAME:
+        {
+            return (e->name == name);
+        }
+        break;
+        case EXPR_UNARY:
+        {
+            if (e->unary.operator == TOKEN_ADDRESS_OF)
+            {
+                // adres pola obiektu to też wskaźnik do obiektu
+                return expr_mentions_name(e->unary.operand, name);
+            }
+
+            if (e->unary.operator == TOKEN_DEREFERENCE && is_plain_name(e->unary.operand, name))
+            {
+                return false;
+            }
+
+            if (e->unary.operator == TOKEN_NOT)
+            {
+                return pointer_escapes_in_condition(e->unary.operand, name);
+            }
+            return pointer_escapes_in_expr(e->unary.operand, name);
+        }
+        break;
+        case EXPR_BINARY:
+        {
+            token_kind op = e->binary.operator;
+            if ((op >= TOKEN_FIRST_CMP_OPERATOR && op <= TOKEN_LAST_CMP_OPERATOR)
+                || op == TOKEN_AND || op == TOKEN_OR)
+            {
+                return pointer_escapes_in_condition(e->binary.left, name)
+                    || pointer_escapes_in_condition(e->binary.right, name);
+            }
+            return pointer_escapes_in_expr(e->binary.left, name)
+                || pointer_escapes_in_expr(e->binary.right, name);
+        }
+        break;
+        case EXPR_TERNARY:
+        {
+            return pointer_escapes_in_condition(e->ternary.condition, name)
+                || pointer_escapes_in_expr(e->ternary.if_true, name)
+                || pointer_escapes_in_expr(e->ternary.if_false, name);
+        }
+        break;
+        case EXPR_CALL:
+        {
+            if (pointer_escapes_in_expr(e->call.function_expr, name)
+                || pointer_escapes_in_expr(e->call.method_receiver, name))
+            {
+                return true;
+            }
+            for (size_t i = 0; i < e->call.args_num; i++)
+            {
+                if (pointer_escapes_in_expr(e->call.args[i], name))
+                {
+                    return true;
+                }
+            }
+        }
+        break;
+        case EXPR_FIELD:
+        {
+            if (is_plain_name(e->field.expr, name))
+            {
+                return false;
+            }
+            return pointer_escapes_in_expr(e->field.expr, name);
+        }
+        break;
+        case EXPR_INDEX:
+        {
+            return pointer_escapes_in_expr(e->index.array_expr, name)
+                || pointer_escapes_in_expr(e->index.index_expr, name);
+        }
+        break;
+        case EXPR_SIZE_OF:
+        {
+            return pointer_escapes_in_expr(e->size_of.expr, name);
+        }
+        break;
+        case EXPR_CAST:
+        {
+            return pointer_escapes_in_expr(e->cast.expr, name);
+        }
+        break;
+        case EXPR_COMPOUND_LITERAL:
+        {
+            for (size_t i = 0; i < e->compound.fields_count; i++)
+            {
+                if (pointer_escapes_in_expr(e->compound.fields[i]->expr, name))
+                {
+                    return true;
+                }
+            }
+        }
+        break;
+        case EXPR_STUB:
+        {
+            // rzutowanie na bool
+            if (e->stub.kind == STUB_EXPR_CAST && e->resolved_type == type_bool)
+            {
+                return pointer_escapes_in_condition(e->stub.original_expr, name);
+            }
+            return pointer_escapes_in_expr(e->stub.original_expr, name);
+        }
+        break;
+        default:
+        {
+            // nie zawierają podwyrażeń
+        }
+        break;
+    }
+    return false;
+}
+
+bool pointer_escapes_in_stmt_block(stmt_block block, const char *name);
+
+bool pointer_escapes_in_stmt(stmt *st, const char *name)
+{
+    switch (st->kind)
+    {
+        case STMT_RETURN:
+        {
+            return pointer_escapes_in_expr(st->return_stmt.ret_expr, name);
+        }
+        break;
+        case STMT_DECL:
+        {
+            decl *d = st->decl_stmt.decl;
+            if (d->kind == DECL_VARIABLE)
+            {
+                return pointer_escapes_in_expr(d->variable.expr, name);
+            }
+        }
+        break;
+        case STMT_IF_ELSE:
+        {
+            return pointer_escapes_in_condition(st->if_else.cond_expr, name)
+                || pointer_escapes_in_stmt_block(st->if_else.then_block, name)
+                || (st->if_else.else_stmt && pointer_escapes_in_stmt(st->if_else.else_stmt, name));
+        }
+        break;
+        case STMT_WHILE:
+        case STMT_DO_WHILE:
+        {
+            return pointer_escapes_in_condition(st->while_stmt.cond_expr, name)
+                || pointer_escapes_in_stmt_block(st->while_stmt.stmts, name);
+        }
+        break;
+        case STMT_FOR:
+        {
+            return (st->for_stmt.init_stmt && pointer_escapes_in_stmt(st->for_stmt.init_stmt, name))
+                || pointer_escapes_in_condition(st->for_stmt.cond_expr, name)
+                || (st->for_stmt.next_stmt && pointer_escapes_in_stmt(st->for_stmt.next_stmt, name))
+                || pointer_escapes_in_stmt_block(st->for_stmt.stmts, name);
+        }
+        break;
+        case STMT_ASSIGN:
+        {
+            // przypisanie do samej zmiennej też ją dyskwalifikuje
+            return pointer_escapes_in_expr(st->assign.assigned_var_expr, name)
+                || pointer_escapes_in_expr(st->assign.value_expr, name);
+        }
+        break;
+        case STMT_SWITCH:
+        {
+            if (pointer_escapes_in_expr(st->switch_stmt.var_expr, name))
+            {
+                return true;
+            }
+            for (size_t i = 0; i < st->switch_stmt.cases_num; i++)
+            {
+                if (pointer_escapes_in_stmt_block(st->switch_stmt.cases[i]->stmts, name))
+                {
+                    return true;
+                }
+            }
+        }
+        break;
+        case STMT_EXPR:
+        {
+            return pointer_escapes_in_expr(st->expr, name);
+        }
+        break;
+        case STMT_BLOCK:
+        {
+            return pointer_escapes_in_stmt_block(st->block, name);
+        }
+        break;
+        case STMT_DELETE:
+        {
+            // delete obiektu na stosie zostaje pominięte
+            if (is_plain_name(st->delete.expr, name))
+            {
+                return false;
+            }
+            return pointer_escapes_in_expr(st->delete.expr, name);
+        }
+        break;
+        case STMT_INC:
+        {
+            return pointer_escapes_in_expr(st->inc.operand, name);
+        }
+        break;
+        default:
+        {
+            // break, continue
+        }
+        break;
+    }
+    return false;
+}
+
+bool pointer_escapes_in_stmt_block(stmt_block block, const char *name)
+{
+    for (size_t i = 0; i < block.stmts_count; i++)
+    {
+        if (pointer_escapes_in_stmt(block.stmts[i], name))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void mark_deletes_of_stack_object(stmt_block block, const char *name);
+
+void mark_deletes_of_stack_object_in_stmt(stmt *st, const char *name)
+{
+    switch (st->kind)
+    {
+        case STMT_DELETE:
+        {
+            if (is_plain_name(st->delete.expr, name))
+            {
+                st->delete.target_on_stack = true;
+            }
+        }
+        break;
+        case STMT_IF_ELSE:
+        {
+            mark_deletes_of_stack_object(st->if_else.then_block, name);
+            if (st->if_else.else_stmt)
+            {
+                mark_deletes_of_stack_object_in_stmt(st->if_else.else_stmt, name);
+            }
+        }
+        break;
+        case STMT_WHILE:
+        case STMT_DO_WHILE:
+        {
+            mark_deletes_of_stack_object(st->while_stmt.stmts, name);
+        }
+        break;
+        case STMT_FOR:
+        {
+            mark_deletes_of_stack_object(st->for_stmt.stmts, name);
+        }
+        break;
+        case STMT_SWITCH:
+        {
+            for (size_t i = 0; i < st->switch_stmt.cases_num; i++)
+            {
+                mark_deletes_of_stack_object(st->switch_stmt.cases[i]->stmts, name);
+            }
+        }
+        break;
+        case STMT_BLOCK:
+        {
+            mark_deletes_of_stack_object(st->block, name);
+        }
+        break;
+        default:
+        {
+            // inne instrukcje nie zawierają delete
+        }
+        break;
+    }
+}
+
+void mark_deletes_of_stack_object(stmt_block block, const char *name)
+{
+    for (size_t i = 0; i < block.stmts_count; i++)
+    {
+        mark_deletes_of_stack_object_in_stmt(block.stmts[i], name);
+    }
+}
+
+bool is_stack_allocation_candidate(decl *d)
+{
+    if (d->kind != DECL_VARIABLE || d->variable.expr == null)
+    {
+        return false;
+    }
+
+    expr *e = d->variable.expr;
+    type *allocated_type = null;
+    if (e->kind == EXPR_NEW)
+    {
+        allocated_type = e->new_init.resolved_type;
+    }
+    else if (e->kind == EXPR_AUTO)
+    {
+        allocated_type = e->auto_init.resolved_type;
+    }
+
+    // tablice mogą mieć rozmiar znany dopiero w czasie wykonania, a listy
+    // (zamienione na stuby) mają własny bufor na stercie
+    if (allocated_type == null
+        || allocated_type->kind == TYPE_ARRAY
+        || allocated_type->kind == TYPE_LIST
+        || allocated_type->size > MAX_STACK_ALLOCATION_SIZE)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+void collect_local_decls(stmt_block block, decl ***decls);
+
+void collect_local_decls_in_stmt(stmt *st, decl ***decls)
+{
+    switch (st->kind)
+    {
+        case STMT_DECL:
+        {
+            buf_push(*decls, st->decl_stmt.decl);
+        }
+        break;
+        case STMT_IF_ELSE:
+        {
+            collect_local_decls(st->if_else.then_block, decls);
+            if (st->if_else.else_stmt)
+            {
+                collect_local_decls_in_stmt(st->if_else.else_stmt, decls);
+            }
+        }
+        break;
+        case STMT_WHILE:
+        case STMT_DO_WHILE:
+        {
+            collect_local_decls(st->while_stmt.stmts, decls);
+        }
+        break;
+        case STMT_FOR:
+        {
+            if (st->for_stmt.init_stmt)
+            {
+                collect_local_decls_in_stmt(st->for_stmt.init_stmt, decls);
+            }
+            collect_local_decls(st->for_stmt.stmts, decls);
+        }
+        break;
+        case STMT_SWITCH:
+        {
+            for (size_t i = 0; i < st->switch_stmt.cases_num; i++)
+            {
+                collect_local_decls(st->switch_stmt.cases[i]->stmts, decls);
+            }
+        }
+        break;
+        case STMT_BLOCK:
+        {
+            collect_local_decls(st->block, decls);
+        }
+        break;
+        default:
+        {
+            // deklaracje występują tylko w blokach
+        }
+        break;
+    }
+}
+
+void collect_local_decls(stmt_block block, decl ***decls)
+{
+    for (size_t i = 0; i < block.stmts_count; i++)
+    {
+        collect_local_decls_in_stmt(block.stmts[i], decls);
+    }
+}
+
+bool is_decl_name_unique(decl **decls, const char *name)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < buf_len(decls); i++)
+    {
+        if (decls[i]->name == name)
+        {
+            count++;
+        }
+    }
+    return (count == 1);
+}
+
+void stack_allocate_non_escaping_objects(symbol **resolved)
+{
+    decl **decls = null;
+    for (size_t i = 0; i < buf_len(resolved); i++)
+    {
+        symbol *sym = resolved[i];
+        if (sym->decl == null || sym->decl->kind != DECL_FUNCTION
+            || sym->decl->function.is_extern)
+        {
+            continue;
+        }
+
+        // nazwy nie mogą się przesłaniać, ale mogą się powtarzać w rozłącznych blokach
+        // - wtedy analiza po nazwie byłaby niejednoznaczna
+        stmt_block body = sym->decl->function.stmts;
+        collect_local_decls(body, &decls);
+        for (size_t j = 0; j < buf_len(decls); j++)
+        {
+            decl *d = decls[j];
+            if (is_stack_allocation_candidate(d)
+                && is_decl_name_unique(decls, d->name)
+                && false == pointer_escapes_in_stmt_block(body, d->name))
+            {
+                expr *e = d->variable.expr;
+                if (e->kind == EXPR_NEW)
+                {
+                    e->new_init.on_stack = true;
+                }
+                else
+                {
+                    e->auto_init.on_stack = true;
+                }
+                mark_deletes_of_stack_object(body, d->name);
+            }
+        }
+        buf_free(decls);
+    }
+}
@@ -0,0 +1,1036 @@
+// wstawianie ciał małych funkcji w miejsca wywołań - wykonywane po resolve,
+// dla funkcji, których ciało da się sprowadzić do jednego wyrażenia
+
+enum
+{
+    INLINE_SIZE_BUDGET = 24, // liczba węzłów wyrażenia
+    MAX_INLINE_DEPTH = 4,
+};
+
+typedef struct inline_candidate
+{
+    expr *body; // null, jeśli funkcji nie da się wstawić
+    bool computed;
+} inline_candidate;
+
+hashmap inline_candidates;
+symbol **inline_reachable_functions;
+hashmap inline_arg_names; // zmienne tymczasowe z argumentami wstawionych wywołań
+size_t inline_arg_count;
+
+size_t count_expr_nodes(expr *e)
+{
+    if (e == null)
+    {
+        return 0;
+    }
+
+    size_t result = 1;
+    switch (e->kind)
+    {
+        case EXPR_UNARY:
+        {
+            result += count_expr_nodes(e->unary.operand);
+        }
+        break;
+        case EXPR_BINARY:
+        {
+            result += count_expr_nodes(e->binary.left) + count_expr_nodes(e->binary.right);
+        }
+        break;
+        case EXPR_TERNARY:
+        {
+            result += count_expr_nodes(e->ternary.condition)
+                + count_expr_nodes(e->ternary.if_true)
+                + count_expr_nodes(e->ternary.if_false);
+        }
+        break;
+        case EXPR_CALL:
+        {
+            result += count_expr_nodes(e->call.function_expr) + count_expr_nodes(e->call.method_receiver);
+            for (size_t i = 0; i < e->call.args_num; i++)
+            {
+                result += count_expr_nodes(e->call.args[i]);
+            }
+        }
+        break;
+        case EXPR_FIELD:
+        {
+            result += count_expr_nodes(e->field.expr);
+        }
+        break;
+        case EXPR_INDEX:
+        {
+            result += count_expr_nodes(e->index.array_expr) + count_expr_nodes(e->index.index_expr);
+        }
+        break;
+        case EXPR_SIZE_OF:
+        {
+            result += count_expr_nodes(e->size_of.expr);
+        }
+        break;
+        case EXPR_CAST:
+        {
+            result += count_expr_nodes(e->cast.expr);
+        }
+        break;
+        case EXPR_STUB:
+        {
+            // niejawne rzutowania nic nie kosztują
+            result = count_expr_nodes(e->stub.original_expr);
+        }
+        break;
+        default:
+        {
+            // nie zawierają podwyrażeń
+        }
+        break;
+    }
+    return result;
+}
+
+// wyrażenia bez efektów ubocznych - ich obliczenie nie zmienia żadnej zmiennej
+bool is_pure_expr(expr *e)
+{
+    switch (e->kind)
+    {
+        case EXPR_INT:
+        case EXPR_FLOAT:
+        case EXPR_CHAR:
+        case EXPR_BOOL:
+        case EXPR_NULL:
+        case EXPR_NAME:
+        case EXPR_SIZE_OF_TYPE:
+        {
+            return true;
+        }
+        break;
+        case EXPR_UNARY:
+        {
+            return is_pure_expr(e->unary.operand);
+        }
+        break;
+        case EXPR_BINARY:
+        {
+            return is_pure_expr(e->binary.left) && is_pure_expr(e->binary.right);
+        }
+        break;
+        case EXPR_TERNARY:
+        {
+            return is_pure_expr(e->ternary.condition)
+                && is_pure_expr(e->ternary.if_true)
+                && is_pure_expr(e->ternary.if_false);
+        }
+        break;
+        case EXPR_FIELD:
+        {
+            return is_pure_expr(e->field.expr);
+        }
+        break;
+        case EXPR_INDEX:
+        {
+            return is_pure_expr(e->index.array_expr) && is_pure_expr(e->index.index_expr);
+        }
+        break;
+        case EXPR_CAST:
+        {
+            return is_pure_expr(e->cast.expr);
+        }
+        break;
+        case EXPR_STUB:
+        {
+            switch (e->stub.kind)
+            {
+                case STUB_EXPR_CAST:
+                case STUB_EXPR_LIST_INDEX:
+                case STUB_EXPR_LIST_LENGTH:
+                case STUB_EXPR_LIST_CAPACITY:
+                case STUB_EXPR_POINTER_ARITHMETIC_BINARY:
+                {
+                    return is_pure_expr(e->stub.original_expr);
+                }
+                break;
+                default:
+                {
+                    return false;
+                }
+                break;
+            }
+        }
+        break;
+        case EXPR_CALL:
+        {
+            // stuby list mają oryginalne wyrażenie wywołania metody
+            if (e->call.method_receiver && e->call.resolved_function == null)
+            {
+                return is_pure_expr(e->call.method_receiver);
+            }
+            return false;
+        }
+        break;
+        default:
+        {
+            // wywołania, new, auto, literały złożone
+            return false;
+        }
+        break;
+    }
+    return false;
+}
+
+expr *reduce_stmt_to_expr(stmt *st, stmt_block rest, size_t rest_index, type *return_type);
+
+// sprowadza ciąg instrukcji postaci if/else i return do jednego wyrażenia
+expr *reduce_stmt_block_to_expr(stmt_block block, size_t index, type *return_type)
+{
+    if (index >= block.stmts_count)
+    {
+        return null;
+    }
+    return reduce_stmt_to_expr(block.stmts[index], block, index + 1, return_type);
+}
+
+expr *reduce_stmt_to_expr(stmt *st, stmt_block rest, size_t rest_index, type *return_type)
+{
+    switch (st->kind)
+    {
+        case STMT_RETURN:
+        {
+            return st->return_stmt.ret_expr;
+        }
+        break;
+        case STMT_BLOCK:
+        {
+            return reduce_stmt_block_to_expr(st->block, 0, return_type);
+        }
+        break;
+        case STMT_IF_ELSE:
+        {
+            expr *if_true = reduce_stmt_block_to_expr(st->if_else.then_block, 0, return_type);
+            expr *if_false = null;
+            if (st->if_else.else_stmt)
+            {
+                if_false = reduce_stmt_to_expr(st->if_else.else_stmt, (stmt_block){ 0 }, 0, return_type);
+            }
+            else
+            {
+                // brak else - wykonanie przechodzi do dalszych instrukcji
+                if_false = reduce_stmt_block_to_expr(rest, rest_index, return_type);
+            }
+
+            if (if_true == null || if_false == null)
+            {
+                return null;
+            }
+
+            expr *result = push_struct(arena, expr);
+            result->kind = EXPR_TERNARY;
+            result->pos = st->pos;
+            result->resolved_type = return_type;
+            result->ternary.condition = st->if_else.cond_expr;
+            result->ternary.if_true = if_true;
+            result->ternary.if_false = if_false;
+            return result;
+        }
+        break;
+        default:
+        {
+            return null;
+        }
+        break;
+    }
+    return null;
+}
+
+bool param_address_taken(expr *e, function_param_list params)
+{
+    if (e == null)
+    {
+        return false;
+    }
+
+    if (e->kind == EXPR_UNARY && e->unary.operator == TOKEN_ADDRESS_OF)
+    {
+        for (size_t i = 0; i < params.param_count; i++)
+        {
+            if (expr_mentions_name(e->unary.operand, params.params[i].name))
+            {
+                return true;
+            }
+        }
+    }
+
+    switch (e->kind)
+    {
+        case EXPR_UNARY:
+        {
+            return param_address_taken(e->unary.operand, params);
+        }
+        break;
+        case EXPR_BINARY:
+        {
+            return param_address_taken(e->binary.left, params)
+                || param_address_taken(e->binary.right, params);
+        }
+        break;
+        case EXPR_TERNARY:
+        {
+            return param_address_taken(e->ternary.condition, params)
+                || param_address_taken(e->ternary.if_true, params)
+                || param_address_taken(e->ternary.if_false, params);
+        }
+        break;
+        case EXPR_CALL:
+        {
+            if (param_address_taken(e->call.method_receiver, params))
+            {
+                return true;
+            }
+            for (size_t i = 0; i < e->call.args_num; i++)
+            {
+                if (param_address_taken(e->call.args[i], params))
+                {
+                    return true;
+                }
+            }
+        }
+        break;
+        case EXPR_FIELD:
+        {
+            return param_address_taken(e->field.expr, params);
+        }
+        break;
+        case EXPR_INDEX:
+        {
+            // parametr-tablica indeksowany po wstawieniu mógłby wskazywać na kopię
+            return param_address_taken(e->index.array_expr, params)
+                || param_address_taken(e->index.index_expr, params);
+        }
+        break;
+        case EXPR_CAST:
+        {
+            return param_address_taken(e->cast.expr, params);
+        }
+        break;
+        case EXPR_SIZE_OF:
+        {
+            return param_address_taken(e->size_of.expr, params);
+        }
+        break;
+        case EXPR_STUB:
+        {
+            return param_address_taken(e->stub.original_expr, params);
+        }
+        break;
+        default:
+        {
+            // nie zawierają podwyrażeń
+        }
+        break;
+    }
+    return false;
+}
+
+bool calls_function(expr *e, symbol *function)
+{
+    if (e == null)
+    {
+        return false;
+    }
+
+    switch (e->kind)
+    {
+        case EXPR_CALL:
+        {
+            if (e->call.resolved_function == function)
+            {
+                return true;
+            }
+            if (calls_function(e->call.method_receiver, function))
+            {
+                return true;
+            }
+            for (size_t i = 0; i < e->call.args_num; i++)
+            {
+                if (calls_function(e->call.args[i], function))
+                {
+                    return true;
+                }
+            }
+        }
+        break;
+        case EXPR_UNARY:
+        {
+            return calls_function(e->unary.operand, function);
+        }
+        break;
+        case EXPR_BINARY:
+        {
+            return calls_function(e->binary.left, function) || calls_function(e->binary.right, function);
+        }
+        break;
+        case EXPR_TERNARY:
+        {
+            return calls_function(e->ternary.condition, function)
+                || calls_function(e->ternary.if_true, function)
+                || calls_function(e->ternary.if_false, function);
+        }
+        break;
+        case EXPR_FIELD:
+        {
+            return calls_function(e->field.expr, function);
+        }
+        break;
+        case EXPR_INDEX:
+        {
+            return calls_function(e->index.array_expr, function)
+                || calls_function(e->index.index_expr, function);
+        }
+        break;
+        case EXPR_CAST:
+        {
+            return calls_function(e->cast.expr, function);
+        }
+        break;
+        case EXPR_SIZE_OF:
+        {
+            return calls_function(e->size_of.expr, function);
+        }
+        break;
+        case EXPR_STUB:
+        {
+            return calls_function(e->stub.original_expr, function);
+        }
+        break;
+        default:
+        {
+            // nie zawierają podwyrażeń
+        }
+        break;
+    }
+    return false;
+}
+
+expr *clone_expr_with_args(expr *e, function_param_list params, expr **args);
+
+expr *get_inlinable_body(symbol *function)
+{
+    inline_candidate *candidate = map_get(&inline_candidates, function);
+    if (candidate)
+    {
+        return candidate->body;
+    }
+
+    candidate = push_struct(arena, inline_candidate);
+    map_put(&inline_candidates, function, candidate);
+
+    decl *d = function->decl;
+    if (d == null || d->kind != DECL_FUNCTION
+        || d->function.is_extern
+        || d->function.is_noinline
+        || d->function.method_receiver
+        || function->name == main_str
+        || function->type->function.return_type == type_void)
+    {
+        return null;
+    }
+
+    expr *body = reduce_stmt_block_to_expr(d->function.stmts, 0, function->type->function.return_type);
+    if (body == null
+        || param_address_taken(body, d->function.params)
+        || calls_function(body, function))
+    {
+        return null;
+    }
+
+    if (false == d->function.is_inline && count_expr_nodes(body) > INLINE_SIZE_BUDGET)
+    {
+        return null;
+    }
+
+    // kopia - wstawianie wywołań w samej funkcji nie może zmienić zapamiętanego ciała
+    candidate->body = clone_expr_with_args(body, (function_param_list){ 0 }, null);
+    return candidate->body;
+}
+
+expr *clone_expr_with_args(expr *e, function_param_list params, expr **args)
+{
+    if (e == null)
+    {
+        return null;
+    }
+
+    if (e->kind == EXPR_NAME)
+    {
+        for (size_t i = 0; i < params.param_count; i++)
+        {
+            if (params.params[i].name == e->name)
+            {
+                return clone_expr_with_args(args[i], (function_param_list){ 0 }, null);
+            }
+        }
+    }
+
+    expr *result = push_struct(arena, expr);
+    *result = *e;
+
+    switch (e->kind)
+    {
+        case EXPR_UNARY:
+        {
+            result->unary.operand = clone_expr_with_args(e->unary.operand, params, args);
+        }
+        break;
+        case EXPR_BINARY:
+        {
+            result->binary.left = clone_expr_with_args(e->binary.left, params, args);
+            result->binary.right = clone_expr_with_args(e->binary.right, params, args);
+        }
+        break;
+        case EXPR_TERNARY:
+        {
+            result->ternary.condition = clone_expr_with_args(e->ternary.condition, params, args);
+            result->ternary.if_true = clone_expr_with_args(e->ternary.if_true, params, args);
+            result->ternary.if_false = clone_expr_with_args(e->ternary.if_false, params, args);
+        }
+        break;
+        case EXPR_CALL:
+        {
+            result->call.function_expr = clone_expr_with_args(e->call.function_expr, params, args);
+            result->call.method_receiver = clone_expr_with_args(e->call.method_receiver, params, args);
+            if (e->call.args_num > 0)
+            {
+                result->call.args = push_size(arena, sizeof(expr *) * e->call.args_num);
+                for (size_t i = 0; i < e->call.args_num; i++)
+                {
+                    result->call.args[i] = clone_expr_with_args(e->call.args[i], params, args);
+                }
+            }
+        }
+        break;
+        case EXPR_FIELD:
+        {
+            result->field.expr = clone_expr_with_args(e->field.expr, params, args);
+        }
+        break;
+        case EXPR_INDEX:
+        {
+            result->index.array_expr = clone_expr_with_args(e->index.array_expr, params, args);
+            result->index.index_expr = clone_expr_with_args(e->index.index_expr, params, args);
+        }
+        break;
+        case EXPR_SIZE_OF:
+        {
+            result->size_of.expr = clone_expr_with_args(e->size_of.expr, params, args);
+        }
+        break;
+        case EXPR_CAST:
+        {
+            result->cast.expr = clone_expr_with_args(e->cast.expr, params, args);
+        }
+        break;
+        case EXPR_COMPOUND_LITERAL:
+        {
+            if (e->compound.fields_count > 0)
+            {
+                result->compound.fields = push_size(arena, sizeof(compound_literal_field *) * e->compound.fields_count);
+                for (size_t i = 0; i < e->compound.fields_count; i++)
+                {
+                    compound_literal_field *field = push_struct(arena, compound_literal_field);
+                    *field = *e->compound.fields[i];
+                    field->expr = clone_expr_with_args(field->expr, params, args);
+                    result->compound.fields[i] = field;
+                }
+            }
+        }
+        break;
+        case EXPR_STUB:
+        {
+            result->stub.original_expr = clone_expr_with_args(e->stub.original_expr, params, args);
+        }
+        break;
+        default:
+        {
+            // nie zawierają podwyrażeń
+        }
+        break;
+    }
+    return result;
+}
+
+// argumenty, które można wstawić w miejsce każdego użycia parametru - pozostałe są
+// najpierw zapisywane w zmiennych tymczasowych, tak jak przy zwykłym wywołaniu
+bool is_substitutable_arg(expr *e, bool body_is_pure)
+{
+    switch (e->kind)
+    {
+        case EXPR_INT:
+        case EXPR_FLOAT:
+        case EXPR_CHAR:
+        case EXPR_BOOL:
+        case EXPR_NULL:
+        case EXPR_SIZE_OF_TYPE:
+        {
+            return true;
+        }
+        break;
+        case EXPR_NAME:
+        {
+            if (map_get(&inline_arg_names, e->name))
+            {
+                return true;
+            }
+            // zmienną lokalną mogłoby zmienić tylko wywołanie wewnątrz ciała funkcji
+            return body_is_pure && null == map_get(&global_symbols, e->name);
+        }
+        break;
+        case EXPR_UNARY:
+        {
+            token_kind op = e->unary.operator;
+            return (op == TOKEN_SUB || op == TOKEN_ADD || op == TOKEN_NOT || op == TOKEN_BITWISE_NOT)
+                && is_substitutable_arg(e->unary.operand, body_is_pure);
+        }
+        break;
+        case EXPR_CAST:
+        {
+            return is_substitutable_arg(e->cast.expr, body_is_pure);
+        }
+        break;
+        case EXPR_STUB:
+        {
+            return e->stub.kind == STUB_EXPR_CAST
+                && is_substitutable_arg(e->stub.original_expr, body_is_pure);
+        }
+        break;
+        default:
+        {
+            return false;
+        }
+        break;
+    }
+    return false;
+}
+
+type *get_inline_arg_type(expr *arg)
+{
+    if (arg->resolved_type == null && arg->kind == EXPR_STUB && arg->stub.original_expr)
+    {
+        return arg->stub.original_expr->resolved_type;
+    }
+    return arg->resolved_type;
+}
+
+// zapisuje argument w nowej zmiennej lokalnej zadeklarowanej przed bieżącą instrukcją
+expr *bind_inline_arg(expr *arg, stmt ***hoisted)
+{
+    char name_buffer[64];
+    snprintf(name_buffer, sizeof(name_buffer), "___inline_arg_%zu___", inline_arg_count++);
+    const char *name = str_intern(name_buffer);
+    map_put(&inline_arg_names, name, (void *)name);
+
+    type *t = get_inline_arg_type(arg);
+
+    decl *d = push_struct(arena, decl);
+    *d = (decl){ .kind = DECL_VARIABLE, .name = name, .pos = arg->pos, .resolved_type = t };
+    d->variable.expr = arg;
+
+    stmt *st = push_struct(arena, stmt);
+    *st = (stmt){ .kind = STMT_DECL, .pos = arg->pos };
+    st->decl_stmt.decl = d;
+    buf_push(*hoisted, st);
+
+    expr *result = push_struct(arena, expr);
+    *result = (expr){ .kind = EXPR_NAME, .resolved_type = t, .pos = arg->pos };
+    result->name = name;
+    return result;
+}
+
+void mark_function_reachable_after_inlining(symbol *function)
+{
+    for (size_t i = 0; i < buf_len(inline_reachable_functions); i++)
+    {
+        if (inline_reachable_functions[i] == function)
+        {
+            return;
+        }
+    }
+    buf_push(inline_reachable_functions, function);
+}
+
+void inline_calls_in_expr(expr *e, size_t depth, stmt ***hoisted);
+
+// hoisted jest null, jeśli wyrażenie nie jest obliczane jako pierwsze w instrukcji
+// należącej do bloku - wtedy nie można przed nim zadeklarować zmiennych dla argumentów
+bool try_inline_call(expr *e, size_t depth, stmt ***hoisted)
+{
+    assert(e->kind == EXPR_CALL);
+    symbol *function = e->call.resolved_function;
+    if (function == null || depth >= MAX_INLINE_DEPTH || e->call.method_receiver)
+    {
+        return false;
+    }
+
+    expr *body = get_inlinable_body(function);
+    if (body == null)
+    {
+        return false;
+    }
+
+    function_param_list params = function->decl->function.params;
+    if ((size_t)params.param_count != e->call.args_num)
+    {
+        return false;
+    }
+
+    bool body_is_pure = is_pure_expr(body);
+    for (size_t i = 0; i < e->call.args_num; i++)
+    {
+        expr *arg = e->call.args[i];
+        if (is_substitutable_arg(arg, body_is_pure))
+        {
+            continue;
+        }
+
+        type *t = get_inline_arg_type(arg);
+        if (hoisted == null || t == null || t->kind == TYPE_ARRAY)
+        {
+            return false;
+        }
+    }
+
+    // argumenty są obliczane raz i po kolei, przed ciałem funkcji
+    expr **args = null;
+    if (e->call.args_num > 0)
+    {
+        args = push_size(arena, sizeof(expr *) * e->call.args_num);
+        for (size_t i = 0; i < e->call.args_num; i++)
+        {
+            expr *arg = e->call.args[i];
+            args[i] = is_substitutable_arg(arg, body_is_pure) ? arg : bind_inline_arg(arg, hoisted);
+        }
+    }
+
+    expr *inlined = clone_expr_with_args(body, params, args);
+    inlined->resolved_type = e->resolved_type;
+    inlined->pos = e->pos;
+    *e = *inlined;
+
+    // wstawione ciało może zawierać kolejne wywołania
+    inline_calls_in_expr(e, depth + 1, hoisted);
+    return true;
+}
+
+void inline_calls_in_expr(expr *e, size_t depth, stmt ***hoisted)
+{
+    if (e == null)
+    {
+        return;
+    }
+
+    // tylko pierwsze obliczane podwyrażenie zachowuje możliwość deklarowania zmiennych
+    switch (e->kind)
+    {
+        case EXPR_NAME:
+        {
+            // funkcja użyta jako wartość
+            if (e->resolved_type && e->resolved_type->kind == TYPE_FUNCTION)
+            {
+                symbol *sym = map_get(&global_symbols, e->name);
+                for (symbol *overload = sym; overload; overload = overload->next_overload)
+                {
+                    mark_function_reachable_after_inlining(overload);
+                }
+            }
+        }
+        break;
+        case EXPR_UNARY:
+        {
+            inline_calls_in_expr(e->unary.operand, depth, hoisted);
+        }
+        break;
+        case EXPR_BINARY:
+        {
+            inline_calls_in_expr(e->binary.left, depth, hoisted);
+            inline_calls_in_expr(e->binary.right, depth, null);
+        }
+        break;
+        case EXPR_TERNARY:
+        {
+            inline_calls_in_expr(e->ternary.condition, depth, hoisted);
+            inline_calls_in_expr(e->ternary.if_true, depth, null);
+            inline_calls_in_expr(e->ternary.if_false, depth, null);
+        }
+        break;
+        case EXPR_CALL:
+        {
+            bool direct_call = (e->call.function_expr->kind == EXPR_NAME && e->call.method_receiver == null);
+            if (e->call.function_expr->kind != EXPR_NAME)
+            {
+                inline_calls_in_expr(e->call.function_expr, depth, null);
+            }
+            inline_calls_in_expr(e->call.method_receiver, depth, null);
+            for (size_t i = 0; i < e->call.args_num; i++)
+            {
+                inline_calls_in_expr(e->call.args[i], depth, (i == 0 && direct_call) ? hoisted : null);
+            }
+
+            if (false == try_inline_call(e, depth, hoisted) && e->call.resolved_function)
+            {
+                mark_function_reachable_after_inlining(e->call.resolved_function);
+            }
+        }
+        break;
+        case EXPR_FIELD:
+        {
+            inline_calls_in_expr(e->field.expr, depth, hoisted);
+        }
+        break;
+        case EXPR_INDEX:
+        {
+            inline_calls_in_expr(e->index.array_expr, depth, null);
+            inline_calls_in_expr(e->index.index_expr, depth, null);
+        }
+        break;
+        case EXPR_SIZE_OF:
+        {
+            inline_calls_in_expr(e->size_of.expr, depth, null);
+        }
+        break;
+        case EXPR_CAST:
+        {
+            inline_calls_in_expr(e->cast.expr, depth, hoisted);
+        }
+        break;
+        case EXPR_COMPOUND_LITERAL:
+        {
+            for (size_t i = 0; i < e->compound.fields_count; i++)
+            {
+                inline_calls_in_expr(e->compound.fields[i]->expr, depth, null);
+            }
+        }
+        break;
+        case EXPR_STUB:
+        {
+            inline_calls_in_expr(e->stub.original_expr, depth, hoisted);
+        }
+        break;
+        default:
+        {
+            // nie zawierają podwyrażeń
+        }
+        break;
+    }
+}
+
+void inline_calls_in_stmt_block(stmt_block *block);
+
+// hoisted jest null dla instrukcji, które nie należą bezpośrednio do bloku
+void inline_calls_in_stmt(stmt *st, stmt ***hoisted)
+{
+    switch (st->kind)
+    {
+        case STMT_RETURN:
+        {
+            inline_calls_in_expr(st->return_stmt.ret_expr, 0, hoisted);
+        }
+        break;
+        case STMT_DECL:
+        {
+            if (st->decl_stmt.decl->kind == DECL_VARIABLE)
+            {
+                inline_calls_in_expr(st->decl_stmt.decl->variable.expr, 0, hoisted);
+            }
+        }
+        break;
+        case STMT_IF_ELSE:
+        {
+            inline_calls_in_expr(st->if_else.cond_expr, 0, hoisted);
+            inline_calls_in_stmt_block(&st->if_else.then_block);
+            if (st->if_else.else_stmt)
+            {
+                inline_calls_in_stmt(st->if_else.else_stmt, null);
+            }
+        }
+        break;
+        case STMT_WHILE:
+        case STMT_DO_WHILE:
+        {
+            // warunek jest obliczany w każdym przebiegu pętli
+            inline_calls_in_expr(st->while_stmt.cond_expr, 0, null);
+            inline_calls_in_stmt_block(&st->while_stmt.stmts);
+        }
+        break;
+        case STMT_FOR:
+        {
+            if (st->for_stmt.init_stmt)
+            {
+                inline_calls_in_stmt(st->for_stmt.init_stmt, hoisted);
+            }
+            inline_calls_in_expr(st->for_stmt.cond_expr, 0, null);
+            if (st->for_stmt.next_stmt)
+            {
+                inline_calls_in_stmt(st->for_stmt.next_stmt, null);
+            }
+            inline_calls_in_stmt_block(&st->for_stmt.stmts);
+        }
+        break;
+        case STMT_ASSIGN:
+        {
+            // przy przypisaniu do elementu tablicy lub pola kolejność obliczania ma znaczenie
+            bool plain_target = (st->assign.assigned_var_expr->kind == EXPR_NAME);
+            inline_calls_in_expr(st->assign.assigned_var_expr, 0, null);
+            inline_calls_in_expr(st->assign.value_expr, 0, plain_target ? hoisted : null);
+        }
+        break;
+        case STMT_SWITCH:
+        {
+            inline_calls_in_expr(st->switch_stmt.var_expr, 0, hoisted);
+            for (size_t i = 0; i < st->switch_stmt.cases_num; i++)
+            {
+                inline_calls_in_stmt_block(&st->switch_stmt.cases[i]->stmts);
+            }
+        }
+        break;
+        case STMT_EXPR:
+        {
+            inline_calls_in_expr(st->expr, 0, hoisted);
+        }
+        break;
+        case STMT_BLOCK:
+        {
+            inline_calls_in_stmt_block(&st->block);
+        }
+        break;
+        case STMT_DELETE:
+        {
+            inline_calls_in_expr(st->delete.expr, 0, hoisted);
+        }
+        break;
+        case STMT_INC:
+        {
+            inline_calls_in_expr(st->inc.operand, 0, null);
+        }
+        break;
+        default:
+        {
+            // break, continue
+        }
+        break;
+    }
+}
+
+void inline_calls_in_stmt_block(stmt_block *block)
+{
+    stmt **hoisted = null;
+    stmt **result = null;
+    for (size_t i = 0; i < block->stmts_count; i++)
+    {
+        inline_calls_in_stmt(block->stmts[i], &hoisted);
+        if (buf_len(hoisted) > 0 && result == null)
+        {
+            for (size_t k = 0; k < i; k++)
+            {
+                buf_push(result, block->stmts[k]);
+            }
+        }
+
+        if (result)
+        {
+            for (size_t k = 0; k < buf_len(hoisted); k++)
+            {
+                buf_push(result, hoisted[k]);
+            }
+            buf_push(result, block->stmts[i]);
+        }
+        buf_free(hoisted);
+    }
+
+    if (result)
+    {
+        block->stmts = push_size(arena, sizeof(stmt *) * buf_len(result));
+        memcpy(block->stmts, result, sizeof(stmt *) * buf_len(result));
+        block->stmts_count = buf_len(result);
+        buf_free(result);
+    }
+}
+
+// zwraca listę bez funkcji, które po wstawieniu nie są już nigdzie wywoływane
+symbol **inline_small_functions(symbol **resolved)
+{
+    map_grow(&inline_candidates, 32);
+    map_grow(&inline_arg_names, 32);
+    inline_arg_count = 0;
+
+    // ciała są zapamiętywane, zanim wstawianie zmieni którąkolwiek funkcję
+    for (size_t i = 0; i < buf_len(resolved); i++)
+    {
+        if (resolved[i]->kind == SYMBOL_FUNCTION)
+        {
+            get_inlinable_body(resolved[i]);
+        }
+    }
+
+    symbol *main_function = null;
+    for (size_t i = 0; i < buf_len(resolved); i++)
+    {
+        symbol *sym = resolved[i];
+        if (sym->kind == SYMBOL_FUNCTION && sym->name == main_str)
+        {
+            main_function = sym;
+        }
+        else if (sym->kind == SYMBOL_VARIABLE
+            && sym->decl->variable.expr
+            && null == sym->decl->variable.folded_value)
+        {
+            inline_calls_in_expr(sym->decl->variable.expr, 0, null);
+        }
+    }
+
+    if (main_function == null)
+    {
+        buf_free(inline_reachable_functions);
+        map_free(&inline_candidates);
+        map_free(&inline_arg_names);
+        return resolved;
+    }
+
+    // kolejka rośnie w trakcie - przechodzimy tylko przez funkcje, które wciąż są wywoływane
+    mark_function_reachable_after_inlining(main_function);
+    for (size_t i = 0; i < buf_len(inline_reachable_functions); i++)
+    {
+        decl *d = inline_reachable_functions[i]->decl;
+        if (d && false == d->function.is_extern)
+        {
+            inline_calls_in_stmt_block(&d->function.stmts);
+        }
+    }
+
+    symbol **result = null;
+    for (size_t i = 0; i < buf_len(resolved); i++)
+    {
+        symbol *sym = resolved[i];
+        bool keep = true;
+        if (sym->kind == SYMBOL_FUNCTION)
+        {
+            keep = false;
+            for (size_t j = 0; j < buf_len(inline_reachable_functions); j++)
+            {
+                if (inline_reachable_functions[j] == sym)
+                {
+                    keep = true;
+                    break;
+                }
+            }
+        }
+
+        if (keep)
+        {
+            buf_push(result, sym);
+        }
+    }
+
+    buf_free(inline_reachable_functions);
+    map_free(&inline_candidates);
+    map_free(&inline_arg_names);
+    return result;
+}
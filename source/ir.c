@@ -0,0 +1,1383 @@
+// pośrednia reprezentacja w postaci SSA, budowana z rozwiązanego AST
+// obsługuje funkcje operujące wyłącznie na wartościach skalarnych -
+// dla pozostałych build_ir_function zwraca null i backend korzysta z AST
+
+typedef struct ir_block ir_block;
+typedef struct ir_instr ir_instr;
+
+typedef enum ir_opcode
+{
+    IR_NONE = 0, // instrukcja usunięta
+    IR_CONST,
+    IR_PARAM,
+    IR_PHI,
+    IR_UNARY,
+    IR_BINARY,
+    IR_CAST,
+    IR_LOAD_GLOBAL,
+    IR_STORE_GLOBAL,
+    IR_CALL,
+
+    IR_JUMP,
+    IR_BRANCH,
+    IR_RETURN,
+} ir_opcode;
+
+struct ir_instr
+{
+    ir_opcode opcode;
+    size_t id;
+    type *type; // null, jeśli instrukcja nie zwraca wartości
+    ir_block *block; // null dla stałych
+    source_pos pos;
+
+    ir_instr **operands;
+    token_kind operator; // IR_UNARY, IR_BINARY
+    union
+    {
+        uint64_t int_value; // IR_CONST dla typów całkowitych, bool i wskaźników
+        float float_value; // IR_CONST dla float
+        size_t param_index; // IR_PARAM
+        symbol *global; // IR_LOAD_GLOBAL, IR_STORE_GLOBAL
+        symbol *function; // IR_CALL
+    };
+    ir_block *targets[2]; // IR_JUMP, IR_BRANCH
+
+    ir_instr *replacement; // ustawiane, gdy instrukcja została zastąpiona inną wartością
+    size_t phi_variable; // używane tylko podczas budowania
+};
+
+struct ir_block
+{
+    size_t id;
+    ir_instr **instrs;
+    ir_block **preds;
+
+    // budowanie SSA
+    hashmap definitions;
+    ir_instr **incomplete_phis;
+    bool sealed;
+
+    // analizy
+    ir_block *idom;
+    size_t rpo_index;
+    bool visited;
+};
+
+typedef struct ir_function
+{
+    symbol *symbol;
+    ir_block **blocks; // pierwszy blok jest wejściowy
+    ir_instr **constants;
+    size_t next_instr_id;
+    size_t next_block_id;
+} ir_function;
+
+typedef struct ir_local_variable
+{
+    const char *name;
+    size_t index;
+} ir_local_variable;
+
+typedef struct ir_builder
+{
+    ir_function *function;
+    ir_block *current;
+    ir_local_variable *scope; // stos widocznych zmiennych lokalnych
+    type **variable_types;
+    ir_block **break_targets;
+    ir_block **continue_targets;
+    bool failed;
+} ir_builder;
+
+hashmap ir_functions;
+
+bool is_ir_scalar_type(type *t)
+{
+    if (t == null)
+    {
+        return false;
+    }
+
+    switch (t->kind)
+    {
+        case TYPE_CHAR:
+        case TYPE_INT:
+        case TYPE_LONG:
+        case TYPE_UINT:
+        case TYPE_ULONG:
+        case TYPE_FLOAT:
+        case TYPE_BOOL:
+        case TYPE_ENUM:
+        case TYPE_POINTER:
+        case TYPE_NULL:
+        {
+            return true;
+        }
+        break;
+        default:
+        {
+            return false;
+        }
+        break;
+    }
+    return false;
+}
+
+// w C operacje na char są wykonywane na int - wynik zapisany do zmiennej
+// tymczasowej typu char byłby obcięty, czego nie robi wyrażenie wygenerowane z AST
+bool is_ir_promoted_type(type *t)
+{
+    bool result = (get_type_size(t) >= 4);
+    return result;
+}
+
+bool is_comparison_operator(token_kind op)
+{
+    bool result = (op >= TOKEN_FIRST_CMP_OPERATOR && op <= TOKEN_LAST_CMP_OPERATOR);
+    return result;
+}
+
+ir_instr *ir_resolve(ir_instr *instr)
+{
+    while (instr && instr->replacement)
+    {
+        instr = instr->replacement;
+    }
+    return instr;
+}
+
+bool ir_is_terminator(ir_instr *instr)
+{
+    bool result = (instr->opcode == IR_JUMP
+        || instr->opcode == IR_BRANCH
+        || instr->opcode == IR_RETURN);
+    return result;
+}
+
+ir_instr *ir_get_terminator(ir_block *block)
+{
+    size_t count = buf_len(block->instrs);
+    if (count > 0 && ir_is_terminator(block->instrs[count - 1]))
+    {
+        return block->instrs[count - 1];
+    }
+    return null;
+}
+
+size_t ir_get_successors(ir_block *block, ir_block **successors)
+{
+    ir_instr *terminator = ir_get_terminator(block);
+    if (terminator == null || terminator->opcode == IR_RETURN)
+    {
+        return 0;
+    }
+    successors[0] = terminator->targets[0];
+    if (terminator->opcode == IR_BRANCH)
+    {
+        successors[1] = terminator->targets[1];
+        return 2;
+    }
+    return 1;
+}
+
+// typy całkowite są przechowywane w postaci rozszerzonej do 64 bitów
+uint64_t ir_normalize_int(type *t, uint64_t value)
+{
+    switch (t->kind)
+    {
+        case TYPE_CHAR: return (uint8_t)value;
+        case TYPE_INT: return (uint64_t)(int64_t)(int32_t)value;
+        case TYPE_UINT: return (uint32_t)value;
+        case TYPE_BOOL: return value != 0;
+        default: return value;
+    }
+}
+
+ir_instr *ir_const_int(ir_function *f, type *t, uint64_t value)
+{
+    ir_instr *instr = push_struct(arena, ir_instr);
+    instr->opcode = IR_CONST;
+    instr->id = f->next_instr_id++;
+    instr->type = t;
+    instr->int_value = ir_normalize_int(t, value);
+    buf_push(f->constants, instr);
+    return instr;
+}
+
+ir_instr *ir_const_float(ir_function *f, float value)
+{
+    ir_instr *instr = push_struct(arena, ir_instr);
+    instr->opcode = IR_CONST;
+    instr->id = f->next_instr_id++;
+    instr->type = type_float;
+    instr->float_value = value;
+    buf_push(f->constants, instr);
+    return instr;
+}
+
+ir_instr *ir_zero_value(ir_function *f, type *t)
+{
+    if (t->kind == TYPE_FLOAT)
+    {
+        return ir_const_float(f, 0.0f);
+    }
+    return ir_const_int(f, t, 0);
+}
+
+ir_block *ir_new_block(ir_function *f)
+{
+    ir_block *block = push_struct(arena, ir_block);
+    block->id = f->next_block_id++;
+    map_grow(&block->definitions, 16);
+    buf_push(f->blocks, block);
+    return block;
+}
+
+ir_instr *ir_new_instr(ir_function *f, ir_opcode opcode, type *t, source_pos pos)
+{
+    ir_instr *instr = push_struct(arena, ir_instr);
+    instr->opcode = opcode;
+    instr->id = f->next_instr_id++;
+    instr->type = t;
+    instr->pos = pos;
+    return instr;
+}
+
+void ir_append(ir_block *block, ir_instr *instr)
+{
+    instr->block = block;
+    buf_push(block->instrs, instr);
+}
+
+// usuwa instrukcję z bloku, zachowując kolejność pozostałych
+void ir_remove_from_block(ir_instr *instr)
+{
+    ir_block *block = instr->block;
+    size_t count = buf_len(block->instrs);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (block->instrs[i] == instr)
+        {
+            for (size_t j = i + 1; j < count; j++)
+            {
+                block->instrs[j - 1] = block->instrs[j];
+            }
+            buf_pop(block->instrs);
+            break;
+        }
+    }
+    instr->block = null;
+}
+
+void ir_insert_before_terminator(ir_block *block, ir_instr *instr)
+{
+    ir_instr *terminator = ir_get_terminator(block);
+    assert(terminator);
+    buf_push(block->instrs, terminator);
+    block->instrs[buf_len(block->instrs) - 2] = instr;
+    instr->block = block;
+}
+
+void ir_add_edge(ir_block *from, ir_block *to)
+{
+    buf_push(to->preds, from);
+}
+
+// usuwa krawędź wraz z odpowiadającymi jej operandami phi
+void ir_remove_edge(ir_block *from, ir_block *to)
+{
+    size_t count = buf_len(to->preds);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (to->preds[i] == from)
+        {
+            for (size_t j = i + 1; j < count; j++)
+            {
+                to->preds[j - 1] = to->preds[j];
+            }
+            buf_pop(to->preds);
+
+            for (size_t k = 0; k < buf_len(to->instrs); k++)
+            {
+                ir_instr *phi = to->instrs[k];
+                if (phi->opcode != IR_PHI)
+                {
+                    break;
+                }
+                size_t operands_count = buf_len(phi->operands);
+                for (size_t j = i + 1; j < operands_count; j++)
+                {
+                    phi->operands[j - 1] = phi->operands[j];
+                }
+                buf_pop(phi->operands);
+            }
+            return;
+        }
+    }
+}
+
+void ir_replace(ir_instr *instr, ir_instr *replacement)
+{
+    assert(instr != replacement);
+    instr->replacement = replacement;
+    if (instr->block)
+    {
+        ir_remove_from_block(instr);
+    }
+    instr->opcode = IR_NONE;
+}
+
+// po zastąpieniu instrukcji trzeba przepiąć operandy, które się do nich odnoszą
+void ir_apply_replacements(ir_function *f)
+{
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        ir_block *block = f->blocks[i];
+        for (size_t k = 0; k < buf_len(block->instrs); k++)
+        {
+            ir_instr *instr = block->instrs[k];
+            for (size_t j = 0; j < buf_len(instr->operands); j++)
+            {
+                instr->operands[j] = ir_resolve(instr->operands[j]);
+            }
+        }
+    }
+}
+
+//
+// budowanie SSA - na podstawie algorytmu Brauna i in.
+//
+
+ir_instr *ir_read_variable(ir_builder *b, size_t variable, ir_block *block);
+
+void ir_write_variable(size_t variable, ir_block *block, ir_instr *value)
+{
+    map_put(&block->definitions, variable + 1, value);
+}
+
+ir_instr *ir_new_phi(ir_builder *b, ir_block *block, size_t variable)
+{
+    ir_instr *phi = ir_new_instr(b->function, IR_PHI, b->variable_types[variable], (source_pos){ 0 });
+    phi->phi_variable = variable;
+    phi->block = block;
+
+    // phi zawsze znajdują się na początku bloku
+    buf_push(block->instrs, phi);
+    size_t index = buf_len(block->instrs) - 1;
+    while (index > 0 && block->instrs[index - 1]->opcode != IR_PHI)
+    {
+        block->instrs[index] = block->instrs[index - 1];
+        index--;
+    }
+    block->instrs[index] = phi;
+    return phi;
+}
+
+ir_instr *ir_try_remove_trivial_phi(ir_function *f, ir_instr *phi)
+{
+    ir_instr *same = null;
+    for (size_t i = 0; i < buf_len(phi->operands); i++)
+    {
+        ir_instr *operand = ir_resolve(phi->operands[i]);
+        if (operand == same || operand == phi)
+        {
+            continue;
+        }
+        if (same != null)
+        {
+            return phi;
+        }
+        same = operand;
+    }
+
+    if (same == null)
+    {
+        // wartość niezdefiniowana - np. w nieosiągalnym bloku
+        same = ir_zero_value(f, phi->type);
+    }
+
+    ir_replace(phi, same);
+    return same;
+}
+
+ir_instr *ir_add_phi_operands(ir_builder *b, size_t variable, ir_instr *phi)
+{
+    ir_block *block = phi->block;
+    for (size_t i = 0; i < buf_len(block->preds); i++)
+    {
+        buf_push(phi->operands, ir_read_variable(b, variable, block->preds[i]));
+    }
+    return ir_try_remove_trivial_phi(b->function, phi);
+}
+
+ir_instr *ir_read_variable_recursive(ir_builder *b, size_t variable, ir_block *block)
+{
+    ir_instr *value = null;
+    if (false == block->sealed)
+    {
+        ir_instr *phi = ir_new_phi(b, block, variable);
+        buf_push(block->incomplete_phis, phi);
+        value = phi;
+    }
+    else if (buf_len(block->preds) == 0)
+    {
+        value = ir_zero_value(b->function, b->variable_types[variable]);
+    }
+    else if (buf_len(block->preds) == 1)
+    {
+        value = ir_read_variable(b, variable, block->preds[0]);
+    }
+    else
+    {
+        // zapisujemy phi przed odczytem poprzedników, żeby przerwać cykle
+        ir_instr *phi = ir_new_phi(b, block, variable);
+        ir_write_variable(variable, block, phi);
+        value = ir_add_phi_operands(b, variable, phi);
+    }
+    ir_write_variable(variable, block, value);
+    return value;
+}
+
+ir_instr *ir_read_variable(ir_builder *b, size_t variable, ir_block *block)
+{
+    ir_instr *value = map_get(&block->definitions, variable + 1);
+    if (value)
+    {
+        return ir_resolve(value);
+    }
+    return ir_read_variable_recursive(b, variable, block);
+}
+
+void ir_seal_block(ir_builder *b, ir_block *block)
+{
+    assert(false == block->sealed);
+    for (size_t i = 0; i < buf_len(block->incomplete_phis); i++)
+    {
+        ir_instr *phi = block->incomplete_phis[i];
+        ir_add_phi_operands(b, phi->phi_variable, phi);
+    }
+    buf_free(block->incomplete_phis);
+    block->sealed = true;
+}
+
+size_t ir_new_variable(ir_builder *b, const char *name, type *t)
+{
+    size_t index = buf_len(b->variable_types);
+    buf_push(b->variable_types, t);
+    if (name)
+    {
+        ir_local_variable local = { .name = name, .index = index };
+        buf_push(b->scope, local);
+    }
+    return index;
+}
+
+bool ir_find_local_variable(ir_builder *b, const char *name, size_t *index)
+{
+    for (size_t i = buf_len(b->scope); i > 0; i--)
+    {
+        if (b->scope[i - 1].name == name)
+        {
+            *index = b->scope[i - 1].index;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ir_leave_scope(ir_builder *b, size_t marker)
+{
+    while (buf_len(b->scope) > marker)
+    {
+        buf_pop(b->scope);
+    }
+}
+
+// kod po return, break lub continue trafia do bloku bez poprzedników
+ir_block *ir_get_current_block(ir_builder *b)
+{
+    if (b->current == null)
+    {
+        b->current = ir_new_block(b->function);
+        b->current->sealed = true;
+    }
+    return b->current;
+}
+
+ir_instr *ir_emit(ir_builder *b, ir_instr *instr)
+{
+    ir_append(ir_get_current_block(b), instr);
+    return instr;
+}
+
+void ir_emit_jump(ir_builder *b, ir_block *target)
+{
+    if (b->current == null)
+    {
+        return;
+    }
+    ir_instr *jump = ir_new_instr(b->function, IR_JUMP, null, (source_pos){ 0 });
+    jump->targets[0] = target;
+    ir_append(b->current, jump);
+    ir_add_edge(b->current, target);
+    b->current = null;
+}
+
+void ir_emit_branch(ir_builder *b, ir_instr *cond, ir_block *if_true, ir_block *if_false)
+{
+    ir_instr *branch = ir_new_instr(b->function, IR_BRANCH, null, (source_pos){ 0 });
+    buf_push(branch->operands, cond);
+    branch->targets[0] = if_true;
+    branch->targets[1] = if_false;
+    ir_block *block = ir_get_current_block(b);
+    ir_append(block, branch);
+    ir_add_edge(block, if_true);
+    ir_add_edge(block, if_false);
+    b->current = null;
+}
+
+ir_instr *ir_emit_cast(ir_builder *b, ir_instr *value, type *target, source_pos pos)
+{
+    if (value == null || value->type == target)
+    {
+        return value;
+    }
+    ir_instr *cast = ir_new_instr(b->function, IR_CAST, target, pos);
+    buf_push(cast->operands, value);
+    return ir_emit(b, cast);
+}
+
+ir_instr *ir_build_expr(ir_builder *b, expr *e);
+
+// && i || wymagają skrócenia obliczeń, więc budujemy je jako rozgałęzienie
+ir_instr *ir_build_logical_expr(ir_builder *b, expr *e)
+{
+    bool is_and = (e->binary.operator == TOKEN_AND);
+    size_t result = ir_new_variable(b, null, e->resolved_type);
+
+    ir_instr *left = ir_build_expr(b, e->binary.left);
+    if (b->failed)
+    {
+        return null;
+    }
+
+    ir_block *right_block = ir_new_block(b->function);
+    ir_block *merge_block = ir_new_block(b->function);
+
+    ir_write_variable(result, ir_get_current_block(b), ir_const_int(b->function, e->resolved_type, is_and ? 0 : 1));
+    if (is_and)
+    {
+        ir_emit_branch(b, left, right_block, merge_block);
+    }
+    else
+    {
+        ir_emit_branch(b, left, merge_block, right_block);
+    }
+    ir_seal_block(b, right_block);
+
+    b->current = right_block;
+    ir_instr *right = ir_build_expr(b, e->binary.right);
+    if (b->failed)
+    {
+        return null;
+    }
+
+    ir_instr *right_bool = ir_new_instr(b->function, IR_BINARY, e->resolved_type, e->pos);
+    right_bool->operator = TOKEN_NEQ;
+    buf_push(right_bool->operands, right);
+    buf_push(right_bool->operands, ir_zero_value(b->function, right->type));
+    ir_emit(b, right_bool);
+
+    ir_write_variable(result, ir_get_current_block(b), right_bool);
+    ir_emit_jump(b, merge_block);
+    ir_seal_block(b, merge_block);
+
+    b->current = merge_block;
+    return ir_read_variable(b, result, merge_block);
+}
+
+ir_instr *ir_build_ternary_expr(ir_builder *b, expr *e)
+{
+    size_t result = ir_new_variable(b, null, e->resolved_type);
+
+    ir_instr *cond = ir_build_expr(b, e->ternary.condition);
+    if (b->failed)
+    {
+        return null;
+    }
+
+    ir_block *true_block = ir_new_block(b->function);
+    ir_block *false_block = ir_new_block(b->function);
+    ir_block *merge_block = ir_new_block(b->function);
+
+    ir_emit_branch(b, cond, true_block, false_block);
+    ir_seal_block(b, true_block);
+    ir_seal_block(b, false_block);
+
+    b->current = true_block;
+    ir_instr *if_true = ir_emit_cast(b, ir_build_expr(b, e->ternary.if_true), e->resolved_type, e->pos);
+    if (b->failed)
+    {
+        return null;
+    }
+    ir_write_variable(result, ir_get_current_block(b), if_true);
+    ir_emit_jump(b, merge_block);
+
+    b->current = false_block;
+    ir_instr *if_false = ir_emit_cast(b, ir_build_expr(b, e->ternary.if_false), e->resolved_type, e->pos);
+    if (b->failed)
+    {
+        return null;
+    }
+    ir_write_variable(result, ir_get_current_block(b), if_false);
+    ir_emit_jump(b, merge_block);
+
+    ir_seal_block(b, merge_block);
+    b->current = merge_block;
+    return ir_read_variable(b, result, merge_block);
+}
+
+bool is_ir_callable(symbol *function)
+{
+    if (function == null
+        || function->kind != SYMBOL_FUNCTION
+        || function->mangled_name == null)
+    {
+        return false;
+    }
+
+    type_function signature = function->type->function;
+    if (signature.has_variadic_arg || signature.receiver_type)
+    {
+        return false;
+    }
+
+    if (signature.return_type != type_void && false == is_ir_scalar_type(signature.return_type))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < signature.param_count; i++)
+    {
+        if (false == is_ir_scalar_type(signature.param_types[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+ir_instr *ir_build_name_expr(ir_builder *b, expr *e)
+{
+    size_t variable = 0;
+    if (ir_find_local_variable(b, e->name, &variable))
+    {
+        return ir_read_variable(b, variable, ir_get_current_block(b));
+    }
+
+    symbol *sym = map_get(&global_symbols, e->name);
+    if (sym && sym->kind == SYMBOL_CONST && is_integer_type(e->resolved_type))
+    {
+        return ir_const_int(b->function, e->resolved_type, (uint64_t)sym->val);
+    }
+
+    if (sym && sym->kind == SYMBOL_VARIABLE && is_ir_scalar_type(sym->type))
+    {
+        ir_instr *load = ir_new_instr(b->function, IR_LOAD_GLOBAL, sym->type, e->pos);
+        load->global = sym;
+        return ir_emit_cast(b, ir_emit(b, load), e->resolved_type, e->pos);
+    }
+
+    b->failed = true;
+    return null;
+}
+
+ir_instr *ir_build_expr(ir_builder *b, expr *e)
+{
+    if (b->failed)
+    {
+        return null;
+    }
+
+    if (false == is_ir_scalar_type(e->resolved_type)
+        && false == (e->kind == EXPR_CALL && e->resolved_type == type_void))
+    {
+        b->failed = true;
+        return null;
+    }
+
+    switch (e->kind)
+    {
+        case EXPR_INT:
+        {
+            // literał, który nie mieści się w swoim typie, jest w C typu long
+            type *t = e->resolved_type;
+            if (ir_normalize_int(t, e->integer_value) != e->integer_value)
+            {
+                t = (e->integer_value > INT64_MAX) ? type_ulong : type_long;
+            }
+            return ir_const_int(b->function, t, e->integer_value);
+        }
+        break;
+        case EXPR_BOOL:
+        {
+            return ir_const_int(b->function, e->resolved_type, e->bool_value ? 1 : 0);
+        }
+        break;
+        case EXPR_CHAR:
+        {
+            return ir_const_int(b->function, e->resolved_type, (uint8_t)e->string_value[0]);
+        }
+        break;
+        case EXPR_FLOAT:
+        {
+            return ir_const_float(b->function, e->float_value);
+        }
+        break;
+        case EXPR_NULL:
+        {
+            return ir_const_int(b->function, e->resolved_type, 0);
+        }
+        break;
+        case EXPR_NAME:
+        {
+            return ir_build_name_expr(b, e);
+        }
+        break;
+        case EXPR_UNARY:
+        {
+            if (e->unary.operator != TOKEN_SUB
+                && e->unary.operator != TOKEN_ADD
+                && e->unary.operator != TOKEN_NOT
+                && e->unary.operator != TOKEN_BITWISE_NOT)
+            {
+                b->failed = true;
+                return null;
+            }
+
+            if (false == is_ir_promoted_type(e->resolved_type) && e->unary.operator != TOKEN_NOT)
+            {
+                b->failed = true;
+                return null;
+            }
+
+            ir_instr *operand = ir_build_expr(b, e->unary.operand);
+            if (b->failed)
+            {
+                return null;
+            }
+
+            ir_instr *instr = ir_new_instr(b->function, IR_UNARY, e->resolved_type, e->pos);
+            instr->operator = e->unary.operator;
+            buf_push(instr->operands, operand);
+            return ir_emit(b, instr);
+        }
+        break;
+        case EXPR_BINARY:
+        {
+            if (e->binary.operator == TOKEN_AND || e->binary.operator == TOKEN_OR)
+            {
+                return ir_build_logical_expr(b, e);
+            }
+
+            if (false == is_ir_promoted_type(e->resolved_type) && false == is_comparison_operator(e->binary.operator))
+            {
+                b->failed = true;
+                return null;
+            }
+
+            ir_instr *left = ir_build_expr(b, e->binary.left);
+            ir_instr *right = ir_build_expr(b, e->binary.right);
+            if (b->failed)
+            {
+                return null;
+            }
+
+            ir_instr *instr = ir_new_instr(b->function, IR_BINARY, e->resolved_type, e->pos);
+            instr->operator = e->binary.operator;
+            buf_push(instr->operands, left);
+            buf_push(instr->operands, right);
+            return ir_emit(b, instr);
+        }
+        break;
+        case EXPR_TERNARY:
+        {
+            return ir_build_ternary_expr(b, e);
+        }
+        break;
+        case EXPR_CALL:
+        {
+            symbol *function = e->call.resolved_function;
+            if (e->call.method_receiver
+                || e->call.function_expr->kind != EXPR_NAME
+                || false == is_ir_callable(function)
+                || e->call.args_num != function->type->function.param_count)
+            {
+                b->failed = true;
+                return null;
+            }
+
+            ir_instr *call = ir_new_instr(b->function, IR_CALL,
+                e->resolved_type == type_void ? null : e->resolved_type, e->pos);
+            call->function = function;
+            for (size_t i = 0; i < e->call.args_num; i++)
+            {
+                ir_instr *arg = ir_build_expr(b, e->call.args[i]);
+                if (b->failed)
+                {
+                    return null;
+                }
+                buf_push(call->operands, ir_emit_cast(b, arg, function->type->function.param_types[i], e->pos));
+            }
+            return ir_emit(b, call);
+        }
+        break;
+        case EXPR_CAST:
+        {
+            ir_instr *value = ir_build_expr(b, e->cast.expr);
+            return ir_emit_cast(b, value, e->resolved_type, e->pos);
+        }
+        break;
+        case EXPR_FIELD:
+        {
+            // tylko wartości wyliczeń
+            type *base_type = e->field.expr->resolved_type;
+            if (base_type && base_type->kind == TYPE_ENUM)
+            {
+                int64_t *val = map_get(&base_type->enumeration.values, e->field.field_name);
+                if (val)
+                {
+                    return ir_const_int(b->function, e->resolved_type, (uint64_t)*val);
+                }
+            }
+            b->failed = true;
+            return null;
+        }
+        break;
+        case EXPR_STUB:
+        {
+            if (e->stub.kind == STUB_EXPR_CAST)
+            {
+                ir_instr *value = ir_build_expr(b, e->stub.original_expr);
+                return ir_emit_cast(b, value, e->resolved_type, e->pos);
+            }
+            b->failed = true;
+            return null;
+        }
+        break;
+        default:
+        {
+            b->failed = true;
+            return null;
+        }
+        break;
+    }
+    return null;
+}
+
+void ir_build_assignment(ir_builder *b, expr *target, ir_instr *value, source_pos pos)
+{
+    if (b->failed)
+    {
+        return;
+    }
+
+    if (target->kind != EXPR_NAME)
+    {
+        b->failed = true;
+        return;
+    }
+
+    size_t variable = 0;
+    if (ir_find_local_variable(b, target->name, &variable))
+    {
+        value = ir_emit_cast(b, value, b->variable_types[variable], pos);
+        ir_write_variable(variable, ir_get_current_block(b), value);
+        return;
+    }
+
+    symbol *sym = map_get(&global_symbols, target->name);
+    if (sym && sym->kind == SYMBOL_VARIABLE && is_ir_scalar_type(sym->type))
+    {
+        ir_instr *store = ir_new_instr(b->function, IR_STORE_GLOBAL, null, pos);
+        store->global = sym;
+        buf_push(store->operands, ir_emit_cast(b, value, sym->type, pos));
+        ir_emit(b, store);
+        return;
+    }
+
+    b->failed = true;
+}
+
+void ir_build_stmt(ir_builder *b, stmt *st);
+
+void ir_build_stmt_block(ir_builder *b, stmt_block block)
+{
+    size_t marker = buf_len(b->scope);
+    for (size_t i = 0; i < block.stmts_count && false == b->failed; i++)
+    {
+        ir_build_stmt(b, block.stmts[i]);
+    }
+    ir_leave_scope(b, marker);
+}
+
+void ir_build_loop_body(ir_builder *b, stmt_block body, ir_block *break_target, ir_block *continue_target)
+{
+    buf_push(b->break_targets, break_target);
+    buf_push(b->continue_targets, continue_target);
+    ir_build_stmt_block(b, body);
+    buf_pop(b->break_targets);
+    buf_pop(b->continue_targets);
+}
+
+void ir_build_stmt(ir_builder *b, stmt *st)
+{
+    if (b->failed)
+    {
+        return;
+    }
+
+    switch (st->kind)
+    {
+        case STMT_RETURN:
+        {
+            ir_instr *ret = ir_new_instr(b->function, IR_RETURN, null, st->pos);
+            if (st->return_stmt.ret_expr)
+            {
+                ir_instr *value = ir_build_expr(b, st->return_stmt.ret_expr);
+                if (b->failed)
+                {
+                    return;
+                }
+                value = ir_emit_cast(b, value, b->function->symbol->type->function.return_type, st->pos);
+                buf_push(ret->operands, value);
+            }
+            ir_emit(b, ret);
+            b->current = null;
+        }
+        break;
+        case STMT_DECL:
+        {
+            decl *d = st->decl_stmt.decl;
+            if (d->kind != DECL_VARIABLE || false == is_ir_scalar_type(d->resolved_type))
+            {
+                b->failed = true;
+                return;
+            }
+
+            ir_instr *value = null;
+            if (d->variable.expr)
+            {
+                value = ir_emit_cast(b, ir_build_expr(b, d->variable.expr), d->resolved_type, st->pos);
+            }
+            else
+            {
+                value = ir_zero_value(b->function, d->resolved_type);
+            }
+
+            if (b->failed)
+            {
+                return;
+            }
+
+            size_t variable = ir_new_variable(b, d->name, d->resolved_type);
+            ir_write_variable(variable, ir_get_current_block(b), value);
+        }
+        break;
+        case STMT_ASSIGN:
+        {
+            if (st->assign.operation != TOKEN_ASSIGN || st->assign.value_expr == null)
+            {
+                b->failed = true;
+                return;
+            }
+            ir_instr *value = ir_build_expr(b, st->assign.value_expr);
+            ir_build_assignment(b, st->assign.assigned_var_expr, value, st->pos);
+        }
+        break;
+        case STMT_INC:
+        {
+            expr *operand = st->inc.operand;
+            if (operand->kind != EXPR_NAME || false == is_integer_type(operand->resolved_type))
+            {
+                b->failed = true;
+                return;
+            }
+
+            ir_instr *value = ir_build_expr(b, operand);
+            if (b->failed)
+            {
+                return;
+            }
+
+            ir_instr *instr = ir_new_instr(b->function, IR_BINARY, operand->resolved_type, st->pos);
+            instr->operator = (st->inc.operator == TOKEN_INC) ? TOKEN_ADD : TOKEN_SUB;
+            buf_push(instr->operands, value);
+            buf_push(instr->operands, ir_const_int(b->function, operand->resolved_type, 1));
+            ir_emit(b, instr);
+
+            ir_build_assignment(b, operand, instr, st->pos);
+        }
+        break;
+        case STMT_EXPR:
+        {
+            ir_build_expr(b, st->expr);
+        }
+        break;
+        case STMT_BLOCK:
+        {
+            ir_build_stmt_block(b, st->block);
+        }
+        break;
+        case STMT_IF_ELSE:
+        {
+            ir_instr *cond = ir_build_expr(b, st->if_else.cond_expr);
+            if (b->failed)
+            {
+                return;
+            }
+
+            ir_block *then_block = ir_new_block(b->function);
+            ir_block *else_block = st->if_else.else_stmt ? ir_new_block(b->function) : null;
+            ir_block *merge_block = ir_new_block(b->function);
+
+            ir_emit_branch(b, cond, then_block, else_block ? else_block : merge_block);
+            ir_seal_block(b, then_block);
+
+            b->current = then_block;
+            ir_build_stmt_block(b, st->if_else.then_block);
+            ir_emit_jump(b, merge_block);
+
+            if (else_block)
+            {
+                ir_seal_block(b, else_block);
+                b->current = else_block;
+                ir_build_stmt(b, st->if_else.else_stmt);
+                ir_emit_jump(b, merge_block);
+            }
+
+            ir_seal_block(b, merge_block);
+            b->current = merge_block;
+        }
+        break;
+        case STMT_WHILE:
+        {
+            ir_block *header = ir_new_block(b->function);
+            ir_block *body = ir_new_block(b->function);
+            ir_block *exit = ir_new_block(b->function);
+
+            ir_get_current_block(b);
+            ir_emit_jump(b, header);
+
+            b->current = header;
+            ir_instr *cond = ir_build_expr(b, st->while_stmt.cond_expr);
+            if (b->failed)
+            {
+                return;
+            }
+            ir_emit_branch(b, cond, body, exit);
+            ir_seal_block(b, body);
+
+            b->current = body;
+            ir_build_loop_body(b, st->while_stmt.stmts, exit, header);
+            ir_emit_jump(b, header);
+
+            ir_seal_block(b, header);
+            ir_seal_block(b, exit);
+            b->current = exit;
+        }
+        break;
+        case STMT_DO_WHILE:
+        {
+            ir_block *body = ir_new_block(b->function);
+            ir_block *cond_block = ir_new_block(b->function);
+            ir_block *exit = ir_new_block(b->function);
+
+            ir_get_current_block(b);
+            ir_emit_jump(b, body);
+
+            b->current = body;
+            ir_build_loop_body(b, st->do_while_stmt.stmts, exit, cond_block);
+            ir_emit_jump(b, cond_block);
+            ir_seal_block(b, cond_block);
+
+            b->current = cond_block;
+            ir_instr *cond = ir_build_expr(b, st->do_while_stmt.cond_expr);
+            if (b->failed)
+            {
+                return;
+            }
+            ir_emit_branch(b, cond, body, exit);
+
+            ir_seal_block(b, body);
+            ir_seal_block(b, exit);
+            b->current = exit;
+        }
+        break;
+        case STMT_FOR:
+        {
+            size_t marker = buf_len(b->scope);
+            if (st->for_stmt.init_stmt)
+            {
+                ir_build_stmt(b, st->for_stmt.init_stmt);
+            }
+
+            ir_block *header = ir_new_block(b->function);
+            ir_block *body = ir_new_block(b->function);
+            ir_block *next = ir_new_block(b->function);
+            ir_block *exit = ir_new_block(b->function);
+
+            ir_get_current_block(b);
+            ir_emit_jump(b, header);
+
+            b->current = header;
+            if (st->for_stmt.cond_expr)
+            {
+                ir_instr *cond = ir_build_expr(b, st->for_stmt.cond_expr);
+                if (b->failed)
+                {
+                    return;
+                }
+                ir_emit_branch(b, cond, body, exit);
+            }
+            else
+            {
+                ir_emit_jump(b, body);
+            }
+            ir_seal_block(b, body);
+
+            b->current = body;
+            ir_build_loop_body(b, st->for_stmt.stmts, exit, next);
+            ir_emit_jump(b, next);
+            ir_seal_block(b, next);
+
+            b->current = next;
+            if (st->for_stmt.next_stmt)
+            {
+                ir_build_stmt(b, st->for_stmt.next_stmt);
+            }
+            ir_emit_jump(b, header);
+
+            ir_seal_block(b, header);
+            ir_seal_block(b, exit);
+            b->current = exit;
+
+            ir_leave_scope(b, marker);
+        }
+        break;
+        case STMT_BREAK:
+        case STMT_CONTINUE:
+        {
+            ir_block **targets = (st->kind == STMT_BREAK) ? b->break_targets : b->continue_targets;
+            if (buf_len(targets) == 0)
+            {
+                b->failed = true;
+                return;
+            }
+            ir_get_current_block(b);
+            ir_emit_jump(b, targets[buf_len(targets) - 1]);
+        }
+        break;
+        default:
+        {
+            // switch, delete
+            b->failed = true;
+        }
+        break;
+    }
+}
+
+void free_ir_function(ir_function *f)
+{
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        ir_block *block = f->blocks[i];
+        for (size_t k = 0; k < buf_len(block->instrs); k++)
+        {
+            buf_free(block->instrs[k]->operands);
+        }
+        buf_free(block->instrs);
+        buf_free(block->preds);
+        buf_free(block->incomplete_phis);
+        map_free(&block->definitions);
+    }
+    buf_free(f->blocks);
+    buf_free(f->constants);
+}
+
+ir_function *build_ir_function(symbol *sym)
+{
+    assert(sym->kind == SYMBOL_FUNCTION);
+    decl *d = sym->decl;
+    if (d == null || d->function.is_extern || false == is_ir_callable(sym))
+    {
+        return null;
+    }
+
+    ir_function *f = push_struct(arena, ir_function);
+    f->symbol = sym;
+
+    ir_builder b = { .function = f };
+    b.current = ir_new_block(f);
+    b.current->sealed = true;
+
+    for (size_t i = 0; i < (size_t)d->function.params.param_count; i++)
+    {
+        function_param param = d->function.params.params[i];
+        type *param_type = sym->type->function.param_types[i];
+
+        ir_instr *instr = ir_new_instr(f, IR_PARAM, param_type, param.pos);
+        instr->param_index = i;
+        ir_emit(&b, instr);
+
+        size_t variable = ir_new_variable(&b, param.name, param_type);
+        ir_write_variable(variable, b.current, instr);
+    }
+
+    ir_build_stmt_block(&b, d->function.stmts);
+
+    if (false == b.failed && b.current)
+    {
+        ir_instr *ret = ir_new_instr(f, IR_RETURN, null, d->pos);
+        type *return_type = sym->type->function.return_type;
+        if (return_type != type_void)
+        {
+            buf_push(ret->operands, ir_zero_value(f, return_type));
+        }
+        ir_emit(&b, ret);
+    }
+
+    buf_free(b.scope);
+    buf_free(b.variable_types);
+    buf_free(b.break_targets);
+    buf_free(b.continue_targets);
+
+    if (b.failed)
+    {
+        free_ir_function(f);
+        return null;
+    }
+
+    ir_apply_replacements(f);
+    return f;
+}
+
+//
+// wypisywanie
+//
+
+void print_ir_value(char **buffer, ir_instr *instr)
+{
+    instr = ir_resolve(instr);
+    if (instr->opcode == IR_CONST)
+    {
+        if (instr->type->kind == TYPE_FLOAT)
+        {
+            buf_printf(*buffer, "%g", instr->float_value);
+        }
+        else if (is_signed_type(instr->type) || instr->type->kind == TYPE_ENUM)
+        {
+            buf_printf(*buffer, "%lld", (long long)instr->int_value);
+        }
+        else
+        {
+            buf_printf(*buffer, "%llu", (unsigned long long)instr->int_value);
+        }
+    }
+    else
+    {
+        buf_printf(*buffer, "v%zu", instr->id);
+    }
+}
+
+const char *get_ir_opcode_name(ir_instr *instr)
+{
+    switch (instr->opcode)
+    {
+        case IR_CONST: return "const";
+        case IR_PARAM: return "param";
+        case IR_PHI: return "phi";
+        case IR_UNARY: return get_token_kind_name(instr->operator);
+        case IR_BINARY: return get_token_kind_name(instr->operator);
+        case IR_CAST: return "cast";
+        case IR_LOAD_GLOBAL: return "load";
+        case IR_STORE_GLOBAL: return "store";
+        case IR_CALL: return "call";
+        case IR_JUMP: return "jump";
+        case IR_BRANCH: return "branch";
+        case IR_RETURN: return "return";
+        default: return "none";
+    }
+}
+
+char *print_ir_function(ir_function *f)
+{
+    char *buffer = null;
+    buf_printf(buffer, "ir %s\n", f->symbol->mangled_name);
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        ir_block *block = f->blocks[i];
+        buf_printf(buffer, "  b%zu:", block->id);
+        for (size_t k = 0; k < buf_len(block->preds); k++)
+        {
+            buf_printf(buffer, "%s b%zu", k == 0 ? " preds" : ",", block->preds[k]->id);
+        }
+        buf_printf(buffer, "\n");
+
+        for (size_t k = 0; k < buf_len(block->instrs); k++)
+        {
+            ir_instr *instr = block->instrs[k];
+            buf_printf(buffer, "    ");
+            if (instr->type)
+            {
+                buf_printf(buffer, "v%zu = ", instr->id);
+            }
+            buf_printf(buffer, "%s", get_ir_opcode_name(instr));
+
+            if (instr->opcode == IR_PARAM)
+            {
+                buf_printf(buffer, " %zu", instr->param_index);
+            }
+            else if (instr->opcode == IR_LOAD_GLOBAL || instr->opcode == IR_STORE_GLOBAL)
+            {
+                buf_printf(buffer, " %s", instr->global->name);
+            }
+            else if (instr->opcode == IR_CALL)
+            {
+                buf_printf(buffer, " %s", instr->function->mangled_name);
+            }
+
+            for (size_t j = 0; j < buf_len(instr->operands); j++)
+            {
+                buf_printf(buffer, j == 0 ? " " : ", ");
+                if (instr->opcode == IR_PHI)
+                {
+                    buf_printf(buffer, "[b%zu: ", block->preds[j]->id);
+                    print_ir_value(&buffer, instr->operands[j]);
+                    buf_printf(buffer, "]");
+                }
+                else
+                {
+                    print_ir_value(&buffer, instr->operands[j]);
+                }
+            }
+
+            if (instr->opcode == IR_JUMP)
+            {
+                buf_printf(buffer, " b%zu", instr->targets[0]->id);
+            }
+            else if (instr->opcode == IR_BRANCH)
+            {
+                buf_printf(buffer, ", b%zu, b%zu", instr->targets[0]->id, instr->targets[1]->id);
+            }
+
+            if (instr->type)
+            {
+                buf_printf(buffer, " : %s", pretty_print_type_name(instr->type, false));
+            }
+            buf_printf(buffer, "\n");
+        }
+    }
+    return buffer;
+}
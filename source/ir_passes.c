@@ -0,0 +1,1085 @@
+// przebiegi optymalizacyjne działające na IR
+// każdy przebieg zwraca true, jeśli coś zmienił - menedżer powtarza je aż do ustalenia się wyniku
+
+#define MAX_IR_PASS_ITERATIONS 8
+
+typedef bool (*ir_pass_function)(ir_function *f);
+
+typedef struct ir_pass
+{
+    const char *name;
+    ir_pass_function run;
+} ir_pass;
+
+bool ir_is_pure(ir_instr *instr)
+{
+    bool result = (instr->opcode == IR_UNARY
+        || instr->opcode == IR_BINARY
+        || instr->opcode == IR_CAST);
+    return result;
+}
+
+bool ir_is_const(ir_instr *instr)
+{
+    bool result = (ir_resolve(instr)->opcode == IR_CONST);
+    return result;
+}
+
+bool ir_may_trap(ir_instr *instr)
+{
+    bool result = (instr->opcode == IR_BINARY
+        && (instr->operator == TOKEN_DIV || instr->operator == TOKEN_MOD)
+        && instr->type->kind != TYPE_FLOAT);
+    return result;
+}
+
+//
+// usuwanie trywialnych phi
+//
+
+bool ir_remove_trivial_phis(ir_function *f)
+{
+    bool changed = false;
+    bool repeat = true;
+    while (repeat)
+    {
+        repeat = false;
+        for (size_t i = 0; i < buf_len(f->blocks); i++)
+        {
+            ir_block *block = f->blocks[i];
+            for (size_t k = 0; k < buf_len(block->instrs);)
+            {
+                ir_instr *phi = block->instrs[k];
+                if (phi->opcode != IR_PHI)
+                {
+                    break;
+                }
+                if (ir_try_remove_trivial_phi(f, phi) != phi)
+                {
+                    repeat = true;
+                    changed = true;
+                }
+                else
+                {
+                    k++;
+                }
+            }
+        }
+    }
+
+    if (changed)
+    {
+        ir_apply_replacements(f);
+    }
+    return changed;
+}
+
+//
+// zwijanie i propagacja stałych
+//
+
+bool ir_fold_int_unary(token_kind op, type *t, uint64_t a, uint64_t *result)
+{
+    switch (op)
+    {
+        case TOKEN_ADD: *result = a; return true;
+        case TOKEN_SUB: *result = 0 - a; return true;
+        case TOKEN_NOT: *result = (a == 0); return true;
+        case TOKEN_BITWISE_NOT: *result = ~a; return true;
+        default: return false;
+    }
+}
+
+bool ir_fold_int_binary(token_kind op, type *t, uint64_t a, uint64_t b, uint64_t *result)
+{
+    bool is_signed = is_signed_type(t) || t->kind == TYPE_ENUM;
+    size_t bits = 8 * get_type_size(t);
+    switch (op)
+    {
+        case TOKEN_ADD: *result = a + b; return true;
+        case TOKEN_SUB: *result = a - b; return true;
+        case TOKEN_MUL: *result = a * b; return true;
+        case TOKEN_BITWISE_AND: *result = a & b; return true;
+        case TOKEN_BITWISE_OR: *result = a | b; return true;
+        case TOKEN_XOR: *result = a ^ b; return true;
+        case TOKEN_DIV:
+        case TOKEN_MOD:
+        {
+            // dzielenie przez zero i przepełnienie zostawiamy na czas wykonania
+            if (b == 0 || (is_signed && (int64_t)b == -1))
+            {
+                return false;
+            }
+            if (is_signed)
+            {
+                *result = (op == TOKEN_DIV)
+                    ? (uint64_t)((int64_t)a / (int64_t)b)
+                    : (uint64_t)((int64_t)a % (int64_t)b);
+            }
+            else
+            {
+                *result = (op == TOKEN_DIV) ? a / b : a % b;
+            }
+            return true;
+        }
+        case TOKEN_LEFT_SHIFT:
+        case TOKEN_RIGHT_SHIFT:
+        {
+            if (b >= bits)
+            {
+                return false;
+            }
+            if (op == TOKEN_LEFT_SHIFT)
+            {
+                *result = a << b;
+            }
+            else
+            {
+                *result = is_signed ? (uint64_t)((int64_t)a >> b) : a >> b;
+            }
+            return true;
+        }
+        case TOKEN_EQ: *result = (a == b); return true;
+        case TOKEN_NEQ: *result = (a != b); return true;
+        case TOKEN_LT: *result = is_signed ? (int64_t)a < (int64_t)b : a < b; return true;
+        case TOKEN_LEQ: *result = is_signed ? (int64_t)a <= (int64_t)b : a <= b; return true;
+        case TOKEN_GT: *result = is_signed ? (int64_t)a > (int64_t)b : a > b; return true;
+        case TOKEN_GEQ: *result = is_signed ? (int64_t)a >= (int64_t)b : a >= b; return true;
+        default: return false;
+    }
+}
+
+bool ir_fold_float_binary(token_kind op, float a, float b, float *float_result, uint64_t *int_result)
+{
+    switch (op)
+    {
+        case TOKEN_ADD: *float_result = a + b; return true;
+        case TOKEN_SUB: *float_result = a - b; return true;
+        case TOKEN_MUL: *float_result = a * b; return true;
+        case TOKEN_DIV:
+        {
+            if (b == 0.0f)
+            {
+                return false;
+            }
+            *float_result = a / b;
+            return true;
+        }
+        case TOKEN_EQ: *int_result = (a == b); return true;
+        case TOKEN_NEQ: *int_result = (a != b); return true;
+        case TOKEN_LT: *int_result = (a < b); return true;
+        case TOKEN_LEQ: *int_result = (a <= b); return true;
+        case TOKEN_GT: *int_result = (a > b); return true;
+        case TOKEN_GEQ: *int_result = (a >= b); return true;
+        default: return false;
+    }
+}
+
+ir_instr *ir_fold_cast(ir_function *f, ir_instr *instr, ir_instr *operand)
+{
+    type *from = operand->type;
+    type *to = instr->type;
+    if (from->kind == TYPE_FLOAT)
+    {
+        if (to->kind == TYPE_FLOAT)
+        {
+            return operand;
+        }
+        if (to->kind == TYPE_BOOL)
+        {
+            return ir_const_int(f, to, operand->float_value != 0.0f);
+        }
+        // wartości spoza zakresu są w C niezdefiniowane
+        if (is_integer_type(to) && operand->float_value > -2147483648.0f && operand->float_value < 2147483647.0f)
+        {
+            return ir_const_int(f, to, (uint64_t)(int64_t)operand->float_value);
+        }
+        return null;
+    }
+
+    if (to->kind == TYPE_FLOAT)
+    {
+        if (is_integer_type(from))
+        {
+            float value = (is_signed_type(from) || from->kind == TYPE_ENUM)
+                ? (float)(int64_t)operand->int_value
+                : (float)operand->int_value;
+            return ir_const_float(f, value);
+        }
+        return null;
+    }
+
+    if (to->kind == TYPE_BOOL)
+    {
+        return ir_const_int(f, to, operand->int_value != 0);
+    }
+
+    if ((is_integer_type(to) || to->kind == TYPE_ENUM)
+        && (is_integer_type(from) || from->kind == TYPE_ENUM || from->kind == TYPE_BOOL))
+    {
+        return ir_const_int(f, to, operand->int_value);
+    }
+    return null;
+}
+
+ir_instr *ir_fold_instr(ir_function *f, ir_instr *instr)
+{
+    for (size_t i = 0; i < buf_len(instr->operands); i++)
+    {
+        if (false == ir_is_const(instr->operands[i]))
+        {
+            return null;
+        }
+    }
+
+    switch (instr->opcode)
+    {
+        case IR_CAST:
+        {
+            return ir_fold_cast(f, instr, ir_resolve(instr->operands[0]));
+        }
+        break;
+        case IR_UNARY:
+        {
+            ir_instr *operand = ir_resolve(instr->operands[0]);
+            if (operand->type->kind == TYPE_FLOAT)
+            {
+                if (instr->operator == TOKEN_SUB)
+                {
+                    return ir_const_float(f, -operand->float_value);
+                }
+                if (instr->operator == TOKEN_ADD)
+                {
+                    return ir_const_float(f, operand->float_value);
+                }
+                if (instr->operator == TOKEN_NOT && instr->type->kind != TYPE_FLOAT)
+                {
+                    return ir_const_int(f, instr->type, operand->float_value == 0.0f);
+                }
+                return null;
+            }
+
+            if (operand->type != instr->type && instr->operator != TOKEN_NOT)
+            {
+                return null;
+            }
+
+            uint64_t value = 0;
+            if (ir_fold_int_unary(instr->operator, operand->type, operand->int_value, &value))
+            {
+                return ir_const_int(f, instr->type, value);
+            }
+        }
+        break;
+        case IR_BINARY:
+        {
+            ir_instr *left = ir_resolve(instr->operands[0]);
+            ir_instr *right = ir_resolve(instr->operands[1]);
+            bool is_shift = (instr->operator == TOKEN_LEFT_SHIFT || instr->operator == TOKEN_RIGHT_SHIFT);
+
+            // typy mieszane zostawiamy kompilatorowi C, żeby nie powielać reguł konwersji
+            if (left->type != right->type && false == is_shift)
+            {
+                return null;
+            }
+
+            if (left->type->kind == TYPE_FLOAT)
+            {
+                float float_result = 0.0f;
+                uint64_t int_result = 0;
+                if (ir_fold_float_binary(instr->operator, left->float_value, right->float_value, &float_result, &int_result))
+                {
+                    // wynik porównania ma typ operandów
+                    if (is_comparison_operator(instr->operator))
+                    {
+                        return (instr->type->kind == TYPE_FLOAT)
+                            ? ir_const_float(f, (float)int_result)
+                            : ir_const_int(f, instr->type, int_result);
+                    }
+                    return ir_const_float(f, float_result);
+                }
+                return null;
+            }
+
+            if (false == is_comparison_operator(instr->operator) && left->type != instr->type)
+            {
+                return null;
+            }
+
+            if (left->type->kind == TYPE_POINTER || left->type->kind == TYPE_NULL)
+            {
+                return null;
+            }
+
+            uint64_t value = 0;
+            if (ir_fold_int_binary(instr->operator, left->type, left->int_value, right->int_value, &value))
+            {
+                return ir_const_int(f, instr->type, value);
+            }
+        }
+        break;
+        default:
+        {
+            return null;
+        }
+        break;
+    }
+    return null;
+}
+
+bool ir_fold_constants(ir_function *f)
+{
+    bool changed = false;
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        ir_block *block = f->blocks[i];
+        for (size_t k = 0; k < buf_len(block->instrs);)
+        {
+            ir_instr *instr = block->instrs[k];
+            ir_instr *folded = ir_is_pure(instr) ? ir_fold_instr(f, instr) : null;
+            if (folded)
+            {
+                ir_replace(instr, folded);
+                changed = true;
+                continue;
+            }
+
+            if (instr->opcode == IR_BRANCH && ir_is_const(instr->operands[0]))
+            {
+                ir_instr *cond = ir_resolve(instr->operands[0]);
+                bool taken = (cond->type->kind == TYPE_FLOAT)
+                    ? cond->float_value != 0.0f
+                    : cond->int_value != 0;
+
+                ir_block *target = instr->targets[taken ? 0 : 1];
+                ir_block *removed = instr->targets[taken ? 1 : 0];
+
+                instr->opcode = IR_JUMP;
+                instr->targets[0] = target;
+                instr->targets[1] = null;
+                buf_free(instr->operands);
+                ir_remove_edge(block, removed);
+                changed = true;
+            }
+            k++;
+        }
+    }
+
+    if (changed)
+    {
+        ir_apply_replacements(f);
+    }
+    return changed;
+}
+
+//
+// upraszczanie grafu przepływu
+//
+
+void ir_mark_reachable(ir_block *block)
+{
+    if (block->visited)
+    {
+        return;
+    }
+    block->visited = true;
+
+    ir_block *successors[2];
+    size_t count = ir_get_successors(block, successors);
+    for (size_t i = 0; i < count; i++)
+    {
+        ir_mark_reachable(successors[i]);
+    }
+}
+
+void ir_remove_block(ir_function *f, size_t index)
+{
+    ir_block *block = f->blocks[index];
+    for (size_t k = 0; k < buf_len(block->instrs); k++)
+    {
+        block->instrs[k]->block = null;
+        block->instrs[k]->opcode = IR_NONE;
+    }
+
+    for (size_t i = index + 1; i < buf_len(f->blocks); i++)
+    {
+        f->blocks[i - 1] = f->blocks[i];
+    }
+    buf_pop(f->blocks);
+}
+
+bool ir_simplify_cfg(ir_function *f)
+{
+    bool changed = false;
+
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        f->blocks[i]->visited = false;
+    }
+    ir_mark_reachable(f->blocks[0]);
+
+    for (size_t i = 0; i < buf_len(f->blocks);)
+    {
+        ir_block *block = f->blocks[i];
+        if (block->visited)
+        {
+            i++;
+            continue;
+        }
+
+        ir_block *successors[2];
+        size_t count = ir_get_successors(block, successors);
+        for (size_t j = 0; j < count; j++)
+        {
+            ir_remove_edge(block, successors[j]);
+        }
+        ir_remove_block(f, i);
+        changed = true;
+    }
+
+    // łączenie bloku z jedynym następnikiem, który nie ma innych poprzedników
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        ir_block *block = f->blocks[i];
+        ir_instr *terminator = ir_get_terminator(block);
+        if (terminator == null || terminator->opcode != IR_JUMP)
+        {
+            continue;
+        }
+
+        ir_block *next = terminator->targets[0];
+        if (next == block || next == f->blocks[0] || buf_len(next->preds) != 1)
+        {
+            continue;
+        }
+
+        // phi z jednym operandem są trywialne
+        while (buf_len(next->instrs) > 0 && next->instrs[0]->opcode == IR_PHI)
+        {
+            ir_instr *phi = next->instrs[0];
+            ir_replace(phi, ir_resolve(phi->operands[0]));
+        }
+
+        ir_remove_from_block(terminator);
+        terminator->opcode = IR_NONE;
+        for (size_t k = 0; k < buf_len(next->instrs); k++)
+        {
+            ir_append(block, next->instrs[k]);
+        }
+        buf_free(next->instrs);
+
+        ir_block *successors[2];
+        size_t count = ir_get_successors(block, successors);
+        for (size_t j = 0; j < count; j++)
+        {
+            ir_block *successor = successors[j];
+            for (size_t k = 0; k < buf_len(successor->preds); k++)
+            {
+                if (successor->preds[k] == next)
+                {
+                    successor->preds[k] = block;
+                }
+            }
+        }
+
+        for (size_t j = 0; j < buf_len(f->blocks); j++)
+        {
+            if (f->blocks[j] == next)
+            {
+                ir_remove_block(f, j);
+                break;
+            }
+        }
+
+        // ten sam blok może zostać połączony z kolejnym
+        i = (size_t)-1;
+        changed = true;
+    }
+
+    if (changed)
+    {
+        ir_apply_replacements(f);
+    }
+    return changed;
+}
+
+//
+// dominatory - algorytm Coopera, Harveya i Kennedy'ego
+//
+
+void ir_postorder(ir_block *block, ir_block ***order)
+{
+    block->visited = true;
+    ir_block *successors[2];
+    size_t count = ir_get_successors(block, successors);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (false == successors[i]->visited)
+        {
+            ir_postorder(successors[i], order);
+        }
+    }
+    buf_push(*order, block);
+}
+
+ir_block *ir_intersect(ir_block *a, ir_block *b)
+{
+    while (a != b)
+    {
+        while (a->rpo_index > b->rpo_index)
+        {
+            a = a->idom;
+        }
+        while (b->rpo_index > a->rpo_index)
+        {
+            b = b->idom;
+        }
+    }
+    return a;
+}
+
+// zwraca bloki w odwrotnym porządku postorder
+ir_block **ir_compute_dominators(ir_function *f)
+{
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        f->blocks[i]->visited = false;
+        f->blocks[i]->idom = null;
+    }
+
+    ir_block **postorder = null;
+    ir_postorder(f->blocks[0], &postorder);
+
+    ir_block **rpo = null;
+    for (size_t i = buf_len(postorder); i > 0; i--)
+    {
+        ir_block *block = postorder[i - 1];
+        block->rpo_index = buf_len(rpo);
+        buf_push(rpo, block);
+    }
+    buf_free(postorder);
+
+    ir_block *entry = rpo[0];
+    entry->idom = entry;
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (size_t i = 1; i < buf_len(rpo); i++)
+        {
+            ir_block *block = rpo[i];
+            ir_block *new_idom = null;
+            for (size_t k = 0; k < buf_len(block->preds); k++)
+            {
+                ir_block *pred = block->preds[k];
+                if (pred->idom == null)
+                {
+                    continue;
+                }
+                new_idom = new_idom ? ir_intersect(pred, new_idom) : pred;
+            }
+
+            if (new_idom != block->idom)
+            {
+                block->idom = new_idom;
+                changed = true;
+            }
+        }
+    }
+    return rpo;
+}
+
+bool ir_dominates(ir_block *a, ir_block *b)
+{
+    while (true)
+    {
+        if (a == b)
+        {
+            return true;
+        }
+        if (b->idom == b || b->idom == null)
+        {
+            return false;
+        }
+        b = b->idom;
+    }
+    return false;
+}
+
+//
+// eliminacja wspólnych podwyrażeń
+//
+
+bool ir_is_commutative(token_kind op)
+{
+    switch (op)
+    {
+        case TOKEN_ADD:
+        case TOKEN_MUL:
+        case TOKEN_BITWISE_AND:
+        case TOKEN_BITWISE_OR:
+        case TOKEN_XOR:
+        case TOKEN_EQ:
+        case TOKEN_NEQ:
+        {
+            return true;
+        }
+        break;
+        default:
+        {
+            return false;
+        }
+        break;
+    }
+    return false;
+}
+
+bool ir_same_value(ir_instr *a, ir_instr *b)
+{
+    a = ir_resolve(a);
+    b = ir_resolve(b);
+    if (a == b)
+    {
+        return true;
+    }
+    if (a->opcode == IR_CONST && b->opcode == IR_CONST && a->type == b->type)
+    {
+        return (a->type->kind == TYPE_FLOAT)
+            ? a->float_value == b->float_value
+            : a->int_value == b->int_value;
+    }
+    return false;
+}
+
+bool ir_same_computation(ir_instr *a, ir_instr *b)
+{
+    if (a->opcode != b->opcode || a->type != b->type || a->operator != b->operator)
+    {
+        return false;
+    }
+
+    size_t count = buf_len(a->operands);
+    if (count != buf_len(b->operands))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (ir_resolve(a->operands[i])->type != ir_resolve(b->operands[i])->type)
+        {
+            return false;
+        }
+    }
+
+    bool same = true;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (false == ir_same_value(a->operands[i], b->operands[i]))
+        {
+            same = false;
+            break;
+        }
+    }
+
+    if (false == same && a->opcode == IR_BINARY && ir_is_commutative(a->operator))
+    {
+        same = ir_same_value(a->operands[0], b->operands[1])
+            && ir_same_value(a->operands[1], b->operands[0]);
+    }
+    return same;
+}
+
+bool ir_eliminate_common_subexpressions(ir_function *f)
+{
+    bool changed = false;
+    ir_block **rpo = ir_compute_dominators(f);
+    ir_instr **available = null;
+
+    for (size_t i = 0; i < buf_len(rpo); i++)
+    {
+        ir_block *block = rpo[i];
+        for (size_t k = 0; k < buf_len(block->instrs);)
+        {
+            ir_instr *instr = block->instrs[k];
+            if (false == ir_is_pure(instr))
+            {
+                k++;
+                continue;
+            }
+
+            ir_instr *found = null;
+            for (size_t j = 0; j < buf_len(available); j++)
+            {
+                ir_instr *candidate = available[j];
+                if (candidate->opcode != IR_NONE
+                    && ir_dominates(candidate->block, block)
+                    && ir_same_computation(candidate, instr))
+                {
+                    found = candidate;
+                    break;
+                }
+            }
+
+            if (found)
+            {
+                ir_replace(instr, found);
+                changed = true;
+            }
+            else
+            {
+                buf_push(available, instr);
+                k++;
+            }
+        }
+    }
+
+    buf_free(available);
+    buf_free(rpo);
+
+    if (changed)
+    {
+        ir_apply_replacements(f);
+    }
+    return changed;
+}
+
+//
+// wyciąganie niezmienników poza pętle
+//
+
+bool ir_in_loop(ir_block **loop, ir_block *block)
+{
+    for (size_t i = 0; i < buf_len(loop); i++)
+    {
+        if (loop[i] == block)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ir_defined_outside_loop(ir_block **loop, ir_instr *value)
+{
+    value = ir_resolve(value);
+    bool result = (value->block == null || false == ir_in_loop(loop, value->block));
+    return result;
+}
+
+bool ir_loop_writes_global(ir_block **loop, symbol *global)
+{
+    for (size_t i = 0; i < buf_len(loop); i++)
+    {
+        ir_block *block = loop[i];
+        for (size_t k = 0; k < buf_len(block->instrs); k++)
+        {
+            ir_instr *instr = block->instrs[k];
+            if (instr->opcode == IR_CALL
+                || (instr->opcode == IR_STORE_GLOBAL && instr->global == global))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool ir_hoist_loop_invariants(ir_function *f, ir_block *header, ir_block *latch)
+{
+    // ciało pętli naturalnej: bloki, z których da się dojść do krawędzi powrotnej bez przechodzenia przez nagłówek
+    ir_block **loop = null;
+    ir_block **worklist = null;
+    buf_push(loop, header);
+    if (latch != header)
+    {
+        buf_push(loop, latch);
+        buf_push(worklist, latch);
+    }
+    while (buf_len(worklist) > 0)
+    {
+        ir_block *block = worklist[buf_len(worklist) - 1];
+        buf_pop(worklist);
+        for (size_t i = 0; i < buf_len(block->preds); i++)
+        {
+            ir_block *pred = block->preds[i];
+            if (false == ir_in_loop(loop, pred))
+            {
+                buf_push(loop, pred);
+                buf_push(worklist, pred);
+            }
+        }
+    }
+    buf_free(worklist);
+
+    ir_block *preheader = null;
+    for (size_t i = 0; i < buf_len(header->preds); i++)
+    {
+        ir_block *pred = header->preds[i];
+        if (false == ir_in_loop(loop, pred))
+        {
+            if (preheader != null && preheader != pred)
+            {
+                buf_free(loop);
+                return false;
+            }
+            preheader = pred;
+        }
+    }
+
+    ir_instr *preheader_terminator = preheader ? ir_get_terminator(preheader) : null;
+    if (preheader_terminator == null || preheader_terminator->opcode != IR_JUMP)
+    {
+        buf_free(loop);
+        return false;
+    }
+
+    bool changed = false;
+    bool repeat = true;
+    while (repeat)
+    {
+        repeat = false;
+        for (size_t i = 0; i < buf_len(loop); i++)
+        {
+            ir_block *block = loop[i];
+            for (size_t k = 0; k < buf_len(block->instrs);)
+            {
+                ir_instr *instr = block->instrs[k];
+                bool hoist = false;
+                if (ir_is_pure(instr) && false == ir_may_trap(instr))
+                {
+                    hoist = true;
+                    for (size_t j = 0; j < buf_len(instr->operands); j++)
+                    {
+                        if (false == ir_defined_outside_loop(loop, instr->operands[j]))
+                        {
+                            hoist = false;
+                            break;
+                        }
+                    }
+                }
+                else if (instr->opcode == IR_LOAD_GLOBAL)
+                {
+                    hoist = (false == ir_loop_writes_global(loop, instr->global));
+                }
+
+                if (hoist)
+                {
+                    ir_remove_from_block(instr);
+                    ir_insert_before_terminator(preheader, instr);
+                    repeat = true;
+                    changed = true;
+                }
+                else
+                {
+                    k++;
+                }
+            }
+        }
+    }
+
+    buf_free(loop);
+    return changed;
+}
+
+bool ir_hoist_invariants(ir_function *f)
+{
+    bool changed = false;
+    ir_block **rpo = ir_compute_dominators(f);
+    for (size_t i = 0; i < buf_len(rpo); i++)
+    {
+        ir_block *block = rpo[i];
+        ir_block *successors[2];
+        size_t count = ir_get_successors(block, successors);
+        for (size_t j = 0; j < count; j++)
+        {
+            // krawędź powrotna prowadzi do bloku, który dominuje źródło
+            if (ir_dominates(successors[j], block))
+            {
+                changed |= ir_hoist_loop_invariants(f, successors[j], block);
+            }
+        }
+    }
+    buf_free(rpo);
+    return changed;
+}
+
+//
+// usuwanie martwych zapisów i przekazywanie wartości do odczytów zmiennych globalnych
+//
+
+typedef struct ir_global_state
+{
+    symbol *global;
+    ir_instr *pending_store; // zapis, którego wartość nie została jeszcze odczytana z pamięci
+    ir_instr *known_value;
+} ir_global_state;
+
+ir_global_state *ir_get_global_state(ir_global_state **states, symbol *global)
+{
+    for (size_t i = 0; i < buf_len(*states); i++)
+    {
+        if ((*states)[i].global == global)
+        {
+            return &(*states)[i];
+        }
+    }
+    ir_global_state state = { .global = global };
+    buf_push(*states, state);
+    return &(*states)[buf_len(*states) - 1];
+}
+
+bool ir_eliminate_dead_stores(ir_function *f)
+{
+    bool changed = false;
+    ir_global_state *states = null;
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        ir_block *block = f->blocks[i];
+        buf_free(states);
+
+        for (size_t k = 0; k < buf_len(block->instrs);)
+        {
+            ir_instr *instr = block->instrs[k];
+            if (instr->opcode == IR_STORE_GLOBAL)
+            {
+                ir_global_state *state = ir_get_global_state(&states, instr->global);
+                if (state->pending_store)
+                {
+                    ir_instr *dead = state->pending_store;
+                    ir_remove_from_block(dead);
+                    dead->opcode = IR_NONE;
+                    changed = true;
+                    k--;
+                }
+                state->pending_store = instr;
+                state->known_value = ir_resolve(instr->operands[0]);
+            }
+            else if (instr->opcode == IR_LOAD_GLOBAL)
+            {
+                ir_global_state *state = ir_get_global_state(&states, instr->global);
+                if (state->known_value)
+                {
+                    ir_replace(instr, state->known_value);
+                    changed = true;
+                    continue;
+                }
+                state->known_value = instr;
+            }
+            else if (instr->opcode == IR_CALL)
+            {
+                // wywołana funkcja może odczytać i zmienić dowolną zmienną globalną
+                buf_free(states);
+            }
+            k++;
+        }
+    }
+    buf_free(states);
+
+    if (changed)
+    {
+        ir_apply_replacements(f);
+    }
+    return changed;
+}
+
+//
+// usuwanie martwego kodu
+//
+
+bool ir_is_root(ir_instr *instr)
+{
+    bool result = (instr->opcode == IR_STORE_GLOBAL
+        || instr->opcode == IR_CALL
+        || ir_is_terminator(instr));
+    return result;
+}
+
+bool ir_eliminate_dead_code(ir_function *f)
+{
+    hashmap live = {0};
+    map_grow(&live, 64);
+    ir_instr **worklist = null;
+
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        ir_block *block = f->blocks[i];
+        for (size_t k = 0; k < buf_len(block->instrs); k++)
+        {
+            ir_instr *instr = block->instrs[k];
+            if (ir_is_root(instr))
+            {
+                map_put(&live, instr, instr);
+                buf_push(worklist, instr);
+            }
+        }
+    }
+
+    while (buf_len(worklist) > 0)
+    {
+        ir_instr *instr = worklist[buf_len(worklist) - 1];
+        buf_pop(worklist);
+        for (size_t i = 0; i < buf_len(instr->operands); i++)
+        {
+            ir_instr *operand = ir_resolve(instr->operands[i]);
+            if (operand->block && null == map_get(&live, operand))
+            {
+                map_put(&live, operand, operand);
+                buf_push(worklist, operand);
+            }
+        }
+    }
+
+    bool changed = false;
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        ir_block *block = f->blocks[i];
+        for (size_t k = 0; k < buf_len(block->instrs);)
+        {
+            ir_instr *instr = block->instrs[k];
+            if (null == map_get(&live, instr))
+            {
+                ir_remove_from_block(instr);
+                instr->opcode = IR_NONE;
+                changed = true;
+            }
+            else
+            {
+                k++;
+            }
+        }
+    }
+
+    buf_free(worklist);
+    map_free(&live);
+    return changed;
+}
+
+ir_pass ir_passes[] =
+{
+    { "trivial-phi", ir_remove_trivial_phis },
+    { "const-fold", ir_fold_constants },
+    { "simplify-cfg", ir_simplify_cfg },
+    { "cse", ir_eliminate_common_subexpressions },
+    { "licm", ir_hoist_invariants },
+    { "dse", ir_eliminate_dead_stores },
+    { "dce", ir_eliminate_dead_code },
+};
+
+void run_ir_passes(ir_function *f)
+{
+    for (size_t iteration = 0; iteration < MAX_IR_PASS_ITERATIONS; iteration++)
+    {
+        bool changed = false;
+        for (size_t i = 0; i < sizeof(ir_passes) / sizeof(ir_passes[0]); i++)
+        {
+            changed |= ir_passes[i].run(f);
+        }
+
+        if (false == changed)
+        {
+            break;
+        }
+    }
+}
@@ -0,0 +1,334 @@
+// kompilacja często wywoływanych funkcji interpretera do kodu maszynowego
+// funkcja staje się "gorąca" po odpowiedniej liczbie wywołań i przebiegów pętli -
+// wtedy jest kompilowana razem z funkcjami, które wywołuje, a kolejne wywołania
+// trafiają bezpośrednio do kodu maszynowego
+
+// funkcje w skompilowanym bloku wywołują się nawzajem w konwencji System V,
+// a w Windows wejście do bloku przechodzi przez funkcję dostosowującą konwencję
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(__EMSCRIPTEN__)
+#define JIT_SUPPORTED 1
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+#else
+#define JIT_SUPPORTED 0
+#endif
+
+#define JIT_HOTNESS_THRESHOLD 1000
+
+typedef void (*jit_entry_point)(uint64_t *args, uint64_t *result);
+
+typedef enum jit_status
+{
+    JIT_INTERPRETED,
+    JIT_COMPILED,
+    JIT_FAILED,
+} jit_status;
+
+typedef struct jit_function
+{
+    symbol *symbol;
+    size_t hotness; // liczba wywołań i przebiegów pętli
+    jit_status status;
+    jit_entry_point entry;
+} jit_function;
+
+typedef struct jit_code_block
+{
+    void *memory;
+    size_t size;
+} jit_code_block;
+
+bool jit_enabled = true;
+hashmap jit_functions;
+jit_code_block *jit_code_blocks;
+jit_function *jit_current_function;
+
+jit_function *jit_get_function(symbol *sym)
+{
+    if (jit_functions.capacity == 0)
+    {
+        map_grow(&jit_functions, 64);
+    }
+
+    jit_function *result = map_get(&jit_functions, sym);
+    if (result == null)
+    {
+        result = xcalloc(sizeof(jit_function));
+        result->symbol = sym;
+        map_put(&jit_functions, sym, result);
+    }
+    return result;
+}
+
+jit_function *jit_enter_function(symbol *sym)
+{
+    jit_function *previous = jit_current_function;
+    if (jit_enabled)
+    {
+        jit_current_function = jit_get_function(sym);
+    }
+    return previous;
+}
+
+void jit_leave_function(jit_function *previous)
+{
+    jit_current_function = previous;
+}
+
+void jit_count_back_edge(void)
+{
+    if (jit_current_function)
+    {
+        jit_current_function->hotness++;
+    }
+}
+
+void *jit_allocate_executable(uint8_t *code, size_t size)
+{
+#if JIT_SUPPORTED && defined(_WIN32)
+    void *memory = VirtualAlloc(null, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (memory == null)
+    {
+        return null;
+    }
+
+    memcpy(memory, code, size);
+    DWORD old_protection = 0;
+    if (false == VirtualProtect(memory, size, PAGE_EXECUTE_READ, &old_protection))
+    {
+        VirtualFree(memory, 0, MEM_RELEASE);
+        return null;
+    }
+    FlushInstructionCache(GetCurrentProcess(), memory, size);
+
+    jit_code_block block = { .memory = memory, .size = size };
+    buf_push(jit_code_blocks, block);
+    return memory;
+#elif JIT_SUPPORTED
+    void *memory = mmap(null, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        return null;
+    }
+
+    memcpy(memory, code, size);
+    if (0 != mprotect(memory, size, PROT_READ | PROT_EXEC))
+    {
+        munmap(memory, size);
+        return null;
+    }
+
+    jit_code_block block = { .memory = memory, .size = size };
+    buf_push(jit_code_blocks, block);
+    return memory;
+#else
+    return null;
+#endif
+}
+
+bool jit_patch_relocations(x64_object *obj, hashmap *global_addresses)
+{
+    for (size_t i = 0; i < buf_len(obj->relocations); i++)
+    {
+        x64_relocation reloc = obj->relocations[i];
+        uint8_t *place = obj->code + reloc.offset;
+
+        if (reloc.type == X64_R_64)
+        {
+            char *address = map_get(global_addresses, reloc.symbol);
+            if (address == null)
+            {
+                return false;
+            }
+            uint64_t value = (uint64_t)(uintptr_t)(address + reloc.addend);
+            memcpy(place, &value, sizeof(value));
+        }
+        else
+        {
+            // wywołania trafiają wyłącznie do funkcji z tego samego bloku kodu
+            size_t target = SIZE_MAX;
+            for (size_t k = 0; k < buf_len(obj->functions); k++)
+            {
+                if (obj->functions[k].name == reloc.symbol)
+                {
+                    target = obj->functions[k].offset;
+                    break;
+                }
+            }
+            if (target == SIZE_MAX)
+            {
+                return false;
+            }
+            int32_t value = (int32_t)((int64_t)target + reloc.addend - (int64_t)reloc.offset);
+            memcpy(place, &value, sizeof(value));
+        }
+    }
+    return true;
+}
+
+// kompiluje funkcję i wszystkie funkcje przez nią wywoływane
+bool jit_compile(jit_function *jf, hashmap *global_addresses)
+{
+    x64_object obj = { .interpreter_layout = true };
+    ir_function **compiled = null;
+    symbol **pending = null;
+    hashmap visited = {0};
+    map_grow(&visited, 16);
+
+    bool success = true;
+    buf_push(pending, jf->symbol);
+    map_put(&visited, jf->symbol, jf->symbol);
+
+    while (buf_len(pending) > 0 && success)
+    {
+        symbol *sym = pending[buf_len(pending) - 1];
+        buf_pop(pending);
+        ir_function *f = build_ir_function(sym);
+        if (f == null)
+        {
+            success = false;
+            break;
+        }
+        run_ir_passes(f);
+        buf_push(compiled, f);
+
+        if (false == x64_compile_function(&obj, f))
+        {
+            success = false;
+            break;
+        }
+
+        for (size_t i = 0; i < buf_len(f->blocks); i++)
+        {
+            ir_block *block = f->blocks[i];
+            for (size_t k = 0; k < buf_len(block->instrs); k++)
+            {
+                ir_instr *instr = block->instrs[k];
+                if (instr->opcode == IR_CALL && null == map_get(&visited, instr->function))
+                {
+                    map_put(&visited, instr->function, instr->function);
+                    buf_push(pending, instr->function);
+                }
+            }
+        }
+    }
+
+    size_t *thunks = null;
+    if (success)
+    {
+        for (size_t i = 0; i < buf_len(compiled); i++)
+        {
+            buf_push(thunks, x64_compile_entry_thunk(&obj, compiled[i]->symbol));
+        }
+        success = jit_patch_relocations(&obj, global_addresses);
+    }
+
+    uint8_t *memory = null;
+    if (success)
+    {
+        memory = jit_allocate_executable(obj.code, buf_len(obj.code));
+        success = (memory != null);
+    }
+
+    if (success)
+    {
+        for (size_t i = 0; i < buf_len(compiled); i++)
+        {
+            jit_function *callee = jit_get_function(compiled[i]->symbol);
+            if (callee->status != JIT_COMPILED)
+            {
+                callee->status = JIT_COMPILED;
+                callee->entry = (jit_entry_point)(uintptr_t)(memory + thunks[i]);
+            }
+        }
+    }
+    else
+    {
+        jf->status = JIT_FAILED;
+    }
+
+    for (size_t i = 0; i < buf_len(compiled); i++)
+    {
+        free_ir_function(compiled[i]);
+    }
+    buf_free(compiled);
+    buf_free(pending);
+    buf_free(thunks);
+    map_free(&visited);
+    free_x64_object(&obj);
+
+    return success;
+}
+
+// zwraca true, jeśli funkcja została wykonana jako kod maszynowy
+bool jit_try_call(symbol *function, char **arg_vals, char *result, hashmap *global_addresses)
+{
+    if (false == jit_enabled || false == JIT_SUPPORTED)
+    {
+        return false;
+    }
+
+    jit_function *jf = jit_get_function(function);
+    if (jf->status == JIT_INTERPRETED)
+    {
+        jf->hotness++;
+        if (jf->hotness < JIT_HOTNESS_THRESHOLD
+            || false == jit_compile(jf, global_addresses))
+        {
+            return false;
+        }
+    }
+
+    if (jf->status != JIT_COMPILED)
+    {
+        return false;
+    }
+
+    type_function signature = function->type->function;
+    uint64_t args[X64_MAX_INT_ARGS + X64_MAX_FLOAT_ARGS] = {0};
+    assert(buf_len(arg_vals) == signature.param_count);
+    for (size_t i = 0; i < signature.param_count; i++)
+    {
+        type *param_type = signature.param_types[i];
+        memcpy(&args[i], arg_vals[i], get_type_size(param_type));
+        if (param_type->kind == TYPE_BOOL)
+        {
+            args[i] = (args[i] != 0);
+        }
+    }
+
+    uint64_t return_value = 0;
+    jf->entry(args, &return_value);
+
+    if (signature.return_type != type_void)
+    {
+        memcpy(result, &return_value, get_type_size(signature.return_type));
+    }
+    return true;
+}
+
+void jit_free(void)
+{
+#if JIT_SUPPORTED
+    for (size_t i = 0; i < buf_len(jit_code_blocks); i++)
+    {
+#if defined(_WIN32)
+        VirtualFree(jit_code_blocks[i].memory, 0, MEM_RELEASE);
+#else
+        munmap(jit_code_blocks[i].memory, jit_code_blocks[i].size);
+#endif
+    }
+#endif
+    buf_free(jit_code_blocks);
+
+    for (size_t i = 0; i < jit_functions.capacity; i++)
+    {
+        if (jit_functions.keys[i])
+        {
+            free(jit_functions.values[i]);
+        }
+    }
+    map_free(&jit_functions);
+    jit_current_function = null;
+}
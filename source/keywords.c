@@ -1,36 +1,104 @@
-const char *struct_keyword;
-const char *enum_keyword;
-const char *union_keyword;
-const char *let_keyword;
-const char *fn_keyword;
-const char *const_keyword;
-const char *new_keyword;
-const char *auto_keyword;
-const char *delete_keyword;
-const char *size_of_keyword;
-const char *size_of_type_keyword;
-const char *as_keyword;
-const char *null_keyword;
-const char *true_keyword;
-const char *false_keyword;
-const char *break_keyword;
-const char *continue_keyword;
-const char *return_keyword;
-const char *if_keyword;
-const char *else_keyword;
-const char *while_keyword;
-const char *do_keyword;
-const char *for_keyword;
-const char *switch_keyword;
-const char *case_keyword;
-const char *default_keyword;
-const char *variadic_keyword;
-const char *extern_keyword;
+const char *keyword_literals[KEYWORD_COUNT] =
+{
+    [KEYWORD_NONE] = "",
+    [KEYWORD_STRUCT] = "struct",
+    [KEYWORD_ENUM] = "enum",
+    [KEYWORD_UNION] = "union",
+    [KEYWORD_LET] = "let",
+    [KEYWORD_FN] = "fn",
+    [KEYWORD_SIZE_OF] = "size_of",
+    [KEYWORD_SIZE_OF_TYPE] = "size_of_type",
+    [KEYWORD_CONST] = "const",
+    [KEYWORD_NEW] = "new",
+    [KEYWORD_AUTO] = "auto",
+    [KEYWORD_DELETE] = "delete",
+    [KEYWORD_AS] = "as",
+    [KEYWORD_NULL] = "null",
+    [KEYWORD_TRUE] = "true",
+    [KEYWORD_FALSE] = "false",
+    [KEYWORD_BREAK] = "break",
+    [KEYWORD_CONTINUE] = "continue",
+    [KEYWORD_RETURN] = "return",
+    [KEYWORD_IF] = "if",
+    [KEYWORD_ELSE] = "else",
+    [KEYWORD_WHILE] = "while",
+    [KEYWORD_DO] = "do",
+    [KEYWORD_FOR] = "for",
+    [KEYWORD_SWITCH] = "switch",
+    [KEYWORD_CASE] = "case",
+    [KEYWORD_DEFAULT] = "default",
+    [KEYWORD_VARIADIC] = "variadic",
+    [KEYWORD_EXTERN] = "extern",
+    [KEYWORD_INLINE] = "inline",
+    [KEYWORD_NOINLINE] = "noinline",
+};
+
+// wskaźniki na internowane nazwy słów kluczowych
+const char *keyword_names[KEYWORD_COUNT];
 
-const char *first_keyword;
-const char *last_keyword;
+const char *variadic_keyword;
 const char **keywords_list;
 
+// doskonała funkcja skrótu - żadne dwa słowa kluczowe nie trafiają w to samo miejsce
+// tablicy, więc po jednym porównaniu wiadomo, czy identyfikator jest słowem kluczowym;
+// współczynniki dobrane tak, by nie było kolizji (sprawdza to lexing_test)
+#define KEYWORD_HASH(first, last, length) ((((first) * 13) + ((last) * 5) + ((length) * 2)) & 63)
+#define MIN_KEYWORD_LENGTH 2
+#define MAX_KEYWORD_LENGTH 12
+
+const uint8_t keyword_hash_table[64] =
+{
+    [KEYWORD_HASH('s', 't', 6)] = KEYWORD_STRUCT,
+    [KEYWORD_HASH('e', 'm', 4)] = KEYWORD_ENUM,
+    [KEYWORD_HASH('u', 'n', 5)] = KEYWORD_UNION,
+    [KEYWORD_HASH('l', 't', 3)] = KEYWORD_LET,
+    [KEYWORD_HASH('f', 'n', 2)] = KEYWORD_FN,
+    [KEYWORD_HASH('s', 'f', 7)] = KEYWORD_SIZE_OF,
+    [KEYWORD_HASH('s', 'e', 12)] = KEYWORD_SIZE_OF_TYPE,
+    [KEYWORD_HASH('c', 't', 5)] = KEYWORD_CONST,
+    [KEYWORD_HASH('n', 'w', 3)] = KEYWORD_NEW,
+    [KEYWORD_HASH('a', 'o', 4)] = KEYWORD_AUTO,
+    [KEYWORD_HASH('d', 'e', 6)] = KEYWORD_DELETE,
+    [KEYWORD_HASH('a', 's', 2)] = KEYWORD_AS,
+    [KEYWORD_HASH('n', 'l', 4)] = KEYWORD_NULL,
+    [KEYWORD_HASH('t', 'e', 4)] = KEYWORD_TRUE,
+    [KEYWORD_HASH('f', 'e', 5)] = KEYWORD_FALSE,
+    [KEYWORD_HASH('b', 'k', 5)] = KEYWORD_BREAK,
+    [KEYWORD_HASH('c', 'e', 8)] = KEYWORD_CONTINUE,
+    [KEYWORD_HASH('r', 'n', 6)] = KEYWORD_RETURN,
+    [KEYWORD_HASH('i', 'f', 2)] = KEYWORD_IF,
+    [KEYWORD_HASH('e', 'e', 4)] = KEYWORD_ELSE,
+    [KEYWORD_HASH('w', 'e', 5)] = KEYWORD_WHILE,
+    [KEYWORD_HASH('d', 'o', 2)] = KEYWORD_DO,
+    [KEYWORD_HASH('f', 'r', 3)] = KEYWORD_FOR,
+    [KEYWORD_HASH('s', 'h', 6)] = KEYWORD_SWITCH,
+    [KEYWORD_HASH('c', 'e', 4)] = KEYWORD_CASE,
+    [KEYWORD_HASH('d', 't', 7)] = KEYWORD_DEFAULT,
+    [KEYWORD_HASH('v', 'c', 8)] = KEYWORD_VARIADIC,
+    [KEYWORD_HASH('e', 'n', 6)] = KEYWORD_EXTERN,
+    [KEYWORD_HASH('i', 'e', 6)] = KEYWORD_INLINE,
+    [KEYWORD_HASH('n', 'e', 8)] = KEYWORD_NOINLINE,
+};
+
+// rozpoznaje słowa kluczowe przed internowaniem identyfikatora
+keyword_kind get_keyword_kind(const char *start, size_t length)
+{
+    if (length < MIN_KEYWORD_LENGTH || length > MAX_KEYWORD_LENGTH)
+    {
+        return KEYWORD_NONE;
+    }
+
+    size_t index = KEYWORD_HASH((uint8_t)start[0], (uint8_t)start[length - 1], length);
+    keyword_kind result = keyword_hash_table[index];
+    const char *literal = keyword_literals[result];
+    if (result != KEYWORD_NONE
+        && 0 == strncmp(literal, start, length) && literal[length] == 0)
+    {
+        return result;
+    }
+    return KEYWORD_NONE;
+}
+
 const char *intern_keyword(const char *keyword)
 {
     const char *result = str_intern(keyword);
@@ -44,48 +112,16 @@ void init_keywords(void)
     if (false == keywords_initialized)
     {
         buf_free(keywords_list);
-        struct_keyword = intern_keyword("struct");
-        enum_keyword = intern_keyword("enum");
-        union_keyword = intern_keyword("union");
-        let_keyword = intern_keyword("let");
-        fn_keyword = intern_keyword("fn");
-        size_of_keyword = intern_keyword("size_of");
-        size_of_type_keyword = intern_keyword("size_of_type");
-        const_keyword = intern_keyword("const");
-        new_keyword = intern_keyword("new");
-        auto_keyword = intern_keyword("auto");
-        delete_keyword = intern_keyword("delete");
-        as_keyword = intern_keyword("as");
-        null_keyword = intern_keyword("null");
-        true_keyword = intern_keyword("true");
-        false_keyword = intern_keyword("false");
-        break_keyword = intern_keyword("break");
-        continue_keyword = intern_keyword("continue");
-        return_keyword = intern_keyword("return");
-        if_keyword = intern_keyword("if");
-        else_keyword = intern_keyword("else");
-        while_keyword = intern_keyword("while");;
-        do_keyword = intern_keyword("do");
-        for_keyword = intern_keyword("for");
-        switch_keyword = intern_keyword("switch");
-        case_keyword = intern_keyword("case");
-        default_keyword = intern_keyword("default");
-        variadic_keyword = intern_keyword("variadic");
-        extern_keyword = intern_keyword("extern");
-    
-        first_keyword = struct_keyword;
-        last_keyword = extern_keyword;
+        for (keyword_kind kind = KEYWORD_NONE + 1; kind < KEYWORD_COUNT; kind++)
+        {
+            keyword_names[kind] = intern_keyword(keyword_literals[kind]);
+        }
+        variadic_keyword = keyword_names[KEYWORD_VARIADIC];
 
         keywords_initialized = true;
     }    
 }
 
-bool is_name_keyword(const char *name)
-{
-    bool result = (name >= first_keyword && name <= last_keyword);
-    return result;
-}
-
 const char *constructor_str;
 const char *main_str;
 const char *mangled_main_void_str;
@@ -93,6 +129,12 @@ const char *mangled_main_args_str;
 const char *add_str;
 const char *length_str;
 const char *capacity_str;
+const char *reserve_str;
+const char *add_range_str;
+const char *insert_at_str;
+const char *remove_at_str;
+const char *clear_str;
+const char *copy_from_str;
 const char *printf_str;
 const char *allocate_str;
 const char *assert_str;
@@ -112,6 +154,12 @@ void init_constant_strings(void)
         add_str = str_intern("add");
         length_str = str_intern("length");
         capacity_str = str_intern("capacity");
+        reserve_str = str_intern("reserve");
+        add_range_str = str_intern("add_range");
+        insert_at_str = str_intern("insert_at");
+        remove_at_str = str_intern("remove_at");
+        clear_str = str_intern("clear");
+        copy_from_str = str_intern("copy_from");
         printf_str = str_intern("printf");
         allocate_str = str_intern("allocate");
         assert_str = str_intern("assert");
@@ -1,23 +1,85 @@
 
 
-char *stream;
-token tok;
-token *all_tokens;
-int lexed_token_index;
+// lekser działa na żądanie parsera - przechowuje tylko kilka ostatnich tokenów
+// w buforze cyklicznym, więc zużycie pamięci nie zależy od wielkości pliku
+#define TOKEN_RING_SIZE 4 // musi być potęgą dwójki
 
-size_t nested_comments_level;
-char *current_line_beginning;
+// stan leksera jest osobny dla każdego wątku parsującego pliki
+THREAD_LOCAL char *stream;
+THREAD_LOCAL char *stream_start;
+THREAD_LOCAL const char *stream_filename;
+THREAD_LOCAL token tok;
+
+THREAD_LOCAL compact_token token_ring[TOKEN_RING_SIZE];
+THREAD_LOCAL size_t lexed_token_count;
+THREAD_LOCAL size_t lexed_token_index;
+
+// przesunięcia początków linii bieżącego pliku - z nich wyznaczane są pozycje tokenów
+THREAD_LOCAL uint32_t *line_offsets;
+THREAD_LOCAL size_t last_source_pos_line;
+
+THREAD_LOCAL size_t nested_comments_level;
+THREAD_LOCAL bool unterminated_string_lexed;
 
 const char *str_intern_range_with_escaping(const char *start, const char *end);
 
-bool lex_next_token(void)
+void add_line_start(char *line_start)
+{
+    buf_push(line_offsets, (uint32_t)(line_start - stream_start));
+}
+
+source_pos get_source_pos(uint32_t offset)
+{
+    // parser pobiera tokeny po kolei - zwykle wystarczy sprawdzić linię poprzedniego
+    size_t line_count = buf_len(line_offsets);
+    size_t low = last_source_pos_line;
+    if (low >= line_count || line_offsets[low] > offset)
+    {
+        low = 0;
+    }
+    size_t high = line_count;
+    if (low + 1 < line_count && line_offsets[low + 1] > offset)
+    {
+        high = low + 1;
+    }
+    else if (low + 2 < line_count && line_offsets[low + 2] > offset)
+    {
+        low = low + 1;
+        high = low + 1;
+    }
+
+    while (high - low > 1)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (line_offsets[middle] <= offset)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    last_source_pos_line = low;
+
+    source_pos result = {0};
+    result.filename = stream_filename;
+    result.line = low + 1;
+    result.character = offset - line_offsets[low] + 1;
+    return result;
+}
+
+// zwraca false, jeśli pominięto białe znaki albo komentarz
+bool lex_next_token(compact_token *lexed)
 {
     bool discard_token = false;
     bool unexpected_character = false;
 
-    char *tok_start_line_beginning = current_line_beginning;
-
-    tok.start = stream;
+    char *start = stream;
+    assert(stream - stream_start <= UINT32_MAX);
+    *lexed = (compact_token){0};
+    lexed->offset = (uint32_t)(start - stream_start);
     switch (*stream)
     {
         case '0': 
@@ -45,8 +107,8 @@ bool lex_next_token(void)
                         stream++;
                     }
                 }
-                tok.kind = TOKEN_INT;
-                tok.uint_val = val;
+                lexed->kind = TOKEN_INT;
+                lexed->uint_val = val;
                 break;
             }
 
@@ -73,8 +135,8 @@ bool lex_next_token(void)
                         stream++;
                     }
                 }
-                tok.kind = TOKEN_INT;
-                tok.uint_val = val;
+                lexed->kind = TOKEN_INT;
+                lexed->uint_val = val;
                 break;
             }
         } 
@@ -119,13 +181,13 @@ bool lex_next_token(void)
                         stream++;
                     }
                 }
-                tok.kind = TOKEN_FLOAT;
-                tok.float_val = float_val;
+                lexed->kind = TOKEN_FLOAT;
+                lexed->float_val = float_val;
             }
             else
             {
-                tok.kind = TOKEN_INT;
-                tok.uint_val = val;
+                lexed->kind = TOKEN_INT;
+                lexed->uint_val = val;
             }          
         }
         break;
@@ -142,18 +204,20 @@ bool lex_next_token(void)
         case '_':
         {
             // zaczęliśmy od litery - dalej idziemy po cyfrach, literach i _
-            while (is_alphanumeric(*stream) || *stream == '_')
-            {
-                stream++;
-            }
-            tok.name = str_intern_range(tok.start, stream);
-            if (is_name_keyword(tok.name))
+            stream = lexer_scan(stream, SCAN_NAME);
+
+            // słowa kluczowe nie trafiają do tablicy internowanych stringów
+            keyword_kind keyword = get_keyword_kind(start, stream - start);
+            if (keyword != KEYWORD_NONE)
             {
-                tok.kind = TOKEN_KEYWORD;
+                lexed->kind = TOKEN_KEYWORD;
+                lexed->uint_val = keyword;
             }
             else
             {
-                tok.kind = TOKEN_NAME;
+                uint64_t name_hash = hash_string(start, stream - start);
+                lexed->kind = TOKEN_NAME;
+                lexed->name = str_intern_range_hashed(start, stream, name_hash);
             }
         }
         break;
@@ -162,20 +226,20 @@ bool lex_next_token(void)
             if (*(stream + 1) == '+')
             {
                 stream += 2;
-                tok.kind = TOKEN_INC;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_INC;
+                lexed->name = str_intern_range(start, stream);
             }
             else if (*(stream + 1) == '=')
             {
                 stream += 2;
-                tok.kind = TOKEN_ADD_ASSIGN;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_ADD_ASSIGN;
+                lexed->name = str_intern_range(start, stream);
             }
             else
             {
                 stream++;
-                tok.kind = TOKEN_ADD;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_ADD;
+                lexed->name = str_intern_range(start, stream);
             }
         }
         break;
@@ -184,20 +248,20 @@ bool lex_next_token(void)
             if (*(stream + 1) == '-')
             {
                 stream += 2;
-                tok.kind = TOKEN_DEC;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_DEC;
+                lexed->name = str_intern_range(start, stream);
             }
             else if (*(stream + 1) == '=')
             {
                 stream += 2;
-                tok.kind = TOKEN_SUB_ASSIGN;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_SUB_ASSIGN;
+                lexed->name = str_intern_range(start, stream);
             }
             else
             {
                 stream++;
-                tok.kind = TOKEN_SUB;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_SUB;
+                lexed->name = str_intern_range(start, stream);
             }
         }
         break;
@@ -206,14 +270,14 @@ bool lex_next_token(void)
             if (*(stream + 1) == '=')
             {
                 stream += 2;
-                tok.kind = TOKEN_MUL_ASSIGN;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_MUL_ASSIGN;
+                lexed->name = str_intern_range(start, stream);
             }
             else
             {
                 stream++;
-                tok.kind = TOKEN_MUL;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_MUL;
+                lexed->name = str_intern_range(start, stream);
             }
         }
         break;
@@ -221,23 +285,12 @@ bool lex_next_token(void)
         {
             if (*(stream + 1) == '/')
             {
-                stream += 1;
                 discard_token = true;
-                for (;;)
+                stream = lexer_scan(stream + 2, SCAN_LINE_COMMENT);
+                if (*(stream) == '\n')
                 {
                     stream++;
-                    if (*(stream) == 0)
-                    {
-                        break;
-                    }
-
-                    if (*(stream) == '\n')
-                    {
-                        stream++;
-                        current_line_beginning = stream;
-                        tok.pos.line++;
-                        break;
-                    }
+                    add_line_start(stream);
                 }
             }         
             else if (*(stream + 1) == '*')
@@ -248,7 +301,8 @@ bool lex_next_token(void)
 
                 while (true)
                 {
-                    stream++;
+                    // znaki inne niż /, * i \n nie zmieniają stanu
+                    stream = lexer_scan(stream + 1, SCAN_BLOCK_COMMENT);
                     if (*(stream) == 0)
                     {
                         break;
@@ -257,8 +311,7 @@ bool lex_next_token(void)
                     if (*(stream) == '\n')
                     {
                         stream++;
-                        current_line_beginning = stream;                        
-                        tok.pos.line++;
+                        add_line_start(stream);
                     }
 
                     if (*(stream) == '/' && *(stream + 1) == '*')
@@ -282,34 +335,35 @@ bool lex_next_token(void)
             else if (*(stream + 1) == '=')
             {
                 stream += 2;
-                tok.kind = TOKEN_DIV_ASSIGN;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_DIV_ASSIGN;
+                lexed->name = str_intern_range(start, stream);
             }
             else
             {
                 stream++;
-                tok.kind = TOKEN_DIV;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_DIV;
+                lexed->name = str_intern_range(start, stream);
             }
         }
         break;
         case '"':
         {
             stream++;
-            tok.kind = TOKEN_STRING;
+            lexed->kind = TOKEN_STRING;
             while (true)
-            {                
+            {
+                stream = lexer_scan(stream, SCAN_STRING);
                 if (*(stream) == '\n')
                 {
                     stream++;
-                    current_line_beginning = stream;
-                    tok.pos.line++;
+                    add_line_start(stream);
                     continue;
                 }
                 else if (*(stream) == 0)
                 {
-                    tok.string_val = 
-                        str_intern_range_with_escaping(tok.start + 1, stream);
+                    unterminated_string_lexed = true;
+                    lexed->string_val = 
+                        str_intern_range_with_escaping(start + 1, stream);
                     break;
                 }
                 else if (*(stream) == '"')
@@ -322,8 +376,8 @@ bool lex_next_token(void)
                     }
                     else
                     {
-                        tok.string_val = 
-                            str_intern_range_with_escaping(tok.start + 1, stream);
+                        lexed->string_val = 
+                            str_intern_range_with_escaping(start + 1, stream);
                         stream++;
                         break;
                     }
@@ -340,14 +394,14 @@ bool lex_next_token(void)
         {
             stream++;
 
-            tok.kind = TOKEN_CHAR;
+            lexed->kind = TOKEN_CHAR;
             
             char *begin = stream;            
             while (*stream)
             {
                 if (*stream == '\n' || *stream == '\r')
                 {
-                    error("Newlines are not allowed in character literals", tok.pos);
+                    error("Newlines are not allowed in character literals", get_source_pos(lexed->offset));
                     break;
                 }
 
@@ -376,61 +430,61 @@ bool lex_next_token(void)
             }
             else
             {
-                error("Character literal without matching ' sign", tok.pos);
+                error("Character literal without matching ' sign", get_source_pos(lexed->offset));
             }
             
             if (end - begin == 0)
             {
-                error("Character literals must contain at least one character", tok.pos);
+                error("Character literals must contain at least one character", get_source_pos(lexed->offset));
             }
             else if (end - begin > 2 && *begin != '\\')
             {
-                error("Character literals can only be one character long", tok.pos);
+                error("Character literals can only be one character long", get_source_pos(lexed->offset));
             }
 
-            tok.string_val = str_intern_range_with_escaping(begin, end);
+            lexed->string_val = str_intern_range_with_escaping(begin, end);
         }
         break;
         case '(':
         {
             stream++;
-            tok.kind = TOKEN_LEFT_PAREN;
-            tok.name = str_intern_range(tok.start, stream);
+            lexed->kind = TOKEN_LEFT_PAREN;
+            lexed->name = str_intern_range(start, stream);
         }
         break;
         case ')':
         {
             stream++;
-            tok.kind = TOKEN_RIGHT_PAREN;
-            tok.name = str_intern_range(tok.start, stream);
+            lexed->kind = TOKEN_RIGHT_PAREN;
+            lexed->name = str_intern_range(start, stream);
         }
         break;
         case '{':
         {
             stream++;
-            tok.kind = TOKEN_LEFT_BRACE;
-            tok.name = str_intern_range(tok.start, stream);
+            lexed->kind = TOKEN_LEFT_BRACE;
+            lexed->name = str_intern_range(start, stream);
         }
         break;
         case '}':
         {
             stream++;
-            tok.kind = TOKEN_RIGHT_BRACE;
-            tok.name = str_intern_range(tok.start, stream);
+            lexed->kind = TOKEN_RIGHT_BRACE;
+            lexed->name = str_intern_range(start, stream);
         }
         break;
         case ',':
         {
             stream++;
-            tok.kind = TOKEN_COMMA;
-            tok.name = str_intern_range(tok.start, stream);
+            lexed->kind = TOKEN_COMMA;
+            lexed->name = str_intern_range(start, stream);
         }
         break;
         case '.':
         {
             stream++;
-            tok.kind = TOKEN_DOT;
-            tok.name = str_intern_range(tok.start, stream);
+            lexed->kind = TOKEN_DOT;
+            lexed->name = str_intern_range(start, stream);
         }
         break;
         case '%':
@@ -438,43 +492,43 @@ bool lex_next_token(void)
             if (*(stream + 1) == '=')
             {
                 stream += 2;
-                tok.kind = TOKEN_MOD_ASSIGN;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_MOD_ASSIGN;
+                lexed->name = str_intern_range(start, stream);
             }
             else
             {
                 stream++;
-                tok.kind = TOKEN_MOD;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_MOD;
+                lexed->name = str_intern_range(start, stream);
             }
         }      
         break;
         case '#':
         {
             stream++;
-            tok.kind = TOKEN_DEREFERENCE;
-            tok.name = str_intern_range(tok.start, stream);
+            lexed->kind = TOKEN_DEREFERENCE;
+            lexed->name = str_intern_range(start, stream);
         }
         break;
         case '@':
         {
             stream++;
-            tok.kind = TOKEN_ADDRESS_OF;
-            tok.name = str_intern_range(tok.start, stream);
+            lexed->kind = TOKEN_ADDRESS_OF;
+            lexed->name = str_intern_range(start, stream);
         }
         break;
         case '[':
         {
             stream++;
-            tok.kind = TOKEN_LEFT_BRACKET;
-            tok.name = str_intern_range(tok.start, stream);
+            lexed->kind = TOKEN_LEFT_BRACKET;
+            lexed->name = str_intern_range(start, stream);
         }
         break;
         case ']':
         {
             stream++;
-            tok.kind = TOKEN_RIGHT_BRACKET;
-            tok.name = str_intern_range(tok.start, stream);
+            lexed->kind = TOKEN_RIGHT_BRACKET;
+            lexed->name = str_intern_range(start, stream);
         }
         break;
         case '<':
@@ -482,29 +536,29 @@ bool lex_next_token(void)
             if (*(stream + 1) == '=')
             {              
                 stream += 2;
-                tok.kind = TOKEN_LEQ;
-                tok.name = str_intern_range(tok.start, stream);                
+                lexed->kind = TOKEN_LEQ;
+                lexed->name = str_intern_range(start, stream);                
             }
             else if (*(stream + 1) == '<')
             {
                 if (*(stream + 2) == '=')
                 {
                     stream += 3;
-                    tok.kind = TOKEN_LEFT_SHIFT_ASSIGN;
-                    tok.name = str_intern_range(tok.start, stream);
+                    lexed->kind = TOKEN_LEFT_SHIFT_ASSIGN;
+                    lexed->name = str_intern_range(start, stream);
                 }
                 else
                 {
                     stream += 2;
-                    tok.kind = TOKEN_LEFT_SHIFT;
-                    tok.name = str_intern_range(tok.start, stream);
+                    lexed->kind = TOKEN_LEFT_SHIFT;
+                    lexed->name = str_intern_range(start, stream);
                 }
             }
             else
             {
                 stream++;
-                tok.kind = TOKEN_LT;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_LT;
+                lexed->name = str_intern_range(start, stream);
             }            
         }
         break;
@@ -513,29 +567,29 @@ bool lex_next_token(void)
             if (*(stream + 1) == '=')
             {             
                 stream += 2;
-                tok.kind = TOKEN_GEQ;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_GEQ;
+                lexed->name = str_intern_range(start, stream);
             }
             else if (*(stream + 1) == '>')
             {
                 if (*(stream + 2) == '=')
                 {
                     stream += 3;
-                    tok.kind = TOKEN_RIGHT_SHIFT_ASSIGN;
-                    tok.name = str_intern_range(tok.start, stream);
+                    lexed->kind = TOKEN_RIGHT_SHIFT_ASSIGN;
+                    lexed->name = str_intern_range(start, stream);
                 }
                 else
                 {
                     stream += 2;
-                    tok.kind = TOKEN_RIGHT_SHIFT;
-                    tok.name = str_intern_range(tok.start, stream);
+                    lexed->kind = TOKEN_RIGHT_SHIFT;
+                    lexed->name = str_intern_range(start, stream);
                 }              
             }
             else
             {
                 stream++;
-                tok.kind = TOKEN_GT;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_GT;
+                lexed->name = str_intern_range(start, stream);
             }
         }
         break;
@@ -546,27 +600,27 @@ bool lex_next_token(void)
                 if (*(stream + 2) == '=')
                 {
                     stream += 3;
-                    tok.kind = TOKEN_OR_ASSIGN;
-                    tok.name = str_intern_range(tok.start, stream);
+                    lexed->kind = TOKEN_OR_ASSIGN;
+                    lexed->name = str_intern_range(start, stream);
                 }
                 else
                 {
                     stream += 2;
-                    tok.kind = TOKEN_OR;
-                    tok.name = str_intern_range(tok.start, stream);
+                    lexed->kind = TOKEN_OR;
+                    lexed->name = str_intern_range(start, stream);
                 }
             }
             else if (*(stream + 1) == '=')
             {
                 stream += 2;
-                tok.kind = TOKEN_BITWISE_OR_ASSIGN;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_BITWISE_OR_ASSIGN;
+                lexed->name = str_intern_range(start, stream);
             }
             else
             {
                 stream++;
-                tok.kind = TOKEN_BITWISE_OR;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_BITWISE_OR;
+                lexed->name = str_intern_range(start, stream);
             }
         }
         break;
@@ -577,27 +631,27 @@ bool lex_next_token(void)
                 if (*(stream + 2) == '=')
                 {
                     stream += 3;
-                    tok.kind = TOKEN_AND_ASSIGN;
-                    tok.name = str_intern_range(tok.start, stream);
+                    lexed->kind = TOKEN_AND_ASSIGN;
+                    lexed->name = str_intern_range(start, stream);
                 }
                 else
                 {
                     stream += 2;
-                    tok.kind = TOKEN_AND;
-                    tok.name = str_intern_range(tok.start, stream);
+                    lexed->kind = TOKEN_AND;
+                    lexed->name = str_intern_range(start, stream);
                 }               
             }
             else if (*(stream + 1) == '=')
             {
                 stream += 2;
-                tok.kind = TOKEN_BITWISE_AND_ASSIGN;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_BITWISE_AND_ASSIGN;
+                lexed->name = str_intern_range(start, stream);
             }
             else
             {
                 stream++;
-                tok.kind = TOKEN_BITWISE_AND;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_BITWISE_AND;
+                lexed->name = str_intern_range(start, stream);
             }
         }
         break;
@@ -606,14 +660,14 @@ bool lex_next_token(void)
             if (*(stream + 1) == '=')
             {
                 stream += 2;
-                tok.kind = TOKEN_XOR_ASSIGN;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_XOR_ASSIGN;
+                lexed->name = str_intern_range(start, stream);
             }
             else
             {
                 stream++;
-                tok.kind = TOKEN_XOR;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_XOR;
+                lexed->name = str_intern_range(start, stream);
             }
         }
         break;
@@ -622,22 +676,22 @@ bool lex_next_token(void)
             if (*(stream + 1) == '=')
             {
                 stream += 2;
-                tok.kind = TOKEN_NEQ;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_NEQ;
+                lexed->name = str_intern_range(start, stream);
             }
             else
             {
                 stream++;
-                tok.kind = TOKEN_NOT;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_NOT;
+                lexed->name = str_intern_range(start, stream);
             }
         }
         break;
         case '~':
         {
             stream++;
-            tok.kind = TOKEN_BITWISE_NOT;
-            tok.name = str_intern_range(tok.start, stream);
+            lexed->kind = TOKEN_BITWISE_NOT;
+            lexed->name = str_intern_range(start, stream);
         }
         break;
         case '=':
@@ -645,14 +699,14 @@ bool lex_next_token(void)
             if (*(stream + 1) == '=')
             {
                 stream += 2;
-                tok.kind = TOKEN_EQ;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_EQ;
+                lexed->name = str_intern_range(start, stream);
             }
             else
             {
                 stream++;
-                tok.kind = TOKEN_ASSIGN;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_ASSIGN;
+                lexed->name = str_intern_range(start, stream);
             }
         }
         break;
@@ -661,30 +715,29 @@ bool lex_next_token(void)
             if (*(stream + 1) == '=')
             {
                 stream += 2;
-                tok.kind = TOKEN_COLON_ASSIGN;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_COLON_ASSIGN;
+                lexed->name = str_intern_range(start, stream);
             }
             else
             {
                 stream++;
-                tok.kind = TOKEN_COLON;
-                tok.name = str_intern_range(tok.start, stream);
+                lexed->kind = TOKEN_COLON;
+                lexed->name = str_intern_range(start, stream);
             }
         }
         break;
         case '?':
         {
             stream++;
-            tok.kind = TOKEN_QUESTION;
-            tok.name = str_intern_range(tok.start, stream);
+            lexed->kind = TOKEN_QUESTION;
+            lexed->name = str_intern_range(start, stream);
         }
         break;
         case '\n':
         {
             stream++;
-            current_line_beginning = stream;
-            tok.pos.line++;
-            tok.kind = TOKEN_NEWLINE;
+            add_line_start(stream);
+            lexed->kind = TOKEN_NEWLINE;
         }
         break;
         case '\r':
@@ -692,13 +745,13 @@ bool lex_next_token(void)
         case '\t': 
         case '\v':
         {
-            stream++;
+            stream = lexer_scan(stream + 1, SCAN_WHITESPACE);
             discard_token = true;
         }
         break;
         case '\0':
         {
-            tok.kind = TOKEN_EOF;
+            lexed->kind = TOKEN_EOF;
         }
         break;
         case ';':
@@ -711,39 +764,30 @@ bool lex_next_token(void)
         break;
     }
     
-    // w przypadku tokenów zajmujących wiele linii
-    if (tok.start < current_line_beginning)
-    {
-        assert(tok.start >= tok_start_line_beginning);
-        tok.pos.character = tok.start - tok_start_line_beginning + 1LL;
-    }
-    else
-    {
-        tok.pos.character = tok.start - current_line_beginning + 1LL;
-    }
-
-    tok.end = stream;
-
     if (unexpected_character)
     {
-        error(xprintf("Unexpected character: %c", *(stream - 1)), tok.pos);
+        error(xprintf("Unexpected character: %c", *(stream - 1)), get_source_pos(lexed->offset));
         unexpected_character = false;
     }
 
-    if (false == discard_token)
-    {
-        buf_push(all_tokens, tok);
-    }
-
-    assert((tok.kind != TOKEN_NAME && tok.kind != TOKEN_KEYWORD) 
-        || tok.name == str_intern(tok.name));
+    assert(lexed->kind != TOKEN_NAME || lexed->name == str_intern(lexed->name));
 
-    bool is_at_end = (tok.kind == TOKEN_EOF && false == discard_token);
-    return (false == is_at_end);
+    return (false == discard_token);
 }
 
 const char *str_intern_range_with_escaping(const char *start, const char *end)
 {
+    // bez sekwencji ucieczki internujemy bezpośrednio z kodu źródłowego
+    const char *it = start;
+    while (it != end && *it != '\\' && *it != '\r' && *it != 0)
+    {
+        it++;
+    }
+    if (it == end)
+    {
+        return str_intern_range(start, end);
+    }
+
     size_t len = end - start;
 
     char *copy = xcalloc(len);
@@ -806,50 +850,79 @@ void init_stream(char *source, char *filename)
 {
     init_keywords(); 
     
-    stream = source;    
-    current_line_beginning = stream;
+    stream = source;
+    stream_start = source;
+    stream_filename = filename ? filename : "<string>";
     nested_comments_level = 0;
+    unterminated_string_lexed = false;
+    lexed_token_count = 0;
     lexed_token_index = 0;
 
+    buf_free(line_offsets);
+    buf_push(line_offsets, 0);
+    last_source_pos_line = 0;
+
     tok = (token){0};
-    tok.pos.filename = filename ? filename : "<string>";
-    tok.pos.line = 1;
-    tok.pos.character = 1;
+    tok.pos = get_source_pos(0);
 
-    buf_free(all_tokens);
-    
-    if (source)
+    // BOM pomijamy, ale liczy się do pozycji w pierwszej linii
+    if (source && (uint8_t)source[0] == 0xef && (uint8_t)source[1] == 0xbb && (uint8_t)source[2] == 0xbf)
     {
-        lex_next_token();
+        stream = source + 3;
     }
 }
 
-void next_token(void)
+// dostępne są tokeny następujące po bieżącym oraz kilka ostatnich
+compact_token *get_lexed_token(size_t index)
 {
-    if (lexed_token_index + 1 < buf_len(all_tokens))
+    assert(index + TOKEN_RING_SIZE >= lexed_token_count);
+    while (lexed_token_count <= index)
     {
-        token *next = &all_tokens[lexed_token_index];
-        if (next)
+        compact_token *lexed = &token_ring[lexed_token_count & (TOKEN_RING_SIZE - 1)];
+        if (lex_next_token(lexed))
         {
-            tok = *next;
-            lexed_token_index++;
-        }
-        if (next->kind == TOKEN_NEWLINE)
-        {
-            next_token();
+            lexed_token_count++;
         }
     }
-    else
+    return &token_ring[index & (TOKEN_RING_SIZE - 1)];
+}
+
+token get_full_token(compact_token *compact)
+{
+    token result = {0};
+    result.kind = compact->kind;
+    result.pos = get_source_pos(compact->offset);
+    result.uint_val = compact->uint_val;
+    if (result.kind == TOKEN_KEYWORD)
     {
-        tok = all_tokens[lexed_token_index];
+        result.keyword = (keyword_kind)compact->uint_val;
+        result.name = keyword_names[result.keyword];
     }
+    return result;
+}
+
+void next_token(void)
+{
+    compact_token *next = get_lexed_token(lexed_token_index);
+    while (next->kind == TOKEN_NEWLINE)
+    {
+        lexed_token_index++;
+        next = get_lexed_token(lexed_token_index);
+    }
+
+    // EOF pozostaje bieżącym tokenem przy kolejnych wywołaniach
+    if (next->kind != TOKEN_EOF)
+    {
+        lexed_token_index++;
+    }
+    tok = get_full_token(next);
 }
 
 bool was_previous_token_newline(void)
 {
     if (lexed_token_index > 2)
     {
-        bool result = (all_tokens[lexed_token_index - 2].kind == TOKEN_NEWLINE);
+        bool result = (get_lexed_token(lexed_token_index - 2)->kind == TOKEN_NEWLINE);
         return result;
     }
     else
@@ -860,50 +933,57 @@ bool was_previous_token_newline(void)
 
 void ignore_tokens_until_newline(void)
 {
-    while (lexed_token_index + 1 < buf_len(all_tokens))
+    compact_token *next = get_lexed_token(lexed_token_index);
+    while (next->kind != TOKEN_EOF)
     {
-        if (all_tokens[lexed_token_index].kind == TOKEN_NEWLINE)
+        lexed_token_index++;
+        if (next->kind == TOKEN_NEWLINE)
         {
-            lexed_token_index++;
             // przypadek wielu newlines pod rząd
-            while (lexed_token_index + 1 < buf_len(all_tokens))
+            next = get_lexed_token(lexed_token_index);
+            while (next->kind == TOKEN_NEWLINE)
             {
-                if (all_tokens[lexed_token_index].kind == TOKEN_NEWLINE)
-                {
-                    lexed_token_index++;
-                }
-                else
-                {
-                    break;
-                }
+                lexed_token_index++;
+                next = get_lexed_token(lexed_token_index);
             }
 
-            tok = all_tokens[lexed_token_index];
-            lexed_token_index++;
-            break;
-        }
-        else if (all_tokens[lexed_token_index].kind == TOKEN_EOF)
-        {
+            if (next->kind != TOKEN_EOF)
+            {
+                lexed_token_index++;
+            }
+            tok = get_full_token(next);
             break;
         }
 
-        lexed_token_index++;
+        next = get_lexed_token(lexed_token_index);
     }
 }
 
 void ignore_tokens_until_next_block(void)
 {
-    while (lexed_token_index + 1 < buf_len(all_tokens))
+    while (get_lexed_token(lexed_token_index)->kind != TOKEN_EOF)
     {
-        if (all_tokens[lexed_token_index].kind == TOKEN_RIGHT_BRACE)
+        bool is_block_end = (get_lexed_token(lexed_token_index)->kind == TOKEN_RIGHT_BRACE);
+        next_token();
+        if (is_block_end)
         {
-            next_token();
             break;
         }
-        else
-        {
-            next_token();
-        }
+    }
+}
+
+// części pliku, do których parser nie dotarł, też trzeba przejrzeć, by zgłosić błędy leksera
+void lex_remaining_tokens(void)
+{
+    if (stream == null)
+    {
+        return;
+    }
+
+    size_t index = lexed_token_count;
+    while (get_lexed_token(index)->kind != TOKEN_EOF)
+    {
+        index++;
     }
 }
 
@@ -916,8 +996,10 @@ void lex(char *source, char *filename)
         return;
     }
 
-    while (lex_next_token());
-
-    tok = all_tokens[0];
-    lexed_token_index = 1;
-}
\ No newline at end of file
+    compact_token *first = get_lexed_token(0);
+    if (first->kind != TOKEN_EOF)
+    {
+        lexed_token_index = 1;
+    }
+    tok = get_full_token(first);
+}
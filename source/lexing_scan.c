@@ -0,0 +1,157 @@
+// wyszukiwanie końca białych znaków, nazw, komentarzy i stringów po 16 lub 32 bajty naraz
+// odczyty są wyrównane, więc nigdy nie przekraczają granicy strony pamięci - mogą sięgać
+// za koniec kodu, ale każde skanowanie zatrzymuje się najpóźniej na kończącym zerze
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LEXER_VECTOR_SIZE 32
+#define LEXER_FULL_MASK UINT32_MAX
+typedef __m256i lexer_vector;
+#define lexer_load(ptr) _mm256_load_si256((const __m256i *)(ptr))
+#define lexer_splat(c) _mm256_set1_epi8(c)
+#define lexer_eq(a, b) _mm256_cmpeq_epi8((a), (b))
+#define lexer_gt(a, b) _mm256_cmpgt_epi8((a), (b))
+#define lexer_or(a, b) _mm256_or_si256((a), (b))
+#define lexer_and(a, b) _mm256_and_si256((a), (b))
+#define lexer_mask(v) ((uint32_t)_mm256_movemask_epi8(v))
+#elif SSE2_SUPPORTED
+#define LEXER_VECTOR_SIZE 16
+#define LEXER_FULL_MASK 0xFFFFu
+typedef __m128i lexer_vector;
+#define lexer_load(ptr) _mm_load_si128((const __m128i *)(ptr))
+#define lexer_splat(c) _mm_set1_epi8(c)
+#define lexer_eq(a, b) _mm_cmpeq_epi8((a), (b))
+#define lexer_gt(a, b) _mm_cmpgt_epi8((a), (b))
+#define lexer_or(a, b) _mm_or_si128((a), (b))
+#define lexer_and(a, b) _mm_and_si128((a), (b))
+#define lexer_mask(v) ((uint32_t)_mm_movemask_epi8(v))
+#else
+#define LEXER_VECTOR_SIZE 0
+#endif
+
+// odczyt za końcem bufora jest zamierzony
+#if defined(__clang__) || defined(__GNUC__)
+#define LEXER_NO_SANITIZE __attribute__((no_sanitize_address))
+#else
+#define LEXER_NO_SANITIZE
+#endif
+
+typedef enum lexer_scan_kind
+{
+    SCAN_WHITESPACE,    // do pierwszego znaku innego niż spacja, \t, \v i \r
+    SCAN_NAME,          // do pierwszego znaku spoza liter, cyfr i _
+    SCAN_LINE_COMMENT,  // do \n
+    SCAN_BLOCK_COMMENT, // do /, * albo \n
+    SCAN_STRING,        // do " albo \n
+} lexer_scan_kind;
+
+bool lexer_simd_enabled = true;
+
+bool is_lexer_scan_stop(char c, lexer_scan_kind kind)
+{
+    switch (kind)
+    {
+        case SCAN_WHITESPACE:
+            return (c != ' ' && c != '\t' && c != '\v' && c != '\r');
+        case SCAN_NAME:
+            return (false == is_alphanumeric(c) && c != '_');
+        case SCAN_LINE_COMMENT:
+            return (c == '\n' || c == 0);
+        case SCAN_BLOCK_COMMENT:
+            return (c == '/' || c == '*' || c == '\n' || c == 0);
+        case SCAN_STRING:
+            return (c == '"' || c == '\n' || c == 0);
+    }
+    return true;
+}
+
+char *lexer_scan_scalar(char *ptr, lexer_scan_kind kind)
+{
+    while (false == is_lexer_scan_stop(*ptr, kind))
+    {
+        ptr++;
+    }
+    return ptr;
+}
+
+#if LEXER_VECTOR_SIZE
+
+lexer_vector lexer_in_range(lexer_vector v, char first, char last)
+{
+    // porównania są ze znakiem - bajty spoza ASCII nigdy nie należą do przedziału
+    lexer_vector result = lexer_and(
+        lexer_gt(v, lexer_splat((char)(first - 1))),
+        lexer_gt(lexer_splat((char)(last + 1)), v));
+    return result;
+}
+
+LEXER_NO_SANITIZE
+uint32_t get_lexer_stop_mask(const char *block, lexer_scan_kind kind)
+{
+    lexer_vector v = lexer_load(block);
+    lexer_vector zero = lexer_eq(v, lexer_splat(0));
+    switch (kind)
+    {
+        case SCAN_WHITESPACE:
+        {
+            lexer_vector whitespace = lexer_or(
+                lexer_or(lexer_eq(v, lexer_splat(' ')), lexer_eq(v, lexer_splat('\t'))),
+                lexer_or(lexer_eq(v, lexer_splat('\v')), lexer_eq(v, lexer_splat('\r'))));
+            return ~lexer_mask(whitespace) & LEXER_FULL_MASK;
+        }
+        case SCAN_NAME:
+        {
+            lexer_vector name = lexer_or(
+                lexer_or(lexer_in_range(v, 'a', 'z'), lexer_in_range(v, 'A', 'Z')),
+                lexer_or(lexer_in_range(v, '0', '9'), lexer_eq(v, lexer_splat('_'))));
+            return ~lexer_mask(name) & LEXER_FULL_MASK;
+        }
+        case SCAN_LINE_COMMENT:
+        {
+            return lexer_mask(lexer_or(zero, lexer_eq(v, lexer_splat('\n'))));
+        }
+        case SCAN_BLOCK_COMMENT:
+        {
+            lexer_vector stop = lexer_or(
+                lexer_or(zero, lexer_eq(v, lexer_splat('\n'))),
+                lexer_or(lexer_eq(v, lexer_splat('/')), lexer_eq(v, lexer_splat('*'))));
+            return lexer_mask(stop);
+        }
+        case SCAN_STRING:
+        {
+            lexer_vector stop = lexer_or(
+                lexer_or(zero, lexer_eq(v, lexer_splat('\n'))),
+                lexer_eq(v, lexer_splat('"')));
+            return lexer_mask(stop);
+        }
+    }
+    return UINT32_MAX;
+}
+
+char *lexer_scan_simd(char *ptr, lexer_scan_kind kind)
+{
+    size_t misalignment = (uintptr_t)ptr & (LEXER_VECTOR_SIZE - 1);
+    const char *block = ptr - misalignment;
+    uint32_t mask = get_lexer_stop_mask(block, kind) & (UINT32_MAX << misalignment);
+    while (mask == 0)
+    {
+        block += LEXER_VECTOR_SIZE;
+        mask = get_lexer_stop_mask(block, kind);
+    }
+    return (char *)block + count_trailing_zeros(mask);
+}
+
+#endif
+
+// zwraca wskaźnik na pierwszy znak, na którym lekser musi się zatrzymać
+char *lexer_scan(char *ptr, lexer_scan_kind kind)
+{
+#if LEXER_VECTOR_SIZE
+    // krótkie fragmenty są częste - najpierw sprawdzamy pierwszy znak
+    if (lexer_simd_enabled && false == is_lexer_scan_stop(*ptr, kind))
+    {
+        return lexer_scan_simd(ptr, kind);
+    }
+#endif
+    return lexer_scan_scalar(ptr, kind);
+}
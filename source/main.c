@@ -1,4 +1,9 @@
-﻿#include <stdio.h>
+﻿// strdup, realpath i mmap nie należą do C99
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdarg.h>
@@ -7,6 +12,8 @@
 #include <stdbool.h>
 #include <ctype.h>
 #include <math.h>
+#include <time.h>
+#include <setjmp.h>
 
 #define SRC_FILE_EXT "wil"
 
@@ -15,14 +22,15 @@
 #pragma warning(disable:4996)
 #endif
 
-#include "utils\utils.c"
+#include "utils/utils.c"
 
-memory_arena *arena;
+THREAD_LOCAL memory_arena *arena;
 
 #include "tokens.c"
 #include "keywords.c"
 #include "ast.c"
 #include "types.c"
+#include "lexing_scan.c"
 #include "lexing.c"
 
 #include "ast_print.c"
@@ -30,13 +38,24 @@ memory_arena *arena;
 #include "arithmetic.c"
 
 #include "resolving.c"
+#include "range_analysis.c"
+#include "escape_analysis.c"
+#include "inlining.c"
+#include "ir.c"
+#include "ir_passes.c"
+#include "x64.c"
+#include "elf_writer.c"
+#include "jit.c"
 #include "cgen.c"
+#include "build.c"
+#include "ast_cache.c"
 #include "mangling.c"
 
 #include "../include/common.c"
 #include "test_runner.c"
 
 #include "treewalk.c"
+#include "const_eval.c"
 #include "setup.c"
 
 #ifdef __EMSCRIPTEN__
@@ -53,36 +72,137 @@ typedef struct compiler_options
     bool print_ast;
     bool test_mode;
     bool help;
+    bool unchecked;
+    bool no_ir;
+    bool print_ir;
+    bool native;
+    bool jit_off;
+    bool cache_off;
+    bool build;
+    char *c_compiler;
+    char *c_flags;
+    size_t split_units;
+    bool check_only;
+    bool server;
+    char *socket_path;
+    char *client_command;
+    bool lexer_benchmark;
+    size_t threads;
 } compiler_options;
 
+#include "server.c"
+
 void parse_file(char *filename, decl ***declarations_list)
 {
-    string_ref source = read_file_for_parsing(filename);
+    string_ref source = map_file_for_parsing(filename);
     if (source.str == null || source.length == 0)
     {
         error_without_pos(xprintf("Source file '%s' doesn't exist.", filename));
         return;
     }
 
-    lex_and_parse(source.str, filename, declarations_list);
+    if (ast_cache_enabled)
+    {
+        parse_source_with_cache(source, filename, ast_cache_dir, declarations_list);
+    }
+    else
+    {
+        lex_and_parse(source.str, filename, declarations_list);
+    }
+}
+
+void parse_prelude(decl ***declarations_list)
+{
+    char *filename = "include/common." SRC_FILE_EXT;
+    string_ref source = map_file_for_parsing(filename);
+    if (source.str == null || source.length == 0)
+    {
+        error_without_pos(xprintf("Source file '%s' doesn't exist.", filename));
+        return;
+    }
 
-    free(source.str);
+    parse_prelude_with_image(source, filename, declarations_list);
 }
 
-void parse_directory(char *path, decl ***declarations_list)
+typedef struct parsed_file
 {
-    char **source_files = get_source_files_in_dir_and_subdirs(path);
-    for (size_t i = 0; i < buf_len(source_files); i++)
+    char *filename;
+    decl **declarations;
+    error_message *errors;
+} parsed_file;
+
+typedef struct parsing_job
+{
+    parsed_file *files;
+    size_t next_file;
+    thread_mutex mutex;
+} parsing_job;
+
+// każdy wątek ma własne areny i stan leksera, a deklaracje i błędy są zbierane
+// osobno dla każdego pliku
+void parse_files_job(void *data)
+{
+    parsing_job *job = data;
+    enter_worker_thread();
+
+    while (true)
     {
-        char *filename = source_files[i];
-        parse_file(filename, declarations_list);       
+        lock_mutex(&job->mutex);
+        size_t index = job->next_file++;
+        unlock_mutex(&job->mutex);
+        if (index >= buf_len(job->files))
+        {
+            break;
+        }
+
+        parsed_file *file = &job->files[index];
+        parse_file(file->filename, &file->declarations);
+        file->errors = errors;
+        errors = null;
     }
 
-    for (size_t i = 0; i < buf_len(source_files); i++)
+    leave_worker_thread();
+}
+
+// wyniki są łączone w kolejności plików, więc nie zależą od liczby wątków
+void parse_files(char **filenames, size_t thread_count, decl ***declarations_list)
+{
+    thread_count = min(thread_count, buf_len(filenames));
+    if (thread_count > 1)
     {
-        free(source_files[i]);
+        parsing_job job = {0};
+        for (size_t i = 0; i < buf_len(filenames); i++)
+        {
+            buf_push(job.files, ((parsed_file){ .filename = filenames[i] }));
+        }
+        init_mutex(&job.mutex);
+
+        bool parsed = run_in_worker_threads(thread_count, parse_files_job, &job);
+        destroy_mutex(&job.mutex);
+
+        for (size_t i = 0; i < buf_len(job.files); i++)
+        {
+            parsed_file *file = &job.files[i];
+            for (size_t j = 0; j < buf_len(file->declarations); j++)
+            {
+                buf_push(*declarations_list, file->declarations[j]);
+            }
+            append_errors(file->errors);
+            buf_free(file->declarations);
+            buf_free(file->errors);
+        }
+        buf_free(job.files);
+
+        if (parsed)
+        {
+            return;
+        }
+    }
+
+    for (size_t i = 0; i < buf_len(filenames); i++)
+    {
+        parse_file(filenames[i], declarations_list);
     }
-    buf_free(source_files);
 }
 
 void report_errors(void)
@@ -109,26 +229,87 @@ void report_errors(void)
 #endif
 }
 
+void build_program(compiler_options options)
+{
+    build_options build = {
+        .compiler = options.c_compiler,
+        .flags = options.c_flags ? options.c_flags : "-O2",
+        .cache_dir = "output/cache",
+    };
+    if (build.compiler == null)
+    {
+        build.compiler = getenv("CC");
+    }
+    if (build.compiler == null)
+    {
+        build.compiler = "cc";
+    }
+
+    char *native_object = null;
+    if (generate_native_code && generate_from_ir)
+    {
+        native_object = get_native_object_filename(options.output_filename);
+    }
+
+    char **c_sources = null;
+    char *c_header = null;
+    if (options.split_units > 1)
+    {
+        c_header = get_split_header_filename(options.output_filename);
+        for (size_t i = 0; i < options.split_units; i++)
+        {
+            buf_push(c_sources, get_split_unit_filename(options.output_filename, i));
+        }
+    }
+    else
+    {
+        buf_push(c_sources, options.output_filename);
+    }
+
+    char *executable = get_output_filename_with_extension(options.output_filename, EXECUTABLE_EXT);
+    if (false == build_executable(&build, c_sources, c_header, native_object, executable))
+    {
+        report_errors();
+    }
+    buf_free(c_sources);
+}
+
 void compile_sources(compiler_options options)
 {
     decl **all_declarations = null;
     symbol **resolved = null;
 
-    parse_file("include/common." SRC_FILE_EXT, &all_declarations);
+#ifndef __EMSCRIPTEN__
+    ast_cache_enabled = (false == options.cache_off);
+#endif
+    parse_prelude(&all_declarations);
     assert(buf_len(all_declarations) > 0);
 
+    // pliki z podanych katalogów są parsowane razem z pozostałymi
+    char **filenames = null;
+    char **directory_files = null;
     for (size_t i = 0; i < buf_len(options.sources); i++)
     {
         char *filename = options.sources[i];
         if (path_has_extension(filename, SRC_FILE_EXT))
         {
-            parse_file(filename, &all_declarations);
+            buf_push(filenames, filename);
         }
         else
         {
-            parse_directory(filename, &all_declarations);
+            char **source_files = get_source_files_in_dir_and_subdirs(filename);
+            for (size_t j = 0; j < buf_len(source_files); j++)
+            {
+                buf_push(filenames, source_files[j]);
+                buf_push(directory_files, source_files[j]);
+            }
+            buf_free(source_files);
         }
     }
+
+    worker_threads_count = options.threads ? options.threads : get_processor_count();
+    parse_files(filenames, worker_threads_count, &all_declarations);
+    buf_free(filenames);
     
     if (options.print_ast)
     {
@@ -163,7 +344,12 @@ void compile_sources(compiler_options options)
     }
     else
     {
+        jit_enabled = (false == options.jit_off);
         resolved = resolve(all_declarations, true);
+        if (buf_len(errors) == 0)
+        {
+            evaluate_compile_time_values(resolved);
+        }
         
         if (buf_len(errors) > 0)
         {
@@ -171,17 +357,41 @@ void compile_sources(compiler_options options)
         }
         else
         {
-            if (options.run)
+            resolved = inline_small_functions(resolved);
+            stack_allocate_non_escaping_objects(resolved);
+
+            if (options.check_only)
+            {
+                // tylko sprawdzenie poprawności - bez generowania kodu
+            }
+            else if (options.run)
             {
                 run_interpreter(resolved);
             }
             else
             {
+                generate_bounds_checks = (false == options.unchecked);
+                generate_from_ir = (false == options.no_ir);
+                print_ir = options.print_ir;
+                generate_native_code = options.native;
+                generate_split_units = options.split_units;
+                generate_separate_runtime = (options.build || options.split_units > 1);
                 c_gen(resolved, options.output_filename, options.print_c);
+
+                if (options.build && buf_len(errors) == 0)
+                {
+                    build_program(options);
+                }
             }
         }
     }
 
+    // pozycje w kodzie wskazują na nazwy plików do końca kompilacji
+    for (size_t i = 0; i < buf_len(directory_files); i++)
+    {
+        free(directory_files[i]);
+    }
+    buf_free(directory_files);
     buf_free(all_declarations);
 }
 
@@ -235,7 +445,7 @@ compiler_options parse_cmd_arguments(int arg_count, char **args)
         {
             if (0 == strcmp(arg, "-run"))
             {
-                result.print_ast = true;
+                result.run = true;
             }
             else if (0 == strcmp(arg, "-print-c"))
             {
@@ -252,6 +462,70 @@ compiler_options parse_cmd_arguments(int arg_count, char **args)
             else if (0 == strcmp(arg, "-help"))
             {
                 result.help = true;
+            }
+            else if (0 == strcmp(arg, "-unchecked"))
+            {
+                result.unchecked = true;
+            }
+            else if (0 == strcmp(arg, "-no-ir"))
+            {
+                result.no_ir = true;
+            }
+            else if (0 == strcmp(arg, "-print-ir"))
+            {
+                result.print_ir = true;
+            }
+            else if (0 == strcmp(arg, "-x64"))
+            {
+                result.native = true;
+            }
+            else if (0 == strcmp(arg, "-jit=off"))
+            {
+                result.jit_off = true;
+            }
+            else if (0 == strcmp(arg, "-check"))
+            {
+                result.check_only = true;
+            }
+            else if (0 == strcmp(arg, "-server"))
+            {
+                result.server = true;
+            }
+            else if (0 == strncmp(arg, "-socket=", 8))
+            {
+                result.socket_path = arg + 8;
+            }
+            else if (0 == strncmp(arg, "-client=", 8))
+            {
+                result.client_command = arg + 8;
+            }
+            else if (0 == strcmp(arg, "-lex-benchmark"))
+            {
+                result.lexer_benchmark = true;
+            }
+            else if (0 == strncmp(arg, "-threads=", 9))
+            {
+                result.threads = (size_t)strtoull(arg + 9, null, 10);
+            }
+            else if (0 == strcmp(arg, "-cache=off"))
+            {
+                result.cache_off = true;
+            }
+            else if (0 == strcmp(arg, "-build"))
+            {
+                result.build = true;
+            }
+            else if (0 == strncmp(arg, "-cc=", 4))
+            {
+                result.c_compiler = arg + 4;
+            }
+            else if (0 == strncmp(arg, "-cflags=", 8))
+            {
+                result.c_flags = arg + 8;
+            }
+            else if (0 == strncmp(arg, "-split=", 7))
+            {
+                result.split_units = (size_t)strtoull(arg + 7, null, 10);
             }          
         }
         else
@@ -270,6 +544,17 @@ int main(int arg_count, char **args)
     compiler_options options = parse_cmd_arguments(arg_count, args);
 
     options.output_filename = "output/output.c";
+
+    if (options.server || options.client_command)
+    {
+        const char *socket_path = options.socket_path ? options.socket_path : SERVER_DEFAULT_SOCKET;
+        int exit_code = options.server
+            ? run_server(socket_path)
+            : run_client(socket_path, options.client_command, arg_count, args);
+        buf_free(options.sources);
+        return exit_code;
+    }
+
 #if DEBUG_BUILD
 #if 1
     options.run = true;
@@ -281,7 +566,13 @@ int main(int arg_count, char **args)
     for (size_t i = 0; i < 100; i++)
     {
 #endif
-        if (options.test_mode)
+        if (options.lexer_benchmark)
+        {
+            allocate_memory();
+            lexer_benchmark(options.sources);
+            clear_memory();
+        }
+        else if (options.test_mode)
         {
             allocate_memory();
             run_all_tests();
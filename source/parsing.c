@@ -90,7 +90,7 @@ typespec *parse_basic_typespec(void)
         t = push_typespec_name(tok.pos, tok.name);
         next_token();
     }
-    else if (is_token_kind(TOKEN_KEYWORD) && tok.name == fn_keyword)
+    else if (is_token_kind(TOKEN_KEYWORD) && tok.keyword == KEYWORD_FN)
     {
         t = push_struct(arena, typespec);
         t->kind = TYPESPEC_FUNCTION;
@@ -249,7 +249,7 @@ expr *parse_compound_literal(void)
     }
     
     if (e && is_token_kind(TOKEN_KEYWORD)
-        && tok.name == as_keyword)
+        && tok.keyword == KEYWORD_AS)
     {
         next_token();
         typespec *t = parse_typespec();
@@ -296,21 +296,21 @@ expr *parse_base_expr(void)
     }
     else if (is_token_kind(TOKEN_KEYWORD))
     {
-        const char *keyword = tok.name;
+        keyword_kind keyword = tok.keyword;
         source_pos pos = tok.pos;
-        if (keyword == new_keyword)
+        if (keyword == KEYWORD_NEW)
         {
             next_token();
             typespec *t = parse_typespec();
             result = push_new_expr(pos, t);
         }
-        else if (keyword == auto_keyword)
+        else if (keyword == KEYWORD_AUTO)
         {
             next_token();
             typespec *t = parse_typespec();
             result = push_auto_expr(pos, t);
         }      
-        else if (keyword == size_of_type_keyword)
+        else if (keyword == KEYWORD_SIZE_OF_TYPE)
         {
             next_token();
             expect_token_kind(TOKEN_LEFT_PAREN);
@@ -325,7 +325,7 @@ expr *parse_base_expr(void)
             }           
             expect_token_kind(TOKEN_RIGHT_PAREN);
         }
-        else if (keyword == size_of_keyword)
+        else if (keyword == KEYWORD_SIZE_OF)
         {
             next_token();
             expect_token_kind(TOKEN_LEFT_PAREN);
@@ -340,17 +340,17 @@ expr *parse_base_expr(void)
             }
             expect_token_kind(TOKEN_RIGHT_PAREN);
         }
-        else if (keyword == null_keyword)
+        else if (keyword == KEYWORD_NULL)
         {
             result = push_null_expr(pos);
             next_token();
         }
-        else if (keyword == true_keyword)
+        else if (keyword == KEYWORD_TRUE)
         {
             result = push_bool_expr(pos, true);
             next_token();
         }
-        else if (keyword == false_keyword)
+        else if (keyword == KEYWORD_FALSE)
         {
             result = push_bool_expr(pos, false);
             next_token();
@@ -543,7 +543,7 @@ expr *parse_cast_expr(void)
 {
     expr *e = parse_unary_expr();
     if (is_token_kind(TOKEN_KEYWORD)
-        && tok.name == as_keyword)
+        && tok.keyword == KEYWORD_AS)
     {
         source_pos pos = tok.pos;
         next_token();
@@ -817,15 +817,15 @@ void parse_switch_cases(switch_stmt *switch_stmt)
 
             if (is_token_kind(TOKEN_KEYWORD))
             {
-                const char *keyword = tok.name;
-                if (keyword == case_keyword)
+                keyword_kind keyword = tok.keyword;
+                if (keyword == KEYWORD_CASE)
                 {               
                     next_token();
                     e = parse_expr();
                     expect_token_kind(TOKEN_COLON);
                     buf_push(case_exprs, e);
                 }
-                else if (keyword == default_keyword
+                else if (keyword == KEYWORD_DEFAULT
                     && false == default_case_defined)
                 {
                     next_token();
@@ -862,7 +862,7 @@ void parse_switch_cases(switch_stmt *switch_stmt)
             c->stmts = parse_statement_block();
 
             if (is_token_kind(TOKEN_KEYWORD)
-                && tok.name == break_keyword)
+                && tok.keyword == KEYWORD_BREAK)
             {
                 c->fallthrough = false;
                 next_token();
@@ -890,7 +890,7 @@ void parse_switch_cases(switch_stmt *switch_stmt)
 stmt *parse_if_statement(void)
 {
     stmt *s = null;
-    if (tok.name == if_keyword)
+    if (tok.keyword == KEYWORD_IF)
     {
         s = push_struct(arena, stmt);
         s->kind = STMT_IF_ELSE;
@@ -909,7 +909,7 @@ stmt *parse_if_statement(void)
         s->if_else.then_block = parse_statement_block();
 
         if (is_token_kind(TOKEN_KEYWORD) 
-            && tok.name == else_keyword)
+            && tok.keyword == KEYWORD_ELSE)
         {
             next_token();            
             s->if_else.else_stmt = parse_statement();           
@@ -924,8 +924,8 @@ stmt *parse_statement(void)
     source_pos pos = tok.pos;
     if (is_token_kind(TOKEN_KEYWORD))
     {
-        const char *keyword = tok.name;
-        if (keyword == return_keyword)
+        keyword_kind keyword = tok.keyword;
+        if (keyword == KEYWORD_RETURN)
         {
             s = push_struct(arena, stmt);
             s->kind = STMT_RETURN;
@@ -933,30 +933,34 @@ stmt *parse_statement(void)
             next_token();
             s->return_stmt.ret_expr = parse_expr();
         }
-        else if (keyword == break_keyword)
+        else if (keyword == KEYWORD_BREAK)
         {
             s = push_struct(arena, stmt);
             s->kind = STMT_BREAK;
             s->pos = pos;
             next_token();
         }
-        else if (keyword == continue_keyword)
+        else if (keyword == KEYWORD_CONTINUE)
         {
             s = push_struct(arena, stmt);
             s->kind = STMT_CONTINUE;
             s->pos = pos;
             next_token();
         }
-        else if (keyword == let_keyword
-            || keyword == const_keyword)
+        else if (keyword == KEYWORD_LET
+            || keyword == KEYWORD_CONST)
         {
             decl *d = parse_declaration(true);
+            if (d && d->kind == DECL_FUNCTION)
+            {
+                parsing_error("Functions cannot be declared inside other functions");
+            }
             s = push_struct(arena, stmt);
             s->decl_stmt.decl = d;
             s->kind = STMT_DECL;
             s->pos = pos;
         }
-        else if (keyword == for_keyword)
+        else if (keyword == KEYWORD_FOR)
         {
             s = push_struct(arena, stmt);
             s->kind = STMT_FOR;
@@ -980,11 +984,11 @@ stmt *parse_statement(void)
 
             s->for_stmt.stmts = parse_statement_block();
         }
-        else if (keyword == if_keyword)
+        else if (keyword == KEYWORD_IF)
         {
             s = parse_if_statement();
         }
-        else if (keyword == do_keyword)
+        else if (keyword == KEYWORD_DO)
         {
             s = push_struct(arena, stmt);
             s->kind = STMT_DO_WHILE;
@@ -995,7 +999,7 @@ stmt *parse_statement(void)
             s->do_while_stmt.stmts = parse_statement_block();
             
             if (is_token_kind(TOKEN_KEYWORD) 
-                && tok.name == while_keyword)
+                && tok.keyword == KEYWORD_WHILE)
             {
                 next_token();
                 expect_token_kind_or_return(TOKEN_LEFT_PAREN);
@@ -1007,7 +1011,7 @@ stmt *parse_statement(void)
                 parsing_error("Missing while clause in do while statement\n");
             }
         }
-        else if (keyword == while_keyword)
+        else if (keyword == KEYWORD_WHILE)
         {
             s = push_struct(arena, stmt);
             s->kind = STMT_WHILE;
@@ -1021,7 +1025,7 @@ stmt *parse_statement(void)
 
             s->while_stmt.stmts = parse_statement_block();
         }
-        else if (keyword == switch_keyword)
+        else if (keyword == KEYWORD_SWITCH)
         {
             s = push_struct(arena, stmt);
             s->kind = STMT_SWITCH;
@@ -1037,7 +1041,7 @@ stmt *parse_statement(void)
             parse_switch_cases(&s->switch_stmt);
             expect_token_kind_or_return(TOKEN_RIGHT_BRACE);
         }
-        else if (keyword == delete_keyword)
+        else if (keyword == KEYWORD_DELETE)
         {
             s = push_struct(arena, stmt);
             s->kind = STMT_DELETE;
@@ -1049,20 +1053,20 @@ stmt *parse_statement(void)
                 parsing_error("Only simple expressions and expression with unary operators are allowed in the delete statement");
             }
         }
-        else if (keyword == fn_keyword)
+        else if (keyword == KEYWORD_FN)
         {
             parsing_error("Function declaration is not allowed in another function scope");
         }
-        else if (keyword == enum_keyword)
+        else if (keyword == KEYWORD_ENUM)
         {
             parsing_error("Enum declaration is not allowed in a function scope");
             ignore_tokens_until_next_block();
         }
-        else if (keyword == false_keyword || keyword == true_keyword)
+        else if (keyword == KEYWORD_FALSE || keyword == KEYWORD_TRUE)
         {
             parsing_error("False/true can be used only as an expression");
         }
-        else if (keyword == new_keyword || keyword == auto_keyword)
+        else if (keyword == KEYWORD_NEW || keyword == KEYWORD_AUTO)
         {
             parsing_error("New/auto are allowed only in expressions. Did you mean to write 'let'?");
         }
@@ -1162,7 +1166,7 @@ function_param parse_function_param(void)
     function_param p = {0};
     if (is_token_kind(TOKEN_KEYWORD))
     {
-        if (tok.name == variadic_keyword)
+        if (tok.keyword == KEYWORD_VARIADIC)
         {
             p.name = variadic_keyword;
             next_token();
@@ -1367,14 +1371,60 @@ void parse_enum(enum_decl *decl)
     buf_free(values);
 }
 
+decl *parse_function_declaration(source_pos pos)
+{
+    decl *declaration = push_struct(arena, decl);
+    declaration->kind = DECL_FUNCTION;
+    declaration->pos = pos;
+
+    next_token();
+
+    // reveiver method
+    if (match_token_kind(TOKEN_LEFT_PAREN))
+    {
+        // fn (s : int) method_name () { }
+        declaration->function.method_receiver = push_struct(arena, function_param);
+        declaration->function.method_receiver->pos = tok.pos;
+        declaration->function.method_receiver->name = parse_identifier();
+        
+        expect_token_kind(TOKEN_COLON);
+
+        declaration->function.method_receiver->type = parse_typespec();
+
+        if (match_token_kind(TOKEN_COMMA))
+        {
+            parsing_error("Only one argument is allowed as a receiver of a method");
+        }
+
+        expect_token_kind(TOKEN_RIGHT_PAREN);
+    }
+
+    declaration->name = parse_identifier();
+ 
+    declaration->function.params = parse_function_param_list();
+
+    if (is_token_kind(TOKEN_COLON))
+    {
+        next_token();
+        if (is_token_kind(TOKEN_NAME))
+        {
+            declaration->function.return_type = parse_typespec();
+        }
+    }
+
+    declaration->function.stmts = parse_statement_block();
+
+    return declaration;
+}
+
 decl *parse_declaration(bool error_on_no_declaration)
 {
     decl *declaration = null;
     source_pos pos = tok.pos;
     if (is_token_kind(TOKEN_KEYWORD))
     {
-        const char *decl_keyword = tok.name;
-        if (decl_keyword == let_keyword)
+        keyword_kind decl_keyword = tok.keyword;
+        if (decl_keyword == KEYWORD_LET)
         {
             declaration = push_struct(arena, decl);
             declaration->kind = DECL_VARIABLE;
@@ -1406,26 +1456,34 @@ decl *parse_declaration(bool error_on_no_declaration)
                 }
             }
         }
-        else if (decl_keyword == const_keyword)
+        else if (decl_keyword == KEYWORD_CONST)
         {
-            declaration = push_struct(arena, decl);
-            declaration->kind = DECL_CONST;
-            declaration->pos = pos;
-
             next_token();
-            declaration->name = parse_identifier();
-
-            if (expect_token_kind(TOKEN_ASSIGN))
+            if (is_token_kind(TOKEN_KEYWORD) && tok.keyword == KEYWORD_FN)
             {
-                expr *expr = parse_expr();
-                declaration->const_decl.expr = expr;
+                declaration = parse_function_declaration(pos);
+                declaration->function.is_const = true;
+            }
+            else
+            {
+                declaration = push_struct(arena, decl);
+                declaration->kind = DECL_CONST;
+                declaration->pos = pos;
+
+                declaration->name = parse_identifier();
+
+                if (expect_token_kind(TOKEN_ASSIGN))
+                {
+                    expr *expr = parse_expr();
+                    declaration->const_decl.expr = expr;
+                }
             }
         }       
-        else if (decl_keyword == struct_keyword
-                || decl_keyword == union_keyword)
+        else if (decl_keyword == KEYWORD_STRUCT
+                || decl_keyword == KEYWORD_UNION)
         {
             declaration = push_struct(arena, decl);
-            declaration->kind = decl_keyword == struct_keyword ? DECL_STRUCT : DECL_UNION;
+            declaration->kind = decl_keyword == KEYWORD_STRUCT ? DECL_STRUCT : DECL_UNION;
             declaration->pos = pos;
 
             next_token();
@@ -1437,54 +1495,28 @@ decl *parse_declaration(bool error_on_no_declaration)
 
             expect_token_kind(TOKEN_RIGHT_BRACE);
         }
-        else if (decl_keyword == fn_keyword)
+        else if (decl_keyword == KEYWORD_FN)
+        {
+            declaration = parse_function_declaration(pos);
+        }
+        else if (decl_keyword == KEYWORD_INLINE || decl_keyword == KEYWORD_NOINLINE)
         {
-            declaration = push_struct(arena, decl);
-            declaration->kind = DECL_FUNCTION;
-            declaration->pos = pos;
-
             next_token();
-
-            // reveiver method
-            if (match_token_kind(TOKEN_LEFT_PAREN))
-            {
-                // fn (s : int) method_name () { }
-                declaration->function.method_receiver = push_struct(arena, function_param);
-                declaration->function.method_receiver->pos = tok.pos;
-                declaration->function.method_receiver->name = parse_identifier();
-                
-                expect_token_kind(TOKEN_COLON);
-
-                declaration->function.method_receiver->type = parse_typespec();
-
-                if (match_token_kind(TOKEN_COMMA))
-                {
-                    parsing_error("Only one argument is allowed as a receiver of a method");
-                }
-
-                expect_token_kind(TOKEN_RIGHT_PAREN);
-            }
-
-            declaration->name = parse_identifier();
-         
-            declaration->function.params = parse_function_param_list();
-
-            if (is_token_kind(TOKEN_COLON))
+            if (false == is_token_kind(TOKEN_KEYWORD)
+                || false == (tok.keyword == KEYWORD_FN))
             {
-                next_token();
-                if (is_token_kind(TOKEN_NAME))
-                {
-                    declaration->function.return_type = parse_typespec();
-                }
+                parsing_error("Only functions can be marked as inline or noinline");
             }
 
-            declaration->function.stmts = parse_statement_block();
+            declaration = parse_function_declaration(pos);
+            declaration->function.is_inline = (decl_keyword == KEYWORD_INLINE);
+            declaration->function.is_noinline = (decl_keyword == KEYWORD_NOINLINE);
         }
-        else if (decl_keyword == extern_keyword)
+        else if (decl_keyword == KEYWORD_EXTERN)
         {
             next_token();
             if (false == is_token_kind(TOKEN_KEYWORD)
-                || false == (tok.name == fn_keyword))
+                || false == (tok.keyword == KEYWORD_FN))
             {
                 parsing_error("Only functions can be marked as extern");
             }
@@ -1514,7 +1546,7 @@ decl *parse_declaration(bool error_on_no_declaration)
                 parsing_error("Function body not allowed for extern functions");
             }
         }
-        else if (decl_keyword == enum_keyword)
+        else if (decl_keyword == KEYWORD_ENUM)
         {
             declaration = push_struct(arena, decl);
             declaration->kind = DECL_ENUM;
@@ -1531,7 +1563,7 @@ decl *parse_declaration(bool error_on_no_declaration)
         }
         else
         {
-            parsing_error(xprintf("Unknown keyword: '%s'. Expected a declaration", decl_keyword));
+            parsing_error(xprintf("Unknown keyword: '%s'. Expected a declaration", keyword_names[decl_keyword]));
         }
     }
     else
@@ -1593,13 +1625,15 @@ void lex_and_parse(char *source, char *filename, decl*** declarations)
 
         // szczególny przypadek - string bez zamykającego cudzysłowu
         if (is_token_kind(TOKEN_STRING) 
-            && lexed_token_index - 1 == buf_len(all_tokens))
+            && unterminated_string_lexed)
         {
             parsing_error("String without matching ending quotation marks");
             break;
         }
     }
 
+    lex_remaining_tokens();
+
     if (decl_count == 0)
     {
         error_without_pos("Could not parse any declaration");
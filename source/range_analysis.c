@@ -0,0 +1,1038 @@
+// analiza zakresów indeksów - oznacza odwołania do list i tablic, które na pewno
+// mieszczą się w granicach, żeby C gen mógł dla nich pominąć sprawdzanie
+
+typedef struct index_range_fact
+{
+    const char *index_name;
+    const char *list_name; // pętla ograniczona przez length() listy
+    int64_t upper_bound; // pętla ograniczona przez stałą; -1, jeśli nie jest
+} index_range_fact;
+
+index_range_fact *index_range_facts;
+const char **range_local_names;
+const char **range_address_taken_names;
+const char **range_fresh_list_names; // listy utworzone w funkcji przez new lub auto
+const char **range_aliased_list_names; // listy skopiowane do innej zmiennej lub przekazane dalej
+
+bool is_name_on_list(const char **names, const char *name)
+{
+    for (size_t i = 0; i < buf_len(names); i++)
+    {
+        if (names[i] == name)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+expr *skip_implicit_casts(expr *e)
+{
+    // niejawne casty tylko poszerzają typ, więc nie zmieniają nieujemnych wartości
+    while (e && e->kind == EXPR_STUB && e->stub.kind == STUB_EXPR_CAST)
+    {
+        e = e->stub.original_expr;
+    }
+    return e;
+}
+
+expr *skip_all_stubs(expr *e)
+{
+    while (e && e->kind == EXPR_STUB)
+    {
+        e = e->stub.original_expr;
+    }
+    return e;
+}
+
+bool get_integer_constant(expr *e, int64_t *value)
+{
+    e = skip_implicit_casts(e);
+    if (e == null)
+    {
+        return false;
+    }
+
+    if (e->kind == EXPR_INT)
+    {
+        *value = (int64_t)e->integer_value;
+        return true;
+    }
+
+    if (e->kind == EXPR_NAME)
+    {
+        symbol *sym = get_symbol(e->name);
+        if (sym && sym->kind == SYMBOL_CONST && sym->type && is_integer_type(sym->type))
+        {
+            *value = sym->val;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool is_list_name(expr *e)
+{
+    e = skip_all_stubs(e);
+    bool result = (e && e->kind == EXPR_NAME && e->resolved_type && e->resolved_type->kind == TYPE_LIST);
+    return result;
+}
+
+bool is_list_method_stub(expr *e)
+{
+    if (e->kind != EXPR_STUB || e->stub.original_expr->kind != EXPR_CALL)
+    {
+        return false;
+    }
+
+    expr *receiver = e->stub.original_expr->call.method_receiver;
+    bool result = (receiver && receiver->resolved_type && receiver->resolved_type->kind == TYPE_LIST);
+    return result;
+}
+
+// lista zapisana pod inną nazwą może zostać zmieniona bez użycia swojej nazwy
+void note_list_copy(expr *e)
+{
+    if (is_list_name(e))
+    {
+        buf_push(range_aliased_list_names, skip_all_stubs(e)->name);
+    }
+}
+
+void collect_range_names_in_stmt_block(stmt_block block);
+
+void collect_range_names_in_expr(expr *e)
+{
+    if (e == null)
+    {
+        return;
+    }
+
+    switch (e->kind)
+    {
+        case EXPR_UNARY:
+        {
+            if (e->unary.operator == TOKEN_ADDRESS_OF)
+            {
+                expr *operand = skip_all_stubs(e->unary.operand);
+                if (operand && operand->kind == EXPR_NAME)
+                {
+                    buf_push(range_address_taken_names, operand->name);
+                }
+            }
+            collect_range_names_in_expr(e->unary.operand);
+        }
+        break;
+        case EXPR_BINARY:
+        {
+            collect_range_names_in_expr(e->binary.left);
+            collect_range_names_in_expr(e->binary.right);
+        }
+        break;
+        case EXPR_TERNARY:
+        {
+            collect_range_names_in_expr(e->ternary.condition);
+            collect_range_names_in_expr(e->ternary.if_true);
+            collect_range_names_in_expr(e->ternary.if_false);
+        }
+        break;
+        case EXPR_CALL:
+        {
+            collect_range_names_in_expr(e->call.function_expr);
+            note_list_copy(e->call.method_receiver);
+            collect_range_names_in_expr(e->call.method_receiver);
+            for (size_t i = 0; i < e->call.args_num; i++)
+            {
+                note_list_copy(e->call.args[i]);
+                collect_range_names_in_expr(e->call.args[i]);
+            }
+        }
+        break;
+        case EXPR_FIELD:
+        {
+            collect_range_names_in_expr(e->field.expr);
+        }
+        break;
+        case EXPR_INDEX:
+        {
+            collect_range_names_in_expr(e->index.array_expr);
+            collect_range_names_in_expr(e->index.index_expr);
+        }
+        break;
+        case EXPR_SIZE_OF:
+        {
+            collect_range_names_in_expr(e->size_of.expr);
+        }
+        break;
+        case EXPR_CAST:
+        {
+            collect_range_names_in_expr(e->cast.expr);
+        }
+        break;
+        case EXPR_COMPOUND_LITERAL:
+        {
+            for (size_t i = 0; i < e->compound.fields_count; i++)
+            {
+                note_list_copy(e->compound.fields[i]->expr);
+                collect_range_names_in_expr(e->compound.fields[i]->expr);
+            }
+        }
+        break;
+        case EXPR_STUB:
+        {
+            if (is_list_method_stub(e))
+            {
+                // metody list nie zapamiętują swojego odbiorcy
+                expr *call = e->stub.original_expr;
+                collect_range_names_in_expr(call->call.method_receiver);
+                for (size_t i = 0; i < call->call.args_num; i++)
+                {
+                    note_list_copy(call->call.args[i]);
+                    collect_range_names_in_expr(call->call.args[i]);
+                }
+            }
+            else
+            {
+                collect_range_names_in_expr(e->stub.original_expr);
+            }
+        }
+        break;
+        default:
+        {
+            // nie zawierają podwyrażeń
+        }
+        break;
+    }
+}
+
+void collect_range_names_in_stmt(stmt *st)
+{
+    switch (st->kind)
+    {
+        case STMT_RETURN:
+        {
+            note_list_copy(st->return_stmt.ret_expr);
+            collect_range_names_in_expr(st->return_stmt.ret_expr);
+        }
+        break;
+        case STMT_DECL:
+        {
+            decl *d = st->decl_stmt.decl;
+            buf_push(range_local_names, d->name);
+            if (d->kind == DECL_VARIABLE)
+            {
+                expr *init = skip_implicit_casts(d->variable.expr);
+                if (init && init->kind == EXPR_STUB
+                    && (init->stub.kind == STUB_EXPR_LIST_NEW || init->stub.kind == STUB_EXPR_LIST_AUTO))
+                {
+                    buf_push(range_fresh_list_names, d->name);
+                }
+                else if (is_list_name(init))
+                {
+                    note_list_copy(init);
+                    buf_push(range_aliased_list_names, d->name);
+                }
+                collect_range_names_in_expr(d->variable.expr);
+            }
+        }
+        break;
+        case STMT_IF_ELSE:
+        {
+            collect_range_names_in_expr(st->if_else.cond_expr);
+            collect_range_names_in_stmt_block(st->if_else.then_block);
+            if (st->if_else.else_stmt)
+            {
+                collect_range_names_in_stmt(st->if_else.else_stmt);
+            }
+        }
+        break;
+        case STMT_WHILE:
+        case STMT_DO_WHILE:
+        {
+            collect_range_names_in_expr(st->while_stmt.cond_expr);
+            collect_range_names_in_stmt_block(st->while_stmt.stmts);
+        }
+        break;
+        case STMT_FOR:
+        {
+            if (st->for_stmt.init_stmt)
+            {
+                collect_range_names_in_stmt(st->for_stmt.init_stmt);
+            }
+            collect_range_names_in_expr(st->for_stmt.cond_expr);
+            if (st->for_stmt.next_stmt)
+            {
+                collect_range_names_in_stmt(st->for_stmt.next_stmt);
+            }
+            collect_range_names_in_stmt_block(st->for_stmt.stmts);
+        }
+        break;
+        case STMT_ASSIGN:
+        {
+            if (is_list_name(st->assign.value_expr))
+            {
+                note_list_copy(st->assign.value_expr);
+                note_list_copy(st->assign.assigned_var_expr);
+            }
+            collect_range_names_in_expr(st->assign.assigned_var_expr);
+            collect_range_names_in_expr(st->assign.value_expr);
+        }
+        break;
+        case STMT_SWITCH:
+        {
+            collect_range_names_in_expr(st->switch_stmt.var_expr);
+            for (size_t i = 0; i < st->switch_stmt.cases_num; i++)
+            {
+                collect_range_names_in_stmt_block(st->switch_stmt.cases[i]->stmts);
+            }
+        }
+        break;
+        case STMT_EXPR:
+        {
+            collect_range_names_in_expr(st->expr);
+        }
+        break;
+        case STMT_BLOCK:
+        {
+            collect_range_names_in_stmt_block(st->block);
+        }
+        break;
+        case STMT_DELETE:
+        {
+            collect_range_names_in_expr(st->delete.expr);
+        }
+        break;
+        case STMT_INC:
+        {
+            collect_range_names_in_expr(st->inc.operand);
+        }
+        break;
+        default:
+        {
+            // break, continue
+        }
+        break;
+    }
+}
+
+void collect_range_names_in_stmt_block(stmt_block block)
+{
+    for (size_t i = 0; i < block.stmts_count; i++)
+    {
+        collect_range_names_in_stmt(block.stmts[i]);
+    }
+}
+
+bool stmt_block_modifies_name(stmt_block block, const char *name);
+
+bool stmt_modifies_name(stmt *st, const char *name)
+{
+    switch (st->kind)
+    {
+        case STMT_ASSIGN:
+        {
+            expr *target = skip_all_stubs(st->assign.assigned_var_expr);
+            return (target && target->kind == EXPR_NAME && target->name == name);
+        }
+        break;
+        case STMT_INC:
+        {
+            expr *target = skip_all_stubs(st->inc.operand);
+            return (target && target->kind == EXPR_NAME && target->name == name);
+        }
+        break;
+        case STMT_DELETE:
+        {
+            expr *target = skip_all_stubs(st->delete.expr);
+            return (target && target->kind == EXPR_NAME && target->name == name);
+        }
+        break;
+        case STMT_IF_ELSE:
+        {
+            return stmt_block_modifies_name(st->if_else.then_block, name)
+                || (st->if_else.else_stmt && stmt_modifies_name(st->if_else.else_stmt, name));
+        }
+        break;
+        case STMT_WHILE:
+        case STMT_DO_WHILE:
+        {
+            return stmt_block_modifies_name(st->while_stmt.stmts, name);
+        }
+        break;
+        case STMT_FOR:
+        {
+            return (st->for_stmt.init_stmt && stmt_modifies_name(st->for_stmt.init_stmt, name))
+                || (st->for_stmt.next_stmt && stmt_modifies_name(st->for_stmt.next_stmt, name))
+                || stmt_block_modifies_name(st->for_stmt.stmts, name);
+        }
+        break;
+        case STMT_SWITCH:
+        {
+            for (size_t i = 0; i < st->switch_stmt.cases_num; i++)
+            {
+                if (stmt_block_modifies_name(st->switch_stmt.cases[i]->stmts, name))
+                {
+                    return true;
+                }
+            }
+        }
+        break;
+        case STMT_BLOCK:
+        {
+            return stmt_block_modifies_name(st->block, name);
+        }
+        break;
+        default:
+        {
+            // przypisania i inkrementacje są wyłącznie instrukcjami
+        }
+        break;
+    }
+    return false;
+}
+
+bool stmt_block_modifies_name(stmt_block block, const char *name)
+{
+    for (size_t i = 0; i < block.stmts_count; i++)
+    {
+        if (stmt_modifies_name(block.stmts[i], name))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// zmiana długości listy wymaga wywołania metody z listą jako odbiorcą albo przekazania
+// listy do funkcji; jeśli lista może mieć inne nazwy, zmienić ją może każde wywołanie
+bool expr_may_modify_list(expr *e, const char *list_name, bool any_call)
+{
+    if (e == null)
+    {
+        return false;
+    }
+
+    switch (e->kind)
+    {
+        case EXPR_UNARY:
+        {
+            return expr_may_modify_list(e->unary.operand, list_name, any_call);
+        }
+        break;
+        case EXPR_BINARY:
+        {
+            return expr_may_modify_list(e->binary.left, list_name, any_call)
+                || expr_may_modify_list(e->binary.right, list_name, any_call);
+        }
+        break;
+        case EXPR_TERNARY:
+        {
+            return expr_may_modify_list(e->ternary.condition, list_name, any_call)
+                || expr_may_modify_list(e->ternary.if_true, list_name, any_call)
+                || expr_may_modify_list(e->ternary.if_false, list_name, any_call);
+        }
+        break;
+        case EXPR_CALL:
+        {
+            if (any_call
+                || (e->call.method_receiver && skip_all_stubs(e->call.method_receiver)->kind == EXPR_NAME
+                    && skip_all_stubs(e->call.method_receiver)->name == list_name))
+            {
+                return true;
+            }
+            for (size_t i = 0; i < e->call.args_num; i++)
+            {
+                expr *arg = skip_all_stubs(e->call.args[i]);
+                if ((arg->kind == EXPR_NAME && arg->name == list_name)
+                    || expr_may_modify_list(e->call.args[i], list_name, any_call))
+                {
+                    return true;
+                }
+            }
+            return expr_may_modify_list(e->call.function_expr, list_name, any_call)
+                || expr_may_modify_list(e->call.method_receiver, list_name, any_call);
+        }
+        break;
+        case EXPR_FIELD:
+        {
+            return expr_may_modify_list(e->field.expr, list_name, any_call);
+        }
+        break;
+        case EXPR_INDEX:
+        {
+            return expr_may_modify_list(e->index.array_expr, list_name, any_call)
+                || expr_may_modify_list(e->index.index_expr, list_name, any_call);
+        }
+        break;
+        case EXPR_SIZE_OF:
+        {
+            return expr_may_modify_list(e->size_of.expr, list_name, any_call);
+        }
+        break;
+        case EXPR_CAST:
+        {
+            return expr_may_modify_list(e->cast.expr, list_name, any_call);
+        }
+        break;
+        case EXPR_COMPOUND_LITERAL:
+        {
+            for (size_t i = 0; i < e->compound.fields_count; i++)
+            {
+                if (expr_may_modify_list(e->compound.fields[i]->expr, list_name, any_call))
+                {
+                    return true;
+                }
+            }
+        }
+        break;
+        case EXPR_STUB:
+        {
+            if (false == is_list_method_stub(e))
+            {
+                return expr_may_modify_list(e->stub.original_expr, list_name, any_call);
+            }
+
+            // length() i capacity() tylko odczytują listę
+            expr *call = e->stub.original_expr;
+            expr *receiver = skip_all_stubs(call->call.method_receiver);
+            if (e->stub.kind != STUB_EXPR_LIST_LENGTH && e->stub.kind != STUB_EXPR_LIST_CAPACITY
+                && (any_call || (receiver->kind == EXPR_NAME && receiver->name == list_name)))
+            {
+                return true;
+            }
+
+            if (expr_may_modify_list(call->call.method_receiver, list_name, any_call))
+            {
+                return true;
+            }
+            for (size_t i = 0; i < call->call.args_num; i++)
+            {
+                if (expr_may_modify_list(call->call.args[i], list_name, any_call))
+                {
+                    return true;
+                }
+            }
+        }
+        break;
+        default:
+        {
+            // nie zawierają podwyrażeń
+        }
+        break;
+    }
+    return false;
+}
+
+bool stmt_block_may_modify_list(stmt_block block, const char *list_name, bool any_call);
+
+bool stmt_may_modify_list(stmt *st, const char *list_name, bool any_call)
+{
+    if (stmt_modifies_name(st, list_name))
+    {
+        return true;
+    }
+
+    switch (st->kind)
+    {
+        case STMT_RETURN:
+        {
+            return expr_may_modify_list(st->return_stmt.ret_expr, list_name, any_call);
+        }
+        break;
+        case STMT_DECL:
+        {
+            decl *d = st->decl_stmt.decl;
+            return (d->kind == DECL_VARIABLE && expr_may_modify_list(d->variable.expr, list_name, any_call));
+        }
+        break;
+        case STMT_IF_ELSE:
+        {
+            return expr_may_modify_list(st->if_else.cond_expr, list_name, any_call)
+                || stmt_block_may_modify_list(st->if_else.then_block, list_name, any_call)
+                || (st->if_else.else_stmt && stmt_may_modify_list(st->if_else.else_stmt, list_name, any_call));
+        }
+        break;
+        case STMT_WHILE:
+        case STMT_DO_WHILE:
+        {
+            return expr_may_modify_list(st->while_stmt.cond_expr, list_name, any_call)
+                || stmt_block_may_modify_list(st->while_stmt.stmts, list_name, any_call);
+        }
+        break;
+        case STMT_FOR:
+        {
+            return (st->for_stmt.init_stmt && stmt_may_modify_list(st->for_stmt.init_stmt, list_name, any_call))
+                || expr_may_modify_list(st->for_stmt.cond_expr, list_name, any_call)
+                || (st->for_stmt.next_stmt && stmt_may_modify_list(st->for_stmt.next_stmt, list_name, any_call))
+                || stmt_block_may_modify_list(st->for_stmt.stmts, list_name, any_call);
+        }
+        break;
+        case STMT_ASSIGN:
+        {
+            return expr_may_modify_list(st->assign.assigned_var_expr, list_name, any_call)
+                || expr_may_modify_list(st->assign.value_expr, list_name, any_call);
+        }
+        break;
+        case STMT_SWITCH:
+        {
+            if (expr_may_modify_list(st->switch_stmt.var_expr, list_name, any_call))
+            {
+                return true;
+            }
+            for (size_t i = 0; i < st->switch_stmt.cases_num; i++)
+            {
+                if (stmt_block_may_modify_list(st->switch_stmt.cases[i]->stmts, list_name, any_call))
+                {
+                    return true;
+                }
+            }
+        }
+        break;
+        case STMT_EXPR:
+        {
+            return expr_may_modify_list(st->expr, list_name, any_call);
+        }
+        break;
+        case STMT_BLOCK:
+        {
+            return stmt_block_may_modify_list(st->block, list_name, any_call);
+        }
+        break;
+        case STMT_DELETE:
+        {
+            // usunięcie innej zmiennej może zwolnić tę samą listę
+            return any_call || expr_may_modify_list(st->delete.expr, list_name, any_call);
+        }
+        break;
+        case STMT_INC:
+        {
+            return expr_may_modify_list(st->inc.operand, list_name, any_call);
+        }
+        break;
+        default:
+        {
+            // break, continue
+        }
+        break;
+    }
+    return false;
+}
+
+bool stmt_block_may_modify_list(stmt_block block, const char *list_name, bool any_call)
+{
+    for (size_t i = 0; i < block.stmts_count; i++)
+    {
+        if (stmt_may_modify_list(block.stmts[i], list_name, any_call))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool is_name_safe_for_range_analysis(const char *name)
+{
+    // zmienne globalne i te, których adres pobrano, mogą zostać zmienione przez wywołania funkcji
+    return is_name_on_list(range_local_names, name)
+        && false == is_name_on_list(range_address_taken_names, name);
+}
+
+bool get_for_loop_range_fact(stmt *st, index_range_fact *fact)
+{
+    assert(st->kind == STMT_FOR);
+    for_stmt *loop = &st->for_stmt;
+
+    if (loop->init_stmt == null || loop->init_stmt->kind != STMT_DECL
+        || loop->cond_expr == null || loop->next_stmt == null)
+    {
+        return false;
+    }
+
+    // let i := <nieujemna stała>
+    decl *index_decl = loop->init_stmt->decl_stmt.decl;
+    if (index_decl->kind != DECL_VARIABLE
+        || index_decl->resolved_type == null
+        || false == is_integer_type(index_decl->resolved_type)
+        || false == is_name_safe_for_range_analysis(index_decl->name))
+    {
+        return false;
+    }
+
+    if (false == is_unsigned_type(index_decl->resolved_type))
+    {
+        int64_t init_value = 0;
+        if (false == get_integer_constant(index_decl->variable.expr, &init_value)
+            || init_value < 0)
+        {
+            return false;
+        }
+    }
+
+    // i < list.length() albo i < <stała>
+    expr *cond = skip_implicit_casts(loop->cond_expr);
+    if (cond->kind != EXPR_BINARY || cond->binary.operator != TOKEN_LT)
+    {
+        return false;
+    }
+
+    expr *left = skip_implicit_casts(cond->binary.left);
+    if (left->kind != EXPR_NAME || left->name != index_decl->name)
+    {
+        return false;
+    }
+
+    fact->index_name = index_decl->name;
+    fact->list_name = null;
+    fact->upper_bound = -1;
+
+    expr *right = skip_implicit_casts(cond->binary.right);
+    // indeksy list są sprawdzane względem length(), więc capacity() nie wystarcza
+    if (right->kind == EXPR_STUB && right->stub.kind == STUB_EXPR_LIST_LENGTH)
+    {
+        expr *receiver = right->stub.original_expr->call.method_receiver;
+        if (receiver->kind != EXPR_NAME
+            || false == is_name_safe_for_range_analysis(receiver->name))
+        {
+            return false;
+        }
+
+        bool may_be_aliased = false == is_name_on_list(range_fresh_list_names, receiver->name)
+            || is_name_on_list(range_aliased_list_names, receiver->name);
+        if (stmt_block_may_modify_list(loop->stmts, receiver->name, may_be_aliased))
+        {
+            return false;
+        }
+        fact->list_name = receiver->name;
+    }
+    else if (false == get_integer_constant(right, &fact->upper_bound) || fact->upper_bound < 0)
+    {
+        return false;
+    }
+
+    // i++ albo i += <dodatnia stała> (po resolve: i = i + <dodatnia stała>)
+    stmt *next = loop->next_stmt;
+    if (next->kind == STMT_INC)
+    {
+        expr *operand = skip_all_stubs(next->inc.operand);
+        if (next->inc.operator != TOKEN_INC
+            || operand->kind != EXPR_NAME || operand->name != index_decl->name)
+        {
+            return false;
+        }
+    }
+    else if (next->kind == STMT_ASSIGN)
+    {
+        expr *target = skip_all_stubs(next->assign.assigned_var_expr);
+        expr *value = skip_implicit_casts(next->assign.value_expr);
+        if (next->assign.operation != TOKEN_ASSIGN
+            || target->kind != EXPR_NAME || target->name != index_decl->name
+            || value->kind != EXPR_BINARY || value->binary.operator != TOKEN_ADD)
+        {
+            return false;
+        }
+
+        expr *step_left = skip_implicit_casts(value->binary.left);
+        int64_t step = 0;
+        if (step_left->kind != EXPR_NAME || step_left->name != index_decl->name
+            || false == get_integer_constant(value->binary.right, &step)
+            || step <= 0)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    if (stmt_block_modifies_name(loop->stmts, index_decl->name))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+void mark_index_if_in_bounds(expr *index_exp, bool is_list)
+{
+    assert(index_exp->kind == EXPR_INDEX);
+
+    expr *array_expr = skip_implicit_casts(index_exp->index.array_expr);
+    expr *index = skip_implicit_casts(index_exp->index.index_expr);
+    type *t = index_exp->index.array_expr->resolved_type;
+
+    if (false == is_list && t->kind == TYPE_ARRAY)
+    {
+        int64_t constant_index = 0;
+        if (get_integer_constant(index, &constant_index)
+            && constant_index >= 0 && (size_t)constant_index < t->array.size)
+        {
+            index_exp->index.is_in_bounds = true;
+            return;
+        }
+    }
+
+    if (index->kind != EXPR_NAME)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < buf_len(index_range_facts); i++)
+    {
+        index_range_fact *fact = &index_range_facts[i];
+        if (fact->index_name != index->name)
+        {
+            continue;
+        }
+
+        if (is_list)
+        {
+            if (fact->list_name && array_expr->kind == EXPR_NAME && fact->list_name == array_expr->name)
+            {
+                index_exp->index.is_in_bounds = true;
+                return;
+            }
+        }
+        else if (t->kind == TYPE_ARRAY)
+        {
+            if (fact->upper_bound >= 0 && (size_t)fact->upper_bound <= t->array.size)
+            {
+                index_exp->index.is_in_bounds = true;
+                return;
+            }
+        }
+    }
+}
+
+void mark_in_bounds_indexes_in_stmt_block(stmt_block block);
+
+void mark_in_bounds_indexes_in_expr(expr *e)
+{
+    if (e == null)
+    {
+        return;
+    }
+
+    switch (e->kind)
+    {
+        case EXPR_UNARY:
+        {
+            mark_in_bounds_indexes_in_expr(e->unary.operand);
+        }
+        break;
+        case EXPR_BINARY:
+        {
+            mark_in_bounds_indexes_in_expr(e->binary.left);
+            mark_in_bounds_indexes_in_expr(e->binary.right);
+        }
+        break;
+        case EXPR_TERNARY:
+        {
+            mark_in_bounds_indexes_in_expr(e->ternary.condition);
+            mark_in_bounds_indexes_in_expr(e->ternary.if_true);
+            mark_in_bounds_indexes_in_expr(e->ternary.if_false);
+        }
+        break;
+        case EXPR_CALL:
+        {
+            mark_in_bounds_indexes_in_expr(e->call.function_expr);
+            mark_in_bounds_indexes_in_expr(e->call.method_receiver);
+            for (size_t i = 0; i < e->call.args_num; i++)
+            {
+                mark_in_bounds_indexes_in_expr(e->call.args[i]);
+            }
+        }
+        break;
+        case EXPR_FIELD:
+        {
+            mark_in_bounds_indexes_in_expr(e->field.expr);
+        }
+        break;
+        case EXPR_INDEX:
+        {
+            mark_in_bounds_indexes_in_expr(e->index.array_expr);
+            mark_in_bounds_indexes_in_expr(e->index.index_expr);
+            mark_index_if_in_bounds(e, false);
+        }
+        break;
+        case EXPR_SIZE_OF:
+        {
+            mark_in_bounds_indexes_in_expr(e->size_of.expr);
+        }
+        break;
+        case EXPR_CAST:
+        {
+            mark_in_bounds_indexes_in_expr(e->cast.expr);
+        }
+        break;
+        case EXPR_COMPOUND_LITERAL:
+        {
+            for (size_t i = 0; i < e->compound.fields_count; i++)
+            {
+                mark_in_bounds_indexes_in_expr(e->compound.fields[i]->expr);
+            }
+        }
+        break;
+        case EXPR_STUB:
+        {
+            expr *orig = e->stub.original_expr;
+            if (e->stub.kind == STUB_EXPR_LIST_INDEX)
+            {
+                mark_in_bounds_indexes_in_expr(orig->index.array_expr);
+                mark_in_bounds_indexes_in_expr(orig->index.index_expr);
+                mark_index_if_in_bounds(orig, true);
+            }
+            else
+            {
+                mark_in_bounds_indexes_in_expr(orig);
+            }
+        }
+        break;
+        default:
+        {
+            // nie zawierają podwyrażeń
+        }
+        break;
+    }
+}
+
+void mark_in_bounds_indexes_in_stmt(stmt *st)
+{
+    switch (st->kind)
+    {
+        case STMT_RETURN:
+        {
+            mark_in_bounds_indexes_in_expr(st->return_stmt.ret_expr);
+        }
+        break;
+        case STMT_DECL:
+        {
+            if (st->decl_stmt.decl->kind == DECL_VARIABLE)
+            {
+                mark_in_bounds_indexes_in_expr(st->decl_stmt.decl->variable.expr);
+            }
+        }
+        break;
+        case STMT_IF_ELSE:
+        {
+            mark_in_bounds_indexes_in_expr(st->if_else.cond_expr);
+            mark_in_bounds_indexes_in_stmt_block(st->if_else.then_block);
+            if (st->if_else.else_stmt)
+            {
+                mark_in_bounds_indexes_in_stmt(st->if_else.else_stmt);
+            }
+        }
+        break;
+        case STMT_WHILE:
+        case STMT_DO_WHILE:
+        {
+            mark_in_bounds_indexes_in_expr(st->while_stmt.cond_expr);
+            mark_in_bounds_indexes_in_stmt_block(st->while_stmt.stmts);
+        }
+        break;
+        case STMT_FOR:
+        {
+            if (st->for_stmt.init_stmt)
+            {
+                mark_in_bounds_indexes_in_stmt(st->for_stmt.init_stmt);
+            }
+            mark_in_bounds_indexes_in_expr(st->for_stmt.cond_expr);
+            if (st->for_stmt.next_stmt)
+            {
+                mark_in_bounds_indexes_in_stmt(st->for_stmt.next_stmt);
+            }
+
+            index_range_fact fact = { 0 };
+            bool has_fact = get_for_loop_range_fact(st, &fact);
+            if (has_fact)
+            {
+                buf_push(index_range_facts, fact);
+            }
+
+            mark_in_bounds_indexes_in_stmt_block(st->for_stmt.stmts);
+
+            if (has_fact)
+            {
+                buf_pop(index_range_facts);
+            }
+        }
+        break;
+        case STMT_ASSIGN:
+        {
+            mark_in_bounds_indexes_in_expr(st->assign.assigned_var_expr);
+            mark_in_bounds_indexes_in_expr(st->assign.value_expr);
+        }
+        break;
+        case STMT_SWITCH:
+        {
+            mark_in_bounds_indexes_in_expr(st->switch_stmt.var_expr);
+            for (size_t i = 0; i < st->switch_stmt.cases_num; i++)
+            {
+                mark_in_bounds_indexes_in_stmt_block(st->switch_stmt.cases[i]->stmts);
+            }
+        }
+        break;
+        case STMT_EXPR:
+        {
+            mark_in_bounds_indexes_in_expr(st->expr);
+        }
+        break;
+        case STMT_BLOCK:
+        {
+            mark_in_bounds_indexes_in_stmt_block(st->block);
+        }
+        break;
+        case STMT_DELETE:
+        {
+            mark_in_bounds_indexes_in_expr(st->delete.expr);
+        }
+        break;
+        case STMT_INC:
+        {
+            mark_in_bounds_indexes_in_expr(st->inc.operand);
+        }
+        break;
+        default:
+        {
+            // break, continue
+        }
+        break;
+    }
+}
+
+void mark_in_bounds_indexes_in_stmt_block(stmt_block block)
+{
+    for (size_t i = 0; i < block.stmts_count; i++)
+    {
+        mark_in_bounds_indexes_in_stmt(block.stmts[i]);
+    }
+}
+
+void analyze_index_ranges(decl *d)
+{
+    assert(d->kind == DECL_FUNCTION);
+    if (d->function.is_extern)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < d->function.params.param_count; i++)
+    {
+        buf_push(range_local_names, d->function.params.params[i].name);
+    }
+
+    if (d->function.method_receiver)
+    {
+        buf_push(range_local_names, d->function.method_receiver->name);
+    }
+
+    collect_range_names_in_stmt_block(d->function.stmts);
+    mark_in_bounds_indexes_in_stmt_block(d->function.stmts);
+
+    assert(buf_len(index_range_facts) == 0);
+    buf_free(range_local_names);
+    buf_free(range_address_taken_names);
+    buf_free(range_fresh_list_names);
+    buf_free(range_aliased_list_names);
+}
@@ -4,16 +4,135 @@ symbol **ordered_global_symbols;
 
 bool installed_types_initialized = false;
 
-enum
+// symbole lokalne są wyszukiwane w mapie po internowanej nazwie - każda nazwa ma swoje miejsce
+// z aktualnie widocznym symbolem, a dziennik zmian pozwala wyjść z zasięgu bez przeglądania mapy
+// każdy wątek ma własną mapę; liczba symboli i głębokość zagnieżdżenia nie są ograniczone
+typedef struct local_name
 {
-    MAX_LOCAL_SYMBOLS = 1024
-};
+    symbol *visible;
+} local_name;
 
-symbol local_symbols[MAX_LOCAL_SYMBOLS];
-symbol *last_local_symbol = local_symbols;
+typedef struct local_scope_change
+{
+    local_name *name;
+    symbol *previous;
+} local_scope_change;
+
+THREAD_LOCAL hashmap local_names;
+THREAD_LOCAL local_scope_change *local_scope_log;
+THREAD_LOCAL symbol **unused_local_symbols;
 
 bool panic_mode;
 
+// w trybie resolve_reachable_only kompletujemy tylko symbole osiągalne z funkcji main
+bool resolve_reachable_only;
+THREAD_LOCAL bool resolving_call_target;
+symbol **reachable_symbols_queue;
+
+// ciała funkcji sprawdzane w wątkach roboczych nie zmieniają stanu globalnego - oznaczenia
+// osiągalności i błędy są zapisywane, a potem odtwarzane w wątku głównym w kolejności kolejki
+typedef struct resolution_log
+{
+    symbol **reachable;
+    error_message *errors;
+    void **usages; // typy i symbole, których wymagało sprawdzanie
+} resolution_log;
+
+THREAD_LOCAL resolution_log *current_resolution_log;
+
+// typy trafiają do ordered_global_symbols w kolejności, w jakiej wymagałoby ich sprawdzanie
+// kodu w jednym wątku, bez kompletowania typów z wyprzedzeniem - dzięki temu kolejność
+// definicji w wygenerowanym C nie zależy od przygotowania ciał funkcji do sprawdzania w wątkach
+// kompletowanie typu i rozwiązywanie symbolu zapamiętują, jakich typów i symboli wymagały,
+// a typ trafia na listę, gdy po raz pierwszy użyje go sprawdzany kod
+typedef struct usage_record
+{
+    void **usages;
+    type *completed_type; // null dla symboli
+    bool is_ordered;
+} usage_record;
+
+hashmap usage_records;
+THREAD_LOCAL usage_record *current_usage_record;
+bool usage_ordering_deferred;
+
+void order_usage(void *key)
+{
+    usage_record *record = map_get(&usage_records, key);
+    if (record == null || record->is_ordered)
+    {
+        return;
+    }
+
+    record->is_ordered = true;
+    for (size_t i = 0; i < buf_len(record->usages); i++)
+    {
+        order_usage(record->usages[i]);
+    }
+    if (record->completed_type)
+    {
+        buf_push(ordered_global_symbols, record->completed_type->symbol);
+    }
+}
+
+void note_usage(void *key)
+{
+    if (current_usage_record)
+    {
+        buf_push(current_usage_record->usages, key);
+    }
+    else if (usage_ordering_deferred)
+    {
+        return;
+    }
+    else if (current_resolution_log)
+    {
+        buf_push(current_resolution_log->usages, key);
+    }
+    else
+    {
+        order_usage(key);
+    }
+}
+
+usage_record *begin_usage_record(type *completed_type)
+{
+    usage_record *outer = current_usage_record;
+    current_usage_record = xcalloc(sizeof(usage_record));
+    current_usage_record->completed_type = completed_type;
+    return outer;
+}
+
+void end_usage_record(void *key, usage_record *outer, bool succeeded)
+{
+    usage_record *record = current_usage_record;
+    current_usage_record = outer;
+    if (succeeded)
+    {
+        map_put(&usage_records, key, record);
+        note_usage(key);
+    }
+    else
+    {
+        buf_free(record->usages);
+        free(record);
+    }
+}
+
+void free_usage_records(void)
+{
+    for (size_t i = 0; i < usage_records.capacity; i++)
+    {
+        usage_record *record = usage_records.values[i];
+        if (record)
+        {
+            buf_free(record->usages);
+            free(record);
+        }
+    }
+    map_free(&usage_records);
+}
+
 void complete_type(type *t);
 void resolve_symbol(symbol *s);
 type *resolve_typespec(typespec *t);
@@ -27,6 +146,17 @@ resolved_expr *resolved_expr_invalid;
 
 void error_in_resolving(const char *error_text, source_pos pos)
 {
+    if (current_resolution_log)
+    {
+        error_message message =
+        {
+            .text = error_text,
+            .pos = pos
+        };
+        buf_push(current_resolution_log->errors, message);
+        return;
+    }
+
     error(error_text, pos);
 }
 
@@ -239,12 +369,12 @@ bool are_symbols_the_same_function(symbol *sym_a, symbol *sym_b)
 
 symbol *get_symbol(const char *name)
 {
-    for (symbol *it = last_local_symbol; it != local_symbols; it--)
+    if (buf_len(local_scope_log) > 0)
     {
-        symbol *sym = it - 1;
-        if (sym->name == name)
+        local_name *local = map_get(&local_names, name);
+        if (local && local->visible)
         {
-            return sym;
+            return local->visible;
         }
     }
 
@@ -268,49 +398,90 @@ bool check_if_symbol_name_unused(const char *name, source_pos pos)
     return true;
 }
 
-symbol *enter_local_scope(void)
+size_t enter_local_scope(void)
 {
-    symbol *marker = last_local_symbol;
+    size_t marker = buf_len(local_scope_log);
     return marker;
 }
 
-void leave_local_scope(symbol *marker)
+void leave_local_scope(size_t marker)
 {
-    assert(marker >= local_symbols && marker <= last_local_symbol);
-    last_local_symbol = marker;
-    // dalszych nie czyścimy - nie będziemy ich nigdy odczytywać
+    assert(marker <= buf_len(local_scope_log));
+    while (buf_len(local_scope_log) > marker)
+    {
+        local_scope_change change = local_scope_log[buf_len(local_scope_log) - 1];
+        buf_push(unused_local_symbols, change.name->visible);
+        change.name->visible = change.previous;
+        buf_pop(local_scope_log);
+    }
 }
 
 void push_local_symbol(const char *name, type *type)
 {
-    int64_t symbols_count = last_local_symbol - local_symbols;
-    assert(symbols_count + 1 < MAX_LOCAL_SYMBOLS);
-    *last_local_symbol++ = (symbol){
+    assert_is_interned(name);
+    if (local_names.capacity == 0)
+    {
+        map_grow(&local_names, 64);
+    }
+
+    local_name *local = map_get(&local_names, name);
+    if (local == null)
+    {
+        local = xcalloc(sizeof(local_name));
+        map_put(&local_names, name, local);
+    }
+
+    // symbole z zamkniętych zasięgów są używane ponownie
+    symbol *sym = null;
+    if (buf_len(unused_local_symbols) > 0)
+    {
+        sym = unused_local_symbols[buf_len(unused_local_symbols) - 1];
+        buf_pop(unused_local_symbols);
+    }
+    else
+    {
+        sym = xmalloc(sizeof(symbol));
+    }
+
+    *sym = (symbol){
       .name = name,
       .kind = SYMBOL_VARIABLE,
       .state = SYMBOL_RESOLVED,
       .type = type,
     };
+
+    local_scope_change change = { .name = local, .previous = local->visible };
+    buf_push(local_scope_log, change);
+    local->visible = sym;
+}
+
+void free_local_symbols(void)
+{
+    leave_local_scope(0);
+    for (size_t i = 0; i < buf_len(unused_local_symbols); i++)
+    {
+        free(unused_local_symbols[i]);
+    }
+    for (size_t i = 0; i < local_names.capacity; i++)
+    {
+        free(local_names.values[i]);
+    }
+    buf_free(unused_local_symbols);
+    buf_free(local_scope_log);
+    map_free(&local_names);
 }
 
 type *get_array_type(type *element, size_t size)
 {
     complete_type(element);
-    type *t = get_new_type(TYPE_ARRAY);
-    t->size = size * get_type_size(element);
-    t->align = get_type_align(element);
-    t->array.base_type = element;
-    t->array.size = size;
+    type *t = get_constructed_type(TYPE_ARRAY, element, size);
     return t;
 }
 
 type *get_list_type(type *element)
 {
     complete_type(element);
-    type *t = get_new_type(TYPE_LIST);
-    t->size = POINTER_SIZE;
-    t->align = POINTER_ALIGN;
-    t->list.base_type = element;
+    type *t = get_constructed_type(TYPE_LIST, element, 0);
     return t;
 }
 
@@ -477,6 +648,8 @@ void push_symbol_from_decl(decl *d)
     buf_push(global_symbols_list, sym);
 }
 
+bool complete_declared_type(type *t);
+
 void complete_type(type *t)
 {
     assert(t);
@@ -488,10 +661,22 @@ void complete_type(type *t)
     }
     else if (t->kind != TYPE_INCOMPLETE)
     {
+        if ((t->kind == TYPE_STRUCT || t->kind == TYPE_UNION || t->kind == TYPE_ENUM)
+            && t->symbol && t->symbol->decl)
+        {
+            note_usage(t);
+        }
         return;
     }
     
     t->kind = TYPE_COMPLETING;
+    usage_record *outer = begin_usage_record(t);
+    bool completed = complete_declared_type(t);
+    end_usage_record(t, outer, completed);
+}
+
+bool complete_declared_type(type *t)
+{
     decl *d = t->symbol->decl;
 
     // pozostałe typy są kompletne od razu
@@ -578,7 +763,7 @@ void complete_type(type *t)
             {
                 error_in_resolving("Unions must have at least one field declared", d->pos);
             }
-            return;
+            return false;
         }
 
         if (d->kind == DECL_STRUCT)
@@ -594,7 +779,25 @@ void complete_type(type *t)
         buf_free(fields);
     }
 
-    buf_push(ordered_global_symbols, t->symbol);
+    return true;
+}
+
+void mark_symbol_reachable(symbol *sym)
+{
+    // symbole lokalne i typy wbudowane nie mają deklaracji
+    if (false == resolve_reachable_only || sym->decl == null || sym->is_reachable)
+    {
+        return;
+    }
+
+    if (current_resolution_log)
+    {
+        buf_push(current_resolution_log->reachable, sym);
+        return;
+    }
+
+    sym->is_reachable = true;
+    buf_push(reachable_symbols_queue, sym);
 }
 
 symbol *resolve_name(const char *name, source_pos name_pos)
@@ -606,6 +809,23 @@ symbol *resolve_name(const char *name, source_pos name_pos)
         return null;
     }
     resolve_symbol(s);
+
+    if (s->kind == SYMBOL_FUNCTION)
+    {
+        // przy wywołaniu osiągalne jest tylko wybrane przeciążenie - oznaczamy je w resolve_call_expr
+        if (false == resolving_call_target)
+        {
+            for (symbol *overload = s; overload; overload = overload->next_overload)
+            {
+                mark_symbol_reachable(overload);
+            }
+        }
+    }
+    else
+    {
+        mark_symbol_reachable(s);
+    }
+
     return s;
 }
 
@@ -1150,6 +1370,52 @@ const char *pretty_print_function_parameters(type *receiver, resolved_expr **arg
     return result;
 }
 
+bool resolve_list_method_integer_arg(expr *e, expr *arg, const char *method_name)
+{
+    resolved_expr *arg_expr = resolve_expr(arg);
+    if (false == check_resolved_expr(arg_expr))
+    {
+        return false;
+    }
+
+    if (false == is_integer_type(arg_expr->type))
+    {
+        error_in_resolving(
+            xprintf("%s method accepts only an integer argument, got %s",
+                method_name, pretty_print_type_name(arg_expr->type, false)),
+            e->pos);
+        return false;
+    }
+
+    return true;
+}
+
+bool resolve_list_method_element_arg(expr *e, expr *arg, type *list_element_type)
+{
+    resolved_expr *new_element_expr = resolve_expr(arg);
+    if (false == check_resolved_expr(new_element_expr))
+    {
+        return false;
+    }
+
+    cast_info cast = check_if_cast_needed(new_element_expr->type, list_element_type, false, new_element_expr->is_const);
+    if (cast.kind == CAST_TYPES_INCOMPATIBLE)
+    {
+        error_in_resolving(
+            xprintf("Cannot add %s element to a list of %s",
+                pretty_print_type_name(new_element_expr->type, false),
+                pretty_print_type_name(list_element_type, true)),
+            e->pos);
+        return false;
+    }
+    else
+    {
+        insert_cast_expr(arg, null, cast);
+    }
+
+    return true;
+}
+
 resolved_expr *resolve_special_case_methods(expr *e)
 {    
     resolved_expr *result = null;
@@ -1166,7 +1432,11 @@ resolved_expr *resolve_special_case_methods(expr *e)
             stub_expr_kind stub_kind = STUB_EXPR_NONE;
             type *resolved_type = null;
 
-            if (e->call.function_expr->name == capacity_str)
+            type *list_type = e->call.method_receiver->resolved_type;
+            type *list_element_type = list_type->list.base_type;
+            const char *method_name = e->call.function_expr->name;
+
+            if (method_name == capacity_str)
             {
                 if (e->call.args_num != 0)
                 {
@@ -1177,7 +1447,7 @@ resolved_expr *resolve_special_case_methods(expr *e)
                 stub_kind = STUB_EXPR_LIST_CAPACITY;
                 resolved_type = type_int;
             }            
-            else if (e->call.function_expr->name == length_str)
+            else if (method_name == length_str)
             {
                 if (e->call.args_num != 0)
                 {
@@ -1188,7 +1458,23 @@ resolved_expr *resolve_special_case_methods(expr *e)
                 stub_kind = STUB_EXPR_LIST_LENGTH;
                 resolved_type = type_int;
             }
-            else if (e->call.function_expr->name == add_str)
+            else if (method_name == reserve_str)
+            {
+                if (e->call.args_num != 1)
+                {
+                    error_in_resolving("Reserve method accepts only one argument", e->pos);
+                    return null;
+                }
+
+                if (false == resolve_list_method_integer_arg(e, e->call.args[0], "Reserve"))
+                {
+                    return null;
+                }
+
+                stub_kind = STUB_EXPR_LIST_RESERVE;
+                resolved_type = type_void;
+            }
+            else if (method_name == add_str)
             {
                 if (e->call.args_num != 1)
                 {
@@ -1196,30 +1482,120 @@ resolved_expr *resolve_special_case_methods(expr *e)
                     return null;
                 }
 
-                type *list_type = e->call.method_receiver->resolved_type;
-                type *list_element_type = list_type->list.base_type;
-                resolved_expr *new_element_expr = resolve_expr(e->call.args[0]);                
-                if (false == check_resolved_expr(new_element_expr))
+                if (false == resolve_list_method_element_arg(e, e->call.args[0], list_element_type))
                 {
                     return null;
                 }
                 
-                cast_info cast = check_if_cast_needed(new_element_expr->type, list_element_type, false, new_element_expr->is_const);
-                if (cast.kind == CAST_TYPES_INCOMPATIBLE)
+                stub_kind = STUB_EXPR_LIST_ADD;
+                resolved_type = type_void;
+            }
+            else if (method_name == add_range_str)
+            {
+                if (e->call.args_num != 2)
+                {
+                    error_in_resolving("Add_range method accepts two arguments: a pointer to the first element and the element count", e->pos);
+                    return null;
+                }
+
+                resolved_expr *elements_expr = resolve_expr(e->call.args[0]);
+                if (false == check_resolved_expr(elements_expr))
+                {
+                    return null;
+                }
+
+                if (elements_expr->type->kind != TYPE_POINTER
+                    || false == compare_types(elements_expr->type->pointer.base_type, list_element_type))
                 {
                     error_in_resolving(
-                        xprintf("Cannot add %s element to a list of %s",
-                            pretty_print_type_name(new_element_expr->type, false),
-                            pretty_print_type_name(list_element_type, true)),
-                        e->pos);                    
+                        xprintf("Add_range method expects a pointer to %s, got %s",
+                            pretty_print_type_name(list_element_type, false),
+                            pretty_print_type_name(elements_expr->type, false)),
+                        e->pos);
                     return null;
                 }
-                else
+
+                if (false == resolve_list_method_integer_arg(e, e->call.args[1], "Add_range"))
                 {
-                    insert_cast_expr(e->call.args[0], null, cast);
+                    return null;
                 }
-                
-                stub_kind = STUB_EXPR_LIST_ADD;
+
+                stub_kind = STUB_EXPR_LIST_ADD_RANGE;
+                resolved_type = type_void;
+            }
+            else if (method_name == insert_at_str)
+            {
+                if (e->call.args_num != 2)
+                {
+                    error_in_resolving("Insert_at method accepts two arguments: an index and an element", e->pos);
+                    return null;
+                }
+
+                if (false == resolve_list_method_integer_arg(e, e->call.args[0], "Insert_at"))
+                {
+                    return null;
+                }
+
+                if (false == resolve_list_method_element_arg(e, e->call.args[1], list_element_type))
+                {
+                    return null;
+                }
+
+                stub_kind = STUB_EXPR_LIST_INSERT_AT;
+                resolved_type = type_void;
+            }
+            else if (method_name == remove_at_str)
+            {
+                if (e->call.args_num != 1)
+                {
+                    error_in_resolving("Remove_at method accepts only one argument", e->pos);
+                    return null;
+                }
+
+                if (false == resolve_list_method_integer_arg(e, e->call.args[0], "Remove_at"))
+                {
+                    return null;
+                }
+
+                stub_kind = STUB_EXPR_LIST_REMOVE_AT;
+                resolved_type = type_void;
+            }
+            else if (method_name == clear_str)
+            {
+                if (e->call.args_num != 0)
+                {
+                    error_in_resolving("Clear method accepts no arguments", e->pos);
+                    return null;
+                }
+
+                stub_kind = STUB_EXPR_LIST_CLEAR;
+                resolved_type = type_void;
+            }
+            else if (method_name == copy_from_str)
+            {
+                if (e->call.args_num != 1)
+                {
+                    error_in_resolving("Copy_from method accepts only one argument", e->pos);
+                    return null;
+                }
+
+                resolved_expr *source_expr = resolve_expr(e->call.args[0]);
+                if (false == check_resolved_expr(source_expr))
+                {
+                    return null;
+                }
+
+                if (false == compare_types(source_expr->type, list_type))
+                {
+                    error_in_resolving(
+                        xprintf("Cannot copy elements from %s to a list of %s",
+                            pretty_print_type_name(source_expr->type, false),
+                            pretty_print_type_name(list_element_type, true)),
+                        e->pos);
+                    return null;
+                }
+
+                stub_kind = STUB_EXPR_LIST_COPY_FROM;
                 resolved_type = type_void;
             }
 
@@ -1304,6 +1680,7 @@ resolved_expr *resolve_special_case_constructors(expr *e)
     }
 
     e->call.resolved_function = matching;
+    mark_symbol_reachable(matching);
 
     resolved_expr *result = get_resolved_rvalue_expr(return_type);
     return result;
@@ -1315,42 +1692,309 @@ typedef struct find_overloads_result
     bool more_than_one_match;
 } find_overloads_result;
 
-find_overloads_result find_function_overload(
-    symbol *first_overload_sym, type *receiver_type,
-    resolved_expr **resolved_args, size_t resolved_args_count,
-    bool allow_implicit_casting, bool allow_variadic)
+// duże zbiory przeciążeń są indeksowane liczbą parametrów, a wybrane przeciążenie jest
+// zapamiętywane dla zbioru, typu odbiorcy i typów argumentów - typy są jednoznaczne,
+// więc wystarczy porównać wskaźniki; mniejsze zbiory szybciej przejrzeć po kolei
+#define MIN_INDEXED_OVERLOADS 4
+#define MAX_MEMOIZED_CALL_ARGS 64
+
+typedef struct overload_set
 {
-    assert(first_overload_sym);
-    assert(false == (allow_implicit_casting && allow_variadic));
-    
-    find_overloads_result result = { 0 };
+    hashmap by_param_count; // klucz to liczba parametrów + 1, wartość to lista przeciążeń bez wariadycznych
+} overload_set;
 
-    symbol *candidate = first_overload_sym;
-    while (candidate)
+typedef struct overload_choice
+{
+    symbol *first_overload;
+    type *receiver_type;
+    type **arg_types;
+    size_t args_count;
+    uint64_t positive_const_args; // dla nich dozwolone jest wymuszenie typu liczbowego
+    find_overloads_result result;
+} overload_choice;
+
+hashmap overload_sets;
+overload_choice **overload_choices;
+size_t overload_choices_count;
+size_t overload_choices_capacity;
+thread_mutex overload_cache_mutex = THREAD_MUTEX_INITIALIZER;
+
+overload_set *build_overload_set(symbol *first_overload)
+{
+    size_t candidates_count = 0;
+    for (symbol *it = first_overload; it; it = it->next_overload)
     {
-        if (candidate->type == null)
+        if (it->type == null || it->type->kind != TYPE_FUNCTION)
         {
-            resolve_symbol(candidate);
-            if (candidate->type == null)
-            {
-                goto find_function_overload_next_candidate;
-            }
+            return null;
         }
+        candidates_count++;
+    }
 
-        assert(candidate->type->kind == TYPE_FUNCTION);
-        type_function candidate_func = candidate->type->function;
+    if (candidates_count < MIN_INDEXED_OVERLOADS)
+    {
+        return null;
+    }
 
-        if (false == allow_variadic && candidate_func.has_variadic_arg)
+    overload_set *set = xcalloc(sizeof(overload_set));
+    map_grow(&set->by_param_count, 16);
+    for (symbol *it = first_overload; it; it = it->next_overload)
+    {
+        if (it->type->function.has_variadic_arg)
         {
-            goto find_function_overload_next_candidate;
+            continue;
         }
 
-        if (receiver_type)
-        {
-            if (candidate_func.receiver_type == null
-                || false == compare_types(receiver_type, candidate_func.receiver_type))
-            {
-                goto find_function_overload_next_candidate;
+        void *key = (void *)(it->type->function.param_count + 1);
+        symbol **candidates = map_get(&set->by_param_count, key);
+        buf_push(candidates, it);
+        map_put(&set->by_param_count, key, candidates);
+    }
+    return set;
+}
+
+// zwraca null, jeśli zbiór jest mały albo któreś z przeciążeń nie jest jeszcze rozwiązane
+overload_set *get_overload_set(symbol *first_overload)
+{
+    if (overload_sets.capacity == 0)
+    {
+        return null;
+    }
+
+    if (worker_threads_running)
+    {
+        lock_mutex(&overload_cache_mutex);
+    }
+
+    overload_set *set = map_get(&overload_sets, first_overload);
+    if (set == null)
+    {
+        set = build_overload_set(first_overload);
+        if (set)
+        {
+            map_put(&overload_sets, first_overload, set);
+        }
+    }
+
+    if (worker_threads_running)
+    {
+        unlock_mutex(&overload_cache_mutex);
+    }
+    return set;
+}
+
+uint64_t hash_overload_choice(symbol *first_overload, type *receiver_type,
+    type **arg_types, size_t args_count, uint64_t positive_const_args)
+{
+    uint64_t result = hash_ptr(first_overload) ^ hash_uint64((uintptr_t)receiver_type ^ positive_const_args);
+    for (size_t i = 0; i < args_count; i++)
+    {
+        result = hash_uint64(result ^ (uintptr_t)arg_types[i]);
+    }
+    return result;
+}
+
+bool is_same_overload_choice(overload_choice *choice, symbol *first_overload, type *receiver_type,
+    type **arg_types, size_t args_count, uint64_t positive_const_args)
+{
+    if (choice->first_overload != first_overload
+        || choice->receiver_type != receiver_type
+        || choice->args_count != args_count
+        || choice->positive_const_args != positive_const_args)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < args_count; i++)
+    {
+        if (choice->arg_types[i] != arg_types[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void grow_overload_choices(size_t new_capacity)
+{
+    new_capacity = max(64, new_capacity);
+    overload_choice **new_choices = xcalloc(new_capacity * sizeof(overload_choice *));
+    for (size_t i = 0; i < overload_choices_capacity; i++)
+    {
+        overload_choice *c = overload_choices[i];
+        if (c)
+        {
+            size_t index = (size_t)hash_overload_choice(c->first_overload, c->receiver_type,
+                c->arg_types, c->args_count, c->positive_const_args);
+            while (new_choices[index & (new_capacity - 1)])
+            {
+                index++;
+            }
+            new_choices[index & (new_capacity - 1)] = c;
+        }
+    }
+    free(overload_choices);
+    overload_choices = new_choices;
+    overload_choices_capacity = new_capacity;
+}
+
+// zwraca miejsce w tablicy, w którym jest albo powinien się znaleźć wybór dla tych argumentów
+overload_choice **find_overload_choice(symbol *first_overload, type *receiver_type,
+    type **arg_types, size_t args_count, uint64_t positive_const_args)
+{
+    if (2 * overload_choices_count >= overload_choices_capacity)
+    {
+        grow_overload_choices(2 * overload_choices_capacity);
+    }
+
+    size_t index = (size_t)hash_overload_choice(first_overload, receiver_type, arg_types, args_count, positive_const_args);
+    while (true)
+    {
+        index &= overload_choices_capacity - 1;
+        overload_choice *choice = overload_choices[index];
+        if (choice == null
+            || is_same_overload_choice(choice, first_overload, receiver_type, arg_types, args_count, positive_const_args))
+        {
+            return &overload_choices[index];
+        }
+        index++;
+    }
+}
+
+bool get_memoized_overload(symbol *first_overload, type *receiver_type,
+    type **arg_types, size_t args_count, uint64_t positive_const_args, find_overloads_result *result)
+{
+    if (worker_threads_running)
+    {
+        lock_mutex(&overload_cache_mutex);
+    }
+
+    overload_choice *choice = *find_overload_choice(first_overload, receiver_type, arg_types, args_count, positive_const_args);
+    if (choice)
+    {
+        *result = choice->result;
+    }
+
+    if (worker_threads_running)
+    {
+        unlock_mutex(&overload_cache_mutex);
+    }
+    return (choice != null);
+}
+
+void memoize_overload(symbol *first_overload, type *receiver_type,
+    type **arg_types, size_t args_count, uint64_t positive_const_args, find_overloads_result result)
+{
+    if (worker_threads_running)
+    {
+        lock_mutex(&overload_cache_mutex);
+    }
+
+    overload_choice **slot = find_overload_choice(first_overload, receiver_type, arg_types, args_count, positive_const_args);
+    if (*slot == null)
+    {
+        overload_choice *choice = xmalloc(sizeof(overload_choice));
+        *choice = (overload_choice){
+            .first_overload = first_overload,
+            .receiver_type = receiver_type,
+            .arg_types = xmalloc(args_count * sizeof(type *) + 1),
+            .args_count = args_count,
+            .positive_const_args = positive_const_args,
+            .result = result,
+        };
+        memcpy(choice->arg_types, arg_types, args_count * sizeof(type *));
+        *slot = choice;
+        overload_choices_count++;
+    }
+
+    if (worker_threads_running)
+    {
+        unlock_mutex(&overload_cache_mutex);
+    }
+}
+
+void init_overload_cache(void)
+{
+    map_grow(&overload_sets, 32);
+    grow_overload_choices(64);
+}
+
+void free_overload_cache(void)
+{
+    for (size_t i = 0; i < overload_sets.capacity; i++)
+    {
+        overload_set *set = overload_sets.values[i];
+        if (set)
+        {
+            for (size_t k = 0; k < set->by_param_count.capacity; k++)
+            {
+                symbol **candidates = set->by_param_count.values[k];
+                buf_free(candidates);
+            }
+            map_free(&set->by_param_count);
+            free(set);
+        }
+    }
+    map_free(&overload_sets);
+
+    for (size_t i = 0; i < overload_choices_capacity; i++)
+    {
+        if (overload_choices[i])
+        {
+            free(overload_choices[i]->arg_types);
+            free(overload_choices[i]);
+        }
+    }
+    free(overload_choices);
+    overload_choices = null;
+    overload_choices_count = 0;
+    overload_choices_capacity = 0;
+}
+
+find_overloads_result find_function_overload(
+    symbol *first_overload_sym, overload_set *set, type *receiver_type,
+    resolved_expr **resolved_args, size_t resolved_args_count,
+    bool allow_implicit_casting, bool allow_variadic)
+{
+    assert(first_overload_sym);
+    assert(false == (allow_implicit_casting && allow_variadic));
+    
+    find_overloads_result result = { 0 };
+
+    // w indeksie przeciążenia są w tej samej kolejności co w łańcuchu
+    bool use_index = (set && false == allow_variadic);
+    symbol **indexed = null;
+    size_t indexed_pos = 0;
+    if (use_index)
+    {
+        indexed = map_get(&set->by_param_count, (void *)(resolved_args_count + 1));
+    }
+
+    symbol *candidate = use_index ? (buf_len(indexed) > 0 ? indexed[0] : null) : first_overload_sym;
+    while (candidate)
+    {
+        if (candidate->type == null)
+        {
+            resolve_symbol(candidate);
+            if (candidate->type == null)
+            {
+                goto find_function_overload_next_candidate;
+            }
+        }
+
+        assert(candidate->type->kind == TYPE_FUNCTION);
+        type_function candidate_func = candidate->type->function;
+
+        if (false == allow_variadic && candidate_func.has_variadic_arg)
+        {
+            goto find_function_overload_next_candidate;
+        }
+
+        if (receiver_type)
+        {
+            if (candidate_func.receiver_type == null
+                || false == compare_types(receiver_type, candidate_func.receiver_type))
+            {
+                goto find_function_overload_next_candidate;
             }
         }
 
@@ -1400,7 +2044,15 @@ find_overloads_result find_function_overload(
         }
 
 find_function_overload_next_candidate:
-        candidate = candidate->next_overload;
+        if (use_index)
+        {
+            indexed_pos++;
+            candidate = (indexed_pos < buf_len(indexed)) ? indexed[indexed_pos] : null;
+        }
+        else
+        {
+            candidate = candidate->next_overload;
+        }
     }
 
     return result;
@@ -1423,7 +2075,9 @@ resolved_expr *resolve_call_expr(expr *e)
         return result;
     }
 
+    resolving_call_target = (e->call.function_expr->kind == EXPR_NAME);
     resolved_expr *fn_expr = resolve_expr(e->call.function_expr);
+    resolving_call_target = false;
         
     if (false == check_resolved_expr(fn_expr))
     {
@@ -1472,18 +2126,49 @@ resolved_expr *resolve_call_expr(expr *e)
     }
 
     symbol *first_candidate = fn_expr->type->symbol;
-    find_overloads_result overloads = find_function_overload(first_candidate, method_receiver_type,
-        resolved_args, resolved_args_count, false, false);
+    overload_set *set = first_candidate->next_overload ? get_overload_set(first_candidate) : null;
 
-    if (overloads.matching == null)
+    // wybór zależy tylko od typów argumentów i od tego, które z nich są dodatnimi stałymi
+    type **arg_types = null;
+    uint64_t positive_const_args = 0;
+    bool memoized = (set && resolved_args_count <= MAX_MEMOIZED_CALL_ARGS);
+    if (memoized)
+    {
+        arg_types = push_size(arena, sizeof(type *) * resolved_args_count + 1);
+        for (size_t i = 0; i < resolved_args_count; i++)
+        {
+            arg_types[i] = resolved_args[i]->type;
+            if (resolved_args[i]->is_const && resolved_args[i]->val > 0)
+            {
+                positive_const_args |= ((uint64_t)1 << i);
+            }
+        }
+    }
+
+    find_overloads_result overloads = { 0 };
+    if (false == memoized
+        || false == get_memoized_overload(first_candidate, method_receiver_type,
+            arg_types, resolved_args_count, positive_const_args, &overloads))
     {
-        overloads = find_function_overload(first_candidate, method_receiver_type,
-            resolved_args, resolved_args_count, true, false);
+        overloads = find_function_overload(first_candidate, set, method_receiver_type,
+            resolved_args, resolved_args_count, false, false);
 
         if (overloads.matching == null)
         {
-            overloads = find_function_overload(first_candidate, method_receiver_type,
-                resolved_args, resolved_args_count, false, true);
+            overloads = find_function_overload(first_candidate, set, method_receiver_type,
+                resolved_args, resolved_args_count, true, false);
+
+            if (overloads.matching == null)
+            {
+                overloads = find_function_overload(first_candidate, set, method_receiver_type,
+                    resolved_args, resolved_args_count, false, true);
+            }
+        }
+
+        if (memoized)
+        {
+            memoize_overload(first_candidate, method_receiver_type,
+                arg_types, resolved_args_count, positive_const_args, overloads);
         }
     }
 
@@ -1507,6 +2192,7 @@ resolved_expr *resolve_call_expr(expr *e)
     
     symbol *resolved_function = overloads.matching;
     e->call.resolved_function = resolved_function;
+    mark_symbol_reachable(resolved_function);
 
     // casty wstawiamy dopiero wtedy, gdy ustalimy już, które z przeciążeń wezwać
     assert(resolved_function->type->function.param_count <= resolved_args_count);
@@ -1876,8 +2562,10 @@ resolved_expr *resolve_expected_expr(expr *e, type *expected_type, bool ignore_e
     }
 
     // udogodnienie - rezultat porównań to zawsze typ bool, a nie typ porównywany
+    // resolved_expr_invalid jest współdzielony - nie może dostać typu bool
     if (e->kind == EXPR_BINARY 
         && is_comparison_operation(e->binary.operator)
+        && check_resolved_expr(result)
         && result->type->kind != TYPE_BOOL)
     {
         cast_info bool_cast = { .kind = CAST_LEFT, .type = type_bool };
@@ -2029,6 +2717,10 @@ void resolve_symbol(symbol *s)
 {
     if (s->state == SYMBOL_RESOLVED)
     {
+        if (s->decl && s->kind != SYMBOL_TYPE)
+        {
+            note_usage(s);
+        }
         return;
     }
     else if (s->state == SYMBOL_RESOLVING)
@@ -2043,6 +2735,7 @@ void resolve_symbol(symbol *s)
     s->state = SYMBOL_RESOLVING;
 
     assert(s->decl);
+    usage_record *outer = begin_usage_record(null);
     switch (s->kind)
     {
         case SYMBOL_CONST:
@@ -2078,6 +2771,8 @@ void resolve_symbol(symbol *s)
         break;
     }
 
+    end_usage_record(s, outer, s->type != null);
+
     if (s->type)
     {
         s->state = SYMBOL_RESOLVED;        
@@ -2093,7 +2788,7 @@ void resolve_symbol(symbol *s)
 
 void resolve_stmt_block(stmt_block st_block, type *opt_ret_type)
 {
-    symbol *marker = enter_local_scope();
+    size_t marker = enter_local_scope();
 
     for (size_t i = 0; i < st_block.stmts_count; i++)
     {
@@ -2252,7 +2947,7 @@ void resolve_stmt(stmt *st, type *opt_ret_type)
         break;
         case STMT_FOR:
         {
-            symbol *marker = enter_local_scope();
+            size_t marker = enter_local_scope();
 
             if (st->for_stmt.init_stmt)
             {
@@ -2419,7 +3114,7 @@ void complete_function_body(symbol *s)
     assert(s->state == SYMBOL_RESOLVED);
     type *return_type = s->type->function.return_type;
 
-    symbol *marker = enter_local_scope();
+    size_t marker = enter_local_scope();
 
     if (s->decl->function.method_receiver)
     {
@@ -2471,7 +3166,7 @@ void complete_symbol(symbol *sym)
         }
     }
 
-    if (sym->kind == SYMBOL_FUNCTION)
+    if (sym->kind == SYMBOL_FUNCTION && false == resolve_reachable_only)
     {
         if (sym->next_overload)
         {
@@ -2480,68 +3175,687 @@ void complete_symbol(symbol *sym)
     }
 }
 
-symbol *get_entry_point(symbol **symbols)
+// ciało funkcji można sprawdzić w wątku roboczym, jeśli wszystkie nazwy, których używa,
+// wskazują na symbole już rozwiązane, a ich typy są kompletne - wtedy sprawdzanie nie rozwiązuje
+// ani nie kompletuje niczego poza samym ciałem; dlatego wcześniej, w wątku głównym, rozwiązujemy
+// symbole i kompletujemy typy w kolejności, w jakiej ciało ich używa
+// raz sprawdzone nazwy i typy trafiają do map
+hashmap stable_global_names;
+hashmap stable_types;
+
+bool is_type_stable(type *t, hashmap *visited)
 {
-    symbol *main_function = null;
-    for (symbol **it = symbols;
-        it != buf_end(symbols);
-        it++)
+    if (t == null || map_get(&stable_types, t) || map_get(visited, t))
     {
-        symbol *sym = *it;
-        if (sym->name == main_str)
+        return true;
+    }
+
+    if (t->kind == TYPE_INCOMPLETE || t->kind == TYPE_COMPLETING)
+    {
+        return false;
+    }
+
+    // typy wskazujące same na siebie są sprawdzane tylko raz
+    map_put(visited, t, t);
+
+    switch (t->kind)
+    {
+        case TYPE_STRUCT:
+        case TYPE_UNION:
         {
-            if (main_function)
+            for (size_t i = 0; i < t->aggregate.fields_count; i++)
             {
-                error_in_resolving("Only one function 'main' allowed", sym->decl->pos);
-                return null;
+                if (false == is_type_stable(t->aggregate.fields[i]->type, visited))
+                {
+                    return false;
+                }
             }
-            else
+        }
+        break;
+        case TYPE_ARRAY:
+        {
+            return is_type_stable(t->array.base_type, visited);
+        }
+        case TYPE_LIST:
+        {
+            return is_type_stable(t->list.base_type, visited);
+        }
+        case TYPE_POINTER:
+        {
+            return is_type_stable(t->pointer.base_type, visited);
+        }
+        case TYPE_FUNCTION:
+        {
+            if (false == is_type_stable(t->function.receiver_type, visited)
+                || false == is_type_stable(t->function.return_type, visited))
             {
-                main_function = sym;
+                return false;
+            }
+            for (size_t i = 0; i < t->function.param_count; i++)
+            {
+                if (false == is_type_stable(t->function.param_types[i], visited))
+                {
+                    return false;
+                }
             }
         }
+        break;
+        default:
+        break;
     }
+    return true;
+}
 
-    if (main_function == null)
+void complete_type_deeply(type *t, hashmap *visited)
+{
+    if (t == null || map_get(&stable_types, t) || map_get(visited, t))
     {
-        error_in_resolving("Entry point function 'main' not defined", (source_pos) { 0 });
-        return null;
+        return;
     }
 
-    if (false == (main_function->mangled_name == mangled_main_args_str
-        || main_function->mangled_name == mangled_main_void_str))
+    map_put(visited, t, t);
+    if (t->kind == TYPE_INCOMPLETE)
     {
-        error_in_resolving(
-            "Main function has an incorrect declaration. Allowed declarations are 'fn main()' and 'fn main(args: string[])'", 
-            main_function->decl->pos);
-        return null;
+        complete_type(t);
     }
 
-    return main_function;
+    switch (t->kind)
+    {
+        case TYPE_STRUCT:
+        case TYPE_UNION:
+        {
+            for (size_t i = 0; i < t->aggregate.fields_count; i++)
+            {
+                complete_type_deeply(t->aggregate.fields[i]->type, visited);
+            }
+        }
+        break;
+        case TYPE_ARRAY:
+        {
+            complete_type_deeply(t->array.base_type, visited);
+        }
+        break;
+        case TYPE_LIST:
+        {
+            complete_type_deeply(t->list.base_type, visited);
+        }
+        break;
+        case TYPE_POINTER:
+        {
+            complete_type_deeply(t->pointer.base_type, visited);
+        }
+        break;
+        case TYPE_FUNCTION:
+        {
+            complete_type_deeply(t->function.receiver_type, visited);
+            complete_type_deeply(t->function.return_type, visited);
+            for (size_t i = 0; i < t->function.param_count; i++)
+            {
+                complete_type_deeply(t->function.param_types[i], visited);
+            }
+        }
+        break;
+        default:
+        break;
+    }
 }
 
-void init_installed_types()
+bool prepare_global_name(const char *name)
 {
-    if (false == installed_types_initialized)
+    symbol *sym = map_get(&global_symbols, name);
+    if (sym == null || map_get(&stable_global_names, name))
     {
-        push_installed_symbol("void", type_void);
-        push_installed_symbol("char", type_char);
-        push_installed_symbol("int", type_int);
-        push_installed_symbol("uint", type_uint);
-        push_installed_symbol("long", type_long);
-        push_installed_symbol("ulong", type_ulong);
-        push_installed_symbol("float", type_float);
-        push_installed_symbol("bool", type_bool);
+        return true;
+    }
 
-        resolved_expr_invalid = get_resolved_lvalue_expr(type_invalid);
+    hashmap visited = {0};
+    map_grow(&visited, 16);
+    for (symbol *it = sym; it && false == panic_mode; it = (it->kind == SYMBOL_FUNCTION) ? it->next_overload : null)
+    {
+        resolve_symbol(it);
+        complete_type_deeply(it->type, &visited);
     }
-    installed_types_initialized = true;
-}
+    map_free(&visited);
 
-symbol **resolve(decl **declarations, bool check_entry_point)
-{
-    assert(arena != null);
-    init_installed_types();
+    if (panic_mode)
+    {
+        return false;
+    }
+
+    map_grow(&visited, 16);
+    bool result = true;
+    for (symbol *it = sym; it && result; it = (it->kind == SYMBOL_FUNCTION) ? it->next_overload : null)
+    {
+        result = (it->state == SYMBOL_RESOLVED && is_type_stable(it->type, &visited));
+    }
+
+    if (result)
+    {
+        for (size_t i = 0; i < visited.capacity; i++)
+        {
+            if (visited.keys[i])
+            {
+                map_put(&stable_types, visited.keys[i], visited.keys[i]);
+            }
+        }
+        map_put(&stable_global_names, name, sym);
+    }
+
+    map_free(&visited);
+    return result;
+}
+
+bool prepare_expr(expr *e);
+
+bool prepare_typespec(typespec *t)
+{
+    if (t == null)
+    {
+        return true;
+    }
+
+    switch (t->kind)
+    {
+        case TYPESPEC_NAME:
+        {
+            return prepare_global_name(t->name);
+        }
+        case TYPESPEC_ARRAY:
+        {
+            return prepare_typespec(t->array.base_type) && prepare_expr(t->array.size_expr);
+        }
+        case TYPESPEC_LIST:
+        {
+            return prepare_typespec(t->list.base_type);
+        }
+        case TYPESPEC_POINTER:
+        {
+            return prepare_typespec(t->pointer.base_type);
+        }
+        case TYPESPEC_FUNCTION:
+        {
+            for (size_t i = 0; i < t->function.param_count; i++)
+            {
+                if (false == prepare_typespec(t->function.param_types[i]))
+                {
+                    return false;
+                }
+            }
+            return prepare_typespec(t->function.ret_type);
+        }
+        default:
+        break;
+    }
+    return true;
+}
+
+bool prepare_expr(expr *e)
+{
+    if (e == null)
+    {
+        return true;
+    }
+
+    switch (e->kind)
+    {
+        case EXPR_NAME:
+        {
+            return prepare_global_name(e->name);
+        }
+        case EXPR_UNARY:
+        {
+            return prepare_expr(e->unary.operand);
+        }
+        case EXPR_BINARY:
+        {
+            return prepare_expr(e->binary.left) && prepare_expr(e->binary.right);
+        }
+        case EXPR_TERNARY:
+        {
+            return prepare_expr(e->ternary.condition)
+                && prepare_expr(e->ternary.if_true)
+                && prepare_expr(e->ternary.if_false);
+        }
+        case EXPR_CALL:
+        {
+            if (false == prepare_expr(e->call.method_receiver) || false == prepare_expr(e->call.function_expr))
+            {
+                return false;
+            }
+            // konstruktory są wyszukiwane po nazwie w resolve_special_case_constructors
+            if ((e->call.function_expr->kind == EXPR_NEW || e->call.function_expr->kind == EXPR_AUTO)
+                && false == prepare_global_name(constructor_str))
+            {
+                return false;
+            }
+            for (size_t i = 0; i < e->call.args_num; i++)
+            {
+                if (false == prepare_expr(e->call.args[i]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case EXPR_FIELD:
+        {
+            return prepare_expr(e->field.expr);
+        }
+        case EXPR_INDEX:
+        {
+            return prepare_expr(e->index.array_expr) && prepare_expr(e->index.index_expr);
+        }
+        case EXPR_NEW:
+        {
+            return prepare_typespec(e->new_init.type);
+        }
+        case EXPR_AUTO:
+        {
+            return prepare_typespec(e->auto_init.type);
+        }
+        case EXPR_SIZE_OF:
+        {
+            return prepare_expr(e->size_of.expr);
+        }
+        case EXPR_SIZE_OF_TYPE:
+        {
+            return prepare_typespec(e->size_of_type.type);
+        }
+        case EXPR_CAST:
+        {
+            return prepare_typespec(e->cast.type) && prepare_expr(e->cast.expr);
+        }
+        case EXPR_COMPOUND_LITERAL:
+        {
+            for (size_t i = 0; i < e->compound.fields_count; i++)
+            {
+                if (false == prepare_expr(e->compound.fields[i]->expr))
+                {
+                    return false;
+                }
+            }
+            return prepare_typespec(e->compound.type);
+        }
+        case EXPR_STUB:
+        {
+            // ciało było już sprawdzane - nie ryzykujemy
+            return false;
+        }
+        default:
+        break;
+    }
+    return true;
+}
+
+bool prepare_stmt(stmt *st);
+
+bool prepare_stmt_block(stmt_block block)
+{
+    for (size_t i = 0; i < block.stmts_count; i++)
+    {
+        if (false == prepare_stmt(block.stmts[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool prepare_stmt(stmt *st)
+{
+    if (st == null)
+    {
+        return true;
+    }
+
+    switch (st->kind)
+    {
+        case STMT_RETURN:
+        {
+            return prepare_expr(st->return_stmt.ret_expr);
+        }
+        case STMT_DECL:
+        {
+            decl *d = st->decl_stmt.decl;
+            return (d->kind == DECL_VARIABLE
+                && prepare_typespec(d->variable.type)
+                && prepare_expr(d->variable.expr));
+        }
+        case STMT_IF_ELSE:
+        {
+            return prepare_expr(st->if_else.cond_expr)
+                && prepare_stmt_block(st->if_else.then_block)
+                && prepare_stmt(st->if_else.else_stmt);
+        }
+        case STMT_WHILE:
+        {
+            return prepare_expr(st->while_stmt.cond_expr) && prepare_stmt_block(st->while_stmt.stmts);
+        }
+        case STMT_DO_WHILE:
+        {
+            return prepare_expr(st->do_while_stmt.cond_expr) && prepare_stmt_block(st->do_while_stmt.stmts);
+        }
+        case STMT_FOR:
+        {
+            return prepare_stmt(st->for_stmt.init_stmt)
+                && prepare_expr(st->for_stmt.cond_expr)
+                && prepare_stmt(st->for_stmt.next_stmt)
+                && prepare_stmt_block(st->for_stmt.stmts);
+        }
+        case STMT_ASSIGN:
+        {
+            return prepare_expr(st->assign.assigned_var_expr) && prepare_expr(st->assign.value_expr);
+        }
+        case STMT_SWITCH:
+        {
+            if (false == prepare_expr(st->switch_stmt.var_expr))
+            {
+                return false;
+            }
+            for (size_t i = 0; i < st->switch_stmt.cases_num; i++)
+            {
+                switch_case *cas = st->switch_stmt.cases[i];
+                for (size_t k = 0; k < cas->cond_exprs_num; k++)
+                {
+                    if (false == prepare_expr(cas->cond_exprs[k]))
+                    {
+                        return false;
+                    }
+                }
+                if (false == prepare_stmt_block(cas->stmts))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case STMT_EXPR:
+        {
+            return prepare_expr(st->expr);
+        }
+        case STMT_BLOCK:
+        {
+            return prepare_stmt_block(st->block);
+        }
+        case STMT_DELETE:
+        {
+            return prepare_expr(st->delete.expr);
+        }
+        case STMT_INC:
+        {
+            return prepare_expr(st->inc.operand);
+        }
+        default:
+        break;
+    }
+    return true;
+}
+
+bool prepare_function_body(symbol *sym)
+{
+    if (sym->kind != SYMBOL_FUNCTION
+        || sym->state != SYMBOL_RESOLVED
+        || sym->decl->function.is_extern)
+    {
+        return false;
+    }
+
+    function_decl *f = &sym->decl->function;
+    if (false == prepare_typespec(f->return_type))
+    {
+        return false;
+    }
+    if (f->method_receiver && false == prepare_typespec(f->method_receiver->type))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < f->params.param_count; i++)
+    {
+        if (false == prepare_typespec(f->params.params[i].type))
+        {
+            return false;
+        }
+    }
+    return prepare_stmt_block(f->stmts);
+}
+
+void enter_worker_thread(void);
+void leave_worker_thread(void);
+
+typedef struct function_bodies_job
+{
+    symbol **functions;
+    resolution_log **logs;
+    size_t next_function;
+    thread_mutex mutex;
+} function_bodies_job;
+
+void complete_function_bodies_job(void *data)
+{
+    function_bodies_job *job = data;
+    enter_worker_thread();
+
+    while (true)
+    {
+        lock_mutex(&job->mutex);
+        size_t index = job->next_function++;
+        unlock_mutex(&job->mutex);
+        if (index >= buf_len(job->functions))
+        {
+            break;
+        }
+
+        current_resolution_log = job->logs[index];
+        complete_function_body(job->functions[index]);
+        current_resolution_log = null;
+    }
+
+    leave_worker_thread();
+}
+
+void replay_resolution_log(resolution_log *log)
+{
+    for (size_t i = 0; i < buf_len(log->reachable); i++)
+    {
+        mark_symbol_reachable(log->reachable[i]);
+    }
+    for (size_t i = 0; i < buf_len(log->errors); i++)
+    {
+        error(log->errors[i].text, log->errors[i].pos);
+    }
+    for (size_t i = 0; i < buf_len(log->usages); i++)
+    {
+        order_usage(log->usages[i]);
+    }
+}
+
+// kolejka jest przetwarzana rundami: symbole z rundy są kompletowane po kolei, a ciała funkcji,
+// które używają już tylko rozwiązanych symboli i kompletnych typów, są odkładane i sprawdzane
+// równolegle; oznaczenia i błędy wszystkich symboli rundy są odtwarzane w kolejności kolejki,
+// więc kolejność symboli i błędów nie zależy od liczby wątków
+void complete_queued_symbols(void)
+{
+    map_grow(&stable_global_names, 32);
+    map_grow(&stable_types, 32);
+
+    size_t round_start = 0;
+    while (round_start < buf_len(reachable_symbols_queue) && false == panic_mode)
+    {
+        size_t round_end = buf_len(reachable_symbols_queue);
+        resolution_log *logs = xcalloc((round_end - round_start) * sizeof(resolution_log));
+
+        function_bodies_job job = {0};
+        size_t replay_end = round_end;
+        for (size_t i = round_start; i < round_end; i++)
+        {
+            symbol *sym = reachable_symbols_queue[i];
+            current_resolution_log = &logs[i - round_start];
+            usage_ordering_deferred = true;
+            bool prepared = prepare_function_body(sym);
+            usage_ordering_deferred = false;
+            if (prepared)
+            {
+                // tak jak w complete_symbol ciało jest sprawdzane po rozwiązaniu symbolu
+                note_usage(sym);
+                buf_push(job.functions, sym);
+                buf_push(job.logs, current_resolution_log);
+            }
+            else
+            {
+                complete_symbol(sym);
+            }
+            current_resolution_log = null;
+
+            if (panic_mode)
+            {
+                replay_end = i + 1;
+                break;
+            }
+        }
+
+        bool completed_in_workers = false;
+        if (worker_threads_count > 1 && buf_len(job.functions) > 1)
+        {
+            init_mutex(&job.mutex);
+            completed_in_workers = run_in_worker_threads(
+                min(worker_threads_count, buf_len(job.functions)), complete_function_bodies_job, &job);
+            destroy_mutex(&job.mutex);
+        }
+
+        if (false == completed_in_workers)
+        {
+            for (size_t i = 0; i < buf_len(job.functions); i++)
+            {
+                current_resolution_log = job.logs[i];
+                complete_function_body(job.functions[i]);
+                current_resolution_log = null;
+            }
+        }
+
+        for (size_t i = round_start; i < round_end; i++)
+        {
+            resolution_log *log = &logs[i - round_start];
+            if (i < replay_end)
+            {
+                replay_resolution_log(log);
+            }
+            buf_free(log->reachable);
+            buf_free(log->errors);
+            buf_free(log->usages);
+        }
+
+        free(logs);
+        buf_free(job.functions);
+        buf_free(job.logs);
+        round_start = round_end;
+    }
+
+    map_free(&stable_global_names);
+    map_free(&stable_types);
+}
+
+void complete_reachable_symbols(void)
+{
+    resolve_reachable_only = true;
+
+    symbol *main_function = map_get(&global_symbols, main_str);
+    if (main_function && main_function->kind == SYMBOL_FUNCTION)
+    {
+        for (symbol *overload = main_function; overload; overload = overload->next_overload)
+        {
+            mark_symbol_reachable(overload);
+        }
+    }
+
+    // kolejka rośnie w trakcie - kompletowanie ciał funkcji oznacza kolejne symbole
+    complete_queued_symbols();
+
+    // sygnatury nieosiągalnych przeciążeń też trafiają na listę podczas wyboru przeciążenia;
+    // typy są kompletowane później niż zmienne i funkcje, które ich używają - stąd kolejność:
+    // najpierw typy, potem zmienne i stałe, a na końcu funkcje
+    symbol_kind kinds_order[] = { SYMBOL_TYPE, SYMBOL_VARIABLE, SYMBOL_FUNCTION };
+    symbol **reachable = null;
+    for (size_t k = 0; k < sizeof(kinds_order) / sizeof(kinds_order[0]); k++)
+    {
+        for (size_t i = 0; i < buf_len(ordered_global_symbols); i++)
+        {
+            symbol *sym = ordered_global_symbols[i];
+            symbol_kind kind = (sym->kind == SYMBOL_TYPE || sym->kind == SYMBOL_FUNCTION) ? sym->kind : SYMBOL_VARIABLE;
+            if (sym->is_reachable && kind == kinds_order[k])
+            {
+                buf_push(reachable, sym);
+            }
+        }
+    }
+    buf_free(ordered_global_symbols);
+    ordered_global_symbols = reachable;
+
+    buf_free(reachable_symbols_queue);
+    resolve_reachable_only = false;
+}
+
+symbol *get_entry_point(symbol **symbols)
+{
+    symbol *main_function = null;
+    for (symbol **it = symbols;
+        it != buf_end(symbols);
+        it++)
+    {
+        symbol *sym = *it;
+        if (sym->name == main_str)
+        {
+            if (main_function)
+            {
+                error_in_resolving("Only one function 'main' allowed", sym->decl->pos);
+                return null;
+            }
+            else
+            {
+                main_function = sym;
+            }
+        }
+    }
+
+    if (main_function == null)
+    {
+        error_in_resolving("Entry point function 'main' not defined", (source_pos) { 0 });
+        return null;
+    }
+
+    if (false == (main_function->mangled_name == mangled_main_args_str
+        || main_function->mangled_name == mangled_main_void_str))
+    {
+        error_in_resolving(
+            "Main function has an incorrect declaration. Allowed declarations are 'fn main()' and 'fn main(args: string[])'", 
+            main_function->decl->pos);
+        return null;
+    }
+
+    return main_function;
+}
+
+void init_installed_types()
+{
+    if (false == installed_types_initialized)
+    {
+        push_installed_symbol("void", type_void);
+        push_installed_symbol("char", type_char);
+        push_installed_symbol("int", type_int);
+        push_installed_symbol("uint", type_uint);
+        push_installed_symbol("long", type_long);
+        push_installed_symbol("ulong", type_ulong);
+        push_installed_symbol("float", type_float);
+        push_installed_symbol("bool", type_bool);
+
+        resolved_expr_invalid = get_resolved_lvalue_expr(type_invalid);
+    }
+    installed_types_initialized = true;
+}
+
+symbol **resolve(decl **declarations, bool check_entry_point)
+{
+    assert(arena != null);
+    init_installed_types();
 
     for (size_t i = 0; i < buf_len(declarations); i++)
     {
@@ -2549,15 +3863,22 @@ symbol **resolve(decl **declarations, bool check_entry_point)
         push_symbol_from_decl(d);
     }
 
-    for (symbol **it = global_symbols_list;
-        it != buf_end(global_symbols_list);
-        it++)
+    if (check_entry_point)
     {
-        symbol *sym = *it;
-        complete_symbol(sym);
-        if (panic_mode)
+        complete_reachable_symbols();
+    }
+    else
+    {
+        for (symbol **it = global_symbols_list;
+            it != buf_end(global_symbols_list);
+            it++)
         {
-            break;
+            symbol *sym = *it;
+            complete_symbol(sym);
+            if (panic_mode)
+            {
+                break;
+            }
         }
     }
 
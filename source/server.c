@@ -0,0 +1,468 @@
+// tryb serwera - proces kompilatora pozostaje uruchomiony i przyjmuje żądania przez gniazdo
+// Unix, dzięki czemu kolejne kompilacje korzystają z obrazu prelude i pamięci podręcznej
+// sparsowanych plików; żądanie to jedna linia z polami oddzielonymi tabulatorami:
+// polecenie (compile, run, check albo shutdown), a po nim ścieżki i opcje kompilatora
+// odpowiedź to wyjście kompilatora zakończone linią ze statusem
+// każde żądanie jest obsługiwane w osobnym procesie potomnym, więc błąd wykonania, wywołanie
+// exit lub nieskończona pętla w programie nie zatrzymują serwera; w pamięci serwera zostaje
+// tylko obraz prelude, przygotowany przy starcie
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define SERVER_SUPPORTED 1
+#include <unistd.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#else
+#define SERVER_SUPPORTED 0
+#endif
+
+#define SERVER_DEFAULT_SOCKET "output/wilfrid.sock"
+#define SERVER_STATUS_PREFIX "#wilfrid-status "
+#define SERVER_MAX_REQUEST_LENGTH 65536
+#define SERVER_REQUEST_TIME_LIMIT 60
+
+// czas w sekundach, po którym proces obsługujący żądanie jest przerywany; 0 - bez limitu
+unsigned int server_request_time_limit = SERVER_REQUEST_TIME_LIMIT;
+
+typedef enum server_command
+{
+    SERVER_COMMAND_NONE,
+    SERVER_COMMAND_COMPILE,
+    SERVER_COMMAND_RUN,
+    SERVER_COMMAND_CHECK,
+    SERVER_COMMAND_SHUTDOWN,
+} server_command;
+
+// dzieli żądanie na pola; pierwsze pole jest nazwą polecenia, pozostałe trafiają do args
+// tak, jak argumenty wiersza poleceń (args[0] to nazwa programu)
+server_command parse_server_request(char *request, char ***args)
+{
+    buf_push(*args, "wilfrid");
+
+    char *command = request;
+    char *field = request;
+    while (field)
+    {
+        char *separator = strpbrk(field, "\t\r\n");
+        if (separator)
+        {
+            *separator = 0;
+        }
+
+        if (field != command && *field)
+        {
+            buf_push(*args, field);
+        }
+        field = separator ? separator + 1 : null;
+    }
+
+    if (0 == strcmp(command, "compile"))
+    {
+        return SERVER_COMMAND_COMPILE;
+    }
+    if (0 == strcmp(command, "run"))
+    {
+        return SERVER_COMMAND_RUN;
+    }
+    if (0 == strcmp(command, "check"))
+    {
+        return SERVER_COMMAND_CHECK;
+    }
+    if (0 == strcmp(command, "shutdown"))
+    {
+        return SERVER_COMMAND_SHUTDOWN;
+    }
+    return SERVER_COMMAND_NONE;
+}
+
+// zwraca status zapisany na końcu odpowiedzi i skraca odpowiedź o linię ze statusem
+int parse_server_response_status(char *response)
+{
+    char *status = null;
+    for (char *it = strstr(response, SERVER_STATUS_PREFIX); it; it = strstr(it + 1, SERVER_STATUS_PREFIX))
+    {
+        status = it;
+    }
+
+    if (status == null)
+    {
+        return -1;
+    }
+
+    int result = atoi(status + strlen(SERVER_STATUS_PREFIX));
+    *status = 0;
+    return result;
+}
+
+#if SERVER_SUPPORTED
+
+void compile_sources(compiler_options options);
+compiler_options parse_cmd_arguments(int arg_count, char **args);
+void parse_prelude(decl ***declarations_list);
+
+int open_server_socket(const char *socket_path, bool listening)
+{
+    struct sockaddr_un address = {0};
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path))
+    {
+        printf("Socket path '%s' is too long\n", socket_path);
+        return -1;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        printf("Could not create a socket\n");
+        return -1;
+    }
+
+    if (listening)
+    {
+        unlink(socket_path);
+        if (0 != bind(fd, (struct sockaddr *)&address, sizeof(address)) || 0 != listen(fd, 16))
+        {
+            printf("Could not listen on '%s'\n", socket_path);
+            close(fd);
+            return -1;
+        }
+    }
+    else if (0 != connect(fd, (struct sockaddr *)&address, sizeof(address)))
+    {
+        printf("Could not connect to '%s'. Is the server running?\n", socket_path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+char *read_server_request(int fd)
+{
+    char *request = null;
+    char c = 0;
+    while (buf_len(request) < SERVER_MAX_REQUEST_LENGTH && 1 == read(fd, &c, 1) && c != '\n')
+    {
+        buf_push(request, c);
+    }
+    buf_push(request, 0);
+    return request;
+}
+
+bool write_to_socket(int fd, const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t written = write(fd, data, length);
+        if (written <= 0)
+        {
+            return false;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+// wykonywane w procesie potomnym - wyjście kompilatora trafia bezpośrednio do gniazda klienta
+int compile_server_request(int client_fd, server_command command, char **args)
+{
+    dup2(client_fd, STDOUT_FILENO);
+    alarm(server_request_time_limit);
+
+    compiler_options options = parse_cmd_arguments((int)buf_len(args), args);
+    options.output_filename = "output/output.c";
+    options.run = (command == SERVER_COMMAND_RUN);
+    options.check_only = (command == SERVER_COMMAND_CHECK);
+    options.print_c = options.print_c || (command == SERVER_COMMAND_COMPILE);
+
+    if (buf_len(options.sources) == 0)
+    {
+        printf("No source files given\n");
+        return 1;
+    }
+
+    allocate_memory();
+    compile_sources(options);
+    return (buf_len(errors) > 0) ? 1 : 0;
+}
+
+// zwraca status żądania; opis przerwania procesu potomnego trafia do message
+int run_server_request_process(int client_fd, server_command command, char **args, char **message)
+{
+    fflush(stdout);
+    pid_t child = fork();
+    if (child == 0)
+    {
+        int child_status = compile_server_request(client_fd, command, args);
+        fflush(stdout);
+        _exit(child_status);
+    }
+
+    int wait_status = 0;
+    if (child < 0 || waitpid(child, &wait_status, 0) != child)
+    {
+        buf_printf(*message, "Could not start a process for the request\n");
+        return 1;
+    }
+
+    if (WIFEXITED(wait_status))
+    {
+        return (WEXITSTATUS(wait_status) == 0) ? 0 : 1;
+    }
+
+    if (WIFSIGNALED(wait_status) && WTERMSIG(wait_status) == SIGALRM)
+    {
+        buf_printf(*message, "\nRequest exceeded the time limit of %u seconds\n", server_request_time_limit);
+    }
+    else
+    {
+        buf_printf(*message, "\nRequest terminated by signal %d\n", WIFSIGNALED(wait_status) ? WTERMSIG(wait_status) : 0);
+    }
+    return 1;
+}
+
+server_command handle_server_request(int client_fd, char *request)
+{
+    char **args = null;
+    server_command command = parse_server_request(request, &args);
+
+    int status = 0;
+    char *message = null;
+    if (command == SERVER_COMMAND_NONE)
+    {
+        buf_printf(message, "Unknown request. Expected compile, run, check or shutdown\n");
+        status = 1;
+    }
+    else if (command != SERVER_COMMAND_SHUTDOWN)
+    {
+        status = run_server_request_process(client_fd, command, args, &message);
+    }
+
+    if (message)
+    {
+        write_to_socket(client_fd, message, buf_len(message));
+        buf_free(message);
+    }
+
+    char trailer[64];
+    int trailer_length = snprintf(trailer, sizeof(trailer), "\n%s%d\n", SERVER_STATUS_PREFIX, status);
+    write_to_socket(client_fd, trailer, (size_t)trailer_length);
+
+    buf_free(args);
+    return command;
+}
+
+// obraz prelude przygotowany w procesie serwera dziedziczą wszystkie procesy potomne
+void prepare_server_prelude(void)
+{
+    allocate_memory();
+    decl **prelude = null;
+    parse_prelude(&prelude);
+    buf_free(prelude);
+    clear_memory();
+}
+
+int run_server(const char *socket_path)
+{
+    // klient, który się rozłączył, nie może zakończyć procesu serwera
+    signal(SIGPIPE, SIG_IGN);
+
+    int server_fd = open_server_socket(socket_path, true);
+    if (server_fd < 0)
+    {
+        return 1;
+    }
+    prepare_server_prelude();
+    printf("Listening on '%s'\n", socket_path);
+    fflush(stdout);
+
+    bool running = true;
+    while (running)
+    {
+        int client_fd = accept(server_fd, null, null);
+        if (client_fd < 0)
+        {
+            continue;
+        }
+
+        char *request = read_server_request(client_fd);
+        running = (SERVER_COMMAND_SHUTDOWN != handle_server_request(client_fd, request));
+        buf_free(request);
+        close(client_fd);
+    }
+
+    close(server_fd);
+    unlink(socket_path);
+    return 0;
+}
+
+// przekazuje serwerowi argumenty wiersza poleceń poza opcjami samego klienta
+// ścieżki są zamieniane na bezwzględne, bo serwer może działać w innym katalogu
+int run_client(const char *socket_path, const char *command, int arg_count, char **args)
+{
+    int fd = open_server_socket(socket_path, false);
+    if (fd < 0)
+    {
+        return 1;
+    }
+
+    char *request = null;
+    buf_printf(request, "%s", command);
+    for (int i = 1; i < arg_count; i++)
+    {
+        if (0 == strncmp(args[i], "-client=", 8) || 0 == strncmp(args[i], "-socket=", 8))
+        {
+            continue;
+        }
+        char *absolute_path = (args[i][0] == '-') ? null : realpath(args[i], null);
+        buf_printf(request, "\t%s", absolute_path ? absolute_path : args[i]);
+        free(absolute_path);
+    }
+    buf_printf(request, "\n");
+
+    char *response = null;
+    if (write_to_socket(fd, request, buf_len(request)))
+    {
+        char chunk[4096];
+        ssize_t count = 0;
+        while ((count = read(fd, chunk, sizeof(chunk))) > 0)
+        {
+            for (ssize_t i = 0; i < count; i++)
+            {
+                buf_push(response, chunk[i]);
+            }
+        }
+    }
+    buf_push(response, 0);
+    close(fd);
+
+    int status = parse_server_response_status(response);
+    printf("%s", response);
+    if (status < 0)
+    {
+        printf("The server closed the connection without a status\n");
+        status = 1;
+    }
+
+    buf_free(request);
+    buf_free(response);
+    return status;
+}
+
+// błędy i pętle w obsługiwanym programie kończą tylko proces potomny
+// odpowiedź trafia do pliku, bo w wersji debug interpreter wypisuje każdą instrukcję
+char *send_test_server_request(char *request, char *source, int *status)
+{
+    char *source_path = "output/server_test." SRC_FILE_EXT;
+    char *response_path = "output/server_test_response.txt";
+    write_file(source_path, source, strlen(source));
+
+    int response_fd = open(response_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    assert(response_fd >= 0);
+    char *request_copy = null;
+    buf_printf(request_copy, "%s\t%s", request, source_path);
+    handle_server_request(response_fd, request_copy);
+    close(response_fd);
+    buf_free(request_copy);
+
+    string_ref file = read_file(response_path);
+    char *response = null;
+    buf_printf(response, "%s", file.str ? file.str : "");
+    free(file.str);
+
+    *status = parse_server_response_status(response);
+    return response;
+}
+
+void server_request_test(void)
+{
+    // proces potomny przydziela pamięć kompilatora tak jak w serwerze, między żądaniami
+    clear_memory();
+
+    int status = -1;
+    char *response = send_test_server_request("run\t-jit=off",
+        "fn main()\n{\n    let a : int[4] = { }\n    let i := 10\n    a[i] = 1\n}\n", &status);
+    assert(status == 1);
+    assert(strstr(response, "RUNTIME ERROR"));
+    buf_free(response);
+
+    response = send_test_server_request("check",
+        "fn main()\n{\n    let i := 10\n    assert(i == 10)\n}\n", &status);
+    assert(status == 0);
+    buf_free(response);
+
+    // wyjście nieskończonej pętli jest pomijane
+    char source[] = "fn main()\n{\n    while (true)\n    {\n    }\n}\n";
+    write_file("output/server_test." SRC_FILE_EXT, source, strlen(source));
+    char **args = null;
+    buf_push(args, "wilfrid");
+    buf_push(args, "-jit=off");
+    buf_push(args, "output/server_test." SRC_FILE_EXT);
+    int null_fd = open("/dev/null", O_WRONLY);
+    assert(null_fd >= 0);
+
+    unsigned int time_limit = server_request_time_limit;
+    server_request_time_limit = 1;
+    char *message = null;
+    status = run_server_request_process(null_fd, SERVER_COMMAND_RUN, args, &message);
+    server_request_time_limit = time_limit;
+    close(null_fd);
+
+    assert(status == 1);
+    assert(message && strstr(message, "exceeded the time limit"));
+    buf_free(message);
+    buf_free(args);
+
+    allocate_memory();
+}
+
+#else
+
+int run_server(const char *socket_path)
+{
+    printf("Server mode is not supported on this platform\n");
+    return 1;
+}
+
+int run_client(const char *socket_path, const char *command, int arg_count, char **args)
+{
+    printf("Server mode is not supported on this platform\n");
+    return 1;
+}
+
+#endif
+
+void server_test(void)
+{
+    printf("\n==== SERVER TEST ====\n");
+
+    char request[] = "check\t/tmp/a.wil\t-unchecked\t/tmp/b c.wil\r\n";
+    char **args = null;
+    assert(SERVER_COMMAND_CHECK == parse_server_request(request, &args));
+    assert(buf_len(args) == 4);
+    assert(0 == strcmp(args[1], "/tmp/a.wil"));
+    assert(0 == strcmp(args[2], "-unchecked"));
+    assert(0 == strcmp(args[3], "/tmp/b c.wil"));
+    buf_free(args);
+
+    char unknown[] = "format\tfile.wil";
+    assert(SERVER_COMMAND_NONE == parse_server_request(unknown, &args));
+    buf_free(args);
+
+    char response[] = "generated code\n" SERVER_STATUS_PREFIX "1\n";
+    assert(1 == parse_server_response_status(response));
+    assert(0 == strcmp(response, "generated code\n"));
+
+    char truncated[] = "generated code";
+    assert(-1 == parse_server_response_status(truncated));
+
+#if SERVER_SUPPORTED
+    server_request_test();
+#endif
+
+    printf("\nAll server tests passed!\n");
+}
@@ -1,13 +1,75 @@
-﻿void allocate_memory(void)
+﻿// pamięć wątków roboczych - areny przechodzą na kolejne wątki i są zwalniane w clear_memory
+typedef struct worker_memory
+{
+    memory_arena *arena;
+    memory_arena *string_arena;
+    char *xprintf_buf;
+} worker_memory;
+
+worker_memory *unused_worker_memory;
+thread_mutex worker_memory_mutex = THREAD_MUTEX_INITIALIZER;
+
+void enter_worker_thread(void)
+{
+    worker_memory memory = {0};
+    lock_mutex(&worker_memory_mutex);
+    if (buf_len(unused_worker_memory) > 0)
+    {
+        memory = unused_worker_memory[buf_len(unused_worker_memory) - 1];
+        buf_pop(unused_worker_memory);
+    }
+    unlock_mutex(&worker_memory_mutex);
+
+    if (memory.arena == null)
+    {
+        memory.arena = allocate_memory_arena(megabytes(1));
+        memory.string_arena = allocate_memory_arena(megabytes(1));
+        memory.xprintf_buf = xmalloc(memory.string_arena->block_size + 1);
+    }
+
+    arena = memory.arena;
+    string_arena = memory.string_arena;
+    xprintf_buf = memory.xprintf_buf;
+    xprintf_buf_size = string_arena->block_size + 1;
+}
+
+void leave_worker_thread(void)
+{
+    buf_free(line_offsets);
+    free_local_symbols();
+
+    worker_memory memory = {
+        .arena = arena,
+        .string_arena = string_arena,
+        .xprintf_buf = xprintf_buf,
+    };
+    lock_mutex(&worker_memory_mutex);
+    buf_push(unused_worker_memory, memory);
+    unlock_mutex(&worker_memory_mutex);
+}
+
+void free_worker_memory(void)
+{
+    for (size_t i = 0; i < buf_len(unused_worker_memory); i++)
+    {
+        free_memory_arena(unused_worker_memory[i].arena);
+        free_memory_arena(unused_worker_memory[i].string_arena);
+        free(unused_worker_memory[i].xprintf_buf);
+    }
+    buf_free(unused_worker_memory);
+}
+
+void allocate_memory(void)
 {
     arena = allocate_memory_arena(megabytes(1));
     string_arena = allocate_memory_arena(megabytes(1));
-    interns = xcalloc(sizeof(hashmap));
-    map_grow(interns, 32);
+    init_interns(1024);
     init_constant_strings();
 
     map_grow(&global_symbols, 32);
-    map_chain_grow(&cached_pointer_types, 32);
+    grow_type_table(&constructed_types, 64);
+    init_overload_cache();
+    map_grow(&usage_records, 64);
 
     vm_global_memory = allocate_memory_arena(kilobytes(100));
     map_grow(&global_identifiers, 32);
@@ -18,26 +80,28 @@
 
 void clear_memory(void)
 {
-    buf_free(all_tokens);
+    buf_free(line_offsets);
+    release_source_files();
 
     free_memory_arena(string_arena);
-    map_free(interns);
-    free(interns);
+    free_interns();
     keywords_initialized = false;
     constant_strings_initialized = false;
     buf_free(keywords_list);
 
     free_memory_arena(arena);
+    free_worker_memory();
 
     buf_free(global_symbols_list);
     buf_free(ordered_global_symbols);
-    map_chain_free(&cached_pointer_types);
+    free_type_table(&constructed_types);
+    free_overload_cache();
+    free_usage_records();
     mangle_clear();
 
     map_free(&global_symbols);
 
-    memset(local_symbols, 0, MAX_LOCAL_SYMBOLS);
-    last_local_symbol = local_symbols;
+    free_local_symbols();
 
     installed_types_initialized = false;
 
@@ -59,4 +123,6 @@ void clear_memory(void)
     buf_free(errors);
     buf_free(ast_buf);
     buf_free(gen_buf);
+    buf_free(gen_list_element_types);
+    buf_free(gen_list_element_cdecls);
 }
\ No newline at end of file
@@ -1,4 +1,4 @@
-char *test_parse_case(char **source, char *source_end, char *case_label, char *end_label)
+﻿char *test_parse_case(char **source, char *source_end, char *case_label, char *end_label)
 {
     int case_label_length = (int)strlen(case_label);
     int end_label_length = (int)strlen(end_label);
@@ -135,6 +135,223 @@ void parsing_tests_from_file(string_ref source, bool print_results)
     }
 }
 
+// wersja wektorowa musi się zatrzymywać dokładnie tam, gdzie skalarna, niezależnie od wyrównania
+void lexer_scan_test(void)
+{
+    char *samples[] = {
+        "  \t\v\r  x",
+        "identifier_with_digits_0123456789_and_more_letters_XYZ + 1",
+        "// comment running past the vector width ........................\nlet",
+        "/* outer /* nested */ still ** in / the comment */ done",
+        "\"string with \\\" escaped quotes and more than thirty two bytes\" tail",
+        "\"string across\nlines\"",
+        "trailing_name",
+        "   ",
+        "caf\xc3\xa9_name",
+    };
+
+    char buffer[256];
+    for (size_t i = 0; i < sizeof(samples) / sizeof(*samples); i++)
+    {
+        size_t length = strlen(samples[i]);
+        for (size_t shift = 0; shift < 32; shift++)
+        {
+            memset(buffer, 'a', sizeof(buffer));
+            memcpy(buffer + shift, samples[i], length + 1);
+            for (size_t k = 0; k <= length; k++)
+            {
+                char *ptr = buffer + shift + k;
+                for (lexer_scan_kind kind = SCAN_WHITESPACE; kind <= SCAN_STRING; kind++)
+                {
+                    lexer_simd_enabled = true;
+                    char *vector_result = lexer_scan(ptr, kind);
+                    lexer_simd_enabled = false;
+                    char *scalar_result = lexer_scan(ptr, kind);
+                    assert(vector_result == scalar_result);
+                }
+            }
+        }
+    }
+    lexer_simd_enabled = true;
+}
+
+void source_mapping_test(void)
+{
+    // plik o rozmiarze wielokrotności strony też musi kończyć się zerem
+    char *path = "output/mapping_test." SRC_FILE_EXT;
+    char *content = null;
+    for (size_t i = 0; i < 64 * 1024 / 16; i++)
+    {
+        buf_printf(content, "let x%010zu\n", i);
+    }
+    assert(buf_len(content) == 64 * 1024);
+    write_file(path, content, 64 * 1024);
+
+    size_t buffers_count = buf_len(source_file_buffers);
+    string_ref mapped = map_file_for_parsing(path);
+    assert(mapped.length == 64 * 1024);
+    assert(0 == memcmp(mapped.str, content, mapped.length));
+    assert(mapped.str[mapped.length] == 0);
+    assert(buf_len(source_file_buffers) == buffers_count + 1);
+
+    lex(mapped.str, path);
+    size_t names_count = 0;
+    while (tok.kind != TOKEN_EOF)
+    {
+        names_count += (tok.kind == TOKEN_NAME);
+        next_token();
+    }
+    assert(names_count == 64 * 1024 / 16);
+
+    release_source_files();
+    assert(buf_len(source_file_buffers) == 0);
+    buf_free(content);
+
+    // pusty plik daje ten sam wynik co wczytanie bez mapowania
+    write_file(path, "", 0);
+    string_ref empty = map_file_for_parsing(path);
+    string_ref read = read_file_for_parsing(path);
+    assert(empty.str == read.str && empty.length == read.length);
+    assert(buf_len(source_file_buffers) == 0);
+}
+
+void lexing_test(void)
+{
+    printf("\n==== LEXING TEST ====\n");
+
+    assert(sizeof(compact_token) <= 16);
+
+    char *source = "let x := 1\n\n  let s := \"a\nb\" (\n    x)";
+    lex(source, "lexing test");
+    assert(tok.kind == TOKEN_KEYWORD && tok.pos.line == 1 && tok.pos.character == 1);
+    for (size_t i = 0; i < 4; i++)
+    {
+        next_token();
+    }
+    assert(tok.kind == TOKEN_KEYWORD && tok.pos.line == 3 && tok.pos.character == 3);
+    next_token();
+    next_token();
+    next_token();
+    assert(tok.kind == TOKEN_STRING && 0 == strcmp(tok.string_val, "a\nb"));
+    assert(tok.pos.line == 3 && tok.pos.character == 12);
+    next_token();
+    assert(tok.kind == TOKEN_LEFT_PAREN && tok.pos.line == 4 && false == was_previous_token_newline());
+    next_token();
+    assert(tok.kind == TOKEN_NAME && tok.pos.line == 5 && tok.pos.character == 5);
+    assert(was_previous_token_newline());
+    next_token();
+    next_token();
+    assert(tok.kind == TOKEN_EOF);
+    next_token();
+    assert(tok.kind == TOKEN_EOF);
+
+    // tokeny nie są przechowywane - rośnie jedynie tablica początków linii
+    char *generated = null;
+    size_t line_count = 20000;
+    for (size_t i = 0; i < line_count; i++)
+    {
+        buf_printf(generated, "let variable_%zu := %zu + 0.5\n", i, i);
+    }
+    lex(generated, "generated");
+    size_t token_count = 1;
+    while (tok.kind != TOKEN_EOF)
+    {
+        next_token();
+        token_count++;
+    }
+    assert(token_count == line_count * 6 + 1);
+    assert(buf_len(line_offsets) == line_count + 1);
+    assert(tok.pos.line == line_count + 1 && tok.pos.character == 1);
+    buf_free(generated);
+
+    lex("\"unterminated", "lexing test");
+    assert(tok.kind == TOKEN_STRING && unterminated_string_lexed);
+
+    // funkcja skrótu słów kluczowych musi pozostać doskonała
+    for (keyword_kind kind = KEYWORD_NONE + 1; kind < KEYWORD_COUNT; kind++)
+    {
+        const char *literal = keyword_literals[kind];
+        assert(kind == get_keyword_kind(literal, strlen(literal)));
+    }
+    char *not_keywords[] = { "structs", "i", "iff", "size_of_typ", "Struct", "nul", "fn_", "_" };
+    for (size_t i = 0; i < sizeof(not_keywords) / sizeof(*not_keywords); i++)
+    {
+        assert(KEYWORD_NONE == get_keyword_kind(not_keywords[i], strlen(not_keywords[i])));
+    }
+
+    lex("fn for_each(variadic) { return }", "lexing test");
+    assert(tok.kind == TOKEN_KEYWORD && tok.keyword == KEYWORD_FN && tok.name == str_intern("fn"));
+    next_token();
+    assert(tok.kind == TOKEN_NAME && tok.keyword == KEYWORD_NONE);
+    next_token();
+    next_token();
+    assert(tok.keyword == KEYWORD_VARIADIC && tok.name == variadic_keyword);
+
+    lexer_scan_test();
+    source_mapping_test();
+
+    printf("\nAll lexing tests passed!\n");
+}
+
+void lexer_benchmark(char **sources)
+{
+    printf("\n==== LEXER BENCHMARK ====\n");
+
+    char **source_files = sources;
+    if (buf_len(source_files) == 0)
+    {
+        source_files = get_source_files_in_dir_and_subdirs("test");
+    }
+
+    for (size_t i = 0; i < buf_len(source_files); i++)
+    {
+        string_ref source = read_file_for_parsing(source_files[i]);
+        if (source.str == null || source.length == 0)
+        {
+            continue;
+        }
+
+        double throughput[2] = {0};
+        for (size_t mode = 0; mode < 2; mode++)
+        {
+            lexer_simd_enabled = (mode == 1);
+
+            // powtarzamy leksowanie, aż pomiar zajmie przynajmniej 0,2 sekundy
+            size_t repetitions = 0;
+            clock_t start = clock();
+            clock_t elapsed = 0;
+            while (elapsed < CLOCKS_PER_SEC / 5)
+            {
+                lex(source.str, source_files[i]);
+                while (tok.kind != TOKEN_EOF)
+                {
+                    next_token();
+                }
+                repetitions++;
+                elapsed = clock() - start;
+            }
+
+            double seconds = (double)elapsed / CLOCKS_PER_SEC;
+            throughput[mode] = (double)(source.length * repetitions) / (1024.0 * 1024.0) / seconds;
+        }
+        lexer_simd_enabled = true;
+
+        printf("%-50s %8.1f MB/s scalar %8.1f MB/s vector (%d bytes)\n",
+            source_files[i], throughput[0], throughput[1], LEXER_VECTOR_SIZE);
+        free(source.str);
+    }
+    buf_free(errors);
+
+    if (source_files != sources)
+    {
+        for (size_t i = 0; i < buf_len(source_files); i++)
+        {
+            free(source_files[i]);
+        }
+        buf_free(source_files);
+    }
+}
+
 void parsing_test_single_case(void)
 {
     char *test = "let str := \"<?xml version=\\\"1.0\\\" encoding=\\\"UTF-8\\\"?>\"";
@@ -169,7 +386,7 @@ void parsing_test(void)
     free(test_file.str);
 }
 
-symbol **test_resolve_decls(char **decl_arr, size_t decl_arr_count, bool print_ast)
+symbol **test_resolve_decls(char **decl_arr, size_t decl_arr_count, bool print_ast, bool check_entry_point)
 {
     assert(arena != null);
     buf_free(global_symbols_list);
@@ -214,7 +431,7 @@ symbol **test_resolve_decls(char **decl_arr, size_t decl_arr_count, bool print_a
 
     buf_free(errors);
     // rezultaty są zapisywane do ordered_global_symbols
-    resolve(all_decls, false);
+    resolve(all_decls, check_entry_point);
     error_counter += buf_len(errors);
     
     if (print_ast)
@@ -316,7 +533,7 @@ void resolve_test(void)
     };
     size_t str_count = sizeof(test_strs) / sizeof(test_strs[0]);
 
-    test_resolve_decls(test_strs, str_count, true);
+    test_resolve_decls(test_strs, str_count, true, false);
 }
 
 void mangled_names_test(void)
@@ -365,7 +582,7 @@ void mangled_names_test(void)
     assert(cmp_strs_count == test_strs_count);
 
     size_t error_counter = 0;
-    symbol **resolved = test_resolve_decls(test_strs, test_strs_count, false);
+    symbol **resolved = test_resolve_decls(test_strs, test_strs_count, false, false);
     for (size_t i = 2 /* dwa pierwsze pomijamy!*/; i < buf_len(resolved); i++)
     {
         symbol *sym = resolved[i];
@@ -391,9 +608,723 @@ void mangled_names_test(void)
     }
 }
 
-#include "utils\utils_tests.c"
+void reachability_test(void)
+{
+    printf("\n==== REACHABILITY TEST ====\n");
+    buf_free(errors);
+
+    char *test_strs[] = {
+        "fn main() { let s : used_struct used(s.i) }",
+        "fn used(x: int) { let f := used_as_value }",
+        "fn used(x: float) { unused_helper() }",
+        "fn used_as_value() { }",
+        "fn unused_helper() { }",
+        "fn unused() { used(1) }",
+        "struct used_struct { i: int }",
+        "struct unused_struct { i: int }",
+        "let unused_global := 1",
+    };
+    size_t str_count = sizeof(test_strs) / sizeof(test_strs[0]);
+
+    symbol **resolved = test_resolve_decls(test_strs, str_count, false, true);
+
+    const char *expected_mangled_names[] = { "___main", "___used___0i", "___used_as_value" };
+    size_t functions_count = 0;
+    for (size_t i = 0; i < buf_len(resolved); i++)
+    {
+        symbol *sym = resolved[i];
+        if (sym->kind == SYMBOL_FUNCTION)
+        {
+            assert(functions_count < 3);
+            assert(0 == strcmp(sym->mangled_name, expected_mangled_names[functions_count]));
+            functions_count++;
+        }
+        else
+        {
+            assert(sym->name == str_intern("used_struct"));
+        }
+    }
+    assert(functions_count == 3);
+}
+
+void local_scopes_test(void)
+{
+    printf("\n==== LOCAL SCOPES TEST ====\n");
+
+    // wyjście z zasięgu przywraca symbol widoczny przed wejściem
+    const char *name = str_intern("scoped_name");
+    size_t function_scope = enter_local_scope();
+    push_local_symbol(name, type_int);
+    symbol *outer = get_symbol(name);
+    assert(outer && outer->type == type_int);
+
+    size_t block_scope = enter_local_scope();
+    push_local_symbol(name, type_float);
+    assert(get_symbol(name)->type == type_float);
+    leave_local_scope(block_scope);
+    assert(get_symbol(name) == outer);
+
+    leave_local_scope(function_scope);
+    assert(get_symbol(name) == null);
+
+    // liczba zmiennych lokalnych w funkcji nie jest ograniczona
+    char *function_str = null;
+    buf_printf(function_str, "fn many_locals(): int { let v0 := 0 ");
+    for (int i = 1; i < 3000; i++)
+    {
+        buf_printf(function_str, "let v%d := v%d + 1 ", i, i - 1);
+    }
+    buf_printf(function_str, "{ let x := v2999 } { let x := v0 } return v2999 }");
+
+    buf_free(errors);
+    char *test_strs[] = { function_str };
+    test_resolve_decls(test_strs, 1, false, false);
+    assert(buf_len(errors) == 0);
+    buf_free(function_str);
+}
+
+void constructed_types_test(void)
+{
+    printf("\n==== CONSTRUCTED TYPES TEST ====\n");
+
+    // takie same typy są tym samym obiektem
+    assert(get_list_type(type_int) == get_list_type(type_int));
+    assert(get_list_type(type_int) != get_list_type(type_long));
+    assert(get_array_type(type_char, 4) == get_array_type(type_char, 4));
+    assert(get_array_type(type_char, 4) != get_array_type(type_char, 5));
+    assert(get_array_type(type_char, 4)->size == 4);
+    assert(get_pointer_type(get_list_type(type_int)) == get_pointer_type(get_list_type(type_int)));
+    assert(get_pointer_type(type_int) != get_list_type(type_int));
+
+    buf_free(errors);
+    char *test_strs[] = {
+        "let a: int[4]^[]",
+        "let b: int[4]^[]",
+        "let c: int[3]^[]",
+    };
+    test_resolve_decls(test_strs, sizeof(test_strs) / sizeof(test_strs[0]), false, false);
+    symbol *a = get_symbol(str_intern("a"));
+    symbol *b = get_symbol(str_intern("b"));
+    symbol *c = get_symbol(str_intern("c"));
+    assert(a->type->kind == TYPE_LIST && a->type == b->type);
+    assert(a->type != c->type);
+}
+
+void overload_index_test(void)
+{
+    printf("\n==== OVERLOAD INDEX TEST ====\n");
+    buf_free(errors);
+
+    char *test_strs[] = {
+        "fn pick(): int { return 0 }",
+        "fn pick(x: int): int { return 1 }",
+        "fn pick(x: float): int { return 2 }",
+        "fn pick(x: int, y: int): int { return 3 }",
+        "fn pick(x: char, y: float): int { return 4 }",
+        "fn pick(x: long, y: long): int { return 5 }",
+        "fn call_0(): int { return pick() }",
+        "fn call_1(): int { return pick(1) }",
+        "fn call_2(): int { return pick(2.0) }",
+        "fn call_3(): int { return pick(1, 2) }",
+        "fn call_4(): int { return pick(3, 4) }",
+        "fn call_5(c: char): int { return pick(c, 1.0) }",
+    };
+    size_t choices_count = overload_choices_count;
+    test_resolve_decls(test_strs, sizeof(test_strs) / sizeof(test_strs[0]), false, false);
+
+    symbol *overloads[6] = { 0 };
+    symbol *it = get_symbol(str_intern("pick"));
+    for (size_t i = 0; i < 6; i++, it = it->next_overload)
+    {
+        overloads[i] = it;
+    }
+    assert(it == null);
+
+    size_t expected_overloads[] = { 0, 1, 2, 3, 3, 4 };
+    for (size_t i = 0; i < 6; i++)
+    {
+        symbol *caller = get_symbol(str_intern(xprintf("call_%zu", i)));
+        expr *call = caller->decl->function.stmts.stmts[0]->return_stmt.ret_expr;
+        assert(call->kind == EXPR_CALL);
+        assert(call->call.resolved_function == overloads[expected_overloads[i]]);
+    }
+
+    // call_3 i call_4 przekazują argumenty tych samych typów
+    assert(overload_choices_count == choices_count + 5);
+}
+
+expr *find_list_index(expr *e)
+{
+    if (e == null)
+    {
+        return null;
+    }
+    if (e->kind == EXPR_STUB && e->stub.kind == STUB_EXPR_LIST_INDEX)
+    {
+        return e->stub.original_expr;
+    }
+    if (e->kind == EXPR_STUB)
+    {
+        return find_list_index(e->stub.original_expr);
+    }
+    if (e->kind == EXPR_BINARY)
+    {
+        expr *left = find_list_index(e->binary.left);
+        return left ? left : find_list_index(e->binary.right);
+    }
+    return null;
+}
+
+// sprawdza, czy odwołanie l[i] w pierwszej instrukcji pętli zostało uznane za bezpieczne
+bool is_loop_list_index_in_bounds(const char *function_name)
+{
+    symbol *sym = get_symbol(str_intern(function_name));
+    assert(sym && sym->decl);
+    analyze_index_ranges(sym->decl);
+
+    stmt *loop = null;
+    for (size_t i = 0; i < sym->decl->function.stmts.stmts_count && loop == null; i++)
+    {
+        stmt *st = sym->decl->function.stmts.stmts[i];
+        loop = (st->kind == STMT_FOR) ? st : null;
+    }
+    assert(loop);
+    stmt *first = loop->for_stmt.stmts.stmts[0];
+    assert(first->kind == STMT_ASSIGN);
+    expr *index = find_list_index(first->assign.value_expr);
+    if (index == null)
+    {
+        index = find_list_index(first->assign.assigned_var_expr);
+    }
+    assert(index);
+    return index->index.is_in_bounds;
+}
+
+void range_analysis_test(void)
+{
+    printf("\n==== RANGE ANALYSIS TEST ====\n");
+    buf_free(errors);
+
+    char *test_strs[] = {
+        "fn clear_list(l: int[]) { l.clear() }",
+        "fn helper() { }",
+        "fn summed(l: int[]): int { let s := 0 for (let i := 0, i < l.length(), i++) { s += l[i] } return s }",
+        "fn by_capacity(l: int[]): int { let s := 0 for (let i := 0, i < l.capacity(), i++) { s += l[i] } return s }",
+        "fn freed(l: int[]): int { let s := 0 for (let i := 0, i < l.length(), i++) { s += l[i] delete l } return s }",
+        "fn removed(l: int[]): int { let s := 0 for (let i := 0, i < l.length(), i++) { s += l[i] l.remove_at(0) } return s }",
+        "fn passed(l: int[]): int { let s := 0 for (let i := 0, i < l.length(), i++) { s += l[i] clear_list(l) } return s }",
+        "fn param_call(l: int[]): int { let s := 0 for (let i := 0, i < l.length(), i++) { s += l[i] helper() } return s }",
+        "fn fresh_call(): int { let l := new int[] let s := 0 for (let i := 0, i < l.length(), i++) { s += l[i] helper() } return s }",
+        "fn aliased(): int { let l := new int[] let m := l for (let i := 0, i < l.length(), i++) { l[i] = 0 m.remove_at(0) } return 0 }",
+    };
+    test_resolve_decls(test_strs, sizeof(test_strs) / sizeof(test_strs[0]), false, false);
+
+    assert(is_loop_list_index_in_bounds("summed"));
+    assert(is_loop_list_index_in_bounds("fresh_call"));
+
+    // indeksy są sprawdzane względem length(), a lista może się zmienić w pętli
+    assert(false == is_loop_list_index_in_bounds("by_capacity"));
+    assert(false == is_loop_list_index_in_bounds("freed"));
+    assert(false == is_loop_list_index_in_bounds("removed"));
+    assert(false == is_loop_list_index_in_bounds("passed"));
+    assert(false == is_loop_list_index_in_bounds("param_call"));
+    assert(false == is_loop_list_index_in_bounds("aliased"));
+
+    printf("\nAll range analysis tests passed!\n");
+}
+
+size_t count_ir_instrs(ir_function *f, ir_opcode opcode, token_kind operator)
+{
+    size_t result = 0;
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        ir_block *block = f->blocks[i];
+        for (size_t k = 0; k < buf_len(block->instrs); k++)
+        {
+            ir_instr *instr = block->instrs[k];
+            if (instr->opcode == opcode && instr->operator == operator)
+            {
+                result++;
+            }
+        }
+    }
+    return result;
+}
+
+ir_function *test_build_ir(const char *function_name)
+{
+    symbol *sym = map_get(&global_symbols, str_intern(function_name));
+    assert(sym && sym->kind == SYMBOL_FUNCTION);
+    ir_function *f = build_ir_function(sym);
+    if (f)
+    {
+        run_ir_passes(f);
+    }
+    return f;
+}
+
+void ir_test(void)
+{
+    printf("\n==== IR TEST ====\n");
+    buf_free(errors);
+
+    char *test_strs[] = {
+        "fn folded(): int { let x := 3 let y := x * 4 - 5 if (y > 100) { return 0 } return y }",
+        "fn hoisted(n: int, k: int): int { let s := 0 for (let i := 0, i < n, i++) { s += k * 4 } return s }",
+        "fn common(a: int, b: int): int { return (a + b) * (a + b) }",
+        "let g := 0",
+        "fn stores() { g = 1 g = 2 }",
+        "fn unsupported(p: int^): int { return #p }",
+    };
+    size_t str_count = sizeof(test_strs) / sizeof(test_strs[0]);
+
+    test_resolve_decls(test_strs, str_count, false, false);
+
+    // stałe są zwinięte, a martwa gałąź usunięta
+    ir_function *folded = test_build_ir("folded");
+    assert(folded);
+    assert(buf_len(folded->blocks) == 1);
+    ir_block *entry = folded->blocks[0];
+    assert(buf_len(entry->instrs) == 1);
+    ir_instr *ret = entry->instrs[0];
+    assert(ret->opcode == IR_RETURN);
+    assert(ir_resolve(ret->operands[0])->opcode == IR_CONST);
+    assert(ir_resolve(ret->operands[0])->int_value == 7);
+
+    // mnożenie niezależne od pętli trafia przed pętlę
+    ir_function *hoisted = test_build_ir("hoisted");
+    assert(hoisted);
+    assert(count_ir_instrs(hoisted, IR_BINARY, TOKEN_MUL) == 1);
+    entry = hoisted->blocks[0];
+    bool found_in_entry = false;
+    for (size_t i = 0; i < buf_len(entry->instrs); i++)
+    {
+        if (entry->instrs[i]->opcode == IR_BINARY && entry->instrs[i]->operator == TOKEN_MUL)
+        {
+            found_in_entry = true;
+        }
+    }
+    assert(found_in_entry);
+
+    ir_function *common = test_build_ir("common");
+    assert(common);
+    assert(count_ir_instrs(common, IR_BINARY, TOKEN_ADD) == 1);
+
+    // pierwszy zapis jest nadpisany przed jakimkolwiek odczytem
+    ir_function *stores = test_build_ir("stores");
+    assert(stores);
+    assert(count_ir_instrs(stores, IR_STORE_GLOBAL, 0) == 1);
+
+    assert(test_build_ir("unsupported") == null);
+
+    char *printed = print_ir_function(hoisted);
+    assert(strstr(printed, "phi"));
+    buf_free(printed);
+
+    free_ir_function(folded);
+    free_ir_function(hoisted);
+    free_ir_function(common);
+    free_ir_function(stores);
+
+    printf("\nAll IR tests passed!\n");
+}
+
+void x64_test(void)
+{
+    printf("\n==== X64 TEST ====\n");
+    buf_free(errors);
+
+    char *test_strs[] = {
+        "fn square(x: long): long { return x * x }",
+        "fn sum_squares(n: long): long { let s : long = 0 for (let i : long = 0, i < n, i++) { s += square(i) } return s }",
+        "extern fn assert(value: bool)",
+        "fn checked(x: int) { assert(x > 0) }",
+        "let last_value : long",
+        "fn store_twice(value: long) { last_value = value last_value = value * 2 }",
+        "fn seven(): int { let x := 3 return x + 4 }",
+    };
+    size_t str_count = sizeof(test_strs) / sizeof(test_strs[0]);
+
+    test_resolve_decls(test_strs, str_count, false, false);
+
+    x64_object obj = {0};
+    ir_function *square = test_build_ir("square");
+    ir_function *sum_squares = test_build_ir("sum_squares");
+    ir_function *checked = test_build_ir("checked");
+    ir_function *store_twice = test_build_ir("store_twice");
+    ir_function *seven = test_build_ir("seven");
+    assert(square && sum_squares && checked && store_twice && seven);
+
+    assert(x64_compile_function(&obj, square));
+    assert(obj.code[0] == 0x55); // push rbp
+    size_t code_size = buf_len(obj.code);
+
+    // wywołanie wymaga relokacji do symbolu funkcji
+    assert(x64_compile_function(&obj, sum_squares));
+    assert(buf_len(obj.relocations) == 1);
+    assert(obj.relocations[0].symbol == square->symbol->mangled_name);
+    assert(obj.relocations[0].type == X64_R_PLT32);
+
+    // funkcje zewnętrzne mogą być makrami C, więc zostają w kodzie C
+    assert(false == x64_compile_function(&obj, checked));
+    assert(buf_len(obj.functions) == 2);
+    assert(buf_len(obj.code) > code_size);
+
+    // funkcje bez żadnej wartości w rejestrze lub na stosie
+    assert(x64_compile_function(&obj, store_twice));
+    assert(x64_compile_function(&obj, seven));
+    assert(buf_len(obj.functions) == 4);
+
+    char *elf = write_elf_object(&obj);
+    assert(memcmp(elf, "\x7F" "ELF", 4) == 0);
+    assert((uint8_t)elf[18] == 62); // EM_X86_64
+    buf_free(elf);
+
+    free_x64_object(&obj);
+    free_ir_function(square);
+    free_ir_function(sum_squares);
+    free_ir_function(checked);
+    free_ir_function(store_twice);
+    free_ir_function(seven);
+
+    printf("\nAll x64 tests passed!\n");
+}
+
+void jit_test(void)
+{
+    printf("\n==== JIT TEST ====\n");
+    buf_free(errors);
+
+    if (false == JIT_SUPPORTED)
+    {
+        printf("\nJIT not supported on this platform\n");
+        return;
+    }
+
+    char *test_strs[] = {
+        "let g : long",
+        "fn triple(x: long): long { return x * 3 }",
+        "fn accumulate(a: long, b: float): float { g += triple(a) return b * 2.0 }",
+        "fn unsupported(p: int^): int { return #p }",
+    };
+    size_t str_count = sizeof(test_strs) / sizeof(test_strs[0]);
+
+    test_resolve_decls(test_strs, str_count, false, false);
+
+    int64_t g = 0;
+    hashmap globals = {0};
+    map_grow(&globals, 16);
+    map_put(&globals, str_intern("g"), &g);
+
+    // wywoływana funkcja jest kompilowana razem z wywołującą
+    symbol *accumulate = map_get(&global_symbols, str_intern("accumulate"));
+    jit_function *jf = jit_get_function(accumulate);
+    assert(jit_compile(jf, &globals));
+    assert(jf->status == JIT_COMPILED);
+    assert(jit_get_function(map_get(&global_symbols, str_intern("triple")))->status == JIT_COMPILED);
+
+    int64_t a = 5;
+    float b = 1.25f;
+    char **arg_vals = null;
+    buf_push(arg_vals, (char *)&a);
+    buf_push(arg_vals, (char *)&b);
+    float result = 0.0f;
+    assert(jit_try_call(accumulate, arg_vals, (char *)&result, &globals));
+    assert(result == 2.5f);
+    assert(g == 15);
+    buf_free(arg_vals);
+
+    symbol *unsupported = map_get(&global_symbols, str_intern("unsupported"));
+    jf = jit_get_function(unsupported);
+    assert(false == jit_compile(jf, &globals));
+    assert(jf->status == JIT_FAILED);
+
+    map_free(&globals);
+    jit_free();
+
+    printf("\nAll JIT tests passed!\n");
+}
+
+void build_test(void)
+{
+    printf("\n==== BUILD TEST ====\n");
+
+    assert(0 == strcmp(get_output_filename_with_extension("output/output.c", ".o"), "output/output.o"));
+    assert(0 == strcmp(get_output_filename_with_extension("output/program", ".o"), "output/program.o"));
+
+    // zmiana kodu albo opcji kompilacji musi dawać inny plik w cache
+    build_options debug = { .compiler = "cc", .flags = "-O0" };
+    build_options release = { .compiler = "cc", .flags = "-O2" };
+    char *code = "int main(void) { return 0; }";
+    char *other_code = "int main(void) { return 1; }";
+    uint64_t debug_hash = hash_build_input(&debug, code, strlen(code));
+    assert(debug_hash == hash_build_input(&debug, code, strlen(code)));
+    assert(debug_hash != hash_build_input(&release, code, strlen(code)));
+    assert(debug_hash != hash_build_input(&debug, other_code, strlen(other_code)));
+
+#if !_WIN32
+    // komunikat o błędzie podaje kod wyjścia polecenia, a nie status procesu
+    assert(3 == get_build_command_exit_code(system("exit 3")));
+    assert(0 == get_build_command_exit_code(system("true")));
+#endif
+
+    assert(0 == strcmp(get_split_header_filename("output/output.c"), "output/output.h"));
+    assert(0 == strcmp(get_split_unit_filename("output/output.c", 1), "output/output_1.c"));
+
+    buf_free(errors);
+    char *test_strs[] = {
+        "struct point { x: int, y: int }",
+        "const scale = 2.0",
+        "let origin : point",
+        "fn length(p: point): int { return p.x + p.y }",
+        "fn scaled(p: point): float { return length(p) as float * scale }",
+        "fn main() { origin.x = length(origin) }",
+    };
+    symbol **resolved = test_resolve_decls(test_strs, sizeof(test_strs) / sizeof(test_strs[0]), false, true);
+
+    // każda z jednostek dołącza wspólny nagłówek, a manifest wymienia wszystkie pliki
+    generate_split_units = 2;
+    generate_separate_runtime = true;
+    c_gen(resolved, "output/split_test.c", false);
+    generate_split_units = 0;
+    generate_separate_runtime = false;
+
+    string_ref manifest = read_file("output/split_test.manifest");
+    assert(manifest.str);
+    assert(strstr(manifest.str, "include/common.c\n"));
+    assert(strstr(manifest.str, "output/split_test_0.c\n"));
+    assert(strstr(manifest.str, "output/split_test_1.c\n"));
+    free(manifest.str);
+
+    string_ref unit = read_file("output/split_test_1.c");
+    assert(unit.str && unit.str == strstr(unit.str, "#include \"split_test.h\""));
+    free(unit.str);
+
+    printf("\nAll build tests passed!\n");
+}
+
+void ast_cache_test(void)
+{
+    printf("\n==== AST CACHE TEST ====\n");
+
+    // drzewo wczytane z pamięci podręcznej musi być identyczne z drzewem z parsera
+    char **source_files = get_source_files_in_dir_and_subdirs("test");
+    for (size_t i = 0; i < buf_len(source_files); i++)
+    {
+        char *filename = source_files[i];
+        string_ref source = read_file_for_parsing(filename);
+        buf_free(errors);
+
+        decl **parsed = null;
+        lex_and_parse(source.str, filename, &parsed);
+        if (buf_len(errors) == 0 && buf_len(parsed) > 0)
+        {
+            uint64_t source_hash = hash_bytes(source.str, source.length);
+            char *serialized = ast_cache_serialize(parsed, buf_len(parsed), source_hash);
+            assert(serialized);
+
+            decl **loaded = null;
+            assert(false == ast_cache_deserialize(serialized, buf_len(serialized), source_hash + 1, filename, &loaded));
+            assert(ast_cache_deserialize(serialized, buf_len(serialized), source_hash, filename, &loaded));
+            assert(buf_len(loaded) == buf_len(parsed));
+
+            for (size_t k = 0; k < buf_len(parsed); k++)
+            {
+                char *parsed_ast = xprintf("%s", get_decl_ast(parsed[k]));
+                assert(0 == strcmp(parsed_ast, get_decl_ast(loaded[k])));
+                assert(loaded[k]->pos.line == parsed[k]->pos.line);
+            }
+
+            // uszkodzony wpis nie może zostać wczytany
+            decl **truncated = null;
+            assert(false == ast_cache_deserialize(serialized, buf_len(serialized) - 1, source_hash, filename, &truncated));
+            assert(buf_len(truncated) == 0);
+
+            buf_free(serialized);
+            buf_free(loaded);
+        }
+
+        buf_free(parsed);
+        free(source.str);
+        free(filename);
+    }
+    buf_free(source_files);
+    buf_free(errors);
+
+    // kolejne parsowanie prelude w tym samym procesie korzysta z jego obrazu
+    char *prelude_filename = "include/common." SRC_FILE_EXT;
+    string_ref prelude = read_file_for_parsing(prelude_filename);
+    buf_free(prelude_image);
+    decl **parsed_prelude = null;
+    decl **loaded_prelude = null;
+    parse_prelude_with_image(prelude, prelude_filename, &parsed_prelude);
+    assert(prelude_image);
+    char *image = prelude_image;
+    parse_prelude_with_image(prelude, prelude_filename, &loaded_prelude);
+    assert(prelude_image == image);
+    assert(buf_len(parsed_prelude) > 0 && buf_len(parsed_prelude) == buf_len(loaded_prelude));
+    for (size_t i = 0; i < buf_len(parsed_prelude); i++)
+    {
+        char *parsed_ast = xprintf("%s", get_decl_ast(parsed_prelude[i]));
+        assert(0 == strcmp(parsed_ast, get_decl_ast(loaded_prelude[i])));
+    }
+    buf_free(parsed_prelude);
+    buf_free(loaded_prelude);
+    free(prelude.str);
+
+    printf("\nAll AST cache tests passed!\n");
+}
+
+void parse_files(char **filenames, size_t thread_count, decl ***declarations_list);
+
+void parallel_parsing_test(void)
+{
+    printf("\n==== PARALLEL PARSING TEST ====\n");
+
+    // wynik parsowania w kilku wątkach musi być taki sam, jak przy parsowaniu po kolei
+    bool cache_enabled = ast_cache_enabled;
+    ast_cache_enabled = false;
+
+    char **source_files = get_source_files_in_dir_and_subdirs("test");
+    buf_free(errors);
+    decl **serial = null;
+    parse_files(source_files, 1, &serial);
+    error_message *serial_errors = errors;
+    errors = null;
+
+    decl **parallel = null;
+    parse_files(source_files, 4, &parallel);
+    assert(buf_len(serial) > 0 && buf_len(serial) == buf_len(parallel));
+    for (size_t i = 0; i < buf_len(serial); i++)
+    {
+        char *serial_ast = xprintf("%s", get_decl_ast(serial[i]));
+        assert(0 == strcmp(serial_ast, get_decl_ast(parallel[i])));
+        assert(serial[i]->pos.filename == parallel[i]->pos.filename);
+        assert(serial[i]->pos.line == parallel[i]->pos.line);
+    }
+
+    // parsing_tests.wil zawiera błędy - ich kolejność też musi się zgadzać
+    assert(buf_len(serial_errors) > 0 && buf_len(serial_errors) == buf_len(errors));
+    for (size_t i = 0; i < buf_len(errors); i++)
+    {
+        assert(0 == strcmp(serial_errors[i].text, errors[i].text));
+        assert(serial_errors[i].pos.line == errors[i].pos.line);
+        assert(serial_errors[i].pos.character == errors[i].pos.character);
+    }
+
+    buf_free(serial_errors);
+    buf_free(errors);
+    buf_free(serial);
+    buf_free(parallel);
+    for (size_t i = 0; i < buf_len(source_files); i++)
+    {
+        free(source_files[i]);
+    }
+    buf_free(source_files);
+    ast_cache_enabled = cache_enabled;
+
+    printf("\nAll parallel parsing tests passed!\n");
+}
+
+// zwraca nazwy i drzewa rozwiązanych symboli - w drzewach widać wstawione casty i stuby
+char *resolve_with_worker_threads(char *source, size_t thread_count, error_message **resolving_errors)
+{
+    buf_free(global_symbols_list);
+    buf_free(ordered_global_symbols);
+    map_free(&global_symbols);
+    map_grow(&global_symbols, 16);
+    installed_types_initialized = false;
+
+    decl **decls = null;
+    lex_and_parse(source, "parallel resolving test", &decls);
+    assert(buf_len(errors) == 0);
+
+    worker_threads_count = thread_count;
+    symbol **resolved = resolve(decls, true);
+    worker_threads_count = 1;
+
+    char *result = null;
+    for (size_t i = 0; i < buf_len(resolved); i++)
+    {
+        buf_printf(result, "%s\n%s\n", resolved[i]->name, get_decl_ast(resolved[i]->decl));
+    }
+
+    *resolving_errors = errors;
+    errors = null;
+    buf_free(decls);
+    return result;
+}
+
+void parallel_resolving_test(void)
+{
+    printf("\n==== PARALLEL RESOLVING TEST ====\n");
+    buf_free(errors);
+
+    // ciała funkcji z kolejnych rund są sprawdzane w wątkach roboczych - symbole, kolejność
+    // i błędy muszą być takie same, jak przy sprawdzaniu po kolei
+    char *source =
+        "struct vec { x: float, y: float, next: vec^ }\n"
+        "let origin : vec\n"
+        "fn length(v: vec): float { return v.x + v.y }\n"
+        "fn scale(v: vec^, s: float) { v.x *= s v.y = v.y * s }\n"
+        "fn broken(v: vec): int { let a := v.z let b := missing return 0 }\n"
+        "fn count(v: vec^): int { let n := 0 while (v) { n++ v = v.next } return n }\n"
+        "fn compare(a: vec, b: vec): bool { return length(a) < length(b) && a.x == b.x }\n"
+        "fn also_broken(v: vec) { let x := other_missing if (v.x > 0.0) { unknown() } }\n"
+        "fn main() {\n"
+        "    let v := new vec\n"
+        "    scale(v, 2.0)\n"
+        "    let c := count(v) + broken(origin)\n"
+        "    if (compare(origin, origin)) { also_broken(origin) }\n"
+        "}\n";
+
+    error_message *serial_errors = null;
+    char *serial = resolve_with_worker_threads(source, 1, &serial_errors);
+    error_message *parallel_errors = null;
+    char *parallel = resolve_with_worker_threads(source, 4, &parallel_errors);
+
+    assert(0 == strcmp(serial, parallel));
+    assert(buf_len(serial_errors) > 1 && buf_len(serial_errors) == buf_len(parallel_errors));
+    for (size_t i = 0; i < buf_len(serial_errors); i++)
+    {
+        assert(0 == strcmp(serial_errors[i].text, parallel_errors[i].text));
+        assert(serial_errors[i].pos.line == parallel_errors[i].pos.line);
+        assert(serial_errors[i].pos.character == parallel_errors[i].pos.character);
+    }
+
+    buf_free(serial);
+    buf_free(parallel);
+    buf_free(serial_errors);
+    buf_free(parallel_errors);
+
+    // typ dostępny przez wskaźnik jest kompletowany z wyprzedzeniem, ale w wygenerowanym
+    // kodzie pojawia się dopiero tam, gdzie po raz pierwszy używa go sprawdzany kod
+    char *types_source =
+        "struct first { later: last^ }\n"
+        "struct middle { v: int }\n"
+        "struct last { v: int }\n"
+        "fn touch(f: first^) { }\n"
+        "fn use_last() { let l: last }\n"
+        "fn main() { touch(null) let m: middle let f: first use_last() }\n";
+    for (size_t thread_count = 1; thread_count <= 4; thread_count += 3)
+    {
+        char *result = resolve_with_worker_threads(types_source, thread_count, &serial_errors);
+        assert(buf_len(serial_errors) == 0);
+        char *first = strstr(result, "first\n");
+        char *middle = strstr(result, "middle\n");
+        char *last = strstr(result, "last\n");
+        assert(first && middle && last && first < middle && middle < last);
+        buf_free(result);
+    }
+
+    printf("\nAll parallel resolving tests passed!\n");
+}
+
+#include "utils/utils_tests.c"
 
 void common_includes_test(void);
+void compile_time_evaluation_test(void);
+void server_test(void);
 void fuzzy_test(void);
 
 void run_all_tests(void)
@@ -403,9 +1334,24 @@ void run_all_tests(void)
     buf_copy_test();
     map_test();
 
+    lexing_test();
     parsing_test();
     resolve_test();
     mangled_names_test();
+    reachability_test();
+    local_scopes_test();
+    constructed_types_test();
+    overload_index_test();
+    range_analysis_test();
+    compile_time_evaluation_test();
+    ir_test();
+    x64_test();
+    jit_test();
+    build_test();
+    ast_cache_test();
+    parallel_parsing_test();
+    parallel_resolving_test();
+    server_test();
     //fuzzy_test();
     common_includes_test();
 }
@@ -479,6 +1425,51 @@ void common_includes_test(void)
     assert(___get_list_length___(int_list) == 3);
     assert(___get_list_capacity___(int_list) == 4);
 
+    ___list_reserve___(int_list, 2, sizeof(int));
+
+    assert(___get_list_capacity___(int_list) == 4);
+
+    ___list_reserve___(int_list, 32, sizeof(int));
+
+    assert(___get_list_length___(int_list) == 3);
+    assert(___get_list_capacity___(int_list) == 32);
+    assert(((int *)int_list->buffer)[2] == 20);
+
+    int range[4] = { 1, 2, 3, 4 };
+    ___list_add_range___(int_list, range, 4, sizeof(int));
+    ___list_add_range___(int_list, int_list->buffer, 2, sizeof(int));
+
+    assert(___get_list_length___(int_list) == 9);
+    assert(((int *)int_list->buffer)[3] == 1);
+    assert(((int *)int_list->buffer)[6] == 4);
+    assert(((int *)int_list->buffer)[7] == 12);
+    assert(((int *)int_list->buffer)[8] == 16);
+
+    int inserted = 7;
+    ___list_insert_at___(int_list, 0, &inserted, sizeof(int));
+    ___list_remove_at_ordered___(int_list, sizeof(int), 1);
+
+    assert(___get_list_length___(int_list) == 9);
+    assert(((int *)int_list->buffer)[0] == 7);
+    assert(((int *)int_list->buffer)[1] == 16);
+    assert(((int *)int_list->buffer)[8] == 16);
+
+    ___list_hdr___ *int_list_copy = ___list_initialize___(1, sizeof(int), 0);
+    ___list_copy_from___(int_list_copy, int_list, sizeof(int));
+
+    assert(___get_list_length___(int_list_copy) == 9);
+    assert(0 == memcmp(int_list_copy->buffer, int_list->buffer, 9 * sizeof(int)));
+
+    assert(___checked_index___(3, 4) == 3);
+    assert(___list_checked_element___(int_list, 8, sizeof(int)) == int_list->buffer + 8 * sizeof(int));
+    assert(*(int *)___list_checked_element___(int_list, 0, sizeof(int)) == 7);
+
+    ___list_clear___(int_list, sizeof(int));
+
+    assert(___get_list_length___(int_list) == 0);
+    assert(___get_list_capacity___(int_list) == 32);
+
+    ___list_free___(int_list_copy);
     ___list_free___(int_list);
 
     assert(___get_list_length___(int_list) == 0);
@@ -80,6 +80,42 @@
     TOKEN_POINTER = TOKEN_XOR, // ^
 } token_kind;
 
+typedef enum keyword_kind
+{
+    KEYWORD_NONE,
+    KEYWORD_STRUCT,
+    KEYWORD_ENUM,
+    KEYWORD_UNION,
+    KEYWORD_LET,
+    KEYWORD_FN,
+    KEYWORD_SIZE_OF,
+    KEYWORD_SIZE_OF_TYPE,
+    KEYWORD_CONST,
+    KEYWORD_NEW,
+    KEYWORD_AUTO,
+    KEYWORD_DELETE,
+    KEYWORD_AS,
+    KEYWORD_NULL,
+    KEYWORD_TRUE,
+    KEYWORD_FALSE,
+    KEYWORD_BREAK,
+    KEYWORD_CONTINUE,
+    KEYWORD_RETURN,
+    KEYWORD_IF,
+    KEYWORD_ELSE,
+    KEYWORD_WHILE,
+    KEYWORD_DO,
+    KEYWORD_FOR,
+    KEYWORD_SWITCH,
+    KEYWORD_CASE,
+    KEYWORD_DEFAULT,
+    KEYWORD_VARIADIC,
+    KEYWORD_EXTERN,
+    KEYWORD_INLINE,
+    KEYWORD_NOINLINE,
+    KEYWORD_COUNT,
+} keyword_kind;
+
 const char *token_kind_names[] = {
 
     [TOKEN_EOF] = "EOF",
@@ -150,9 +186,8 @@ const char *token_kind_names[] = {
 typedef struct token
 {
     token_kind kind;
+    keyword_kind keyword; // dla TOKEN_KEYWORD - name wskazuje wtedy na nazwę słowa kluczowego
     source_pos pos;
-    const char *start;
-    const char *end;
     union
     {
         uint64_t uint_val;
@@ -163,6 +198,22 @@ typedef struct token
     };
 } token;
 
+// postać przechowywana przez lekser (16 bajtów) - zamiast pozycji w kodzie jest
+// przesunięcie od początku pliku, z którego pozycja jest wyznaczana dopiero dla parsera
+typedef struct compact_token
+{
+    uint32_t offset;
+    uint16_t kind;
+    union
+    {
+        uint64_t uint_val;
+        int64_t int_val;
+        double float_val;
+        const char *name;
+        const char *string_val;
+    };
+} compact_token;
+
 const char *get_token_kind_name(token_kind kind)
 {
     if (kind < sizeof(token_kind_names) / sizeof(*token_kind_names))
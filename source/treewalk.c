@@ -30,11 +30,33 @@ size_t debug_print_buffer_size = 1000;
 #define debug_print_vm_value
 #endif
 
+// gdy ustawiony jest punkt powrotu, błąd przerywa tylko bieżące obliczenie, a jego opis
+// trafia do runtime_error_message - w przeciwnym razie kończy działanie programu
+jmp_buf *runtime_error_recovery;
+char *runtime_error_message;
+source_pos runtime_error_pos;
+
+// liczba instrukcji i przebiegów pętli, po której obliczenie jest przerywane; 0 - bez limitu
+size_t vm_step_limit;
+size_t vm_steps;
+
 void runtime_error(source_pos pos, const char *format, ...)
 {
     va_list args;
     va_start(args, format);
 
+    if (runtime_error_recovery)
+    {
+        char message[1024];
+        stbsp_vsnprintf(message, sizeof(message), format, args);
+        va_end(args);
+
+        buf_free(runtime_error_message);
+        buf_printf(runtime_error_message, "%s", message);
+        runtime_error_pos = pos;
+        longjmp(*runtime_error_recovery, 1);
+    }
+
     char *message_buf = null;
     buf_printf(message_buf, "RUNTIME ERROR ");
     print_source_pos(&message_buf, pos);
@@ -49,6 +71,15 @@ void runtime_error(source_pos pos, const char *format, ...)
     exit(1);
 }
 
+void count_vm_step(source_pos pos)
+{
+    vm_steps++;
+    if (vm_step_limit && vm_steps > vm_step_limit)
+    {
+        runtime_error(pos, "Evaluation exceeded the limit of %zu steps", vm_step_limit);
+    }
+}
+
 typedef struct vm_value_meta
 {
     char *name;
@@ -360,6 +391,25 @@ byte *push_identifier_on_stack(const char *name, type *type)
     return result;
 }
 
+byte *push_allocation_on_stack(type *type)
+{
+    // GC przeszukuje stos co 8 bajtów, więc wskaźniki w obiekcie muszą być wyrównane;
+    // dopełnienie za obiektem zachowuje wyrównanie wartości umieszczanych później
+    int64_t stack_size = last_used_vm_stack_byte - vm_stack;
+    int64_t padding_before = align_up(stack_size + 1, 8) - (stack_size + 1);
+    int64_t size = get_type_size(type);
+    int64_t padding_after = align_up(padding_before + size, 8) - (padding_before + size);
+    if (stack_size + padding_before + size + padding_after >= MAX_VM_STACK_SIZE)
+    {
+        runtime_error((source_pos){ 0 }, "Stack overflow");
+    }
+
+    last_used_vm_stack_byte += padding_before;
+    byte *result = push_identifier_on_stack(null, type);
+    last_used_vm_stack_byte += padding_after;
+    return result;
+}
+
 byte *get_vm_variable(const char *name)
 {
     assert(name);
@@ -1340,19 +1390,25 @@ byte *eval_function_call(expr *exp, byte *result)
 
         result = push_identifier_on_stack(null, exp->resolved_type);
 
-        byte *marker = enter_vm_stack_scope();
+        if (exp->call.method_receiver
+            || false == jit_try_call(function, arg_vals, result, &global_identifiers))
         {
-            for (size_t i = 0; i < buf_len(arg_vals); i++)
+            byte *marker = enter_vm_stack_scope();
             {
-                const char *name = arg_names[i];
-                type *type = arg_types[i];
-                byte *arg_val = push_identifier_on_stack(name, type);
-                copy_vm_val(arg_val, arg_vals[i], get_type_size(type));
-            }
+                for (size_t i = 0; i < buf_len(arg_vals); i++)
+                {
+                    const char *name = arg_names[i];
+                    type *type = arg_types[i];
+                    byte *arg_val = push_identifier_on_stack(name, type);
+                    copy_vm_val(arg_val, arg_vals[i], get_type_size(type));
+                }
 
-            eval_function(function, result);
+                jit_function *caller = jit_enter_function(function);
+                eval_function(function, result);
+                jit_leave_function(caller);
+            }
+            leave_vm_stack_scope(marker);
         }
-        leave_vm_stack_scope(marker);
 
         buf_free(arg_vals);
         buf_free(arg_types);
@@ -1490,7 +1546,7 @@ byte *eval_expression(expr *exp)
         case EXPR_TERNARY:
         {
             byte *val = eval_expression(exp->ternary.condition);
-            if (*val)
+            if (is_non_zero(val, get_type_size(exp->ternary.condition->resolved_type)))
             {
                 result = eval_expression(exp->ternary.if_true);
             }
@@ -1584,6 +1640,12 @@ byte *eval_expression(expr *exp)
                 fatal("this shouldn't happen");
             }
 
+            if (arr_type->kind == TYPE_ARRAY && element_index >= arr_type->array.size)
+            {
+                runtime_error(exp->pos, "Index out of bounds: %zu (bound: %zu)",
+                    element_index, arr_type->array.size);
+            }
+
             size_t index_offset = get_array_index_offset(arr_type, element_index);
             result = arr + index_offset;
         }
@@ -1593,6 +1655,17 @@ byte *eval_expression(expr *exp)
             type *t = exp->new_init.resolved_type;
             assert(t);
 
+            if (exp->new_init.on_stack)
+            {
+                // zostanie zwolnione razem z zakresem, w którym jest deklaracja
+                uintptr_t ptr = (uintptr_t)push_allocation_on_stack(t);
+                copy_vm_val(result, (byte *)&ptr, sizeof(uintptr_t));
+
+                debug_vm_print(exp->pos, "stack allocation at %p, type %s",
+                    (void *)ptr, pretty_print_type_name(t, false));
+                break;
+            }
+
             size_t size = 0;
             if (t->kind == TYPE_ARRAY && t->array.size == 0)
             {                
@@ -1626,6 +1699,17 @@ byte *eval_expression(expr *exp)
         case EXPR_AUTO:
         {
             assert(exp->auto_init.resolved_type);
+
+            if (exp->auto_init.on_stack)
+            {
+                uintptr_t ptr = (uintptr_t)push_allocation_on_stack(exp->auto_init.resolved_type);
+                copy_vm_val(result, (byte *)&ptr, sizeof(uintptr_t));
+
+                debug_vm_print(exp->pos, "stack allocation at %p, type %s",
+                    (void *)ptr, pretty_print_type_name(exp->auto_init.resolved_type, false));
+                break;
+            }
+
             size_t size = get_type_size(exp->auto_init.resolved_type);
             uintptr_t ptr = (uintptr_t)___calloc_wrapper___(size, true);
             copy_vm_val(result, (byte *)&ptr, sizeof(uintptr_t));
@@ -1717,6 +1801,38 @@ byte *eval_expression(expr *exp)
     return result;
 }
 
+vm_list_header *eval_list_method_receiver(expr *orig_exp)
+{
+    assert(orig_exp->kind == EXPR_CALL);
+    assert(orig_exp->call.method_receiver);
+
+    expr *list_expr = orig_exp->call.method_receiver;
+    assert(list_expr->resolved_type);
+    assert(list_expr->resolved_type->kind == TYPE_LIST);
+
+    byte *receiver = eval_expression(list_expr);
+    if (*(uintptr_t *)receiver == 0)
+    {
+        runtime_error(orig_exp->pos, "Tried to call method on a uninitialized list");
+    }
+
+    return *(vm_list_header **)receiver;
+}
+
+size_t eval_list_method_integer_arg(expr *orig_exp, expr *arg_expr)
+{
+    byte *arg = eval_expression(arg_expr);
+
+    int64_t value = 0;
+    perform_cast(orig_exp->pos, (byte *)&value, type_long, arg, arg_expr->resolved_type);
+    if (value < 0)
+    {
+        runtime_error(orig_exp->pos, "Negative value %lld passed to a list method", (long long)value);
+    }
+
+    return (size_t)value;
+}
+
 byte *eval_stub_expression(byte *result, expr *exp)
 {
     assert(exp->kind == EXPR_STUB);
@@ -1859,8 +1975,16 @@ byte *eval_stub_expression(byte *result, expr *exp)
         break;
         case STUB_EXPR_LIST_REMOVE_AT:
         {
-            // not implemented in cgen
-            fatal("unimplemented");
+            vm_list_header *hdr = eval_list_method_receiver(orig_exp);
+            size_t index = eval_list_method_integer_arg(orig_exp, orig_exp->call.args[0]);
+            if (index >= hdr->length)
+            {
+                runtime_error(orig_exp->pos, "Tried to remove element at index %zu from a list of length %zu",
+                    index, hdr->length);
+            }
+
+            size_t elem_size = get_type_size(orig_exp->call.method_receiver->resolved_type->list.base_type);
+            ___list_remove_at_ordered___(hdr, elem_size, index);
         }
         break;
         case STUB_EXPR_LIST_NEW:
@@ -1911,6 +2035,64 @@ byte *eval_stub_expression(byte *result, expr *exp)
             hdr->length++;
         }
         break;
+        case STUB_EXPR_LIST_RESERVE:
+        {
+            vm_list_header *hdr = eval_list_method_receiver(orig_exp);
+            size_t capacity = eval_list_method_integer_arg(orig_exp, orig_exp->call.args[0]);
+            size_t elem_size = get_type_size(orig_exp->call.method_receiver->resolved_type->list.base_type);
+
+            ___list_reserve___(hdr, capacity, elem_size);
+        }
+        break;
+        case STUB_EXPR_LIST_ADD_RANGE:
+        {
+            vm_list_header *hdr = eval_list_method_receiver(orig_exp);
+            byte *elements = *(byte **)eval_expression(orig_exp->call.args[0]);
+            size_t count = eval_list_method_integer_arg(orig_exp, orig_exp->call.args[1]);
+            if (elements == null && count > 0)
+            {
+                runtime_error(orig_exp->pos, "Tried to add elements to a list from a null pointer");
+            }
+
+            size_t elem_size = get_type_size(orig_exp->call.method_receiver->resolved_type->list.base_type);
+            ___list_add_range___(hdr, elements, count, elem_size);
+        }
+        break;
+        case STUB_EXPR_LIST_INSERT_AT:
+        {
+            vm_list_header *hdr = eval_list_method_receiver(orig_exp);
+            size_t index = eval_list_method_integer_arg(orig_exp, orig_exp->call.args[0]);
+            byte *element = eval_expression(orig_exp->call.args[1]);
+            if (index > hdr->length)
+            {
+                runtime_error(orig_exp->pos, "Tried to insert element at index %zu to a list of length %zu",
+                    index, hdr->length);
+            }
+
+            size_t elem_size = get_type_size(orig_exp->call.method_receiver->resolved_type->list.base_type);
+            ___list_insert_at___(hdr, index, element, elem_size);
+        }
+        break;
+        case STUB_EXPR_LIST_CLEAR:
+        {
+            vm_list_header *hdr = eval_list_method_receiver(orig_exp);
+            size_t elem_size = get_type_size(orig_exp->call.method_receiver->resolved_type->list.base_type);
+            ___list_clear___(hdr, elem_size);
+        }
+        break;
+        case STUB_EXPR_LIST_COPY_FROM:
+        {
+            vm_list_header *hdr = eval_list_method_receiver(orig_exp);
+            vm_list_header *source = *(vm_list_header **)eval_expression(orig_exp->call.args[0]);
+            if (source == null)
+            {
+                runtime_error(orig_exp->pos, "Tried to copy elements from a uninitialized list");
+            }
+
+            size_t elem_size = get_type_size(orig_exp->call.method_receiver->resolved_type->list.base_type);
+            ___list_copy_from___(hdr, source, elem_size);
+        }
+        break;
         case STUB_EXPR_LIST_INDEX:
         {
             assert(orig_exp->kind == EXPR_INDEX);
@@ -1957,6 +2139,16 @@ bool break_loop = false;
 bool continue_loop = false;
 bool return_func = false;
 
+// przywraca stan interpretera po obliczeniu przerwanym przez runtime_error
+void reset_vm_after_error(byte *stack_marker)
+{
+    leave_vm_stack_scope(stack_marker);
+    break_loop = false;
+    continue_loop = false;
+    return_func = false;
+    jit_current_function = null;
+}
+
 void eval_statement(stmt *st, byte *opt_ret_value);
 
 void eval_statement_block(stmt_block block, byte *opt_ret_value)
@@ -1985,6 +2177,7 @@ void eval_statement_block(stmt_block block, byte *opt_ret_value)
 void eval_statement(stmt *st, byte *opt_ret_value)
 {
     assert(st);
+    count_vm_step(st->pos);
     switch (st->kind)
     {
         case STMT_NONE:
@@ -2112,6 +2305,10 @@ void eval_statement(stmt *st, byte *opt_ret_value)
                     break;
                 }
 
+                // wartości tymczasowe z poprzedniego przebiegu nie są już potrzebne
+                leave_vm_stack_scope(marker);
+                jit_count_back_edge();
+                count_vm_step(st->pos);
                 cond_var = eval_expression(st->while_stmt.cond_expr);
 
                 debug_vm_print(st->pos, "WHILE - condition evaluated as: %s", debug_print_vm_value(cond_var, cond_type));
@@ -2155,6 +2352,10 @@ void eval_statement(stmt *st, byte *opt_ret_value)
                     break;
                 }
 
+                // wartości tymczasowe z poprzedniego przebiegu nie są już potrzebne
+                leave_vm_stack_scope(marker);
+                jit_count_back_edge();
+                count_vm_step(st->pos);
                 cond_var = eval_expression(st->do_while_stmt.cond_expr);
 
                 debug_vm_print(st->pos, "DO WHILE - condition evaluated as: %s", debug_print_vm_value(cond_var, cond_type));
@@ -2204,6 +2405,10 @@ void eval_statement(stmt *st, byte *opt_ret_value)
                 }
 
                 eval_statement(st->for_stmt.next_stmt, null);
+                // wartości tymczasowe z poprzedniego przebiegu nie są już potrzebne
+                leave_vm_stack_scope(marker);
+                jit_count_back_edge();
+                count_vm_step(st->pos);
                 cond_var = eval_expression(st->for_stmt.cond_expr);
 
                 debug_vm_print(st->pos, "FOR - condition evaluated as: %s", debug_print_vm_value(cond_var, cond_type));
@@ -2341,6 +2546,10 @@ void eval_statement(stmt *st, byte *opt_ret_value)
             {
                 eval_stub_expression(null, st->delete.expr);
             }
+            else if (st->delete.target_on_stack)
+            {
+                debug_vm_print(st->pos, "delete of a stack allocation skipped");
+            }
             else
             {
                 byte *obj = eval_expression(st->delete.expr);
@@ -2391,7 +2600,12 @@ void eval_global_declarations(symbol **syms)
             case SYMBOL_VARIABLE:
             {
                 assert(sym->decl->kind == DECL_VARIABLE);
-                if (sym->decl->variable.expr)
+                if (sym->decl->variable.folded_value)
+                {
+                    // obliczone w czasie kompilacji
+                    push_global_identifier(pos, sym->name, sym->decl->variable.folded_value, size);
+                }
+                else if (sym->decl->variable.expr)
                 {
                     byte *result = eval_expression(sym->decl->variable.expr);
                     push_global_identifier(pos, sym->name, result, size);
@@ -2404,7 +2618,8 @@ void eval_global_declarations(symbol **syms)
             break;
             case SYMBOL_CONST:
             {
-                push_global_identifier(pos, sym->name, (byte *)&sym->val, size);
+                // stałe są odczytywane jako long, niezależnie od typu symbolu
+                push_global_identifier(pos, sym->name, (byte *)&sym->val, sizeof(sym->val));
             }
             break;           
         }
@@ -2449,7 +2664,9 @@ void run_interpreter(symbol **resolved_decls)
         return;
     }
 
+    jit_enter_function(main);
     eval_function(main, null);
+    jit_free();
 
 #if DEBUG_BUILD
     printf("\n=== FINISHED INTERPRETER RUN ===\n\n");
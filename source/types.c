@@ -146,6 +146,7 @@ struct symbol
     symbol_state state;
     decl *decl;
     type *type;
+    bool is_reachable; // osiągalny z funkcji main
     union
     {
         int64_t val;
@@ -187,6 +188,8 @@ bool compare_types(type *a, type *b)
     assert(a);
     assert(b);
 
+    // takie same typy są tym samym obiektem - dalsze porównania dotyczą tylko typów,
+    // które uznajemy za zgodne, choć nie są identyczne, np. long i enum albo null i wskaźnik
     if (a == b)
     {
         return true;
@@ -253,27 +256,148 @@ size_t get_type_align(type *type)
     return type->align;
 }
 
-chained_hashmap cached_pointer_types;
+// typy wskaźników, list i tablic są tworzone tylko raz dla danego typu bazowego i rozmiaru,
+// więc takie same typy są tym samym obiektem; typy funkcji nie trafiają do tablicy,
+// bo każdy z nich wskazuje na swój symbol, od którego zaczyna się wybór przeciążenia
+typedef struct type_table
+{
+    type **types;
+    size_t count;
+    size_t capacity;
+} type_table;
 
-type *get_pointer_type(type *base_type)
+type_table constructed_types;
+thread_mutex constructed_types_mutex = THREAD_MUTEX_INITIALIZER;
+
+type *get_base_type(type *t)
 {
-    if (base_type == null)
+    switch (t->kind)
     {
-        return type_invalid;
+        case TYPE_POINTER: return t->pointer.base_type;
+        case TYPE_LIST: return t->list.base_type;
+        case TYPE_ARRAY: return t->array.base_type;
+        default: return null;
     }
-    
-    type *ptr_type = map_chain_get(&cached_pointer_types, base_type);
-    if (ptr_type)
+}
+
+uint64_t hash_constructed_type(type_kind kind, type *base_type, size_t array_size)
+{
+    uint64_t result = hash_ptr(base_type) ^ hash_uint64(((uint64_t)kind << 48) ^ array_size);
+    return result;
+}
+
+void grow_type_table(type_table *table, size_t new_capacity)
+{
+    new_capacity = max(64, new_capacity);
+    type **new_types = xcalloc(new_capacity * sizeof(type *));
+    for (size_t i = 0; i < table->capacity; i++)
+    {
+        type *t = table->types[i];
+        if (t)
+        {
+            size_t array_size = (t->kind == TYPE_ARRAY) ? t->array.size : 0;
+            size_t index = (size_t)hash_constructed_type(t->kind, get_base_type(t), array_size);
+            while (new_types[index & (new_capacity - 1)])
+            {
+                index++;
+            }
+            new_types[index & (new_capacity - 1)] = t;
+        }
+    }
+    free(table->types);
+    table->types = new_types;
+    table->capacity = new_capacity;
+}
+
+void free_type_table(type_table *table)
+{
+    free(table->types);
+    table->types = null;
+    table->count = 0;
+    table->capacity = 0;
+}
+
+type *get_constructed_type_unlocked(type_kind kind, type *base_type, size_t array_size)
+{
+    if (2 * constructed_types.count >= constructed_types.capacity)
     {
-        return ptr_type;
+        grow_type_table(&constructed_types, 2 * constructed_types.capacity);
     }
 
-    type *type = get_new_type(TYPE_POINTER);
-    type->size = POINTER_SIZE;
-    type->align = POINTER_ALIGN;
-    type->pointer.base_type = base_type;
-    map_chain_put(&cached_pointer_types, base_type, type);
-    return type;
+    size_t index = (size_t)hash_constructed_type(kind, base_type, array_size);
+    while (true)
+    {
+        index &= constructed_types.capacity - 1;
+        type *t = constructed_types.types[index];
+        if (t == null)
+        {
+            break;
+        }
+        if (t->kind == kind && get_base_type(t) == base_type
+            && (kind != TYPE_ARRAY || t->array.size == array_size))
+        {
+            return t;
+        }
+        index++;
+    }
+
+    type *t = get_new_type(kind);
+    switch (kind)
+    {
+        case TYPE_POINTER:
+        {
+            t->size = POINTER_SIZE;
+            t->align = POINTER_ALIGN;
+            t->pointer.base_type = base_type;
+        }
+        break;
+        case TYPE_LIST:
+        {
+            t->size = POINTER_SIZE;
+            t->align = POINTER_ALIGN;
+            t->list.base_type = base_type;
+        }
+        break;
+        case TYPE_ARRAY:
+        {
+            t->size = array_size * get_type_size(base_type);
+            t->align = get_type_align(base_type);
+            t->array.base_type = base_type;
+            t->array.size = array_size;
+        }
+        break;
+        default:
+        {
+            fatal("only pointer, list and array types are constructed");
+        }
+        break;
+    }
+
+    constructed_types.types[index] = t;
+    constructed_types.count++;
+    return t;
+}
+
+type *get_constructed_type(type_kind kind, type *base_type, size_t array_size)
+{
+    assert(base_type);
+    if (worker_threads_running)
+    {
+        lock_mutex(&constructed_types_mutex);
+        type *result = get_constructed_type_unlocked(kind, base_type, array_size);
+        unlock_mutex(&constructed_types_mutex);
+        return result;
+    }
+    return get_constructed_type_unlocked(kind, base_type, array_size);
+}
+
+type *get_pointer_type(type *base_type)
+{
+    if (base_type == null)
+    {
+        return type_invalid;
+    }
+    return get_constructed_type(TYPE_POINTER, base_type, 0);
 }
 
 type *get_function_type(type **param_types, size_t param_types_count, type *return_type)
@@ -32,7 +32,7 @@ typedef struct error_message
     source_pos pos;
 } error_message;
 
-error_message *errors;
+THREAD_LOCAL error_message *errors;
 
 void error(const char *error_text, source_pos pos)
 {
@@ -64,6 +64,23 @@ void error_without_pos(const char *error_text)
     buf_push(errors, message);
 }
 
+// dołącza błędy zebrane w innym wątku - pierwszy z nich mógł powtórzyć ostatni błąd
+// z tej listy, tak samo jak przy zgłaszaniu ich po kolei w jednym wątku
+void append_errors(error_message *messages)
+{
+    for (size_t i = 0; i < buf_len(messages); i++)
+    {
+        if (i == 0 && messages[i].pos.filename)
+        {
+            error(messages[i].text, messages[i].pos);
+        }
+        else
+        {
+            buf_push(errors, messages[i]);
+        }
+    }
+}
+
 typedef enum source_pos_print_mode
 {
     SOURCE_POS_PRINT_FULL = 0,
@@ -1,4 +1,4 @@
-﻿#if __EMSCRIPTEN__
+﻿#if !defined(_WIN32)
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -12,13 +12,18 @@
 #else
 
 #include <io.h>
+#include <direct.h>
 
+#ifndef MAX_PATH
 #define MAX_PATH _MAX_PATH
+#endif
 
 #endif
 
 string_ref read_file(char *filename);
 bool write_file(const char *path, const char *buf, size_t len);
+bool file_exists(const char *path);
+bool make_directory(const char *path);
 
 string_ref read_file_for_parsing(char *filename)
 {
@@ -127,7 +132,7 @@ char **get_source_files_in_dir_and_subdirs(char *path)
     return source_files;
 }
 
-#if __EMSCRIPTEN__
+#if !defined(_WIN32)
 
 void path_copy(char *dest, size_t dest_array_size, const char *src)
 {
@@ -190,6 +195,28 @@ bool write_file(const char *path, const char *buf, size_t len)
     return (elements_written == 1);
 }
 
+bool file_exists(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == null)
+    {
+        return false;
+    }
+    fclose(file);
+    return true;
+}
+
+bool make_directory(const char *path)
+{
+    errno = 0;
+    if (0 == mkdir(path, 0777) || errno == EEXIST)
+    {
+        return true;
+    }
+    printf("Directory '%s' could not be created: %s\n", path, strerror(errno));
+    return false;
+}
+
 void get_source_files_in_dir(char *path, char ***source_files_buf, char ***directories_buf)
 {
     bool is_find_handle_valid = false;
@@ -223,7 +250,8 @@ void get_source_files_in_dir(char *path, char ***source_files_buf, char ***direc
             bool is_directory = (entry->d_type & DT_DIR);
             if (is_directory)
             {
-                if (0 != strcmp(entry->d_name, ".."))
+                // w przeciwieństwie do _findfirst readdir zwraca też katalog bieżący
+                if (0 != strcmp(entry->d_name, "..") && 0 != strcmp(entry->d_name, "."))
                 {
                     buf_push(*directories_buf, strdup(filename_buffer));
                 }
@@ -326,6 +354,27 @@ bool write_file(const char *path, const char *buf, size_t len)
     return (elements_written == 1);
 }
 
+bool file_exists(const char *path)
+{
+    FILE *file;
+    errno_t err = fopen_s(&file, path, "rb");
+    if (err != 0 || file == null)
+    {
+        return false;
+    }
+    fclose(file);
+    return true;
+}
+
+bool make_directory(const char *path)
+{
+    if (0 == _mkdir(path) || errno == EEXIST)
+    {
+        return true;
+    }
+    return false;
+}
+
 void get_source_files_in_dir(char *path, char ***source_files_buf, char ***directories_buf)
 {
     char filespec_buffer[MAX_PATH] = { 0 };
@@ -403,4 +452,169 @@ void get_source_files_in_dir(char *path, char ***source_files_buf, char ***direc
     }
 }
 
-#endif
\ No newline at end of file
+#endif
+
+// pliki źródłowe są mapowane do pamięci tylko do odczytu i pozostają zmapowane do końca
+// kompilacji; za plikiem zawsze znajduje się wyzerowana strona, więc kod kończy się zerem
+// nawet wtedy, gdy rozmiar pliku jest wielokrotnością rozmiaru strony
+
+#if defined(_WIN32)
+#define FILE_MAPPING_SUPPORTED 1
+#elif !defined(__EMSCRIPTEN__)
+#define FILE_MAPPING_SUPPORTED 1
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#define FILE_MAPPING_SUPPORTED 0
+#endif
+
+typedef struct source_file_buffer
+{
+    char *memory;
+    size_t mapping_size; // 0 dla plików wczytanych do pamięci ze sterty
+} source_file_buffer;
+
+source_file_buffer *source_file_buffers;
+thread_mutex source_file_buffers_mutex = THREAD_MUTEX_INITIALIZER;
+
+void register_source_file_buffer(source_file_buffer buffer)
+{
+    lock_mutex(&source_file_buffers_mutex);
+    buf_push(source_file_buffers, buffer);
+    unlock_mutex(&source_file_buffers_mutex);
+}
+
+// gdy mapowanie nie jest możliwe, plik jest wczytywany i zwalniany razem ze zmapowanymi
+string_ref read_source_file_to_heap(char *filename)
+{
+    string_ref result = read_file_for_parsing(filename);
+    if (result.str)
+    {
+        source_file_buffer buffer = { .memory = result.str };
+        register_source_file_buffer(buffer);
+    }
+    return result;
+}
+
+#if FILE_MAPPING_SUPPORTED && defined(_WIN32)
+
+// widok pliku obejmuje całe strony, a ich część za końcem pliku system wypełnia zerami;
+// na Windows nie da się jednak umieścić dodatkowej strony tuż za widokiem, który nie
+// kończy się na granicy 64 KB, więc pliki o rozmiarze będącym wielokrotnością strony
+// (i puste) są wczytywane na stertę
+string_ref map_file_for_parsing(char *filename)
+{
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, null,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, null);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return read_source_file_to_heap(filename);
+    }
+
+    SYSTEM_INFO system_info = {0};
+    GetSystemInfo(&system_info);
+
+    LARGE_INTEGER file_size = {0};
+    if (false == GetFileSizeEx(file, &file_size)
+        || file_size.QuadPart <= 0
+        || (uint64_t)file_size.QuadPart > SIZE_MAX
+        || (file_size.QuadPart % system_info.dwPageSize) == 0)
+    {
+        CloseHandle(file);
+        return read_source_file_to_heap(filename);
+    }
+
+    // widok utrzymuje obiekt mapowania i plik, więc uchwyty można od razu zamknąć
+    HANDLE mapping = CreateFileMappingA(file, null, PAGE_READONLY, 0, 0, null);
+    CloseHandle(file);
+    if (mapping == null)
+    {
+        return read_source_file_to_heap(filename);
+    }
+    char *memory = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (memory == null)
+    {
+        return read_source_file_to_heap(filename);
+    }
+
+    size_t size = (size_t)file_size.QuadPart;
+    source_file_buffer buffer = { .memory = memory, .mapping_size = size };
+    register_source_file_buffer(buffer);
+    return (string_ref) { .str = memory, .length = size };
+}
+
+#elif FILE_MAPPING_SUPPORTED
+
+string_ref map_file_for_parsing(char *filename)
+{
+    errno = 0;
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        printf("File '%s' could not be opened: %s\n", filename, strerror(errno));
+        return (string_ref) { 0 };
+    }
+
+    // puste pliki obsługujemy tak jak bez mapowania, żeby komunikaty były te same
+    struct stat info = {0};
+    if (0 != fstat(fd, &info) || info.st_size <= 0)
+    {
+        close(fd);
+        return read_source_file_to_heap(filename);
+    }
+
+    size_t size = (size_t)info.st_size;
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t mapping_size = align_up(size, page_size) + page_size;
+
+    // najpierw rezerwujemy wyzerowany obszar, a potem nakładamy na jego początek plik
+    char *memory = mmap(null, mapping_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        close(fd);
+        return read_source_file_to_heap(filename);
+    }
+    if (MAP_FAILED == mmap(memory, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0))
+    {
+        munmap(memory, mapping_size);
+        close(fd);
+        return read_source_file_to_heap(filename);
+    }
+    close(fd);
+
+    source_file_buffer buffer = { .memory = memory, .mapping_size = mapping_size };
+    register_source_file_buffer(buffer);
+    return (string_ref) { .str = memory, .length = size };
+}
+
+#else
+
+string_ref map_file_for_parsing(char *filename)
+{
+    return read_source_file_to_heap(filename);
+}
+
+#endif
+
+void release_source_files(void)
+{
+    for (size_t i = 0; i < buf_len(source_file_buffers); i++)
+    {
+        source_file_buffer buffer = source_file_buffers[i];
+#if FILE_MAPPING_SUPPORTED
+        if (buffer.mapping_size)
+        {
+#if defined(_WIN32)
+            UnmapViewOfFile(buffer.memory);
+#else
+            munmap(buffer.memory, buffer.mapping_size);
+#endif
+            continue;
+        }
+#endif
+        free(buffer.memory);
+    }
+    buf_free(source_file_buffers);
+}
@@ -1,43 +1,224 @@
-﻿typedef struct intern_str intern_str;
-struct intern_str
+﻿// tablica internowanych stringów z adresowaniem otwartym - sloty są podzielone na grupy
+// po 16, a każdy slot ma bajt znacznika z 7 bitami skrótu, więc cała grupa jest
+// sprawdzana jednym porównaniem SSE2; pełny skrót i długość są zapisane w slocie
+// i porównanie znaków następuje dopiero wtedy, gdy one się zgadzają
+
+#define INTERN_GROUP_SIZE 16
+#define INTERN_TAG_EMPTY 0
+
+typedef struct intern_str
 {
     size_t len;
-    intern_str *next;
-    char str[];
-};
+    const char *str;
+    uint64_t hash;
+} intern_str;
 
-hashmap *interns;
-memory_arena *string_arena;
+typedef struct intern_table
+{
+    uint8_t *tags;
+    intern_str *entries;
+    size_t count;
+    size_t capacity;
+} intern_table;
 
-const char *str_intern_range(const char *start, const char *end)
+// tablica jest podzielona na części wybierane bitami skrótu - wątki robocze parsera
+// blokują tylko tę część, do której trafia internowany string
+#define INTERN_SHARD_COUNT 16
+
+typedef struct intern_shard
 {
-    size_t len = end - start;
+    intern_table table;
+    thread_mutex mutex;
+} intern_shard;
+
+intern_shard intern_shards[INTERN_SHARD_COUNT];
+THREAD_LOCAL memory_arena *string_arena;
+
+uint64_t hash_string(const char *buf, size_t len)
+{
+    // po 8 bajtów naraz, z mieszaniem końcowym z MurmurHash3
+    uint64_t x = 0x9e3779b97f4a7c15 ^ (len * 0xff51afd7ed558ccd);
+    while (len >= 8)
+    {
+        uint64_t word = 0;
+        memcpy(&word, buf, 8);
+        x = (x ^ word) * 0xc4ceb9fe1a85ec53;
+        x ^= x >> 29;
+        buf += 8;
+        len -= 8;
+    }
+    if (len > 0)
+    {
+        uint64_t word = 0;
+        memcpy(&word, buf, len);
+        x = (x ^ word) * 0xc4ceb9fe1a85ec53;
+        x ^= x >> 29;
+    }
+
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccd;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53;
+    x ^= x >> 33;
+    return x;
+}
+
+uint8_t get_intern_tag(uint64_t hash)
+{
+    // najstarszy bit odróżnia zajęty slot od pustego
+    uint8_t result = (uint8_t)(0x80 | (hash >> 57));
+    return result;
+}
+
+// maska bitowa slotów grupy, których znacznik jest równy podanemu
+uint32_t match_intern_tags(uint8_t *group, uint8_t tag)
+{
+#if SSE2_SUPPORTED
+    __m128i tags = _mm_loadu_si128((const __m128i *)group);
+    uint32_t result = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(tags, _mm_set1_epi8((char)tag)));
+    return result;
+#else
+    uint32_t result = 0;
+    for (size_t i = 0; i < INTERN_GROUP_SIZE; i++)
+    {
+        if (group[i] == tag)
+        {
+            result |= (1u << i);
+        }
+    }
+    return result;
+#endif
+}
+
+void intern_table_insert(intern_table *table, intern_str entry)
+{
+    assert(is_power_of_2(table->capacity));
+    size_t group_mask = table->capacity / INTERN_GROUP_SIZE - 1;
+    size_t group = (size_t)entry.hash & group_mask;
+    for (size_t step = 1; ; step++)
+    {
+        uint8_t *tags = table->tags + group * INTERN_GROUP_SIZE;
+        uint32_t empty = match_intern_tags(tags, INTERN_TAG_EMPTY);
+        if (empty)
+        {
+            size_t index = group * INTERN_GROUP_SIZE + count_trailing_zeros(empty);
+            table->tags[index] = get_intern_tag(entry.hash);
+            table->entries[index] = entry;
+            table->count++;
+            return;
+        }
+        group = (group + step) & group_mask;
+    }
+}
+
+void intern_table_grow(intern_table *table, size_t new_capacity)
+{
+    new_capacity = max(INTERN_GROUP_SIZE, new_capacity);
+    intern_table new_table = {
+        .tags = xcalloc(new_capacity),
+        .entries = xcalloc(new_capacity * sizeof(intern_str)),
+        .capacity = new_capacity,
+    };
+    for (size_t i = 0; i < table->capacity; i++)
+    {
+        // zapisane skróty pozwalają przenieść wpisy bez ponownego haszowania
+        if (table->tags[i] != INTERN_TAG_EMPTY)
+        {
+            intern_table_insert(&new_table, table->entries[i]);
+        }
+    }
+    free(table->tags);
+    free(table->entries);
+    *table = new_table;
+}
 
-    uint64_t hash = hash_bytes(start, len);
-    // wartość 0 jest zarezerwowana jako sentinel - na niej przerwiemy wyszukiwanie
-    void *key = (void *)(uintptr_t)(hash ? hash : 1);
+void intern_table_free(intern_table *table)
+{
+    free(table->tags);
+    free(table->entries);
+    *table = (intern_table){0};
+}
+
+const char *intern_in_table(intern_table *table, const char *start, size_t len, uint64_t hash)
+{
+    if (8 * (table->count + 1) > 7 * table->capacity)
+    {
+        intern_table_grow(table, 2 * table->capacity);
+    }
 
-    intern_str *intern = map_get(interns, key);
-    for (intern_str *it = intern; it; it = it->next)
+    uint8_t tag = get_intern_tag(hash);
+    size_t group_mask = table->capacity / INTERN_GROUP_SIZE - 1;
+    size_t group = (size_t)hash & group_mask;
+    for (size_t step = 1; ; step++)
     {
-        // musimy wcześniej sprawdzić długość, by uniknąć sytuacji, w której 
-        // tylko prefix się zgadza - strncmp nie sprawdza długości
-        if (it->len == len && strncmp(it->str, start, len) == 0)
+        uint8_t *tags = table->tags + group * INTERN_GROUP_SIZE;
+        for (uint32_t matches = match_intern_tags(tags, tag); matches; matches &= matches - 1)
         {
-            return it->str;
+            intern_str *it = &table->entries[group * INTERN_GROUP_SIZE + count_trailing_zeros(matches)];
+            if (it->hash == hash && it->len == len && memcmp(it->str, start, len) == 0)
+            {
+                return it->str;
+            }
         }
+
+        // wolny slot w grupie oznacza, że dalej stringu na pewno nie ma
+        if (match_intern_tags(tags, INTERN_TAG_EMPTY))
+        {
+            break;
+        }
+        group = (group + step) & group_mask;
     }
 
-    // jeśli nie znaleźliśmy
-    intern_str *new_intern = push_size(string_arena, offsetof(intern_str, str) + len + 1);
-    new_intern->len = len;
-    new_intern->next = intern;
+    char *str = push_size(string_arena, len + 1);
+    memcpy(str, start, len);
+    str[len] = 0;
 
-    memcpy(new_intern->str, start, len);
-    new_intern->str[len] = 0;
-    map_put(interns, key, new_intern);
+    intern_str entry = { .len = len, .str = str, .hash = hash };
+    intern_table_insert(table, entry);
+    return str;
+}
 
-    return new_intern->str;
+void init_interns(size_t capacity)
+{
+    for (size_t i = 0; i < INTERN_SHARD_COUNT; i++)
+    {
+        intern_table_grow(&intern_shards[i].table, capacity / INTERN_SHARD_COUNT);
+        init_mutex(&intern_shards[i].mutex);
+    }
+}
+
+void free_interns(void)
+{
+    for (size_t i = 0; i < INTERN_SHARD_COUNT; i++)
+    {
+        intern_table_free(&intern_shards[i].table);
+        destroy_mutex(&intern_shards[i].mutex);
+    }
+}
+
+// wersja dla wywołujących, którzy już obliczyli skrót funkcją hash_string
+const char *str_intern_range_hashed(const char *start, const char *end, uint64_t hash)
+{
+    size_t len = end - start;
+    assert(hash == hash_string(start, len));
+
+    // część wybierają bity ze środka skrótu - młodsze wybierają grupę, a najstarsze tworzą znacznik
+    intern_shard *shard = &intern_shards[(hash >> 32) & (INTERN_SHARD_COUNT - 1)];
+    if (worker_threads_running)
+    {
+        lock_mutex(&shard->mutex);
+    }
+    const char *result = intern_in_table(&shard->table, start, len, hash);
+    if (worker_threads_running)
+    {
+        unlock_mutex(&shard->mutex);
+    }
+    return result;
+}
+
+const char *str_intern_range(const char *start, const char *end)
+{
+    return str_intern_range_hashed(start, end, hash_string(start, end - start));
 }
 
 const char *str_intern(const char *str)
@@ -45,8 +226,8 @@ const char *str_intern(const char *str)
     return str_intern_range(str, str + strlen(str));
 }
 
-char *xprintf_buf;
-size_t xprintf_buf_size;
+THREAD_LOCAL char *xprintf_buf;
+THREAD_LOCAL size_t xprintf_buf_size;
 
 char *xprintf(const char *format, ...)
 { 
@@ -19,6 +19,7 @@ typedef struct buffer_header
 
 #define buf_push(b, x) (__buf_fit((b), 1), (b)[__buf_header(b)->len++] = (x))
 #define buf_free(b) ((b) ? (free(__buf_header(b)), (b) = null) : 0)
+#define buf_pop(b) ((b) && buf_len(b) > 0 ? __buf_header(b)->len-- : 0)
 #define buf_remove_at(b, i) ((b) && buf_len(b) > (i) ? ((b)[i] = (b)[buf_len(b) - 1], (b)[buf_len(b) - 1] = 0, __buf_header(b)->len--) : 0) 
 
 buffer_header *__get_buf_header(void *ptr)
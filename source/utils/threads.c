@@ -0,0 +1,162 @@
+// wątki robocze korzystają z wątków Win32 albo POSIX - w kompilacjach dla emscripten
+// THREADS_SUPPORTED jest równe 0 i cała praca jest wykonywana w wątku głównym
+
+#if defined(_WIN32)
+#define THREADS_SUPPORTED 1
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#define NOGDI
+#include <windows.h>
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+typedef SRWLOCK thread_mutex;
+#define THREAD_MUTEX_INITIALIZER SRWLOCK_INIT
+#elif !defined(__EMSCRIPTEN__)
+#define THREADS_SUPPORTED 1
+#include <pthread.h>
+#include <unistd.h>
+#define THREAD_LOCAL __thread
+typedef pthread_mutex_t thread_mutex;
+#define THREAD_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+#else
+#define THREADS_SUPPORTED 0
+#define THREAD_LOCAL
+typedef int thread_mutex;
+#define THREAD_MUTEX_INITIALIZER 0
+#endif
+
+#define MAX_WORKER_THREADS 64
+
+size_t worker_threads_count = 1;
+bool worker_threads_running; // współdzielone tablice wymagają wtedy blokad
+
+void init_mutex(thread_mutex *mutex)
+{
+#if defined(_WIN32)
+    InitializeSRWLock(mutex);
+#elif THREADS_SUPPORTED
+    pthread_mutex_init(mutex, null);
+#endif
+}
+
+// SRWLOCK nie wymaga zwalniania
+void destroy_mutex(thread_mutex *mutex)
+{
+#if THREADS_SUPPORTED && !defined(_WIN32)
+    pthread_mutex_destroy(mutex);
+#endif
+}
+
+void lock_mutex(thread_mutex *mutex)
+{
+#if defined(_WIN32)
+    AcquireSRWLockExclusive(mutex);
+#elif THREADS_SUPPORTED
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+void unlock_mutex(thread_mutex *mutex)
+{
+#if defined(_WIN32)
+    ReleaseSRWLockExclusive(mutex);
+#elif THREADS_SUPPORTED
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+size_t get_processor_count(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info = {0};
+    GetSystemInfo(&info);
+    return (info.dwNumberOfProcessors > 0) ? (size_t)info.dwNumberOfProcessors : 1;
+#elif THREADS_SUPPORTED
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (size_t)count : 1;
+#else
+    return 1;
+#endif
+}
+
+typedef void (*thread_job)(void *data);
+
+typedef struct worker_thread
+{
+    thread_job job;
+    void *data;
+} worker_thread;
+
+#if defined(_WIN32)
+DWORD WINAPI run_worker_thread(LPVOID arg)
+{
+    worker_thread *worker = arg;
+    worker->job(worker->data);
+    return 0;
+}
+#elif THREADS_SUPPORTED
+void *run_worker_thread(void *arg)
+{
+    worker_thread *worker = arg;
+    worker->job(worker->data);
+    return null;
+}
+#endif
+
+// uruchamia zadanie w podanej liczbie wątków i czeka, aż wszystkie się zakończą
+// wątek główny tylko czeka - jego zmienne THREAD_LOCAL pozostają nietknięte
+// zwraca false, jeśli nie udało się uruchomić żadnego wątku
+bool run_in_worker_threads(size_t thread_count, thread_job job, void *data)
+{
+#if defined(_WIN32)
+    // MAX_WORKER_THREADS nie przekracza MAXIMUM_WAIT_OBJECTS
+    thread_count = min(thread_count, MAX_WORKER_THREADS);
+    worker_thread worker = { .job = job, .data = data };
+    HANDLE threads[MAX_WORKER_THREADS];
+    DWORD started = 0;
+    worker_threads_running = true;
+    for (size_t i = 0; i < thread_count; i++)
+    {
+        HANDLE thread = CreateThread(null, 0, run_worker_thread, &worker, 0, null);
+        if (thread)
+        {
+            threads[started] = thread;
+            started++;
+        }
+    }
+    if (started > 0)
+    {
+        WaitForMultipleObjects(started, threads, TRUE, INFINITE);
+    }
+    for (DWORD i = 0; i < started; i++)
+    {
+        CloseHandle(threads[i]);
+    }
+    worker_threads_running = false;
+    return (started > 0);
+#elif THREADS_SUPPORTED
+    thread_count = min(thread_count, MAX_WORKER_THREADS);
+    worker_thread worker = { .job = job, .data = data };
+    pthread_t threads[MAX_WORKER_THREADS];
+    size_t started = 0;
+    worker_threads_running = true;
+    for (size_t i = 0; i < thread_count; i++)
+    {
+        if (0 == pthread_create(&threads[started], null, run_worker_thread, &worker))
+        {
+            started++;
+        }
+    }
+    for (size_t i = 0; i < started; i++)
+    {
+        pthread_join(threads[i], null);
+    }
+    worker_threads_running = false;
+    return (started > 0);
+#else
+    return false;
+#endif
+}
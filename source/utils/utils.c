@@ -82,6 +82,31 @@ bool is_alphanumeric(char c)
 
 #define is_digit(d) (((uint32_t)(d) - '0') < 10u)
 
+// SSE2 jest dostępne na każdym procesorze x86-64
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SSE2_SUPPORTED 1
+#include <emmintrin.h>
+#else
+#define SSE2_SUPPORTED 0
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+uint32_t count_trailing_zeros(uint32_t mask)
+{
+    assert(mask != 0);
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return (uint32_t)index;
+#else
+    return (uint32_t)__builtin_ctz(mask);
+#endif
+}
+
+#include "threads.c"
 #include "hashmap.c"
 #include "interning.c"
 #include "errors.c"
@@ -31,6 +31,25 @@ void intern_str_test(void)
     char z[] = "hello!";
     const char *pz = str_intern(z);
     assert(pz != px);
+    assert(str_intern_range(z, z + 5) == px);
+
+    // wiele stringów o wspólnym prefiksie - tablica musi się kilka razy powiększyć
+    const char **interned = null;
+    char name[64];
+    for (size_t i = 0; i < 5000; i++)
+    {
+        int length = snprintf(name, sizeof(name), "identifier_with_long_prefix_%zu", i);
+        buf_push(interned, str_intern_range_hashed(name, name + length, hash_string(name, length)));
+    }
+    for (size_t i = 0; i < buf_len(interned); i++)
+    {
+        snprintf(name, sizeof(name), "identifier_with_long_prefix_%zu", i);
+        assert(str_intern(name) == interned[i]);
+        assert(0 == strcmp(name, interned[i]));
+    }
+    buf_free(interned);
+
+    assert(str_intern("") == str_intern_range(x, x));
 }
 
 void buf_remove_at_test(void)
@@ -0,0 +1,1670 @@
+// generowanie kodu maszynowego x86-64 (System V) na podstawie IR
+// funkcje, których nie da się przetłumaczyć, zostają w kodzie C
+
+typedef enum x64_reg
+{
+    X64_RAX = 0,
+    X64_RCX,
+    X64_RDX,
+    X64_RBX,
+    X64_RSP,
+    X64_RBP,
+    X64_RSI,
+    X64_RDI,
+    X64_R8,
+    X64_R9,
+    X64_R10,
+    X64_R11,
+    X64_R12,
+    X64_R13,
+    X64_R14,
+    X64_R15,
+} x64_reg;
+
+typedef enum x64_condition
+{
+    X64_CC_B = 0x2,
+    X64_CC_AE = 0x3,
+    X64_CC_E = 0x4,
+    X64_CC_NE = 0x5,
+    X64_CC_BE = 0x6,
+    X64_CC_A = 0x7,
+    X64_CC_P = 0xA,
+    X64_CC_NP = 0xB,
+    X64_CC_L = 0xC,
+    X64_CC_GE = 0xD,
+    X64_CC_LE = 0xE,
+    X64_CC_G = 0xF,
+} x64_condition;
+
+// w kodzie dla JIT w Windows funkcja wejściowa przyjmuje argumenty w rcx i rdx i musi
+// zachować rdi, rsi oraz xmm6-xmm15, które w System V należą do wywoływanej funkcji
+#if defined(_WIN32)
+#define X64_WIN64_ENTRY 1
+#else
+#define X64_WIN64_ENTRY 0
+#endif
+#define X64_WIN64_SAVED_XMM_COUNT 10
+#define X64_WIN64_STACK_PAGE_SIZE 4096
+
+#define X64_R_64 1
+#define X64_R_PC32 2
+#define X64_R_PLT32 4
+
+// wartości są przechowywane wyłącznie w rejestrach zachowywanych przez wywoływaną funkcję,
+// więc wywołania nie wymagają zapisywania rejestrów
+x64_reg x64_allocatable_regs[] = { X64_RBX, X64_R12, X64_R13, X64_R14, X64_R15 };
+#define X64_ALLOCATABLE_REGS_COUNT (sizeof(x64_allocatable_regs) / sizeof(x64_allocatable_regs[0]))
+
+x64_reg x64_int_arg_regs[] = { X64_RDI, X64_RSI, X64_RDX, X64_RCX, X64_R8, X64_R9 };
+#define X64_MAX_INT_ARGS 6
+#define X64_MAX_FLOAT_ARGS 8
+
+typedef struct x64_relocation
+{
+    size_t offset;
+    const char *symbol;
+    uint32_t type;
+    int64_t addend;
+} x64_relocation;
+
+typedef struct x64_function_code
+{
+    const char *name;
+    size_t offset;
+    size_t size;
+} x64_function_code;
+
+typedef struct x64_object
+{
+    uint8_t *code;
+    x64_relocation *relocations;
+    x64_function_code *functions;
+
+    // kod dla JIT - zmienne globalne są adresowane bezwzględnie
+    // i mają rozmiary używane przez interpreter
+    bool interpreter_layout;
+} x64_object;
+
+typedef struct x64_location
+{
+    bool in_register;
+    x64_reg reg;
+    int32_t offset; // względem rbp
+} x64_location;
+
+typedef struct x64_interval
+{
+    ir_instr *value;
+    size_t start;
+    size_t end;
+} x64_interval;
+
+typedef struct x64_jump_fixup
+{
+    size_t offset; // miejsce przesunięcia rel32
+    ir_block *target;
+} x64_jump_fixup;
+
+typedef struct x64_gen
+{
+    x64_object *obj;
+    ir_function *function;
+
+    size_t values_count;
+    x64_location *locations; // indeksowane identyfikatorem wartości
+    int32_t *phi_slots; // przesunięcia zmiennych pośredniczących w kopiowaniu phi
+    size_t *block_offsets;
+    x64_jump_fixup *fixups;
+
+    x64_reg *saved_regs;
+    size_t stack_slots;
+    bool failed;
+} x64_gen;
+
+hashmap native_functions;
+
+//
+// kodowanie instrukcji
+//
+
+void x64_emit_byte(x64_gen *gen, uint8_t byte)
+{
+    buf_push(gen->obj->code, byte);
+}
+
+void x64_emit_u32(x64_gen *gen, uint32_t value)
+{
+    for (size_t i = 0; i < 4; i++)
+    {
+        x64_emit_byte(gen, (uint8_t)(value >> (8 * i)));
+    }
+}
+
+void x64_emit_u64(x64_gen *gen, uint64_t value)
+{
+    for (size_t i = 0; i < 8; i++)
+    {
+        x64_emit_byte(gen, (uint8_t)(value >> (8 * i)));
+    }
+}
+
+void x64_patch_u32(x64_gen *gen, size_t offset, uint32_t value)
+{
+    for (size_t i = 0; i < 4; i++)
+    {
+        gen->obj->code[offset + i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+size_t x64_code_offset(x64_gen *gen)
+{
+    return buf_len(gen->obj->code);
+}
+
+void x64_emit_rex(x64_gen *gen, bool wide, x64_reg reg, x64_reg rm)
+{
+    if (wide || reg >= X64_R8 || rm >= X64_R8)
+    {
+        x64_emit_byte(gen, (uint8_t)(0x40 | (wide << 3) | ((reg >> 3) << 2) | (rm >> 3)));
+    }
+}
+
+// instrukcja z operandem rejestrowym w polu r/m
+void x64_emit_rr(x64_gen *gen, uint8_t prefix, bool wide, const char *opcode, x64_reg reg, x64_reg rm)
+{
+    if (prefix)
+    {
+        x64_emit_byte(gen, prefix);
+    }
+    x64_emit_rex(gen, wide, reg, rm);
+    for (const char *it = opcode; *it; it++)
+    {
+        x64_emit_byte(gen, (uint8_t)*it);
+    }
+    x64_emit_byte(gen, (uint8_t)(0xC0 | ((reg & 7) << 3) | (rm & 7)));
+}
+
+// instrukcja z operandem [base + disp32]
+void x64_emit_mem(x64_gen *gen, uint8_t prefix, bool wide, const char *opcode, x64_reg reg, x64_reg base, int32_t offset)
+{
+    // rsp i r12 jako baza wymagałyby bajtu SIB
+    assert((base & 7) != X64_RSP);
+    if (prefix)
+    {
+        x64_emit_byte(gen, prefix);
+    }
+    x64_emit_rex(gen, wide, reg, base);
+    for (const char *it = opcode; *it; it++)
+    {
+        x64_emit_byte(gen, (uint8_t)*it);
+    }
+    x64_emit_byte(gen, (uint8_t)(0x80 | ((reg & 7) << 3) | (base & 7)));
+    x64_emit_u32(gen, (uint32_t)offset);
+}
+
+void x64_emit_rbp(x64_gen *gen, bool wide, const char *opcode, x64_reg reg, int32_t offset)
+{
+    x64_emit_mem(gen, 0, wide, opcode, reg, X64_RBP, offset);
+}
+
+// instrukcja z operandem [rip + disp32] odnoszącym się do symbolu
+void x64_emit_rip(x64_gen *gen, bool wide, const char *opcode, x64_reg reg, const char *symbol)
+{
+    x64_emit_rex(gen, wide, reg, X64_RAX);
+    for (const char *it = opcode; *it; it++)
+    {
+        x64_emit_byte(gen, (uint8_t)*it);
+    }
+    x64_emit_byte(gen, (uint8_t)(((reg & 7) << 3) | X64_RBP));
+
+    x64_relocation reloc = {
+        .offset = x64_code_offset(gen),
+        .symbol = symbol,
+        .type = X64_R_PC32,
+        .addend = -4,
+    };
+    buf_push(gen->obj->relocations, reloc);
+    x64_emit_u32(gen, 0);
+}
+
+void x64_mov_rr(x64_gen *gen, x64_reg dst, x64_reg src)
+{
+    if (dst != src)
+    {
+        x64_emit_rr(gen, 0, true, "\x89", src, dst);
+    }
+}
+
+void x64_mov_imm(x64_gen *gen, x64_reg dst, uint64_t value)
+{
+    if (value <= UINT32_MAX)
+    {
+        // zapis do 32-bitowego rejestru zeruje starszą połowę
+        x64_emit_rex(gen, false, X64_RAX, dst);
+        x64_emit_byte(gen, (uint8_t)(0xB8 + (dst & 7)));
+        x64_emit_u32(gen, (uint32_t)value);
+    }
+    else if ((int64_t)value >= INT32_MIN && (int64_t)value < 0)
+    {
+        x64_emit_rr(gen, 0, true, "\xC7", 0, dst);
+        x64_emit_u32(gen, (uint32_t)value);
+    }
+    else
+    {
+        x64_emit_rex(gen, true, X64_RAX, dst);
+        x64_emit_byte(gen, (uint8_t)(0xB8 + (dst & 7)));
+        x64_emit_u64(gen, value);
+    }
+}
+
+void x64_push(x64_gen *gen, x64_reg reg)
+{
+    x64_emit_rex(gen, false, X64_RAX, reg);
+    x64_emit_byte(gen, (uint8_t)(0x50 + (reg & 7)));
+}
+
+void x64_pop(x64_gen *gen, x64_reg reg)
+{
+    x64_emit_rex(gen, false, X64_RAX, reg);
+    x64_emit_byte(gen, (uint8_t)(0x58 + (reg & 7)));
+}
+
+void x64_setcc_rax(x64_gen *gen, x64_condition cc)
+{
+    char opcode[] = { 0x0F, (char)(0x90 + cc), 0 };
+    x64_emit_rr(gen, 0, false, opcode, 0, X64_RAX);
+}
+
+void x64_setcc_rcx(x64_gen *gen, x64_condition cc)
+{
+    char opcode[] = { 0x0F, (char)(0x90 + cc), 0 };
+    x64_emit_rr(gen, 0, false, opcode, 0, X64_RCX);
+}
+
+// movzx eax, al
+void x64_zero_extend_al(x64_gen *gen)
+{
+    x64_emit_rr(gen, 0, false, "\x0F\xB6", X64_RAX, X64_RAX);
+}
+
+void x64_movd_to_xmm(x64_gen *gen, int xmm, x64_reg src)
+{
+    x64_emit_rr(gen, 0x66, false, "\x0F\x6E", (x64_reg)xmm, src);
+}
+
+void x64_movd_from_xmm(x64_gen *gen, x64_reg dst, int xmm)
+{
+    x64_emit_rr(gen, 0x66, false, "\x0F\x7E", (x64_reg)xmm, dst);
+}
+
+size_t x64_emit_jump(x64_gen *gen, const char *opcode)
+{
+    for (const char *it = opcode; *it; it++)
+    {
+        x64_emit_byte(gen, (uint8_t)*it);
+    }
+    size_t offset = x64_code_offset(gen);
+    x64_emit_u32(gen, 0);
+    return offset;
+}
+
+void x64_patch_jump_here(x64_gen *gen, size_t offset)
+{
+    x64_patch_u32(gen, offset, (uint32_t)(x64_code_offset(gen) - (offset + 4)));
+}
+
+//
+// lokalizacje wartości
+//
+
+int32_t x64_slot_offset(x64_gen *gen, size_t slot)
+{
+    int32_t result = -(int32_t)(8 * (buf_len(gen->saved_regs) + 1 + slot));
+    return result;
+}
+
+uint64_t x64_const_bits(ir_instr *value)
+{
+    if (value->type->kind == TYPE_FLOAT)
+    {
+        uint32_t bits = 0;
+        memcpy(&bits, &value->float_value, sizeof(bits));
+        return bits;
+    }
+    return value->int_value;
+}
+
+void x64_load(x64_gen *gen, x64_reg dst, ir_instr *value)
+{
+    value = ir_resolve(value);
+    if (value->opcode == IR_CONST)
+    {
+        x64_mov_imm(gen, dst, x64_const_bits(value));
+        return;
+    }
+
+    x64_location loc = gen->locations[value->id];
+    if (loc.in_register)
+    {
+        x64_mov_rr(gen, dst, loc.reg);
+    }
+    else
+    {
+        x64_emit_rbp(gen, true, "\x8B", dst, loc.offset);
+    }
+}
+
+void x64_store(x64_gen *gen, ir_instr *value, x64_reg src)
+{
+    x64_location loc = gen->locations[value->id];
+    if (loc.in_register)
+    {
+        x64_mov_rr(gen, loc.reg, src);
+    }
+    else
+    {
+        x64_emit_rbp(gen, true, "\x89", src, loc.offset);
+    }
+}
+
+//
+// konwersje typów - wartości całkowite są trzymane w rejestrach w postaci rozszerzonej do 64 bitów
+//
+
+bool x64_is_64_bit_type(type *t)
+{
+    bool result = (t->kind == TYPE_LONG || t->kind == TYPE_ULONG || t->kind == TYPE_ENUM
+        || t->kind == TYPE_POINTER || t->kind == TYPE_NULL);
+    return result;
+}
+
+// typ, w którym C wykonuje operację - po promocji typów mniejszych od int
+type *x64_promote(type *t)
+{
+    switch (t->kind)
+    {
+        case TYPE_CHAR:
+        case TYPE_BOOL:
+        {
+            return type_int;
+        }
+        break;
+        case TYPE_ENUM:
+        {
+            return type_long;
+        }
+        break;
+        case TYPE_POINTER:
+        case TYPE_NULL:
+        {
+            return type_ulong;
+        }
+        break;
+        default:
+        {
+            return t;
+        }
+        break;
+    }
+    return t;
+}
+
+type *x64_common_type(type *a, type *b)
+{
+    if (a->kind == TYPE_FLOAT || b->kind == TYPE_FLOAT)
+    {
+        return type_float;
+    }
+
+    a = x64_promote(a);
+    b = x64_promote(b);
+    if (a == b)
+    {
+        return a;
+    }
+
+    size_t a_size = get_type_size(a);
+    size_t b_size = get_type_size(b);
+    if (a_size != b_size)
+    {
+        return (a_size > b_size) ? a : b;
+    }
+    return is_unsigned_type(a) ? a : b;
+}
+
+void x64_normalize(x64_gen *gen, type *t)
+{
+    switch (t->kind)
+    {
+        case TYPE_CHAR:
+        {
+            x64_zero_extend_al(gen);
+        }
+        break;
+        case TYPE_INT:
+        {
+            // movsxd rax, eax
+            x64_emit_rr(gen, 0, true, "\x63", X64_RAX, X64_RAX);
+        }
+        break;
+        case TYPE_UINT:
+        case TYPE_FLOAT:
+        {
+            // mov eax, eax
+            x64_emit_rr(gen, 0, false, "\x89", X64_RAX, X64_RAX);
+        }
+        break;
+        case TYPE_BOOL:
+        {
+            // test rax, rax; setne al
+            x64_emit_rr(gen, 0, true, "\x85", X64_RAX, X64_RAX);
+            x64_setcc_rax(gen, X64_CC_NE);
+            x64_zero_extend_al(gen);
+        }
+        break;
+        default:
+        {
+        }
+        break;
+    }
+}
+
+// wartości przekazywane zgodnie z ABI - bool i char mają określony tylko najmłodszy bajt
+void x64_normalize_abi_value(x64_gen *gen, type *t)
+{
+    if (t->kind == TYPE_BOOL || t->kind == TYPE_CHAR)
+    {
+        x64_zero_extend_al(gen);
+    }
+    else
+    {
+        x64_normalize(gen, t);
+    }
+}
+
+// ustawia al na 1, jeśli liczba zmiennoprzecinkowa w eax jest różna od zera
+void x64_float_is_non_zero(x64_gen *gen)
+{
+    x64_movd_to_xmm(gen, 0, X64_RAX);
+    x64_emit_rr(gen, 0, false, "\x0F\x57", (x64_reg)1, (x64_reg)1); // xorps xmm1, xmm1
+    x64_emit_rr(gen, 0, false, "\x0F\x2E", (x64_reg)0, (x64_reg)1); // ucomiss xmm0, xmm1
+    x64_setcc_rax(gen, X64_CC_NE);
+    x64_setcc_rcx(gen, X64_CC_P);
+    x64_emit_rr(gen, 0, false, "\x08", X64_RCX, X64_RAX); // or al, cl
+    x64_zero_extend_al(gen);
+}
+
+// konwertuje wartość w rax
+void x64_convert(x64_gen *gen, type *from, type *to)
+{
+    if (from == to)
+    {
+        return;
+    }
+
+    if (to->kind == TYPE_BOOL)
+    {
+        if (from->kind == TYPE_FLOAT)
+        {
+            x64_float_is_non_zero(gen);
+        }
+        else
+        {
+            x64_normalize(gen, to);
+        }
+        return;
+    }
+
+    if (to->kind == TYPE_FLOAT)
+    {
+        if (from->kind == TYPE_ULONG)
+        {
+            // wartości powyżej INT64_MAX wymagałyby osobnej ścieżki
+            gen->failed = true;
+            return;
+        }
+        // cvtsi2ss xmm0, rax; movd eax, xmm0
+        x64_emit_rr(gen, 0xF3, true, "\x0F\x2A", (x64_reg)0, X64_RAX);
+        x64_movd_from_xmm(gen, X64_RAX, 0);
+        return;
+    }
+
+    if (from->kind == TYPE_FLOAT)
+    {
+        // cvttss2si rax, xmm0
+        x64_movd_to_xmm(gen, 0, X64_RAX);
+        x64_emit_rr(gen, 0xF3, true, "\x0F\x2C", X64_RAX, (x64_reg)0);
+    }
+    x64_normalize(gen, to);
+}
+
+//
+// instrukcje IR
+//
+
+void x64_gen_unary(x64_gen *gen, ir_instr *instr)
+{
+    ir_instr *operand = ir_resolve(instr->operands[0]);
+    x64_load(gen, X64_RAX, operand);
+
+    if (instr->operator == TOKEN_NOT)
+    {
+        if (operand->type->kind == TYPE_FLOAT)
+        {
+            x64_float_is_non_zero(gen);
+            x64_emit_rr(gen, 0, false, "\x83", (x64_reg)6, X64_RAX); // xor eax, 1
+            x64_emit_byte(gen, 1);
+        }
+        else
+        {
+            x64_emit_rr(gen, 0, true, "\x85", X64_RAX, X64_RAX);
+            x64_setcc_rax(gen, X64_CC_E);
+            x64_zero_extend_al(gen);
+        }
+        x64_convert(gen, type_int, instr->type);
+        return;
+    }
+
+    type *op_type = x64_promote(operand->type);
+    x64_convert(gen, operand->type, op_type);
+    switch (instr->operator)
+    {
+        case TOKEN_SUB:
+        {
+            if (op_type->kind == TYPE_FLOAT)
+            {
+                x64_emit_byte(gen, 0x35); // xor eax, imm32
+                x64_emit_u32(gen, 0x80000000);
+            }
+            else
+            {
+                x64_emit_rr(gen, 0, true, "\xF7", (x64_reg)3, X64_RAX); // neg rax
+            }
+        }
+        break;
+        case TOKEN_BITWISE_NOT:
+        {
+            x64_emit_rr(gen, 0, true, "\xF7", (x64_reg)2, X64_RAX); // not rax
+        }
+        break;
+        case TOKEN_ADD:
+        {
+        }
+        break;
+        default:
+        {
+            gen->failed = true;
+        }
+        break;
+    }
+    x64_normalize(gen, op_type);
+    x64_convert(gen, op_type, instr->type);
+}
+
+void x64_gen_float_binary(x64_gen *gen, ir_instr *instr)
+{
+    x64_movd_to_xmm(gen, 0, X64_RAX);
+    x64_movd_to_xmm(gen, 1, X64_R11);
+
+    const char *opcode = null;
+    switch (instr->operator)
+    {
+        case TOKEN_ADD: opcode = "\x0F\x58"; break;
+        case TOKEN_SUB: opcode = "\x0F\x5C"; break;
+        case TOKEN_MUL: opcode = "\x0F\x59"; break;
+        case TOKEN_DIV: opcode = "\x0F\x5E"; break;
+        default: break;
+    }
+
+    if (opcode)
+    {
+        x64_emit_rr(gen, 0xF3, false, opcode, (x64_reg)0, (x64_reg)1);
+        x64_movd_from_xmm(gen, X64_RAX, 0);
+        x64_convert(gen, type_float, instr->type);
+        return;
+    }
+
+    if (false == is_comparison_operator(instr->operator))
+    {
+        gen->failed = true;
+        return;
+    }
+
+    // a < b i a <= b sprowadzamy do b > a i b >= a, bo flagi ucomiss działają jak porównanie bez znaku
+    bool swap = (instr->operator == TOKEN_LT || instr->operator == TOKEN_LEQ);
+    x64_emit_rr(gen, 0, false, "\x0F\x2E", (x64_reg)(swap ? 1 : 0), (x64_reg)(swap ? 0 : 1));
+    switch (instr->operator)
+    {
+        case TOKEN_GT:
+        case TOKEN_LT:
+        {
+            x64_setcc_rax(gen, X64_CC_A);
+        }
+        break;
+        case TOKEN_GEQ:
+        case TOKEN_LEQ:
+        {
+            x64_setcc_rax(gen, X64_CC_AE);
+        }
+        break;
+        case TOKEN_EQ:
+        {
+            x64_setcc_rax(gen, X64_CC_E);
+            x64_setcc_rcx(gen, X64_CC_NP);
+            x64_emit_rr(gen, 0, false, "\x20", X64_RCX, X64_RAX); // and al, cl
+        }
+        break;
+        case TOKEN_NEQ:
+        {
+            x64_setcc_rax(gen, X64_CC_NE);
+            x64_setcc_rcx(gen, X64_CC_P);
+            x64_emit_rr(gen, 0, false, "\x08", X64_RCX, X64_RAX); // or al, cl
+        }
+        break;
+        default:
+        {
+        }
+        break;
+    }
+    x64_zero_extend_al(gen);
+    x64_convert(gen, type_int, instr->type);
+}
+
+void x64_gen_binary(x64_gen *gen, ir_instr *instr)
+{
+    ir_instr *left = ir_resolve(instr->operands[0]);
+    ir_instr *right = ir_resolve(instr->operands[1]);
+
+    if (instr->operator == TOKEN_LEFT_SHIFT || instr->operator == TOKEN_RIGHT_SHIFT)
+    {
+        type *op_type = x64_promote(left->type);
+        x64_load(gen, X64_RCX, right);
+        x64_load(gen, X64_RAX, left);
+        x64_convert(gen, left->type, op_type);
+
+        uint8_t ext = 4; // shl
+        if (instr->operator == TOKEN_RIGHT_SHIFT)
+        {
+            ext = is_signed_type(op_type) ? 7 : 5; // sar, shr
+        }
+        x64_emit_rr(gen, 0, true, "\xD3", (x64_reg)ext, X64_RAX);
+        x64_normalize(gen, op_type);
+        x64_convert(gen, op_type, instr->type);
+        return;
+    }
+
+    type *op_type = x64_common_type(left->type, right->type);
+    x64_load(gen, X64_RAX, right);
+    x64_convert(gen, right->type, op_type);
+    x64_mov_rr(gen, X64_R11, X64_RAX);
+    x64_load(gen, X64_RAX, left);
+    x64_convert(gen, left->type, op_type);
+
+    if (op_type->kind == TYPE_FLOAT)
+    {
+        x64_gen_float_binary(gen, instr);
+        return;
+    }
+
+    x64_mov_rr(gen, X64_RCX, X64_R11);
+    bool is_signed = is_signed_type(op_type);
+
+    if (is_comparison_operator(instr->operator))
+    {
+        x64_condition cc = X64_CC_E;
+        switch (instr->operator)
+        {
+            case TOKEN_EQ: cc = X64_CC_E; break;
+            case TOKEN_NEQ: cc = X64_CC_NE; break;
+            case TOKEN_LT: cc = is_signed ? X64_CC_L : X64_CC_B; break;
+            case TOKEN_LEQ: cc = is_signed ? X64_CC_LE : X64_CC_BE; break;
+            case TOKEN_GT: cc = is_signed ? X64_CC_G : X64_CC_A; break;
+            case TOKEN_GEQ: cc = is_signed ? X64_CC_GE : X64_CC_AE; break;
+            default: break;
+        }
+        x64_emit_rr(gen, 0, true, "\x39", X64_RCX, X64_RAX); // cmp rax, rcx
+        x64_setcc_rax(gen, cc);
+        x64_zero_extend_al(gen);
+        x64_convert(gen, type_int, instr->type);
+        return;
+    }
+
+    switch (instr->operator)
+    {
+        case TOKEN_ADD: x64_emit_rr(gen, 0, true, "\x01", X64_RCX, X64_RAX); break;
+        case TOKEN_SUB: x64_emit_rr(gen, 0, true, "\x29", X64_RCX, X64_RAX); break;
+        case TOKEN_BITWISE_AND: x64_emit_rr(gen, 0, true, "\x21", X64_RCX, X64_RAX); break;
+        case TOKEN_BITWISE_OR: x64_emit_rr(gen, 0, true, "\x09", X64_RCX, X64_RAX); break;
+        case TOKEN_XOR: x64_emit_rr(gen, 0, true, "\x31", X64_RCX, X64_RAX); break;
+        case TOKEN_MUL: x64_emit_rr(gen, 0, true, "\x0F\xAF", X64_RAX, X64_RCX); break;
+        case TOKEN_DIV:
+        case TOKEN_MOD:
+        {
+            if (is_signed)
+            {
+                x64_emit_byte(gen, 0x48); // cqo
+                x64_emit_byte(gen, 0x99);
+                x64_emit_rr(gen, 0, true, "\xF7", (x64_reg)7, X64_RCX); // idiv rcx
+            }
+            else
+            {
+                x64_emit_rr(gen, 0, false, "\x31", X64_RDX, X64_RDX); // xor edx, edx
+                x64_emit_rr(gen, 0, true, "\xF7", (x64_reg)6, X64_RCX); // div rcx
+            }
+
+            if (instr->operator == TOKEN_MOD)
+            {
+                x64_mov_rr(gen, X64_RAX, X64_RDX);
+            }
+        }
+        break;
+        default:
+        {
+            gen->failed = true;
+        }
+        break;
+    }
+    x64_normalize(gen, op_type);
+    x64_convert(gen, op_type, instr->type);
+}
+
+size_t x64_get_memory_size(x64_gen *gen, type *t)
+{
+    if (gen->obj->interpreter_layout)
+    {
+        return get_type_size(t);
+    }
+
+    // rozmiary typów w wygenerowanym kodzie C
+    if (t->kind == TYPE_BOOL || t->kind == TYPE_CHAR)
+    {
+        return 1;
+    }
+    return x64_is_64_bit_type(t) ? 8 : 4;
+}
+
+// odwołanie do zmiennej globalnej przez rip albo, w kodzie dla JIT, przez adres w r11
+void x64_emit_global(x64_gen *gen, bool wide, const char *opcode, x64_reg reg, const char *symbol)
+{
+    if (gen->obj->interpreter_layout)
+    {
+        // mov r11, imm64
+        x64_emit_rex(gen, true, X64_RAX, X64_R11);
+        x64_emit_byte(gen, (uint8_t)(0xB8 + (X64_R11 & 7)));
+        x64_relocation reloc = {
+            .offset = x64_code_offset(gen),
+            .symbol = symbol,
+            .type = X64_R_64,
+        };
+        buf_push(gen->obj->relocations, reloc);
+        x64_emit_u64(gen, 0);
+
+        x64_emit_mem(gen, 0, wide, opcode, reg, X64_R11, 0);
+    }
+    else
+    {
+        x64_emit_rip(gen, wide, opcode, reg, symbol);
+    }
+}
+
+void x64_gen_load_global(x64_gen *gen, ir_instr *instr)
+{
+    size_t size = x64_get_memory_size(gen, instr->global->type);
+    if (size == 1)
+    {
+        x64_emit_global(gen, false, "\x0F\xB6", X64_RAX, instr->global->name); // movzx eax, byte
+    }
+    else
+    {
+        x64_emit_global(gen, size == 8, "\x8B", X64_RAX, instr->global->name);
+    }
+    x64_normalize(gen, instr->global->type);
+}
+
+void x64_gen_store_global(x64_gen *gen, ir_instr *instr)
+{
+    x64_load(gen, X64_RAX, instr->operands[0]);
+    size_t size = x64_get_memory_size(gen, instr->global->type);
+    x64_emit_global(gen, size == 8, size == 1 ? "\x88" : "\x89", X64_RAX, instr->global->name);
+}
+
+void x64_gen_call(x64_gen *gen, ir_instr *instr)
+{
+    symbol *function = instr->function;
+
+    // funkcje zewnętrzne mogą być w C makrami, jak assert
+    if (function->decl == null || function->decl->function.is_extern)
+    {
+        gen->failed = true;
+        return;
+    }
+
+    size_t int_args = 0;
+    size_t float_args = 0;
+    for (size_t i = 0; i < buf_len(instr->operands); i++)
+    {
+        ir_instr *arg = ir_resolve(instr->operands[i]);
+        if (arg->type->kind == TYPE_FLOAT)
+        {
+            x64_load(gen, X64_RAX, arg);
+            x64_movd_to_xmm(gen, (int)float_args, X64_RAX);
+            float_args++;
+        }
+        else
+        {
+            int_args++;
+        }
+    }
+
+    if (int_args > X64_MAX_INT_ARGS || float_args > X64_MAX_FLOAT_ARGS)
+    {
+        gen->failed = true;
+        return;
+    }
+
+    int_args = 0;
+    for (size_t i = 0; i < buf_len(instr->operands); i++)
+    {
+        ir_instr *arg = ir_resolve(instr->operands[i]);
+        if (arg->type->kind != TYPE_FLOAT)
+        {
+            x64_load(gen, x64_int_arg_regs[int_args++], arg);
+        }
+    }
+
+    x64_emit_byte(gen, 0xE8);
+    x64_relocation reloc = {
+        .offset = x64_code_offset(gen),
+        .symbol = function->mangled_name,
+        .type = X64_R_PLT32,
+        .addend = -4,
+    };
+    buf_push(gen->obj->relocations, reloc);
+    x64_emit_u32(gen, 0);
+
+    if (instr->type)
+    {
+        if (instr->type->kind == TYPE_FLOAT)
+        {
+            x64_movd_from_xmm(gen, X64_RAX, 0);
+        }
+        else
+        {
+            // starsze bity rejestru wyniku są niezdefiniowane
+            x64_normalize_abi_value(gen, instr->type);
+        }
+        x64_store(gen, instr, X64_RAX);
+    }
+}
+
+void x64_gen_epilogue(x64_gen *gen)
+{
+    size_t saved_count = buf_len(gen->saved_regs);
+    // lea rsp, [rbp - 8 * saved_count]
+    x64_emit_rbp(gen, true, "\x8D", X64_RSP, -(int32_t)(8 * saved_count));
+    for (size_t i = saved_count; i > 0; i--)
+    {
+        x64_pop(gen, gen->saved_regs[i - 1]);
+    }
+    x64_pop(gen, X64_RBP);
+    x64_emit_byte(gen, 0xC3);
+}
+
+void x64_gen_phi_copies(x64_gen *gen, ir_block *from, ir_block *to)
+{
+    size_t pred_index = 0;
+    while (to->preds[pred_index] != from)
+    {
+        pred_index++;
+    }
+
+    for (size_t i = 0; i < buf_len(to->instrs); i++)
+    {
+        ir_instr *phi = to->instrs[i];
+        if (phi->opcode != IR_PHI)
+        {
+            break;
+        }
+        x64_load(gen, X64_RAX, phi->operands[pred_index]);
+        x64_emit_rbp(gen, true, "\x89", X64_RAX, gen->phi_slots[phi->id]);
+    }
+}
+
+void x64_gen_jump_to(x64_gen *gen, ir_block *target)
+{
+    size_t offset = x64_emit_jump(gen, "\xE9");
+    x64_jump_fixup fixup = { .offset = offset, .target = target };
+    buf_push(gen->fixups, fixup);
+}
+
+void x64_gen_instr(x64_gen *gen, ir_instr *instr, ir_block *next_block)
+{
+    switch (instr->opcode)
+    {
+        case IR_PARAM:
+        {
+            // parametry są przenoszone w prologu
+        }
+        break;
+        case IR_PHI:
+        {
+            x64_emit_rbp(gen, true, "\x8B", X64_RAX, gen->phi_slots[instr->id]);
+            x64_store(gen, instr, X64_RAX);
+        }
+        break;
+        case IR_UNARY:
+        {
+            x64_gen_unary(gen, instr);
+            x64_store(gen, instr, X64_RAX);
+        }
+        break;
+        case IR_BINARY:
+        {
+            x64_gen_binary(gen, instr);
+            x64_store(gen, instr, X64_RAX);
+        }
+        break;
+        case IR_CAST:
+        {
+            ir_instr *operand = ir_resolve(instr->operands[0]);
+            x64_load(gen, X64_RAX, operand);
+            x64_convert(gen, operand->type, instr->type);
+            x64_store(gen, instr, X64_RAX);
+        }
+        break;
+        case IR_LOAD_GLOBAL:
+        {
+            x64_gen_load_global(gen, instr);
+            x64_store(gen, instr, X64_RAX);
+        }
+        break;
+        case IR_STORE_GLOBAL:
+        {
+            x64_gen_store_global(gen, instr);
+        }
+        break;
+        case IR_CALL:
+        {
+            x64_gen_call(gen, instr);
+        }
+        break;
+        case IR_JUMP:
+        {
+            x64_gen_phi_copies(gen, instr->block, instr->targets[0]);
+            if (instr->targets[0] != next_block)
+            {
+                x64_gen_jump_to(gen, instr->targets[0]);
+            }
+        }
+        break;
+        case IR_BRANCH:
+        {
+            ir_instr *cond = ir_resolve(instr->operands[0]);
+            x64_load(gen, X64_RAX, cond);
+            if (cond->type->kind == TYPE_FLOAT)
+            {
+                x64_float_is_non_zero(gen);
+            }
+            x64_emit_rr(gen, 0, true, "\x85", X64_RAX, X64_RAX); // test rax, rax
+            size_t false_jump = x64_emit_jump(gen, "\x0F\x84"); // jz
+
+            x64_gen_phi_copies(gen, instr->block, instr->targets[0]);
+            x64_gen_jump_to(gen, instr->targets[0]);
+
+            x64_patch_jump_here(gen, false_jump);
+            x64_gen_phi_copies(gen, instr->block, instr->targets[1]);
+            if (instr->targets[1] != next_block)
+            {
+                x64_gen_jump_to(gen, instr->targets[1]);
+            }
+        }
+        break;
+        case IR_RETURN:
+        {
+            if (buf_len(instr->operands) > 0)
+            {
+                ir_instr *value = ir_resolve(instr->operands[0]);
+                x64_load(gen, X64_RAX, value);
+                if (value->type->kind == TYPE_FLOAT)
+                {
+                    x64_movd_to_xmm(gen, 0, X64_RAX);
+                }
+            }
+            x64_gen_epilogue(gen);
+        }
+        break;
+        default:
+        {
+            gen->failed = true;
+        }
+        break;
+    }
+}
+
+void x64_gen_prologue(x64_gen *gen)
+{
+    x64_push(gen, X64_RBP);
+    x64_mov_rr(gen, X64_RBP, X64_RSP);
+    for (size_t i = 0; i < buf_len(gen->saved_regs); i++)
+    {
+        x64_push(gen, gen->saved_regs[i]);
+    }
+
+    // przed wywołaniem rsp musi być wyrównany do 16 bajtów
+    size_t frame_size = 8 * gen->stack_slots;
+    if ((8 * buf_len(gen->saved_regs) + frame_size) % 16 != 0)
+    {
+        frame_size += 8;
+    }
+#if X64_WIN64_ENTRY
+    // stos w Windows rośnie przez stronę ochronną - większa ramka wymagałaby sondowania
+    if (gen->obj->interpreter_layout && frame_size >= X64_WIN64_STACK_PAGE_SIZE)
+    {
+        gen->failed = true;
+    }
+#endif
+    if (frame_size > 0)
+    {
+        x64_emit_rr(gen, 0, true, "\x81", (x64_reg)5, X64_RSP); // sub rsp, imm32
+        x64_emit_u32(gen, (uint32_t)frame_size);
+    }
+
+    ir_function *f = gen->function;
+    ir_block *entry = f->blocks[0];
+    size_t int_args = 0;
+    size_t float_args = 0;
+    type_function signature = f->symbol->type->function;
+    ir_instr **params = xcalloc(sizeof(ir_instr *) * (signature.param_count + 1));
+    for (size_t i = 0; i < buf_len(entry->instrs); i++)
+    {
+        if (entry->instrs[i]->opcode == IR_PARAM)
+        {
+            params[entry->instrs[i]->param_index] = entry->instrs[i];
+        }
+    }
+
+    for (size_t i = 0; i < signature.param_count; i++)
+    {
+        type *param_type = signature.param_types[i];
+        if (param_type->kind == TYPE_FLOAT)
+        {
+            if (float_args == X64_MAX_FLOAT_ARGS)
+            {
+                gen->failed = true;
+                break;
+            }
+            x64_movd_from_xmm(gen, X64_RAX, (int)float_args++);
+        }
+        else
+        {
+            if (int_args == X64_MAX_INT_ARGS)
+            {
+                gen->failed = true;
+                break;
+            }
+            x64_mov_rr(gen, X64_RAX, x64_int_arg_regs[int_args++]);
+            x64_normalize_abi_value(gen, param_type);
+        }
+
+        // nieużywane parametry zostały usunięte z IR
+        if (params[i])
+        {
+            x64_store(gen, params[i], X64_RAX);
+        }
+    }
+    free(params);
+}
+
+//
+// przydział rejestrów - linear scan
+//
+
+typedef struct x64_liveness
+{
+    size_t words;
+    uint64_t **live_in; // indeksowane identyfikatorem bloku
+    uint64_t **live_out;
+} x64_liveness;
+
+bool x64_bit_get(uint64_t *set, size_t index)
+{
+    return (set[index / 64] >> (index % 64)) & 1;
+}
+
+void x64_bit_set(uint64_t *set, size_t index)
+{
+    set[index / 64] |= ((uint64_t)1 << (index % 64));
+}
+
+bool x64_is_allocated_value(ir_instr *instr)
+{
+    instr = ir_resolve(instr);
+    bool result = (instr->block != null && instr->type != null);
+    return result;
+}
+
+// liczba identyfikatorów, którymi mogą być indeksowane tablice i zbiory wartości - obejmuje też
+// operandy spoza bloków funkcji
+size_t x64_count_value_ids(ir_function *f)
+{
+    size_t result = f->next_instr_id;
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        ir_block *block = f->blocks[i];
+        for (size_t k = 0; k < buf_len(block->instrs); k++)
+        {
+            ir_instr *instr = block->instrs[k];
+            if (instr->id >= result)
+            {
+                result = instr->id + 1;
+            }
+            for (size_t j = 0; j < buf_len(instr->operands); j++)
+            {
+                ir_instr *operand = ir_resolve(instr->operands[j]);
+                if (operand && operand->id >= result)
+                {
+                    result = operand->id + 1;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+void x64_compute_liveness(ir_function *f, size_t values_count, x64_liveness *liveness)
+{
+    size_t words = (values_count + 63) / 64;
+    size_t blocks_count = f->next_block_id;
+    liveness->words = words;
+    liveness->live_in = xcalloc(sizeof(uint64_t *) * blocks_count);
+    liveness->live_out = xcalloc(sizeof(uint64_t *) * blocks_count);
+
+    uint64_t **uses = xcalloc(sizeof(uint64_t *) * blocks_count);
+    uint64_t **defs = xcalloc(sizeof(uint64_t *) * blocks_count);
+
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        ir_block *block = f->blocks[i];
+        liveness->live_in[block->id] = xcalloc(sizeof(uint64_t) * words);
+        liveness->live_out[block->id] = xcalloc(sizeof(uint64_t) * words);
+        uses[block->id] = xcalloc(sizeof(uint64_t) * words);
+        defs[block->id] = xcalloc(sizeof(uint64_t) * words);
+
+        for (size_t k = 0; k < buf_len(block->instrs); k++)
+        {
+            ir_instr *instr = block->instrs[k];
+            if (instr->opcode != IR_PHI)
+            {
+                for (size_t j = 0; j < buf_len(instr->operands); j++)
+                {
+                    ir_instr *operand = ir_resolve(instr->operands[j]);
+                    if (x64_is_allocated_value(operand) && false == x64_bit_get(defs[block->id], operand->id))
+                    {
+                        x64_bit_set(uses[block->id], operand->id);
+                    }
+                }
+            }
+            if (instr->type)
+            {
+                x64_bit_set(defs[block->id], instr->id);
+            }
+        }
+    }
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (size_t i = buf_len(f->blocks); i > 0; i--)
+        {
+            ir_block *block = f->blocks[i - 1];
+            uint64_t *live_out = liveness->live_out[block->id];
+            uint64_t *live_in = liveness->live_in[block->id];
+
+            ir_block *successors[2];
+            size_t count = ir_get_successors(block, successors);
+            for (size_t j = 0; j < count; j++)
+            {
+                ir_block *successor = successors[j];
+                uint64_t *successor_in = liveness->live_in[successor->id];
+                for (size_t w = 0; w < words; w++)
+                {
+                    live_out[w] |= successor_in[w];
+                }
+
+                // operandy phi są używane na końcu poprzednika
+                for (size_t p = 0; p < buf_len(successor->preds); p++)
+                {
+                    if (successor->preds[p] != block)
+                    {
+                        continue;
+                    }
+                    for (size_t k = 0; k < buf_len(successor->instrs); k++)
+                    {
+                        ir_instr *phi = successor->instrs[k];
+                        if (phi->opcode != IR_PHI)
+                        {
+                            break;
+                        }
+                        ir_instr *operand = ir_resolve(phi->operands[p]);
+                        if (x64_is_allocated_value(operand))
+                        {
+                            x64_bit_set(live_out, operand->id);
+                        }
+                    }
+                }
+            }
+
+            for (size_t w = 0; w < words; w++)
+            {
+                uint64_t new_in = uses[block->id][w] | (live_out[w] & ~defs[block->id][w]);
+                if (new_in != live_in[w])
+                {
+                    live_in[w] = new_in;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        free(uses[f->blocks[i]->id]);
+        free(defs[f->blocks[i]->id]);
+    }
+    free(uses);
+    free(defs);
+}
+
+void x64_free_liveness(ir_function *f, x64_liveness *liveness)
+{
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        free(liveness->live_in[f->blocks[i]->id]);
+        free(liveness->live_out[f->blocks[i]->id]);
+    }
+    free(liveness->live_in);
+    free(liveness->live_out);
+}
+
+int x64_compare_intervals(const void *a, const void *b)
+{
+    const x64_interval *left = a;
+    const x64_interval *right = b;
+    if (left->start != right->start)
+    {
+        return (left->start < right->start) ? -1 : 1;
+    }
+    if (left->value->id != right->value->id)
+    {
+        return (left->value->id < right->value->id) ? -1 : 1;
+    }
+    return 0;
+}
+
+// interval_index przechowuje numer przedziału powiększony o 1; 0 oznacza wartość bez przedziału,
+// np. zdefiniowaną poza blokami funkcji
+void x64_extend_interval(x64_interval *intervals, size_t *interval_index, size_t value_id, size_t position)
+{
+    if (interval_index[value_id] == 0)
+    {
+        return;
+    }
+
+    x64_interval *interval = &intervals[interval_index[value_id] - 1];
+    if (position < interval->start)
+    {
+        interval->start = position;
+    }
+    if (position > interval->end)
+    {
+        interval->end = position;
+    }
+}
+
+void x64_allocate_registers(x64_gen *gen)
+{
+    ir_function *f = gen->function;
+    size_t values_count = gen->values_count;
+
+    x64_liveness liveness = {0};
+    x64_compute_liveness(f, values_count, &liveness);
+
+    // numeracja instrukcji w kolejności bloków
+    size_t *block_start = xcalloc(sizeof(size_t) * f->next_block_id);
+    size_t *block_end = xcalloc(sizeof(size_t) * f->next_block_id);
+    size_t *interval_index = xcalloc(sizeof(size_t) * values_count);
+    x64_interval *intervals = null;
+
+    size_t position = 0;
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        ir_block *block = f->blocks[i];
+        block_start[block->id] = position;
+        for (size_t k = 0; k < buf_len(block->instrs); k++)
+        {
+            ir_instr *instr = block->instrs[k];
+            if (instr->type)
+            {
+                x64_interval interval = { .value = instr, .start = position, .end = position };
+                buf_push(intervals, interval);
+                interval_index[instr->id] = buf_len(intervals);
+            }
+            position += 2;
+        }
+        block_end[block->id] = position;
+        position += 2;
+    }
+
+    position = 0;
+    for (size_t i = 0; i < buf_len(f->blocks); i++)
+    {
+        ir_block *block = f->blocks[i];
+        for (size_t k = 0; k < buf_len(block->instrs); k++)
+        {
+            ir_instr *instr = block->instrs[k];
+            if (instr->opcode != IR_PHI)
+            {
+                for (size_t j = 0; j < buf_len(instr->operands); j++)
+                {
+                    ir_instr *operand = ir_resolve(instr->operands[j]);
+                    if (x64_is_allocated_value(operand))
+                    {
+                        // wartość zdefiniowana poza blokami funkcji nie ma miejsca w rejestrze ani na stosie
+                        if (interval_index[operand->id] == 0)
+                        {
+                            gen->failed = true;
+                        }
+                        x64_extend_interval(intervals, interval_index, operand->id, position);
+                    }
+                }
+            }
+            position += 2;
+        }
+        position += 2;
+
+        for (size_t v = 0; v < values_count; v++)
+        {
+            if (x64_bit_get(liveness.live_in[block->id], v))
+            {
+                x64_extend_interval(intervals, interval_index, v, block_start[block->id]);
+            }
+            if (x64_bit_get(liveness.live_out[block->id], v))
+            {
+                x64_extend_interval(intervals, interval_index, v, block_end[block->id]);
+            }
+        }
+    }
+
+    // qsort nie przyjmuje pustego wskaźnika, nawet dla zera elementów
+    if (intervals)
+    {
+        qsort(intervals, buf_len(intervals), sizeof(x64_interval), x64_compare_intervals);
+    }
+
+    bool used_regs[X64_ALLOCATABLE_REGS_COUNT] = {0};
+    x64_interval *reg_owner[X64_ALLOCATABLE_REGS_COUNT] = {0};
+
+    for (size_t i = 0; i < buf_len(intervals); i++)
+    {
+        x64_interval *current = &intervals[i];
+
+        // zwalnianie rejestrów wartości, które już nie żyją
+        for (size_t r = 0; r < X64_ALLOCATABLE_REGS_COUNT; r++)
+        {
+            if (reg_owner[r] && reg_owner[r]->end < current->start)
+            {
+                reg_owner[r] = null;
+            }
+        }
+
+        size_t free_reg = X64_ALLOCATABLE_REGS_COUNT;
+        size_t furthest = X64_ALLOCATABLE_REGS_COUNT;
+        for (size_t r = 0; r < X64_ALLOCATABLE_REGS_COUNT; r++)
+        {
+            if (reg_owner[r] == null)
+            {
+                free_reg = r;
+                break;
+            }
+            if (furthest == X64_ALLOCATABLE_REGS_COUNT || reg_owner[r]->end > reg_owner[furthest]->end)
+            {
+                furthest = r;
+            }
+        }
+
+        if (free_reg == X64_ALLOCATABLE_REGS_COUNT && reg_owner[furthest]->end > current->end)
+        {
+            // zabieramy rejestr wartości, która żyje najdłużej
+            x64_interval *spilled = reg_owner[furthest];
+            gen->locations[spilled->value->id] = (x64_location){ .offset = (int32_t)gen->stack_slots++ };
+            free_reg = furthest;
+        }
+
+        if (free_reg < X64_ALLOCATABLE_REGS_COUNT)
+        {
+            reg_owner[free_reg] = current;
+            used_regs[free_reg] = true;
+            gen->locations[current->value->id] = (x64_location){
+                .in_register = true,
+                .reg = x64_allocatable_regs[free_reg],
+            };
+        }
+        else
+        {
+            gen->locations[current->value->id] = (x64_location){ .offset = (int32_t)gen->stack_slots++ };
+        }
+    }
+
+    for (size_t r = 0; r < X64_ALLOCATABLE_REGS_COUNT; r++)
+    {
+        if (used_regs[r])
+        {
+            buf_push(gen->saved_regs, x64_allocatable_regs[r]);
+        }
+    }
+
+    // sloty na stosie są znane dopiero teraz, bo zależą od liczby zachowanych rejestrów
+    for (size_t i = 0; i < buf_len(intervals); i++)
+    {
+        ir_instr *value = intervals[i].value;
+        if (false == gen->locations[value->id].in_register)
+        {
+            gen->locations[value->id].offset = x64_slot_offset(gen, (size_t)gen->locations[value->id].offset);
+        }
+        if (value->opcode == IR_PHI)
+        {
+            gen->phi_slots[value->id] = x64_slot_offset(gen, gen->stack_slots++);
+        }
+    }
+
+    buf_free(intervals);
+    free(interval_index);
+    free(block_start);
+    free(block_end);
+    x64_free_liveness(f, &liveness);
+}
+
+//
+// kompilacja funkcji
+//
+
+bool x64_compile_function(x64_object *obj, ir_function *f)
+{
+    size_t code_start = buf_len(obj->code);
+    size_t relocations_start = buf_len(obj->relocations);
+
+    size_t values_count = x64_count_value_ids(f);
+    x64_gen gen = {
+        .obj = obj,
+        .function = f,
+        .values_count = values_count,
+        .locations = xcalloc(sizeof(x64_location) * values_count),
+        .phi_slots = xcalloc(sizeof(int32_t) * values_count),
+        .block_offsets = xcalloc(sizeof(size_t) * f->next_block_id),
+    };
+
+    x64_allocate_registers(&gen);
+    x64_gen_prologue(&gen);
+
+    for (size_t i = 0; i < buf_len(f->blocks) && false == gen.failed; i++)
+    {
+        ir_block *block = f->blocks[i];
+        ir_block *next_block = (i + 1 < buf_len(f->blocks)) ? f->blocks[i + 1] : null;
+        gen.block_offsets[block->id] = x64_code_offset(&gen);
+        for (size_t k = 0; k < buf_len(block->instrs) && false == gen.failed; k++)
+        {
+            x64_gen_instr(&gen, block->instrs[k], next_block);
+        }
+    }
+
+    if (false == gen.failed)
+    {
+        for (size_t i = 0; i < buf_len(gen.fixups); i++)
+        {
+            x64_jump_fixup fixup = gen.fixups[i];
+            size_t target = gen.block_offsets[fixup.target->id];
+            x64_patch_u32(&gen, fixup.offset, (uint32_t)(target - (fixup.offset + 4)));
+        }
+
+        // wyrównanie kolejnej funkcji
+        while (buf_len(obj->code) % 16 != 0)
+        {
+            buf_push(obj->code, 0xCC);
+        }
+
+        x64_function_code code = {
+            .name = f->symbol->mangled_name,
+            .offset = code_start,
+            .size = buf_len(obj->code) - code_start,
+        };
+        buf_push(obj->functions, code);
+    }
+    else
+    {
+        __buf_header(obj->code)->len = code_start;
+        if (obj->relocations)
+        {
+            __buf_header(obj->relocations)->len = relocations_start;
+        }
+    }
+
+    free(gen.locations);
+    free(gen.phi_slots);
+    free(gen.block_offsets);
+    buf_free(gen.fixups);
+    buf_free(gen.saved_regs);
+
+    return (false == gen.failed);
+}
+
+// funkcja o jednolitej sygnaturze void (uint64_t *args, uint64_t *result),
+// przez którą interpreter wywołuje skompilowany kod
+size_t x64_compile_entry_thunk(x64_object *obj, symbol *function)
+{
+    x64_gen gen = { .obj = obj };
+    size_t result = x64_code_offset(&gen);
+
+    x64_push(&gen, X64_RBP);
+    x64_mov_rr(&gen, X64_RBP, X64_RSP);
+    x64_push(&gen, X64_RBX);
+#if X64_WIN64_ENTRY
+    x64_push(&gen, X64_RDI);
+    x64_push(&gen, X64_RSI);
+    x64_emit_rr(&gen, 0, true, "\x81", (x64_reg)5, X64_RSP); // sub rsp, imm32
+    x64_emit_u32(&gen, 16 * X64_WIN64_SAVED_XMM_COUNT + 8);
+    for (int i = 0; i < X64_WIN64_SAVED_XMM_COUNT; i++)
+    {
+        // movdqu [rbp - offset], xmm6 + i
+        x64_emit_mem(&gen, 0xF3, false, "\x0F\x7F", (x64_reg)(6 + i), X64_RBP, -40 - 16 * i);
+    }
+    x64_mov_rr(&gen, X64_RDI, X64_RCX);
+    x64_mov_rr(&gen, X64_RSI, X64_RDX);
+#else
+    x64_emit_rr(&gen, 0, true, "\x83", (x64_reg)5, X64_RSP); // sub rsp, 8
+    x64_emit_byte(&gen, 8);
+#endif
+
+    x64_mov_rr(&gen, X64_RBX, X64_RSI);
+    x64_mov_rr(&gen, X64_R11, X64_RDI);
+
+    type_function signature = function->type->function;
+    size_t int_args = 0;
+    size_t float_args = 0;
+    for (size_t i = 0; i < signature.param_count; i++)
+    {
+        int32_t offset = (int32_t)(8 * i);
+        if (signature.param_types[i]->kind == TYPE_FLOAT)
+        {
+            x64_emit_mem(&gen, 0x66, false, "\x0F\x6E", (x64_reg)float_args++, X64_R11, offset); // movd xmm, [r11 + offset]
+        }
+        else
+        {
+            x64_emit_mem(&gen, 0, true, "\x8B", x64_int_arg_regs[int_args++], X64_R11, offset);
+        }
+    }
+
+    x64_emit_byte(&gen, 0xE8);
+    x64_relocation reloc = {
+        .offset = x64_code_offset(&gen),
+        .symbol = function->mangled_name,
+        .type = X64_R_PLT32,
+        .addend = -4,
+    };
+    buf_push(obj->relocations, reloc);
+    x64_emit_u32(&gen, 0);
+
+    if (signature.return_type->kind == TYPE_FLOAT)
+    {
+        x64_movd_from_xmm(&gen, X64_RAX, 0);
+    }
+    x64_emit_mem(&gen, 0, true, "\x89", X64_RAX, X64_RBX, 0);
+
+#if X64_WIN64_ENTRY
+    for (int i = 0; i < X64_WIN64_SAVED_XMM_COUNT; i++)
+    {
+        // movdqu xmm6 + i, [rbp - offset]
+        x64_emit_mem(&gen, 0xF3, false, "\x0F\x6F", (x64_reg)(6 + i), X64_RBP, -40 - 16 * i);
+    }
+    x64_emit_rr(&gen, 0, true, "\x81", (x64_reg)0, X64_RSP); // add rsp, imm32
+    x64_emit_u32(&gen, 16 * X64_WIN64_SAVED_XMM_COUNT + 8);
+    x64_pop(&gen, X64_RSI);
+    x64_pop(&gen, X64_RDI);
+#else
+    x64_emit_rr(&gen, 0, true, "\x83", (x64_reg)0, X64_RSP); // add rsp, 8
+    x64_emit_byte(&gen, 8);
+#endif
+    x64_pop(&gen, X64_RBX);
+    x64_pop(&gen, X64_RBP);
+    x64_emit_byte(&gen, 0xC3);
+
+    while (buf_len(obj->code) % 16 != 0)
+    {
+        buf_push(obj->code, 0xCC);
+    }
+
+    return result;
+}
+
+// kompiluje wszystkie funkcje, dla których zbudowano IR
+void x64_compile_functions(x64_object *obj, symbol **resolved)
+{
+    map_grow(&native_functions, 64);
+    for (size_t i = 0; i < buf_len(resolved); i++)
+    {
+        symbol *sym = resolved[i];
+        ir_function *f = (ir_functions.capacity > 0) ? map_get(&ir_functions, sym) : null;
+        if (f && x64_compile_function(obj, f))
+        {
+            map_put(&native_functions, sym, sym);
+        }
+    }
+}
+
+void free_x64_object(x64_object *obj)
+{
+    buf_free(obj->code);
+    buf_free(obj->relocations);
+    buf_free(obj->functions);
+}